@@ -11,11 +11,69 @@ TEMPLATE = app
 SOURCES += main.cpp \
            mainwindow.cpp \
            tcp_stream_assembler.cpp \
-           http_parser.cpp
+           http_parser.cpp \
+           flow_stats.cpp \
+           conversations_window.cpp \
+           http_stats.cpp \
+           http_stats_window.cpp \
+           packet_decoder.cpp \
+           trace.cpp \
+           flow_sampler.cpp \
+           capture_filter.cpp \
+           thread_tuning.cpp \
+           frame_queue.cpp \
+           pcap_file_writer.cpp \
+           pcap_ring_writer.cpp \
+           trigger_capture.cpp \
+           http_body_decoder.cpp \
+           string_interner.cpp \
+           header_columns_model.cpp \
+           websocket_parser.cpp \
+           tls_sniffer.cpp \
+           udp_dissector.cpp \
+           dns_parser.cpp \
+           ip_defragmenter.cpp \
+           hpack.cpp \
+           http2_decoder.cpp \
+           interface_rates.cpp \
+           packet_merger.cpp \
+           process_resolver.cpp \
+           trigram_index.cpp \
+           offline_analyzer.cpp \
+           event_stream.cpp
 
 HEADERS += mainwindow.h \
            tcp_stream_assembler.h \
-           http_parser.h
+           http_parser.h \
+           flow_stats.h \
+           conversations_window.h \
+           http_stats.h \
+           http_stats_window.h \
+           packet_decoder.h \
+           trace.h \
+           flow_sampler.h \
+           capture_filter.h \
+           thread_tuning.h \
+           frame_queue.h \
+           pcap_file_writer.h \
+           pcap_ring_writer.h \
+           trigger_capture.h \
+           http_body_decoder.h \
+           string_interner.h \
+           header_columns_model.h \
+           websocket_parser.h \
+           tls_sniffer.h \
+           udp_dissector.h \
+           dns_parser.h \
+           ip_defragmenter.h \
+           hpack.h \
+           http2_decoder.h \
+           interface_rates.h \
+           packet_merger.h \
+           process_resolver.h \
+           trigram_index.h \
+           offline_analyzer.h \
+           event_stream.h
 
 # Флаги компилятора в зависимости от платформы
 win32 {
@@ -26,6 +84,10 @@ win32 {
     INCLUDEPATH += "c:/npcap/Include"
     LIBS += -L"c:/npcap/Lib/x64" -lwpcap -lPacket -lws2_32
 
+    # zlib для распаковки тел HTTP (путь задаётся ZLIB_DIR)
+    INCLUDEPATH += $$(ZLIB_DIR)/include
+    LIBS += -L$$(ZLIB_DIR)/lib -lzlib
+
     # Windows-специфичные определения
     DEFINES += WIN32 _CONSOLE WPCAP HAVE_REMOTE _WINSOCK_DEPRECATED_NO_WARNINGS
 } else {
@@ -33,7 +95,10 @@ win32 {
     QMAKE_CXXFLAGS += -Wall
 
     # Unix/Linux библиотеки
-    LIBS += -lpcap
+    LIBS += -lpcap -lz
+
+    # shm_open в glibc до 2.34 - в librt
+    linux: LIBS += -lrt
 }
 
 # Дополнительные опции для отладки
@@ -49,6 +114,42 @@ CONFIG(release, debug|release) {
     message("Release build")
 }
 
+# Трассировка горячего пути: qmake CONFIG+=tracing
+# (без этой опции точки трассировки не компилируются)
+tracing {
+    DEFINES += SNIFFER_TRACING
+    message("Tracing enabled")
+}
+
+# Распаковка Content-Encoding: br: qmake CONFIG+=brotli (нужен libbrotlidec);
+# без этой опции gzip и deflate поддерживаются всегда
+brotli {
+    DEFINES += SNIFFER_BROTLI
+    LIBS += -lbrotlidec
+    message("Brotli enabled")
+}
+
+# Бенчмарки пути разбора: make sniffer-bench (собирает bench/sniffer-bench.pro)
+sniffer_bench.target = sniffer-bench
+sniffer_bench.commands = $(MKDIR) bench && cd bench && $$QMAKE_QMAKE $$PWD/bench/sniffer-bench.pro && $(MAKE)
+QMAKE_EXTRA_TARGETS += sniffer_bench
+
+# Регрессионные проверки: make sniffer-tests (эталонный корпус и векторы
+# разборщиков, затем время и выделения на сгенерированном трафике против
+# базы bench/golden/baseline.json; ненулевой код - ошибка). Эталонные
+# сценарии малы для замеров времени - с базой сравнивается только трафик
+sniffer_tests.target = sniffer-tests
+sniffer_tests.depends = sniffer-bench
+sniffer_tests.commands = cd bench && ./sniffer-bench --golden $$PWD/bench/golden && \
+                         ./sniffer-bench --flows 1000 --requests 20 --ooo 0.05 --retransmit 0.02 --iterations 20 \
+                                         --baseline $$PWD/bench/golden/baseline.json
+QMAKE_EXTRA_TARGETS += sniffer_tests
+
+# Пример читателя потока событий: make event-consumer (собирает tools/event-consumer.pro)
+event_consumer.target = event-consumer
+event_consumer.commands = $(MKDIR) tools && cd tools && $$QMAKE_QMAKE $$PWD/tools/event-consumer.pro && $(MAKE)
+QMAKE_EXTRA_TARGETS += event_consumer
+
 # Инструкции для установки
 unix {
     target.path = /usr/local/bin
@@ -0,0 +1,711 @@
+// sniffer-bench: микро- и сквозные бенчмарки пути разбора
+// (заголовки -> сборка TCP-потоков -> HTTP) на синтетическом трафике.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include "traffic_generator.h"
+#include "golden_corpus.h"
+#include "parser_checks.h"
+#include "../packet_decoder.h"
+#include "../tcp_stream_assembler.h"
+#include "../http_parser.h"
+#include "../flow_stats.h"
+#include "../http_stats.h"
+#include "../offline_analyzer.h"
+
+// ------------------ Подсчёт выделений памяти ------------------
+
+static std::atomic<uint64_t> allocationCount(0);
+
+void* operator new(size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+
+namespace {
+
+// ------------------ Результаты ------------------
+
+struct BenchResult {
+    std::string name;
+    uint64_t packets;
+    uint64_t bytes;
+    double seconds;
+    uint64_t allocations;
+    long peakRssKb;
+    uint64_t messages;
+    uint64_t expectedMessages;
+
+    double packetsPerSecond() const { return seconds > 0 ? packets / seconds : 0; }
+    double bytesPerSecond() const { return seconds > 0 ? bytes / seconds : 0; }
+    double nsPerPacket() const { return packets ? seconds * 1e9 / packets : 0; }
+    double allocationsPerPacket() const { return packets ? double(allocations) / packets : 0; }
+};
+
+long peakRssKb() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return static_cast<long>(counters.PeakWorkingSetSize / 1024);
+    }
+    return 0;
+#else
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+#endif
+}
+
+std::string toJson(const BenchResult& r) {
+    char buffer[512];
+    snprintf(buffer, sizeof(buffer),
+             "{\"name\":\"%s\",\"packets\":%llu,\"bytes\":%llu,\"seconds\":%.6f,"
+             "\"packets_per_sec\":%.1f,\"bytes_per_sec\":%.1f,\"ns_per_packet\":%.2f,"
+             "\"allocs_per_packet\":%.3f,\"peak_rss_kb\":%ld,\"messages\":%llu,\"expected_messages\":%llu}",
+             r.name.c_str(),
+             static_cast<unsigned long long>(r.packets), static_cast<unsigned long long>(r.bytes),
+             r.seconds, r.packetsPerSecond(), r.bytesPerSecond(), r.nsPerPacket(),
+             r.allocationsPerPacket(), r.peakRssKb,
+             static_cast<unsigned long long>(r.messages), static_cast<unsigned long long>(r.expectedMessages));
+    return buffer;
+}
+
+// Извлекает числовое поле из строки JSON, записанной toJson()
+bool jsonNumber(const std::string& line, const std::string& field, double& value) {
+    std::string pattern = "\"" + field + "\":";
+    size_t pos = line.find(pattern);
+    if (pos == std::string::npos) return false;
+    value = std::strtod(line.c_str() + pos + pattern.size(), nullptr);
+    return true;
+}
+
+bool jsonString(const std::string& line, const std::string& field, std::string& value) {
+    std::string pattern = "\"" + field + "\":\"";
+    size_t pos = line.find(pattern);
+    if (pos == std::string::npos) return false;
+    size_t start = pos + pattern.size();
+    size_t end = line.find('"', start);
+    if (end == std::string::npos) return false;
+    value = line.substr(start, end - start);
+    return true;
+}
+
+// ------------------ Параметры запуска ------------------
+
+struct BenchOptions {
+    TrafficOptions traffic;
+    int iterations;
+    std::string only;          // Запустить только бенчмарк с этим именем
+    bool json;
+    std::string outputFile;
+    std::string baselineFile;
+    double tolerance;
+    double allocTolerance;     // Число выделений детерминировано - допуск меньше
+    std::string pcapFile;      // Только сохранить сгенерированный трафик
+
+    // Проверка результата разбора по эталонам
+    std::string goldenDir;
+    std::string writeGoldenDir;
+    std::vector<std::string> replayFiles;
+
+    // Разбор файла в несколько потоков против одного
+    std::string offlineFile;
+    unsigned offlineThreads;
+
+    BenchOptions() : iterations(5), json(false), tolerance(0.10), allocTolerance(0.02), offlineThreads(0) {}
+};
+
+void printUsage() {
+    printf("Использование: sniffer-bench [параметры]\n"
+           "  --flows N            число TCP-соединений (100)\n"
+           "  --requests N         запросов на соединение (20)\n"
+           "  --segment N          размер TCP-сегмента (1460)\n"
+           "  --body N             размер тела ответа (4096)\n"
+           "  --ooo R              доля переставленных сегментов, 0..1 (0)\n"
+           "  --retransmit R       доля повторных сегментов, 0..1 (0)\n"
+           "  --chunked            ответы с Transfer-Encoding: chunked\n"
+           "  --chunk-size N       размер чанка (1024)\n"
+           "  --bulk-flows N       не-HTTP соединения на порт 443 (0)\n"
+           "  --bulk-bytes N       данных в каждом из них (262144)\n"
+           "  --seed N             зерно генератора (1)\n"
+           "  --iterations N       повторов каждого замера, берётся лучший (5)\n"
+           "  --only NAME          запустить только один бенчмарк\n"
+           "  --json               вывод в формате JSON (по записи на строку)\n"
+           "  --output FILE        сохранить результаты JSON в файл\n"
+           "  --baseline FILE      сравнить с сохранёнными результатами (поля tolerance и\n"
+           "                       alloc_tolerance записи базы заменяют общие допуски)\n"
+           "  --tolerance R        допустимое замедление относительно базы (0.10)\n"
+           "  --alloc-tolerance R  допустимый рост выделений на пакет (0.02)\n"
+           "  --write-pcap FILE    сохранить трафик в pcap и выйти (для tcpreplay)\n"
+           "\n"
+           "Проверка по эталонам (вместо обычных бенчмарков): эталонные сценарии\n"
+           "и файлы --replay проходят разбор файла в один поток, список выведенных\n"
+           "сообщений сравнивается с DIR/<сценарий>.txt и с разбором в --offline-threads\n"
+           "потоков (по умолчанию не меньше 4), замеры идут под именами golden_<сценарий>;\n"
+           "при --golden также проверяются разборщики на известных векторах\n"
+           "  --golden DIR         сравнить с эталонами; расхождение - код возврата 1\n"
+           "  --write-golden DIR   записать эталоны (после проверки изменений вручную)\n"
+           "  --replay FILE        добавить файл pcap как сценарий (можно несколько)\n"
+           "\n"
+           "Разбор файла (вместо обычных бенчмарков): файл разбирается в один поток\n"
+           "и в несколько, результаты должны совпасть; замеры - offline_<потоков>\n"
+           "  --offline FILE       файл pcap\n"
+           "  --offline-threads N  потоков параллельного разбора (по числу ядер)\n");
+}
+
+bool parseOptions(int argc, char* argv[], BenchOptions& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (arg == "--flows" && hasValue) options.traffic.flows = std::strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--requests" && hasValue) options.traffic.requestsPerFlow = std::strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--segment" && hasValue) options.traffic.segmentSize = std::strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--body" && hasValue) options.traffic.bodySize = std::strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--ooo" && hasValue) options.traffic.outOfOrderRate = std::strtod(argv[++i], nullptr);
+        else if (arg == "--retransmit" && hasValue) options.traffic.retransmitRate = std::strtod(argv[++i], nullptr);
+        else if (arg == "--chunked") options.traffic.chunked = true;
+        else if (arg == "--chunk-size" && hasValue) options.traffic.chunkSize = std::strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--bulk-flows" && hasValue) options.traffic.bulkFlows = std::strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--bulk-bytes" && hasValue) options.traffic.bulkBytes = std::strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--seed" && hasValue) options.traffic.seed = std::strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--iterations" && hasValue) options.iterations = std::atoi(argv[++i]);
+        else if (arg == "--only" && hasValue) options.only = argv[++i];
+        else if (arg == "--json") options.json = true;
+        else if (arg == "--output" && hasValue) options.outputFile = argv[++i];
+        else if (arg == "--baseline" && hasValue) options.baselineFile = argv[++i];
+        else if (arg == "--tolerance" && hasValue) options.tolerance = std::strtod(argv[++i], nullptr);
+        else if (arg == "--alloc-tolerance" && hasValue) options.allocTolerance = std::strtod(argv[++i], nullptr);
+        else if (arg == "--golden" && hasValue) options.goldenDir = argv[++i];
+        else if (arg == "--write-golden" && hasValue) options.writeGoldenDir = argv[++i];
+        else if (arg == "--replay" && hasValue) options.replayFiles.push_back(argv[++i]);
+        else if (arg == "--write-pcap" && hasValue) options.pcapFile = argv[++i];
+        else if (arg == "--offline" && hasValue) options.offlineFile = argv[++i];
+        else if (arg == "--offline-threads" && hasValue) options.offlineThreads = std::strtoul(argv[++i], nullptr, 10);
+        else {
+            printUsage();
+            return false;
+        }
+    }
+
+    if (options.iterations < 1) options.iterations = 1;
+    if (!options.replayFiles.empty() && options.goldenDir.empty() && options.writeGoldenDir.empty()) {
+        fprintf(stderr, "--replay используется вместе с --golden или --write-golden\n");
+        return false;
+    }
+    return true;
+}
+
+// ------------------ Замеры ------------------
+
+// Выполняет тело несколько раз и возвращает лучший результат
+BenchResult measure(const std::string& name, int iterations, uint64_t packets, uint64_t bytes,
+                    const std::function<uint64_t()>& body) {
+    BenchResult best{name, packets, bytes, 0, 0, 0, 0, 0};
+
+    for (int i = 0; i < iterations; i++) {
+        uint64_t allocationsBefore = allocationCount.load(std::memory_order_relaxed);
+        auto start = std::chrono::steady_clock::now();
+
+        uint64_t messages = body();
+
+        auto end = std::chrono::steady_clock::now();
+        uint64_t allocations = allocationCount.load(std::memory_order_relaxed) - allocationsBefore;
+        double seconds = std::chrono::duration<double>(end - start).count();
+
+        if (i == 0 || seconds < best.seconds) {
+            best.seconds = seconds;
+            best.allocations = allocations;
+            best.messages = messages;
+        }
+    }
+
+    best.peakRssKb = peakRssKb();
+    return best;
+}
+
+struct Workload {
+    const std::vector<SyntheticFrame>* frames;
+    std::vector<DecodedPacket> decoded;
+    std::vector<std::vector<uint8_t>> messages;   // Собранные HTTP-сообщения
+    uint64_t bytes;
+    uint64_t payloadBytes;
+    uint64_t expectedMessages;
+};
+
+// Не даёт компилятору выбросить результат замера
+volatile uint64_t sink = 0;
+
+uint64_t benchDecode(const Workload& w) {
+    uint64_t sum = 0;
+    DecodedPacket packet;
+    for (const SyntheticFrame& frame : *w.frames) {
+        if (PacketDecoder::decode(frame.data.data(), frame.data.size(), packet)) {
+            sum += packet.payloadLength;
+        }
+    }
+    sink = sum;
+    return 0;
+}
+
+uint64_t benchFlowStats(const Workload& w, FlowStatsMode mode) {
+    FlowStatistics statistics(mode);
+    for (size_t i = 0; i < w.decoded.size(); i++) {
+        const DecodedPacket& p = w.decoded[i];
+        statistics.addPacket(p.srcIP, p.dstIP, p.srcPort, p.dstPort, p.protocol, (*w.frames)[i].data.size());
+    }
+    return 0;
+}
+
+uint64_t benchAssembler(const Workload& w) {
+    uint64_t messages = 0;
+    TCPStreamAssembler assembler([&messages](const StreamKey&, const std::vector<uint8_t>&) {
+        messages++;
+    });
+    for (const DecodedPacket& p : w.decoded) {
+        if (p.protocol == IP_PROTO_TCP) {
+            assembler.processPacket(p.srcIP, p.dstIP, p.srcPort, p.dstPort,
+                                    p.seqNum, p.payload, p.payloadLength, p.tcpFlags);
+        }
+    }
+    return messages;
+}
+
+uint64_t benchHttpParse(const Workload& w) {
+    uint64_t parsed = 0;
+    for (const std::vector<uint8_t>& message : w.messages) {
+        if (HTTPParser::isHTTP(message.data(), message.size())) {
+            HTTPMessage parsedMessage = HTTPParser::parseHTTP(message.data(), message.size());
+            parsed += parsedMessage.isRequest || parsedMessage.statusCode > 0;
+        }
+    }
+    return parsed;
+}
+
+// Повторяет CaptureThread::processPacket без обращений к GUI
+uint64_t benchPipeline(const Workload& w) {
+    FlowStatistics flowStats;
+    HttpEndpointStats httpStats;
+    uint64_t messages = 0;
+    uint64_t timestampUs = 0;
+
+    TCPStreamAssembler assembler([&](const StreamKey& key, const std::vector<uint8_t>& data) {
+        if (HTTPParser::isHTTP(data.data(), data.size())) {
+            HTTPMessage message = HTTPParser::parseHTTP(data.data(), data.size());
+            if (message.isRequest) {
+                httpStats.onRequest(key, HTTPParser::getHeader(message, "Host"), message.uri, timestampUs);
+            } else {
+                httpStats.onResponse(key, message.statusCode, timestampUs);
+            }
+            messages++;
+        }
+    });
+
+    uint64_t packetCount = 0;
+    uint64_t lastCleanupUs = 0;
+    DecodedPacket packet;
+    for (const SyntheticFrame& frame : *w.frames) {
+        packetCount++;
+        timestampUs = frame.timestampUs;
+
+        if (PacketDecoder::decode(frame.data.data(), frame.data.size(), packet)) {
+            flowStats.addPacket(packet.srcIP, packet.dstIP, packet.srcPort, packet.dstPort,
+                                packet.protocol, frame.data.size());
+            if (packet.protocol == IP_PROTO_TCP) {
+                assembler.processPacket(packet.srcIP, packet.dstIP, packet.srcPort, packet.dstPort,
+                                        packet.seqNum, packet.payload, packet.payloadLength, packet.tcpFlags);
+            }
+        }
+
+        if (timestampUs - lastCleanupUs >= 1000000) {
+            lastCleanupUs = timestampUs;
+            assembler.clearOldStreams(300);
+        }
+    }
+    return messages;
+}
+
+// ------------------ Сравнение с базой ------------------
+
+int compareWithBaseline(const std::vector<BenchResult>& results, const std::string& file,
+                        double tolerance, double allocTolerance) {
+    std::ifstream in(file);
+    if (!in) {
+        fprintf(stderr, "Не удалось открыть файл базы %s\n", file.c_str());
+        return 2;
+    }
+
+    struct Baseline {
+        double ns = 0;
+        double allocs = -1;   // Нет в старых файлах базы
+        double tolerance = -1;
+        double allocTolerance = -1;
+    };
+    std::map<std::string, Baseline> baseline;
+    std::string line;
+    while (std::getline(in, line)) {
+        std::string name;
+        Baseline entry;
+        if (jsonString(line, "name", name) && jsonNumber(line, "ns_per_packet", entry.ns)) {
+            jsonNumber(line, "allocs_per_packet", entry.allocs);
+            jsonNumber(line, "tolerance", entry.tolerance);
+            jsonNumber(line, "alloc_tolerance", entry.allocTolerance);
+            baseline[name] = entry;
+        }
+    }
+
+    int regressions = 0;
+    printf("\n%-20s %14s %14s %9s %12s %10s\n", "Сравнение", "база нс/пак", "сейчас", "изм.",
+           "база выд/пак", "сейчас");
+    for (const BenchResult& r : results) {
+        auto it = baseline.find(r.name);
+        if (it == baseline.end() || it->second.ns <= 0) continue;
+
+        // Допуски записи базы: у эталонных сценариев время зависит от машины,
+        // а число выделений детерминировано
+        double timeLimit = it->second.tolerance >= 0 ? it->second.tolerance : tolerance;
+        double allocLimit = it->second.allocTolerance >= 0 ? it->second.allocTolerance : allocTolerance;
+        double change = r.nsPerPacket() / it->second.ns - 1.0;
+        bool regression = change > timeLimit;
+
+        // Выделения сравниваются с небольшим абсолютным запасом: при нуле
+        // в базе относительный допуск не работает
+        bool allocRegression = it->second.allocs >= 0 &&
+                               r.allocationsPerPacket() > it->second.allocs * (1.0 + allocLimit) + 0.001;
+        regressions += regression || allocRegression;
+        printf("%-20s %14.2f %14.2f %+8.1f%% %12.3f %10.3f%s\n", r.name.c_str(), it->second.ns, r.nsPerPacket(),
+               change * 100, it->second.allocs, r.allocationsPerPacket(),
+               regression || allocRegression ? "  РЕГРЕССИЯ" : "");
+    }
+
+    return regressions > 0 ? 1 : 0;
+}
+
+// ------------------ Эталоны ------------------
+
+// Не меньше двух сборщиков в параллельном разборе - проверяется и слияние событий
+const unsigned GOLDEN_MIN_THREADS = 4;
+
+// Прогоняет эталонные сценарии, сравнивает или записывает эталоны и
+// замеряет каждый сценарий; разбор в несколько потоков сверяется с разбором
+// в одном. Возвращает число расхождений (-1 - ошибка)
+int runGoldenChecks(const BenchOptions& options, std::vector<BenchResult>& results) {
+    unsigned threads = options.offlineThreads != 0 ? options.offlineThreads
+                                                   : std::max(GOLDEN_MIN_THREADS, std::thread::hardware_concurrency());
+    std::vector<GoldenScenario> scenarios = buildGoldenCorpus();
+    for (const std::string& file : options.replayFiles) {
+        GoldenScenario scenario;
+        size_t slash = file.find_last_of("/\\");
+        scenario.name = file.substr(slash == std::string::npos ? 0 : slash + 1);
+        scenario.name = scenario.name.substr(0, scenario.name.rfind('.'));
+        std::string error;
+        if (!loadPcap(file, scenario.frames, error)) {
+            fprintf(stderr, "%s: %s\n", file.c_str(), error.c_str());
+            return -1;
+        }
+        scenarios.push_back(std::move(scenario));
+    }
+
+    int mismatches = 0;
+    for (const GoldenScenario& scenario : scenarios) {
+        if (!options.only.empty() && options.only != scenario.name) continue;
+
+        // Кадры идут через OfflineAnalyzer, как при разборе файла
+        std::string pcapFile = writeGoldenPcap(scenario);
+        std::vector<std::string> actual;
+        std::string error;
+        if (pcapFile.empty() || !runGolden(pcapFile, 1, actual, error)) {
+            fprintf(stderr, "%s: %s\n", scenario.name.c_str(),
+                    pcapFile.empty() ? "не удалось записать временный pcap" : error.c_str());
+            if (!pcapFile.empty()) std::remove(pcapFile.c_str());
+            return -1;
+        }
+
+        // События сборщиков сливаются по номеру кадра - результат обязан совпасть
+        std::vector<std::string> parallel;
+        std::string difference;
+        if (threads > 1) {
+            if (!runGolden(pcapFile, threads, parallel, error)) {
+                fprintf(stderr, "%s: %s\n", scenario.name.c_str(), error.c_str());
+                std::remove(pcapFile.c_str());
+                return -1;
+            }
+            if (!compareGolden(parallel, actual, difference)) {
+                fprintf(stderr, "%s: разбор в %u потоков расходится с разбором в одном, %s\n",
+                        scenario.name.c_str(), threads, difference.c_str());
+                mismatches++;
+            }
+        }
+
+        if (!options.writeGoldenDir.empty()) {
+            std::string file = options.writeGoldenDir + "/" + scenario.name + ".txt";
+            if (!writeGoldenFile(file, actual)) {
+                fprintf(stderr, "Не удалось записать %s\n", file.c_str());
+                std::remove(pcapFile.c_str());
+                return -1;
+            }
+        } else {
+            std::string file = options.goldenDir + "/" + scenario.name + ".txt";
+            std::vector<std::string> expected;
+            if (!readGoldenFile(file, expected)) {
+                fprintf(stderr, "%s: нет эталона %s\n", scenario.name.c_str(), file.c_str());
+                mismatches++;
+            } else if (!compareGolden(actual, expected, difference)) {
+                fprintf(stderr, "%s: расхождение с эталоном, %s\n", scenario.name.c_str(), difference.c_str());
+                mismatches++;
+            }
+        }
+
+        uint64_t bytes = 0;
+        for (const SyntheticFrame& frame : scenario.frames) {
+            bytes += frame.data.size();
+        }
+        results.push_back(measure("golden_" + scenario.name, options.iterations, scenario.frames.size(), bytes,
+                                  [&] {
+            std::vector<std::string> lines;
+            runGolden(pcapFile, 1, lines, error);
+            return static_cast<uint64_t>(lines.size() - 1);
+        }));
+        std::remove(pcapFile.c_str());
+    }
+
+    if (!options.goldenDir.empty() && options.only.empty()) {
+        std::vector<std::string> failures;
+        size_t checks = runParserChecks(failures);
+        for (const std::string& failure : failures) {
+            fprintf(stderr, "разборщик: %s\n", failure.c_str());
+        }
+        printf("Проверок разборщиков: %zu, ошибок: %zu\n", checks, failures.size());
+        mismatches += static_cast<int>(failures.size());
+    }
+    return mismatches;
+}
+
+// ------------------ Разбор файла ------------------
+
+// Разбирает файл в один поток и в несколько, сравнивает результаты и
+// замеряет оба прогона; возвращает число расхождений (-1 - ошибка)
+int runOfflineChecks(const BenchOptions& options, std::vector<BenchResult>& results) {
+    unsigned threads = options.offlineThreads != 0 ? options.offlineThreads
+                                                   : std::max(2u, std::thread::hardware_concurrency());
+    std::vector<std::string> reference;
+    int mismatches = 0;
+    for (unsigned count : {1u, threads}) {
+        OfflineOptions offline;
+        offline.threads = count;
+        OfflineResult result;
+        if (!OfflineAnalyzer(offline).analyze(options.offlineFile, result)) {
+            fprintf(stderr, "%s: %s\n", options.offlineFile.c_str(), result.error.c_str());
+            return -1;
+        }
+
+        std::vector<std::string> lines = goldenLines(result);
+        std::string difference;
+        if (count == 1) {
+            reference.swap(lines);
+        } else if (!compareGolden(lines, reference, difference)) {
+            fprintf(stderr, "Разбор в %u потоков расходится с разбором в одном, %s\n", count, difference.c_str());
+            mismatches++;
+        }
+
+        results.push_back(measure("offline_" + std::to_string(count), options.iterations, result.frames,
+                                  result.fileBytes, [&] {
+            OfflineResult run;
+            OfflineAnalyzer(offline).analyze(options.offlineFile, run);
+            return static_cast<uint64_t>(run.events.size());
+        }));
+        if (count == threads) {
+            printf("Потоков разбора заголовков: %u, сборщиков: %u; ожидание чтения %.3f с, обработки %.3f с\n",
+                   result.decodeThreads, result.shardThreads, result.readWaitSeconds, result.workWaitSeconds);
+        }
+        if (count == threads) break;   // --offline-threads 1: один прогон
+    }
+    return mismatches;
+}
+
+void printResults(const std::vector<BenchResult>& results) {
+    printf("%-20s %12s %10s %10s %10s %10s %12s\n",
+           "Бенчмарк", "пак/с", "МБ/с", "нс/пак", "выд/пак", "RSS, МБ", "сообщений");
+    for (const BenchResult& r : results) {
+        char messages[32] = "-";
+        if (r.expectedMessages) {
+            snprintf(messages, sizeof(messages), "%llu/%llu",
+                     static_cast<unsigned long long>(r.messages),
+                     static_cast<unsigned long long>(r.expectedMessages));
+        } else if (r.messages) {
+            snprintf(messages, sizeof(messages), "%llu", static_cast<unsigned long long>(r.messages));
+        }
+        printf("%-20s %12.0f %10.1f %10.1f %10.3f %10.1f %12s\n",
+               r.name.c_str(), r.packetsPerSecond(), r.bytesPerSecond() / 1e6,
+               r.nsPerPacket(), r.allocationsPerPacket(), r.peakRssKb / 1024.0, messages);
+    }
+}
+
+// Вывод, сохранение и сравнение с базой - общие для обоих режимов
+int reportResults(const BenchOptions& options, const std::vector<BenchResult>& results) {
+    if (options.json) {
+        for (const BenchResult& r : results) {
+            printf("%s\n", toJson(r).c_str());
+        }
+    } else {
+        printResults(results);
+    }
+
+    if (!options.outputFile.empty()) {
+        std::ofstream out(options.outputFile);
+        for (const BenchResult& r : results) {
+            out << toJson(r) << "\n";
+        }
+    }
+
+    if (!options.baselineFile.empty()) {
+        return compareWithBaseline(results, options.baselineFile, options.tolerance, options.allocTolerance);
+    }
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    BenchOptions options;
+    if (!parseOptions(argc, argv, options)) {
+        return 2;
+    }
+
+    if (!options.offlineFile.empty()) {
+        std::vector<BenchResult> results;
+        int mismatches = runOfflineChecks(options, results);
+        if (mismatches < 0) {
+            return 2;
+        }
+        int status = reportResults(options, results);
+        return mismatches > 0 ? 1 : status;
+    }
+
+    if (!options.goldenDir.empty() || !options.writeGoldenDir.empty()) {
+        std::vector<BenchResult> results;
+        int mismatches = runGoldenChecks(options, results);
+        if (mismatches < 0) {
+            return 2;
+        }
+        int status = reportResults(options, results);
+        if (mismatches > 0) {
+            fprintf(stderr, "Расхождений с эталонами: %d\n", mismatches);
+            return 1;
+        }
+        return status;
+    }
+
+    // Генерация трафика не входит в замеры
+    TrafficGenerator generator(options.traffic);
+    generator.generate();
+
+    if (!options.pcapFile.empty()) {
+        if (!generator.writePcap(options.pcapFile)) {
+            fprintf(stderr, "Не удалось записать %s\n", options.pcapFile.c_str());
+            return 2;
+        }
+        printf("Записано кадров: %zu в %s\n", generator.frames().size(), options.pcapFile.c_str());
+        return 0;
+    }
+
+    Workload workload;
+    workload.frames = &generator.frames();
+    workload.bytes = generator.totalBytes();
+    workload.payloadBytes = 0;
+    workload.expectedMessages = generator.expectedMessages().size();
+    workload.decoded.resize(workload.frames->size());
+    for (size_t i = 0; i < workload.frames->size(); i++) {
+        const SyntheticFrame& frame = (*workload.frames)[i];
+        PacketDecoder::decode(frame.data.data(), frame.data.size(), workload.decoded[i]);
+        workload.payloadBytes += workload.decoded[i].payloadLength;
+    }
+    {
+        TCPStreamAssembler assembler([&workload](const StreamKey&, const std::vector<uint8_t>& data) {
+            workload.messages.push_back(data);
+        });
+        for (const DecodedPacket& p : workload.decoded) {
+            if (p.protocol == IP_PROTO_TCP) {
+                assembler.processPacket(p.srcIP, p.dstIP, p.srcPort, p.dstPort,
+                                        p.seqNum, p.payload, p.payloadLength, p.tcpFlags);
+            }
+        }
+    }
+
+    uint64_t frames = workload.frames->size();
+    uint64_t messageBytes = 0;
+    for (const auto& message : workload.messages) {
+        messageBytes += message.size();
+    }
+
+    struct Case {
+        const char* name;
+        uint64_t units;
+        uint64_t bytes;
+        std::function<uint64_t()> body;
+    };
+
+    std::vector<Case> cases = {
+        {"decode", frames, workload.bytes, [&] { return benchDecode(workload); }},
+        {"flow_stats_exact", frames, workload.bytes, [&] { return benchFlowStats(workload, FLOW_STATS_EXACT); }},
+        {"flow_stats_bounded", frames, workload.bytes, [&] { return benchFlowStats(workload, FLOW_STATS_BOUNDED); }},
+        {"assembler", frames, workload.payloadBytes, [&] { return benchAssembler(workload); }},
+        {"http_parse", workload.messages.size(), messageBytes, [&] { return benchHttpParse(workload); }},
+        {"pipeline", frames, workload.bytes, [&] { return benchPipeline(workload); }},
+    };
+
+    std::vector<BenchResult> results;
+    for (const Case& c : cases) {
+        if (!options.only.empty() && options.only != c.name) continue;
+
+        BenchResult result = measure(c.name, options.iterations, c.units, c.bytes, c.body);
+        if (result.name == "assembler" || result.name == "pipeline") {
+            result.expectedMessages = workload.expectedMessages;
+        } else {
+            result.messages = 0;
+        }
+        results.push_back(result);
+    }
+
+    if (!options.json) {
+        printf("Кадров: %llu, байт: %llu, ожидается HTTP-сообщений: %llu\n\n",
+               static_cast<unsigned long long>(frames), static_cast<unsigned long long>(workload.bytes),
+               static_cast<unsigned long long>(workload.expectedMessages));
+    }
+    return reportResults(options, results);
+}
@@ -0,0 +1,624 @@
+#include "golden_corpus.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <filesystem>
+#include <iterator>
+#include <random>
+
+#include "../packet_decoder.h"
+
+namespace {
+
+const uint32_t CLIENT = 0x0A000001;   // 10.0.0.1
+const uint32_t SERVER = 0x0A640001;   // 10.100.0.1
+const uint32_t RESOLVER = 0x0A640035; // 10.100.0.53
+
+void putU16(uint8_t* p, uint16_t value) {
+    p[0] = static_cast<uint8_t>(value >> 8);
+    p[1] = static_cast<uint8_t>(value);
+}
+
+void putU32(uint8_t* p, uint32_t value) {
+    p[0] = static_cast<uint8_t>(value >> 24);
+    p[1] = static_cast<uint8_t>(value >> 16);
+    p[2] = static_cast<uint8_t>(value >> 8);
+    p[3] = static_cast<uint8_t>(value);
+}
+
+// Кадры сценария получают метки с шагом 10 мкс
+void addFrame(GoldenScenario& scenario, std::vector<uint8_t> data) {
+    SyntheticFrame frame;
+    frame.timestampUs = 1000000 + scenario.frames.size() * 10;
+    frame.data = std::move(data);
+    scenario.frames.push_back(std::move(frame));
+}
+
+void addTcp(GoldenScenario& scenario, uint32_t srcIP, uint32_t dstIP, uint16_t srcPort, uint16_t dstPort,
+            uint32_t& seqNum, uint8_t flags, const std::string& payload = std::string()) {
+    addFrame(scenario, TrafficGenerator::buildTcpFrame(
+        srcIP, dstIP, srcPort, dstPort, seqNum, flags,
+        reinterpret_cast<const uint8_t*>(payload.data()), payload.size()));
+    seqNum += static_cast<uint32_t>(payload.size()) + ((flags & (TCP_FLAG_SYN | TCP_FLAG_FIN)) ? 1 : 0);
+}
+
+// Кадр Ethernet/IPv4 с произвольной нагрузкой IP (для UDP и фрагментов)
+std::vector<uint8_t> buildIpv4Frame(uint8_t protocol, uint32_t srcIP, uint32_t dstIP, uint16_t id,
+                                    uint16_t fragment, const uint8_t* payload, size_t length) {
+    std::vector<uint8_t> frame(14 + 20 + length, 0);
+    uint8_t* eth = frame.data();
+    uint8_t* ip = eth + 14;
+    eth[0] = 0x02; eth[5] = 0x01;
+    eth[6] = 0x02; eth[11] = 0x02;
+    putU16(eth + 12, 0x0800);
+
+    ip[0] = 0x45;
+    putU16(ip + 2, static_cast<uint16_t>(20 + length));
+    putU16(ip + 4, id);
+    putU16(ip + 6, fragment);
+    ip[8] = 64;
+    ip[9] = protocol;
+    putU32(ip + 12, srcIP);
+    putU32(ip + 16, dstIP);
+    if (length > 0) {
+        memcpy(ip + 20, payload, length);
+    }
+    return frame;
+}
+
+std::vector<uint8_t> buildUdp(uint16_t srcPort, uint16_t dstPort, const std::vector<uint8_t>& payload) {
+    std::vector<uint8_t> udp(8 + payload.size(), 0);
+    putU16(udp.data(), srcPort);
+    putU16(udp.data() + 2, dstPort);
+    putU16(udp.data() + 4, static_cast<uint16_t>(udp.size()));
+    std::copy(payload.begin(), payload.end(), udp.begin() + 8);
+    return udp;
+}
+
+std::vector<uint8_t> buildDns(uint16_t id, bool response, const char* name, size_t answers) {
+    std::vector<uint8_t> dns(12, 0);
+    putU16(dns.data(), id);
+    putU16(dns.data() + 2, response ? 0x8180 : 0x0100);
+    putU16(dns.data() + 4, 1);
+    putU16(dns.data() + 6, static_cast<uint16_t>(answers));
+
+    // Вопрос: имя метками, тип A, класс IN
+    for (const char* label = name; *label;) {
+        const char* dot = strchr(label, '.');
+        size_t length = dot ? size_t(dot - label) : strlen(label);
+        dns.push_back(static_cast<uint8_t>(length));
+        dns.insert(dns.end(), label, label + length);
+        label += length + (dot ? 1 : 0);
+    }
+    const uint8_t question[] = {0, 0, 1, 0, 1};
+    dns.insert(dns.end(), question, question + sizeof(question));
+
+    // Ответы: ссылка на имя вопроса, A, IN, TTL 300, адрес 192.0.2.N
+    for (size_t i = 0; i < answers; i++) {
+        const uint8_t record[] = {0xc0, 12, 0, 1, 0, 1, 0, 0, 1, 44, 0, 4,
+                                  192, 0, 2, static_cast<uint8_t>(i + 1)};
+        dns.insert(dns.end(), record, record + sizeof(record));
+    }
+    return dns;
+}
+
+GoldenScenario generated(const std::string& name, const TrafficOptions& options) {
+    TrafficGenerator generator(options);
+    generator.generate();
+    return GoldenScenario{name, generator.frames()};
+}
+
+// Несколько запросов в одном сегменте и ответы, разрезанные посреди заголовков
+GoldenScenario pipelined() {
+    GoldenScenario scenario{"pipelined", {}};
+    uint32_t client = 1000;
+    uint32_t server = 5000;
+    addTcp(scenario, CLIENT, SERVER, 40000, 80, client, TCP_FLAG_SYN);
+    addTcp(scenario, SERVER, CLIENT, 80, 40000, server, TCP_FLAG_SYN | TCP_FLAG_ACK);
+
+    std::string requests;
+    std::string responses;
+    for (int i = 0; i < 3; i++) {
+        requests += "GET /pipelined/" + std::to_string(i) + " HTTP/1.1\r\nHost: golden.local\r\n\r\n";
+        std::string body = "body-" + std::to_string(i);
+        responses += "HTTP/1.1 200 OK\r\nContent-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body;
+    }
+    addTcp(scenario, CLIENT, SERVER, 40000, 80, client, TCP_FLAG_PSH | TCP_FLAG_ACK, requests);
+
+    size_t split = responses.find("Content-Length") + 4;
+    addTcp(scenario, SERVER, CLIENT, 80, 40000, server, TCP_FLAG_PSH | TCP_FLAG_ACK, responses.substr(0, split));
+    addTcp(scenario, SERVER, CLIENT, 80, 40000, server, TCP_FLAG_PSH | TCP_FLAG_ACK, responses.substr(split));
+
+    addTcp(scenario, CLIENT, SERVER, 40000, 80, client, TCP_FLAG_FIN | TCP_FLAG_ACK);
+    addTcp(scenario, SERVER, CLIENT, 80, 40000, server, TCP_FLAG_FIN | TCP_FLAG_ACK);
+    return scenario;
+}
+
+// Номера последовательности обеих сторон переходят через 2^32 посреди сообщений
+GoldenScenario wraparound() {
+    GoldenScenario scenario{"seq_wraparound", {}};
+    uint32_t client = 0xffffff00;
+    uint32_t server = 0xfffff800;
+    addTcp(scenario, CLIENT, SERVER, 40001, 80, client, TCP_FLAG_SYN);
+    addTcp(scenario, SERVER, CLIENT, 80, 40001, server, TCP_FLAG_SYN | TCP_FLAG_ACK);
+
+    std::string body(700, 'q');
+    std::string request = "POST /upload HTTP/1.1\r\nHost: golden.local\r\nContent-Length: 700\r\n\r\n" + body;
+    for (size_t pos = 0; pos < request.size(); pos += 200) {
+        addTcp(scenario, CLIENT, SERVER, 40001, 80, client, TCP_FLAG_ACK, request.substr(pos, 200));
+    }
+
+    std::string payload(6000, 'r');
+    std::string response = "HTTP/1.1 201 Created\r\nContent-Length: 6000\r\n\r\n" + payload;
+    for (size_t pos = 0; pos < response.size(); pos += 1460) {
+        addTcp(scenario, SERVER, CLIENT, 80, 40001, server, TCP_FLAG_ACK, response.substr(pos, 1460));
+    }
+    return scenario;
+}
+
+// Сегменты, перешедшие через 2^32, приходят раньше сегментов до перехода
+GoldenScenario wraparoundOutOfOrder() {
+    GoldenScenario scenario{"seq_wraparound_ooo", {}};
+    uint32_t client = 0xffffff80;
+    uint32_t server = 0xfffffa00;
+    addTcp(scenario, CLIENT, SERVER, 40003, 80, client, TCP_FLAG_SYN);
+    addTcp(scenario, SERVER, CLIENT, 80, 40003, server, TCP_FLAG_SYN | TCP_FLAG_ACK);
+
+    // Запрос: 4 сегмента по 100 байт, переход после второго; отправка 3, 2, 1, 0
+    std::string body(300, 'o');
+    std::string request = "POST /wrap-ooo HTTP/1.1\r\nHost: golden.local\r\nContent-Length: 300\r\n\r\n" + body;
+    std::vector<std::pair<uint32_t, std::string>> segments;
+    for (size_t pos = 0; pos < request.size(); pos += 100) {
+        segments.emplace_back(client, request.substr(pos, 100));
+        client += static_cast<uint32_t>(segments.back().second.size());
+    }
+    for (size_t i = segments.size(); i-- > 0;) {
+        uint32_t seq = segments[i].first;
+        addTcp(scenario, CLIENT, SERVER, 40003, 80, seq, TCP_FLAG_ACK, segments[i].second);
+    }
+
+    // Ответ: переход внутри второго сегмента; первым приходит третий
+    std::string payload(3000, 'p');
+    std::string response = "HTTP/1.1 200 OK\r\nContent-Length: 3000\r\n\r\n" + payload;
+    segments.clear();
+    for (size_t pos = 0; pos < response.size(); pos += 1000) {
+        segments.emplace_back(server, response.substr(pos, 1000));
+        server += static_cast<uint32_t>(segments.back().second.size());
+    }
+    for (size_t i : {size_t(2), size_t(0), size_t(3), size_t(1)}) {
+        uint32_t seq = segments[i].first;
+        addTcp(scenario, SERVER, CLIENT, 80, 40003, seq, TCP_FLAG_ACK, segments[i].second);
+    }
+    return scenario;
+}
+
+// Повтор, объединивший уже собранные и потерянные данные (начало раньше
+// ожидаемого номера, конец позже), и повтор со сдвинутыми границами
+GoldenScenario coalescedRetransmit() {
+    GoldenScenario scenario{"coalesced_retransmit", {}};
+    uint32_t client = 7000;
+    uint32_t server = 9000;
+    addTcp(scenario, CLIENT, SERVER, 40004, 80, client, TCP_FLAG_SYN);
+    addTcp(scenario, SERVER, CLIENT, 80, 40004, server, TCP_FLAG_SYN | TCP_FLAG_ACK);
+
+    std::string request = "GET /coalesced HTTP/1.1\r\nHost: golden.local\r\nUser-Agent: golden\r\n"
+                          "Accept: */*\r\n\r\n";
+    std::string parts[4];
+    for (size_t i = 0; i < 4; i++) {
+        parts[i] = request.substr(i * 20, i == 3 ? std::string::npos : 20);
+    }
+    uint32_t seq = client;
+    addTcp(scenario, CLIENT, SERVER, 40004, 80, seq, TCP_FLAG_ACK, parts[0]);
+    addTcp(scenario, CLIENT, SERVER, 40004, 80, seq, TCP_FLAG_ACK, parts[1]);
+    seq += static_cast<uint32_t>(parts[2].size());   // Третий сегмент потерян
+    addTcp(scenario, CLIENT, SERVER, 40004, 80, seq, TCP_FLAG_ACK, parts[3]);
+    seq = client + 20;                                // Повтор второго и третьего одним сегментом
+    addTcp(scenario, CLIENT, SERVER, 40004, 80, seq, TCP_FLAG_ACK, parts[1] + parts[2]);
+
+    std::string payload(2400, 'c');
+    std::string response = "HTTP/1.1 200 OK\r\nContent-Length: 2400\r\n\r\n" + payload;
+    seq = server;
+    addTcp(scenario, SERVER, CLIENT, 80, 40004, seq, TCP_FLAG_ACK, response.substr(0, 1000));
+    // Повтор с середины первого сегмента до середины третьего
+    seq = server + 500;
+    addTcp(scenario, SERVER, CLIENT, 80, 40004, seq, TCP_FLAG_ACK, response.substr(500, 1800));
+    addTcp(scenario, SERVER, CLIENT, 80, 40004, seq, TCP_FLAG_ACK, response.substr(2300));
+    return scenario;
+}
+
+// Hello TLS: ClientHello в двух записях, граница сегментов внутри заголовка
+// записи; ServerHello одной записью, разрезанной после первых трёх байт
+GoldenScenario tlsSplitRecords() {
+    GoldenScenario scenario{"tls_split_records", {}};
+    uint32_t client = 11000;
+    uint32_t server = 12000;
+    addTcp(scenario, CLIENT, SERVER, 40005, 443, client, TCP_FLAG_SYN);
+    addTcp(scenario, SERVER, CLIENT, 443, 40005, server, TCP_FLAG_SYN | TCP_FLAG_ACK);
+
+    auto record = [](const std::vector<uint8_t>& handshake, size_t from, size_t length) {
+        std::string out = {'\x16', '\x03', '\x01', char(length >> 8), char(length & 0xff)};
+        out.append(reinterpret_cast<const char*>(handshake.data()) + from, length);
+        return out;
+    };
+    std::vector<uint8_t> hello = buildTlsHello(true, "split.golden.local");
+    std::string records = record(hello, 0, 50) + record(hello, 50, hello.size() - 50);
+    addTcp(scenario, CLIENT, SERVER, 40005, 443, client, TCP_FLAG_ACK, records.substr(0, 52));
+    addTcp(scenario, CLIENT, SERVER, 40005, 443, client, TCP_FLAG_ACK, records.substr(52, 5));
+    addTcp(scenario, CLIENT, SERVER, 40005, 443, client, TCP_FLAG_ACK | TCP_FLAG_PSH, records.substr(57));
+
+    std::vector<uint8_t> serverHello = buildTlsHello(false, std::string());
+    records = record(serverHello, 0, serverHello.size());
+    addTcp(scenario, SERVER, CLIENT, 443, 40005, server, TCP_FLAG_ACK, records.substr(0, 3));
+    addTcp(scenario, SERVER, CLIENT, 443, 40005, server, TCP_FLAG_ACK | TCP_FLAG_PSH, records.substr(3));
+    return scenario;
+}
+
+// WebSocket после Upgrade: начало первого кадра в одном сегменте с ответом
+// 101, заголовки кадров (длина, маска) разрезаны границами сегментов
+GoldenScenario webSocketSplit() {
+    GoldenScenario scenario{"websocket_split", {}};
+    uint32_t client = 13000;
+    uint32_t server = 14000;
+    addTcp(scenario, CLIENT, SERVER, 40006, 80, client, TCP_FLAG_SYN);
+    addTcp(scenario, SERVER, CLIENT, 80, 40006, server, TCP_FLAG_SYN | TCP_FLAG_ACK);
+
+    addTcp(scenario, CLIENT, SERVER, 40006, 80, client, TCP_FLAG_ACK | TCP_FLAG_PSH,
+           "GET /chat HTTP/1.1\r\nHost: golden.local\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+           "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\nSec-WebSocket-Version: 13\r\n\r\n");
+
+    // Кадр сервера с 16-битной длиной: 101 и первые 3 байта заголовка вместе
+    std::string text(300, 's');
+    std::string frame = {'\x81', char(126), char(text.size() >> 8), char(text.size() & 0xff)};
+    frame += text;
+    std::string upgrade = "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                          "Sec-WebSocket-Accept: s3pPLMBiTxaQ9kYGzzhZRbK+xOo=\r\n\r\n";
+    addTcp(scenario, SERVER, CLIENT, 80, 40006, server, TCP_FLAG_ACK, upgrade + frame.substr(0, 3));
+    addTcp(scenario, SERVER, CLIENT, 80, 40006, server, TCP_FLAG_ACK | TCP_FLAG_PSH, frame.substr(3));
+
+    // Кадр клиента с маской: граница внутри маски, затем внутри данных
+    const char mask[4] = {'\x11', '\x22', '\x33', '\x44'};
+    std::string message = "hello, golden";
+    std::string masked = {'\x81', char(0x80 | message.size())};
+    masked.append(mask, 4);
+    for (size_t i = 0; i < message.size(); i++) {
+        masked += static_cast<char>(message[i] ^ mask[i % 4]);
+    }
+    addTcp(scenario, CLIENT, SERVER, 40006, 80, client, TCP_FLAG_ACK, masked.substr(0, 1));
+    addTcp(scenario, CLIENT, SERVER, 40006, 80, client, TCP_FLAG_ACK, masked.substr(1, 3));
+    addTcp(scenario, CLIENT, SERVER, 40006, 80, client, TCP_FLAG_ACK, masked.substr(4, 6));
+    addTcp(scenario, CLIENT, SERVER, 40006, 80, client, TCP_FLAG_ACK | TCP_FLAG_PSH, masked.substr(10));
+
+    const std::string close = {'\x88', '\x02', '\x03', '\xe8'};
+    addTcp(scenario, SERVER, CLIENT, 80, 40006, server, TCP_FLAG_ACK | TCP_FLAG_PSH, close);
+    return scenario;
+}
+
+// Кадр HTTP/2: 9 байт заголовка и данные
+std::string http2Frame(uint8_t type, uint8_t flags, uint32_t stream, const std::vector<uint8_t>& payload) {
+    std::string frame = {char(payload.size() >> 16), char((payload.size() >> 8) & 0xff), char(payload.size() & 0xff),
+                         char(type), char(flags), char((stream >> 24) & 0x7f), char((stream >> 16) & 0xff),
+                         char((stream >> 8) & 0xff), char(stream & 0xff)};
+    frame.append(payload.begin(), payload.end());
+    return frame;
+}
+
+std::vector<uint8_t> hexBytes(const char* hex) {
+    std::vector<uint8_t> bytes;
+    for (const char* p = hex; p[0] && p[1]; p += 2) {
+        unsigned value = 0;
+        sscanf(p, "%2x", &value);
+        bytes.push_back(static_cast<uint8_t>(value));
+    }
+    return bytes;
+}
+
+// h2c с prior knowledge: запросы - блоки RFC 7541 C.4 (Хаффман, общая
+// динамическая таблица), ответы - блоки C.6; кадры разрезаны сегментами
+GoldenScenario http2Hpack() {
+    GoldenScenario scenario{"http2_hpack", {}};
+    uint32_t client = 15000;
+    uint32_t server = 16000;
+    addTcp(scenario, CLIENT, SERVER, 40007, 80, client, TCP_FLAG_SYN);
+    addTcp(scenario, SERVER, CLIENT, 80, 40007, server, TCP_FLAG_SYN | TCP_FLAG_ACK);
+
+    const uint8_t END_STREAM = 0x1;
+    const uint8_t END_HEADERS = 0x4;
+    std::string requests = "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n" + http2Frame(H2_SETTINGS, 0, 0, {});
+    requests += http2Frame(H2_HEADERS, END_STREAM | END_HEADERS, 1, hexBytes("828684418cf1e3c2e5f23a6ba0ab90f4ff"));
+    requests += http2Frame(H2_HEADERS, END_STREAM | END_HEADERS, 3, hexBytes("828684be5886a8eb10649cbf"));
+    requests += http2Frame(H2_HEADERS, END_STREAM | END_HEADERS, 5,
+                           hexBytes("828785bf408825a849e95ba97d7f8925a849e95bb8e8b4bf"));
+    for (size_t pos = 0; pos < requests.size(); pos += 29) {
+        addTcp(scenario, CLIENT, SERVER, 40007, 80, client, TCP_FLAG_ACK, requests.substr(pos, 29));
+    }
+
+    std::string responses = http2Frame(H2_SETTINGS, 0, 0, {});
+    responses += http2Frame(H2_HEADERS, END_HEADERS, 1, hexBytes(
+        "488264025885aec3771a4b6196d07abe941054d444a8200595040b8166e082a62d1bff6e919d29ad171863c78f0b"
+        "97c8e9ae82ae43d3"));
+    std::string body = "moved to www.example.com";
+    responses += http2Frame(H2_DATA, END_STREAM, 1, std::vector<uint8_t>(body.begin(), body.end()));
+    responses += http2Frame(H2_HEADERS, END_STREAM | END_HEADERS, 3, hexBytes("4883640effc1c0bf"));
+    responses += http2Frame(H2_HEADERS, END_STREAM | END_HEADERS, 5, hexBytes(
+        "88c16196d07abe941054d444a8200595040b8166e084a62d1bffc05a839bd9ab77ad94e7821dd7f2e6c7b335dfdf"
+        "cd5b3960d5af27087f3672c1ab270fb5291f9587316065c003ed4ee5b1063d5007"));
+    for (size_t pos = 0; pos < responses.size(); pos += 40) {
+        addTcp(scenario, SERVER, CLIENT, 80, 40007, server, TCP_FLAG_ACK, responses.substr(pos, 40));
+    }
+    return scenario;
+}
+
+// DNS: цепочка CNAME со ссылками сжатия на вопрос и на данные другой записи
+GoldenScenario dnsCompression() {
+    GoldenScenario scenario{"dns_compression", {}};
+    std::vector<uint8_t> query = buildUdp(53002, 53, buildDns(0x4321, false, "www.golden.example", 0));
+    addFrame(scenario, buildIpv4Frame(IP_PROTO_UDP, CLIENT, RESOLVER, 2, 0, query.data(), query.size()));
+
+    std::vector<uint8_t> dns = buildDns(0x4321, true, "www.golden.example", 0);
+    putU16(dns.data() + 6, 3);
+    const uint8_t question = 12;
+    const uint8_t cname[] = {0xc0, question, 0, 5, 0, 1, 0, 0, 0, 60, 0, 6, 3, 'c', 'd', 'n', 0xc0, question + 4};
+    const uint8_t cnameData = static_cast<uint8_t>(dns.size() + 12);
+    dns.insert(dns.end(), cname, cname + sizeof(cname));
+    for (uint8_t last : {uint8_t(7), uint8_t(8)}) {
+        const uint8_t address[] = {0xc0, cnameData, 0, 1, 0, 1, 0, 0, 0, 60, 0, 4, 192, 0, 2, last};
+        dns.insert(dns.end(), address, address + sizeof(address));
+    }
+    std::vector<uint8_t> response = buildUdp(53, 53002, dns);
+    addFrame(scenario, buildIpv4Frame(IP_PROTO_UDP, RESOLVER, CLIENT, 3, 0, response.data(), response.size()));
+    return scenario;
+}
+
+// Фрагменты IP: последний первым, средний дважды, первый перекрывает средний
+// теми же данными - датаграмма собирается один раз
+GoldenScenario ipFragmentsOverlap() {
+    GoldenScenario scenario{"ip_fragments_overlap", {}};
+    std::vector<uint8_t> query = buildUdp(53003, 53, buildDns(0x5678, false, "overlap.example", 0));
+    addFrame(scenario, buildIpv4Frame(IP_PROTO_UDP, CLIENT, RESOLVER, 4, 0, query.data(), query.size()));
+
+    std::vector<uint8_t> response = buildUdp(53, 53003, buildDns(0x5678, true, "overlap.example", 30));
+    const uint16_t MORE = 0x2000;
+    addFrame(scenario, buildIpv4Frame(IP_PROTO_UDP, RESOLVER, CLIENT, 9, 400 / 8,
+                                      response.data() + 400, response.size() - 400));
+    for (int copy = 0; copy < 2; copy++) {
+        addFrame(scenario, buildIpv4Frame(IP_PROTO_UDP, RESOLVER, CLIENT, 9, MORE | (200 / 8),
+                                          response.data() + 200, 200));
+    }
+    addFrame(scenario, buildIpv4Frame(IP_PROTO_UDP, RESOLVER, CLIENT, 9, MORE, response.data(), 296));
+    return scenario;
+}
+
+// DNS: запрос и большой ответ, пришедший двумя фрагментами IP в обратном порядке
+GoldenScenario dnsFragments() {
+    GoldenScenario scenario{"dns_ip_fragments", {}};
+    std::vector<uint8_t> query = buildUdp(53001, 53, buildDns(0x1234, false, "golden.example", 0));
+    addFrame(scenario, buildIpv4Frame(IP_PROTO_UDP, CLIENT, RESOLVER, 1, 0, query.data(), query.size()));
+
+    std::vector<uint8_t> response = buildUdp(53, 53001, buildDns(0x1234, true, "golden.example", 40));
+    const size_t split = 256;
+    addFrame(scenario, buildIpv4Frame(IP_PROTO_UDP, RESOLVER, CLIENT, 7, split / 8,
+                                      response.data() + split, response.size() - split));
+    addFrame(scenario, buildIpv4Frame(IP_PROTO_UDP, RESOLVER, CLIENT, 7, 0x2000, response.data(), split));
+    return scenario;
+}
+
+// Трафик с меткой 802.1Q: разборщик пропускает метку и собирает те же сообщения
+GoldenScenario vlan() {
+    TrafficOptions options;
+    options.flows = 2;
+    options.requestsPerFlow = 2;
+    options.bodySize = 512;
+    GoldenScenario scenario = generated("vlan", options);
+    for (SyntheticFrame& frame : scenario.frames) {
+        const uint8_t tag[] = {0x81, 0x00, 0x00, 0x64};
+        frame.data.insert(frame.data.begin() + 12, tag, tag + sizeof(tag));
+    }
+    return scenario;
+}
+
+template <typename T>
+T readValue(const uint8_t* p, bool swapped) {
+    T value;
+    memcpy(&value, p, sizeof(T));
+    if (swapped) {
+        uint8_t bytes[sizeof(T)];
+        memcpy(bytes, &value, sizeof(T));
+        std::reverse(bytes, bytes + sizeof(T));
+        memcpy(&value, bytes, sizeof(T));
+    }
+    return value;
+}
+
+} // namespace
+
+std::vector<uint8_t> buildTlsHello(bool client, const std::string& serverName) {
+    std::vector<uint8_t> body = {0x03, 0x03};
+    for (uint8_t i = 0; i < 32; i++) {
+        body.push_back(static_cast<uint8_t>(i * 7 + (client ? 1 : 2)));   // random
+    }
+    body.push_back(32);                                                  // session_id
+    body.insert(body.end(), 32, 0x5a);
+
+    std::vector<uint8_t> extensions;
+    auto extension = [&extensions](uint16_t type, const std::vector<uint8_t>& data) {
+        const uint8_t header[] = {uint8_t(type >> 8), uint8_t(type), uint8_t(data.size() >> 8), uint8_t(data.size())};
+        extensions.insert(extensions.end(), header, header + sizeof(header));
+        extensions.insert(extensions.end(), data.begin(), data.end());
+    };
+
+    if (client) {
+        const uint8_t suites[] = {0, 6, 0x13, 0x01, 0x13, 0x02, 0xc0, 0x2f, 1, 0};
+        body.insert(body.end(), suites, suites + sizeof(suites));
+
+        std::vector<uint8_t> sni = {uint8_t((serverName.size() + 3) >> 8), uint8_t(serverName.size() + 3), 0,
+                                    uint8_t(serverName.size() >> 8), uint8_t(serverName.size())};
+        sni.insert(sni.end(), serverName.begin(), serverName.end());
+        extension(0, sni);
+        extension(16, {0, 12, 2, 'h', '2', 8, 'h', 't', 't', 'p', '/', '1', '.', '1'});
+        extension(43, {6, 0x5a, 0x5a, 0x03, 0x04, 0x03, 0x03});   // GREASE, 1.3, 1.2
+    } else {
+        const uint8_t suite[] = {0x13, 0x01, 0};
+        body.insert(body.end(), suite, suite + sizeof(suite));
+        extension(43, {0x03, 0x04});
+    }
+    body.push_back(static_cast<uint8_t>(extensions.size() >> 8));
+    body.push_back(static_cast<uint8_t>(extensions.size()));
+    body.insert(body.end(), extensions.begin(), extensions.end());
+
+    std::vector<uint8_t> handshake = {static_cast<uint8_t>(client ? 1 : 2), uint8_t(body.size() >> 16),
+                                      uint8_t(body.size() >> 8), uint8_t(body.size())};
+    handshake.insert(handshake.end(), body.begin(), body.end());
+    return handshake;
+}
+
+std::vector<GoldenScenario> buildGoldenCorpus() {
+    std::vector<GoldenScenario> corpus;
+
+    TrafficOptions options;
+    options.flows = 6;
+    options.requestsPerFlow = 4;
+    options.bodySize = 5000;
+    options.seed = 11;
+    options.outOfOrderRate = 0.3;
+    corpus.push_back(generated("out_of_order", options));
+
+    options.outOfOrderRate = 0;
+    options.retransmitRate = 0.2;
+    options.seed = 12;
+    corpus.push_back(generated("retransmit", options));
+
+    options.retransmitRate = 0;
+    options.chunked = true;
+    options.chunkSize = 700;
+    options.seed = 13;
+    corpus.push_back(generated("chunked", options));
+
+    corpus.push_back(pipelined());
+    corpus.push_back(wraparound());
+    corpus.push_back(wraparoundOutOfOrder());
+    corpus.push_back(coalescedRetransmit());
+    corpus.push_back(tlsSplitRecords());
+    corpus.push_back(webSocketSplit());
+    corpus.push_back(http2Hpack());
+    corpus.push_back(dnsFragments());
+    corpus.push_back(dnsCompression());
+    corpus.push_back(ipFragmentsOverlap());
+    corpus.push_back(vlan());
+    return corpus;
+}
+
+bool loadPcap(const std::string& fileName, std::vector<SyntheticFrame>& frames, std::string& error) {
+    std::ifstream in(fileName, std::ios::binary);
+    if (!in) {
+        error = "не удалось открыть " + fileName;
+        return false;
+    }
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    if (data.size() < 24) {
+        error = "файл короче заголовка pcap";
+        return false;
+    }
+
+    uint32_t magic = readValue<uint32_t>(data.data(), false);
+    bool swapped = magic == 0xd4c3b2a1 || magic == 0x4d3cb2a1;
+    bool nanoseconds = magic == 0xa1b23c4d || magic == 0x4d3cb2a1;
+    if (!swapped && magic != 0xa1b2c3d4 && !nanoseconds) {
+        error = "не формат pcap (pcapng не поддерживается)";
+        return false;
+    }
+    uint32_t linkType = readValue<uint32_t>(data.data() + 20, swapped);
+    if (linkType != 1) {
+        error = "поддерживается только Ethernet (тип канала " + std::to_string(linkType) + ")";
+        return false;
+    }
+
+    frames.clear();
+    size_t pos = 24;
+    while (pos + 16 <= data.size()) {
+        uint32_t seconds = readValue<uint32_t>(data.data() + pos, swapped);
+        uint32_t fraction = readValue<uint32_t>(data.data() + pos + 4, swapped);
+        uint32_t caplen = readValue<uint32_t>(data.data() + pos + 8, swapped);
+        pos += 16;
+        if (caplen > data.size() - pos) {
+            error = "обрезанная запись в конце файла";
+            return false;
+        }
+
+        SyntheticFrame frame;
+        frame.timestampUs = uint64_t(seconds) * 1000000 + (nanoseconds ? fraction / 1000 : fraction);
+        frame.data.assign(data.begin() + pos, data.begin() + pos + caplen);
+        frames.push_back(std::move(frame));
+        pos += caplen;
+    }
+    return true;
+}
+
+std::string writeGoldenPcap(const GoldenScenario& scenario) {
+    std::random_device random;
+    std::filesystem::path file = std::filesystem::temp_directory_path() /
+        ("sniffer-golden-" + scenario.name + "-" + std::to_string(random()) + ".pcap");
+    return TrafficGenerator::writePcap(file.string(), scenario.frames) ? file.string() : std::string();
+}
+
+std::vector<std::string> goldenLines(const OfflineResult& result) {
+    char summary[256];
+    snprintf(summary, sizeof(summary),
+             "frames=%llu decoded=%llu undecoded=%llu tcp=%llu udp=%llu fragments=%llu reassembled=%llu "
+             "truncated=%d events=%zu",
+             static_cast<unsigned long long>(result.frames), static_cast<unsigned long long>(result.decoded),
+             static_cast<unsigned long long>(result.undecoded), static_cast<unsigned long long>(result.tcpPackets),
+             static_cast<unsigned long long>(result.udpPackets), static_cast<unsigned long long>(result.fragments),
+             static_cast<unsigned long long>(result.reassembled), result.truncated ? 1 : 0, result.events.size());
+    std::vector<std::string> lines(1, summary);
+    lines.reserve(result.events.size() + 1);
+    for (const OfflineEvent& event : result.events) {
+        lines.push_back(OfflineAnalyzer::formatEvent(event));
+    }
+    return lines;
+}
+
+bool runGolden(const std::string& pcapFile, unsigned threads, std::vector<std::string>& lines, std::string& error) {
+    OfflineOptions options;
+    options.threads = threads;
+    OfflineResult result;
+    if (!OfflineAnalyzer(options).analyze(pcapFile, result)) {
+        error = result.error;
+        return false;
+    }
+    lines = goldenLines(result);
+    return true;
+}
+
+bool compareGolden(const std::vector<std::string>& actual, const std::vector<std::string>& expected,
+                   std::string& difference) {
+    size_t count = std::max(actual.size(), expected.size());
+    for (size_t i = 0; i < count; i++) {
+        const std::string& got = i < actual.size() ? actual[i] : std::string("(нет строки)");
+        const std::string& want = i < expected.size() ? expected[i] : std::string("(нет строки)");
+        if (got != want) {
+            difference = "строка " + std::to_string(i + 1) + ":\n  эталон: " + want + "\n  сейчас: " + got;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool readGoldenFile(const std::string& fileName, std::vector<std::string>& lines) {
+    std::ifstream in(fileName);
+    if (!in) return false;
+    lines.clear();
+    std::string line;
+    while (std::getline(in, line)) {
+        lines.push_back(line);
+    }
+    return true;
+}
+
+bool writeGoldenFile(const std::string& fileName, const std::vector<std::string>& lines) {
+    std::ofstream out(fileName);
+    for (const std::string& line : lines) {
+        out << line << "\n";
+    }
+    return static_cast<bool>(out);
+}
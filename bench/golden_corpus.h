@@ -0,0 +1,50 @@
+#ifndef GOLDEN_CORPUS_H
+#define GOLDEN_CORPUS_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "traffic_generator.h"
+#include "../offline_analyzer.h"
+
+// Набор кадров для проверки результата разбора
+struct GoldenScenario {
+    std::string name;
+    std::vector<SyntheticFrame> frames;
+};
+
+// Эталонные сценарии: детерминированный трафик с тем, что чаще всего
+// ломает сборку (перестановки, повторы, chunked, конвейер запросов,
+// переход номера последовательности через 2^32, фрагменты IP, DNS, VLAN)
+std::vector<GoldenScenario> buildGoldenCorpus();
+
+// Сообщение рукопожатия TLS (без заголовка записи): ClientHello с SNI,
+// ALPN h2 и http/1.1 и версиями 1.3/1.2 или ServerHello TLS 1.3
+std::vector<uint8_t> buildTlsHello(bool client, const std::string& serverName);
+
+// Чтение файла pcap (Ethernet, микро- или наносекундные метки, любой
+// порядок байт); false - файл не прочитан, причина в error
+bool loadPcap(const std::string& fileName, std::vector<SyntheticFrame>& frames, std::string& error);
+
+// Кадры сценария во временном файле pcap (удаляет вызывающий);
+// пустая строка - файл не записан
+std::string writeGoldenPcap(const GoldenScenario& scenario);
+
+// Разбор файла через OfflineAnalyzer - общий путь разбора (заголовки, сборка
+// фрагментов, сборка TCP, HTTP/WebSocket/TLS/HTTP2, DNS); threads - как в
+// OfflineOptions. Результат - текст: строка итогов и по строке на событие
+bool runGolden(const std::string& pcapFile, unsigned threads, std::vector<std::string>& lines, std::string& error);
+
+// Итоги и события разбора текстом (эталоны, сравнение прогонов)
+std::vector<std::string> goldenLines(const OfflineResult& result);
+
+// Сравнение с эталоном; false - есть расхождения, первое описано в difference
+bool compareGolden(const std::vector<std::string>& actual, const std::vector<std::string>& expected,
+                   std::string& difference);
+
+bool readGoldenFile(const std::string& fileName, std::vector<std::string>& lines);
+bool writeGoldenFile(const std::string& fileName, const std::vector<std::string>& lines);
+
+#endif // GOLDEN_CORPUS_H
@@ -0,0 +1,314 @@
+#include "parser_checks.h"
+#include <cstdio>
+#include <cstring>
+
+#include "golden_corpus.h"
+#include "../hpack.h"
+#include "../dns_parser.h"
+#include "../tls_sniffer.h"
+#include "../websocket_parser.h"
+
+namespace {
+
+std::vector<uint8_t> fromHex(const char* hex) {
+    std::vector<uint8_t> bytes;
+    for (const char* p = hex; p[0] && p[1]; p += 2) {
+        unsigned value = 0;
+        sscanf(p, "%2x", &value);
+        bytes.push_back(static_cast<uint8_t>(value));
+    }
+    return bytes;
+}
+
+struct Checks {
+    size_t count = 0;
+    std::vector<std::string>& failures;
+
+    explicit Checks(std::vector<std::string>& failures) : failures(failures) {}
+
+    void expect(bool ok, const std::string& what) {
+        count++;
+        if (!ok) failures.push_back(what);
+    }
+};
+
+// ------------------ HPACK (RFC 7541, приложение C) ------------------
+
+struct HpackVector {
+    const char* name;
+    const char* block;
+    const char* headers;    // "имя: значение" через \n
+    size_t tableSize;       // Размер динамической таблицы после блока
+};
+
+// C.2 - отдельные представления, C.3/C.4 - запросы без Хаффмана и с ним,
+// C.5/C.6 - ответы с вытеснением из таблицы в 256 байт. Таблица уменьшается
+// до 256 обновлением размера в начале первого блока (3fe101): в RFC этот
+// размер задан SETTINGS, которых здесь нет
+const HpackVector C2[] = {
+    {"C.2.1", "400a637573746f6d2d6b65790d637573746f6d2d686561646572", "custom-key: custom-header\n", 55},
+};
+const HpackVector C2_2[] = {
+    {"C.2.2", "040c2f73616d706c652f70617468", ":path: /sample/path\n", 0},
+};
+const HpackVector C2_3[] = {
+    {"C.2.3", "100870617373776f726406736563726574", "password: secret\n", 0},
+};
+const HpackVector C2_4[] = {
+    {"C.2.4", "82", ":method: GET\n", 0},
+};
+
+const HpackVector C3[] = {
+    {"C.3.1", "828684410f7777772e6578616d706c652e636f6d",
+     ":method: GET\n:scheme: http\n:path: /\n:authority: www.example.com\n", 57},
+    {"C.3.2", "828684be58086e6f2d6361636865",
+     ":method: GET\n:scheme: http\n:path: /\n:authority: www.example.com\ncache-control: no-cache\n", 110},
+    {"C.3.3", "828785bf400a637573746f6d2d6b65790c637573746f6d2d76616c7565",
+     ":method: GET\n:scheme: https\n:path: /index.html\n:authority: www.example.com\ncustom-key: custom-value\n",
+     164},
+};
+
+const HpackVector C4[] = {
+    {"C.4.1", "828684418cf1e3c2e5f23a6ba0ab90f4ff",
+     ":method: GET\n:scheme: http\n:path: /\n:authority: www.example.com\n", 57},
+    {"C.4.2", "828684be5886a8eb10649cbf",
+     ":method: GET\n:scheme: http\n:path: /\n:authority: www.example.com\ncache-control: no-cache\n", 110},
+    {"C.4.3", "828785bf408825a849e95ba97d7f8925a849e95bb8e8b4bf",
+     ":method: GET\n:scheme: https\n:path: /index.html\n:authority: www.example.com\ncustom-key: custom-value\n",
+     164},
+};
+
+const HpackVector C5[] = {
+    {"C.5.1",
+     "3fe101"
+     "4803333032580770726976617465611d4d6f6e2c203231204f637420323031332032303a31333a323120474d54"
+     "6e1768747470733a2f2f7777772e6578616d706c652e636f6d",
+     ":status: 302\ncache-control: private\ndate: Mon, 21 Oct 2013 20:13:21 GMT\n"
+     "location: https://www.example.com\n", 222},
+    {"C.5.2", "4803333037c1c0bf",
+     ":status: 307\ncache-control: private\ndate: Mon, 21 Oct 2013 20:13:21 GMT\n"
+     "location: https://www.example.com\n", 222},
+    {"C.5.3",
+     "88c1611d4d6f6e2c203231204f637420323031332032303a31333a323220474d54c05a04677a69707738666f6f3d"
+     "4153444a4b48514b425a584f5157454f50495541585157454f49553b206d61782d6167653d333630303b207665"
+     "7273696f6e3d31",
+     ":status: 200\ncache-control: private\ndate: Mon, 21 Oct 2013 20:13:22 GMT\n"
+     "location: https://www.example.com\ncontent-encoding: gzip\n"
+     "set-cookie: foo=ASDJKHQKBZXOQWEOPIUAXQWEOIU; max-age=3600; version=1\n", 215},
+};
+
+const HpackVector C6[] = {
+    {"C.6.1",
+     "3fe101"
+     "488264025885aec3771a4b6196d07abe941054d444a8200595040b8166e082a62d1bff6e919d29ad171863c78f0b"
+     "97c8e9ae82ae43d3",
+     ":status: 302\ncache-control: private\ndate: Mon, 21 Oct 2013 20:13:21 GMT\n"
+     "location: https://www.example.com\n", 222},
+    {"C.6.2", "4883640effc1c0bf",
+     ":status: 307\ncache-control: private\ndate: Mon, 21 Oct 2013 20:13:21 GMT\n"
+     "location: https://www.example.com\n", 222},
+    {"C.6.3",
+     "88c16196d07abe941054d444a8200595040b8166e084a62d1bffc05a839bd9ab77ad94e7821dd7f2e6c7b335dfdf"
+     "cd5b3960d5af27087f3672c1ab270fb5291f9587316065c003ed4ee5b1063d5007",
+     ":status: 200\ncache-control: private\ndate: Mon, 21 Oct 2013 20:13:22 GMT\n"
+     "location: https://www.example.com\ncontent-encoding: gzip\n"
+     "set-cookie: foo=ASDJKHQKBZXOQWEOPIUAXQWEOIU; max-age=3600; version=1\n", 215},
+};
+
+// Блоки одной последовательности декодируются одним декодером по порядку
+template <size_t N>
+void checkHpack(Checks& checks, const HpackVector (&vectors)[N]) {
+    HpackDecoder decoder;
+    std::vector<HpackHeader> headers;
+    for (const HpackVector& vector : vectors) {
+        std::vector<uint8_t> block = fromHex(vector.block);
+        size_t count = 0;
+        bool ok = decoder.decode(block.data(), block.size(), headers, count);
+
+        std::string text;
+        for (size_t i = 0; ok && i < count; i++) {
+            text += headers[i].name + ": " + headers[i].value + "\n";
+        }
+        checks.expect(ok, std::string("HPACK ") + vector.name + ": блок не декодирован");
+        checks.expect(text == vector.headers,
+                      std::string("HPACK ") + vector.name + ": заголовки\n" + text + "вместо\n" + vector.headers);
+        checks.expect(decoder.tableSize() == vector.tableSize,
+                      std::string("HPACK ") + vector.name + ": размер таблицы " +
+                      std::to_string(decoder.tableSize()) + " вместо " + std::to_string(vector.tableSize));
+    }
+}
+
+void checkHpackErrors(Checks& checks) {
+    HpackDecoder decoder;
+    std::vector<HpackHeader> headers;
+    size_t count = 0;
+
+    // Индекс за пределами пустой динамической таблицы
+    std::vector<uint8_t> block = fromHex("be");
+    checks.expect(!decoder.decode(block.data(), block.size(), headers, count), "HPACK: индекс 62 в пустой таблице");
+
+    // Обрезанная строка и дополнение Хаффмана длиннее 7 бит (RFC 7541, 5.2)
+    HpackDecoder truncated;
+    block = fromHex("400a6375");
+    checks.expect(!truncated.decode(block.data(), block.size(), headers, count), "HPACK: обрезанная строка");
+    std::string out;
+    block = fromHex("ffff");
+    checks.expect(!HpackDecoder::decodeHuffman(block.data(), block.size(), out), "Хаффман: дополнение из 16 единиц");
+}
+
+// ------------------ DNS ------------------
+
+void putName(std::vector<uint8_t>& dns, const char* name) {
+    for (const char* label = name; *label;) {
+        const char* dot = strchr(label, '.');
+        size_t length = dot ? size_t(dot - label) : strlen(label);
+        dns.push_back(static_cast<uint8_t>(length));
+        dns.insert(dns.end(), label, label + length);
+        label += length + (dot ? 1 : 0);
+    }
+}
+
+void checkDnsCompression(Checks& checks) {
+    // Ответ: www.golden.example CNAME cdn.<ссылка на golden.example>,
+    // cdn... A 192.0.2.7 с именем-ссылкой на данные CNAME
+    std::vector<uint8_t> dns = fromHex("abcd81800001000200000000");
+    const size_t question = dns.size();
+    putName(dns, "www.golden.example");
+    dns.push_back(0);
+    const uint8_t tail[] = {0, 1, 0, 1};
+    dns.insert(dns.end(), tail, tail + sizeof(tail));
+
+    const uint8_t cnameHead[] = {0xc0, uint8_t(question), 0, 5, 0, 1, 0, 0, 0, 60, 0, 6};
+    dns.insert(dns.end(), cnameHead, cnameHead + sizeof(cnameHead));
+    const size_t cnameData = dns.size();
+    const uint8_t cname[] = {3, 'c', 'd', 'n', 0xc0, uint8_t(question + 4)};
+    dns.insert(dns.end(), cname, cname + sizeof(cname));
+    const uint8_t address[] = {0xc0, uint8_t(cnameData), 0, 1, 0, 1, 0, 0, 0, 60, 0, 4, 192, 0, 2, 7};
+    dns.insert(dns.end(), address, address + sizeof(address));
+
+    DnsMessage message;
+    bool parsed = DnsParser::parse(dns.data(), dns.size(), message);
+    checks.expect(parsed && message.answerCount == 2, "DNS: ответ со сжатыми именами не разобран");
+    if (!parsed) return;
+
+    std::string answers;
+    size_t offset = message.answersOffset;
+    DnsRecord record;
+    char name[DnsParser::MAX_NAME_LENGTH];
+    char data[DnsParser::MAX_NAME_LENGTH + 32];
+    while (DnsParser::readRecord(message, offset, record)) {
+        DnsParser::readName(message, record.name, name, sizeof(name));
+        DnsParser::formatData(message, record, data, sizeof(data));
+        answers += std::string(name) + " " + DnsParser::typeName(record.type) + " " + data + "\n";
+    }
+    const char* expected = "www.golden.example CNAME cdn.golden.example\ncdn.golden.example A 192.0.2.7\n";
+    checks.expect(answers == expected, "DNS: сжатые имена\n" + answers + "вместо\n" + expected);
+
+    // Ссылка на себя и ссылка вперёд - не зацикливаться и не читать за пределы
+    std::vector<uint8_t> loop = dns;
+    loop[cnameData + 4] = 0xc0;
+    loop[cnameData + 5] = uint8_t(cnameData + 4);
+    DnsMessage looped;
+    bool ok = DnsParser::parse(loop.data(), loop.size(), looped) &&
+              DnsParser::readName(looped, cnameData, name, sizeof(name));
+    checks.expect(!ok, "DNS: ссылка сжатия на себя принята");
+
+    loop[cnameData + 5] = uint8_t(loop.size() - 1);
+    ok = DnsParser::parse(loop.data(), loop.size(), looped) &&
+         DnsParser::readName(looped, cnameData, name, sizeof(name));
+    checks.expect(!ok, "DNS: ссылка сжатия вперёд принята");
+}
+
+// ------------------ TLS ------------------
+
+// Запись Handshake с частью сообщения
+void appendRecord(std::vector<uint8_t>& out, const uint8_t* data, size_t size) {
+    const uint8_t header[] = {0x16, 0x03, 0x01, uint8_t(size >> 8), uint8_t(size)};
+    out.insert(out.end(), header, header + sizeof(header));
+    out.insert(out.end(), data, data + size);
+}
+
+void checkTlsRecords(Checks& checks) {
+    std::vector<uint8_t> handshake = buildTlsHello(true, "split.golden.local");
+
+    // ClientHello в трёх записях; до последнего байта - "нужно ещё"
+    std::vector<uint8_t> records;
+    appendRecord(records, handshake.data(), 3);
+    appendRecord(records, handshake.data() + 3, 60);
+    appendRecord(records, handshake.data() + 63, handshake.size() - 63);
+
+    TlsHello hello;
+    bool waiting = true;
+    for (size_t size = 0; size < records.size(); size++) {
+        waiting = waiting && TlsSniffer::parseHello(records.data(), size, hello) == TLS_NEED_MORE;
+    }
+    checks.expect(waiting, "TLS: неполные записи ClientHello не распознаны как неполные");
+
+    TlsSniffResult result = TlsSniffer::parseHello(records.data(), records.size(), hello);
+    checks.expect(result == TLS_HELLO && hello.client && hello.serverName == "split.golden.local" &&
+                  hello.version == 0x0304 && hello.alpn.size() == 2 && hello.offeredCipherSuites == 3,
+                  "TLS: ClientHello из трёх записей разобран неверно (SNI " + hello.serverName + ")");
+
+    handshake = buildTlsHello(false, std::string());
+    records.clear();
+    appendRecord(records, handshake.data(), handshake.size());
+    result = TlsSniffer::parseHello(records.data(), records.size(), hello);
+    checks.expect(result == TLS_HELLO && !hello.client && hello.version == 0x0304 && hello.cipherSuite == 0x1301,
+                  "TLS: ServerHello разобран неверно");
+
+    // Запись другого типа (Application Data) - не рукопожатие
+    records[0] = 0x17;
+    checks.expect(TlsSniffer::parseHello(records.data(), records.size(), hello) == TLS_NOT_HANDSHAKE,
+                  "TLS: Application Data принята за рукопожатие");
+}
+
+// ------------------ WebSocket ------------------
+
+void checkWebSocketSplit(Checks& checks) {
+    // Кадр клиента с маской и 16-битной длиной, затем короткий кадр сервера
+    std::string text(300, 'w');
+    for (size_t i = 0; i < text.size(); i++) {
+        text[i] = static_cast<char>('a' + i % 26);
+    }
+    const uint8_t mask[4] = {0x37, 0xfa, 0x21, 0x3d};
+    std::vector<uint8_t> stream = {0x81, 0x80 | 126, uint8_t(text.size() >> 8), uint8_t(text.size())};
+    stream.insert(stream.end(), mask, mask + 4);
+    for (size_t i = 0; i < text.size(); i++) {
+        stream.push_back(static_cast<uint8_t>(text[i]) ^ mask[i % 4]);
+    }
+    const uint8_t close[] = {0x88, 0x02, 0x03, 0xe8};
+    stream.insert(stream.end(), close, close + sizeof(close));
+
+    // По байту: каждая граница внутри заголовка, длины и маски
+    WebSocketFrameParser parser(1024);
+    std::vector<WebSocketFrame> frames;
+    bool ok = true;
+    for (uint8_t byte : stream) {
+        ok = ok && parser.feed(&byte, 1, [&](const WebSocketFrame& frame) { frames.push_back(frame); });
+    }
+    checks.expect(ok && frames.size() == 2, "WebSocket: кадры, переданные по байту, не собраны");
+    if (frames.size() != 2) return;
+    checks.expect(frames[0].opcode == WS_TEXT && frames[0].fin && frames[0].masked &&
+                  frames[0].length == text.size() && frames[0].payload == text,
+                  "WebSocket: данные кадра с маской после разрезания заголовка");
+    checks.expect(frames[1].opcode == WS_CLOSE && frames[1].length == 2, "WebSocket: кадр Close");
+}
+
+} // namespace
+
+size_t runParserChecks(std::vector<std::string>& failures) {
+    Checks checks(failures);
+    checkHpack(checks, C2);
+    checkHpack(checks, C2_2);
+    checkHpack(checks, C2_3);
+    checkHpack(checks, C2_4);
+    checkHpack(checks, C3);
+    checkHpack(checks, C4);
+    checkHpack(checks, C5);
+    checkHpack(checks, C6);
+    checkHpackErrors(checks);
+    checkDnsCompression(checks);
+    checkTlsRecords(checks);
+    checkWebSocketSplit(checks);
+    return checks.count;
+}
@@ -0,0 +1,15 @@
+#ifndef PARSER_CHECKS_H
+#define PARSER_CHECKS_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Проверки отдельных разборщиков на известных данных, без сборки потоков:
+// векторы RFC 7541 (приложение C) для HPACK и Хаффмана, сжатие имён DNS
+// и ссылки-циклы, Hello TLS из нескольких записей, пришедший по байту,
+// кадры WebSocket, разрезанные внутри заголовка. Возвращает число
+// проверок; описание каждой ошибки - в failures
+size_t runParserChecks(std::vector<std::string>& failures);
+
+#endif // PARSER_CHECKS_H
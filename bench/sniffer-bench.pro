@@ -0,0 +1,58 @@
+# sniffer-bench.pro - бенчмарки пути разбора пакетов (без Qt и libpcap)
+#
+# Сборка:   qmake sniffer-bench.pro && make
+# Запуск:   ./sniffer-bench --flows 1000 --ooo 0.05 --json --output result.json
+# Сравнение с базой: ./sniffer-bench --baseline baseline.json --tolerance 0.1
+# Проверка по эталонам: ./sniffer-bench --golden golden --replay capture.pcap
+#   (эталоны создаются --write-golden golden; код возврата 1 - расхождение)
+# Эталоны и база времени (параметры трафика - в первой строке golden/baseline.json)
+# хранятся в golden/, проверка из сборки приложения: make sniffer-tests
+# Разбор файла в несколько потоков: ./sniffer-bench --offline capture.pcap --offline-threads 8
+
+QT -= core gui
+
+TARGET = sniffer-bench
+CONFIG += c++17 console warn_on release
+CONFIG -= app_bundle qt
+
+TEMPLATE = app
+
+INCLUDEPATH += ..
+
+SOURCES += bench_main.cpp \
+           traffic_generator.cpp \
+           golden_corpus.cpp \
+           parser_checks.cpp \
+           ../packet_decoder.cpp \
+           ../ip_defragmenter.cpp \
+           ../udp_dissector.cpp \
+           ../dns_parser.cpp \
+           ../tcp_stream_assembler.cpp \
+           ../websocket_parser.cpp \
+           ../tls_sniffer.cpp \
+           ../hpack.cpp \
+           ../http2_decoder.cpp \
+           ../http_parser.cpp \
+           ../http_body_decoder.cpp \
+           ../string_interner.cpp \
+           ../flow_stats.cpp \
+           ../http_stats.cpp \
+           ../offline_analyzer.cpp \
+           ../trace.cpp
+
+HEADERS += traffic_generator.h \
+           golden_corpus.h \
+           parser_checks.h
+
+tracing {
+    DEFINES += SNIFFER_TRACING
+}
+
+win32 {
+    QMAKE_CXXFLAGS += /W4 /O2
+    INCLUDEPATH += $$(ZLIB_DIR)/include
+    LIBS += -lpsapi -L$$(ZLIB_DIR)/lib -lzlib
+} else {
+    QMAKE_CXXFLAGS += -Wall -O2
+    LIBS += -lz
+}
@@ -0,0 +1,288 @@
+#include "traffic_generator.h"
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+#include <fstream>
+
+namespace {
+
+const uint32_t CLIENT_BASE = 0x0A000001;   // 10.0.0.1
+
+void putU16(uint8_t* p, uint16_t value) {
+    p[0] = static_cast<uint8_t>(value >> 8);
+    p[1] = static_cast<uint8_t>(value);
+}
+
+// Запись целого в порядке хоста (формат pcap использует порядок записавшей машины)
+template <typename T>
+void writeRaw(std::ofstream& out, T value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void putU32(uint8_t* p, uint32_t value) {
+    p[0] = static_cast<uint8_t>(value >> 24);
+    p[1] = static_cast<uint8_t>(value >> 16);
+    p[2] = static_cast<uint8_t>(value >> 8);
+    p[3] = static_cast<uint8_t>(value);
+}
+
+uint16_t clientPort(size_t flow) {
+    return static_cast<uint16_t>(20000 + flow % 40000);
+}
+
+} // namespace
+
+TrafficOptions::TrafficOptions()
+    : flows(100), requestsPerFlow(20), segmentSize(1460), bodySize(4096),
+      outOfOrderRate(0.0), retransmitRate(0.0), chunked(false), chunkSize(1024),
+      bulkFlows(0), bulkBytes(256 * 1024), seed(1) {
+}
+
+TrafficGenerator::TrafficGenerator(const TrafficOptions& options)
+    : options(options), bytes(0), randomState(options.seed ? options.seed : 1) {
+}
+
+uint32_t TrafficGenerator::nextRandom() {
+    // xorshift32: детерминированный и быстрый
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 17;
+    randomState ^= randomState << 5;
+    return randomState;
+}
+
+double TrafficGenerator::nextUnit() {
+    return (nextRandom() & 0xffffff) / double(0x1000000);
+}
+
+uint32_t TrafficGenerator::clientAddress(size_t flow) {
+    return CLIENT_BASE + static_cast<uint32_t>(flow);
+}
+
+size_t TrafficGenerator::flowOfAddress(uint32_t ip) {
+    return ip - CLIENT_BASE;
+}
+
+std::vector<uint8_t> TrafficGenerator::buildTcpFrame(uint32_t srcIP, uint32_t dstIP,
+                                                     uint16_t srcPort, uint16_t dstPort,
+                                                     uint32_t seqNum, uint8_t flags,
+                                                     const uint8_t* payload, size_t length) {
+    std::vector<uint8_t> frame(14 + 20 + 20 + length, 0);
+    uint8_t* eth = frame.data();
+    uint8_t* ip = eth + 14;
+    uint8_t* tcp = ip + 20;
+
+    // Ethernet: локально администрируемые MAC-адреса
+    eth[0] = 0x02; eth[5] = 0x01;
+    eth[6] = 0x02; eth[11] = 0x02;
+    putU16(eth + 12, 0x0800);
+
+    // IPv4 без опций
+    ip[0] = 0x45;
+    putU16(ip + 2, static_cast<uint16_t>(20 + 20 + length));
+    ip[8] = 64;
+    ip[9] = 6;
+    putU32(ip + 12, srcIP);
+    putU32(ip + 16, dstIP);
+
+    // TCP без опций
+    putU16(tcp, srcPort);
+    putU16(tcp + 2, dstPort);
+    putU32(tcp + 4, seqNum);
+    tcp[12] = 5 << 4;
+    tcp[13] = flags;
+    putU16(tcp + 14, 65535);
+
+    if (length > 0) {
+        memcpy(tcp + 20, payload, length);
+    }
+    return frame;
+}
+
+std::string TrafficGenerator::buildRequest(size_t flow, size_t index) const {
+    return "GET /api/v1/items/" + std::to_string(flow * 1000 + index) + " HTTP/1.1\r\n"
+           "Host: bench.local\r\n"
+           "User-Agent: sniffer-bench/1.0\r\n"
+           "Accept: application/json\r\n"
+           "\r\n";
+}
+
+std::string TrafficGenerator::buildResponse(size_t flow, size_t index) const {
+    std::string body(options.bodySize, 'x');
+    for (size_t i = 0; i < body.size(); i += 64) {
+        body[i] = static_cast<char>('a' + (flow + index + i / 64) % 26);
+    }
+
+    std::string response = "HTTP/1.1 200 OK\r\n"
+                           "Content-Type: application/json\r\n"
+                           "Server: bench\r\n";
+
+    if (!options.chunked) {
+        response += "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n";
+        response += body;
+        return response;
+    }
+
+    response += "Transfer-Encoding: chunked\r\n\r\n";
+    size_t chunk = std::max<size_t>(options.chunkSize, 1);
+    for (size_t pos = 0; pos < body.size(); pos += chunk) {
+        size_t length = std::min(chunk, body.size() - pos);
+        char sizeLine[32];
+        snprintf(sizeLine, sizeof(sizeLine), "%zx\r\n", length);
+        response += sizeLine;
+        response.append(body, pos, length);
+        response += "\r\n";
+    }
+    response += "0\r\n\r\n";
+    return response;
+}
+
+bool TrafficGenerator::writePcap(const std::string& fileName, const std::vector<SyntheticFrame>& frames) {
+    std::ofstream out(fileName, std::ios::binary);
+    if (!out) return false;
+
+    // Заголовок файла: микросекунды, Ethernet
+    writeRaw<uint32_t>(out, 0xa1b2c3d4);
+    writeRaw<uint16_t>(out, 2);
+    writeRaw<uint16_t>(out, 4);
+    writeRaw<int32_t>(out, 0);
+    writeRaw<uint32_t>(out, 0);
+    writeRaw<uint32_t>(out, 65535);
+    writeRaw<uint32_t>(out, 1);
+
+    for (const SyntheticFrame& frame : frames) {
+        writeRaw<uint32_t>(out, static_cast<uint32_t>(frame.timestampUs / 1000000));
+        writeRaw<uint32_t>(out, static_cast<uint32_t>(frame.timestampUs % 1000000));
+        writeRaw<uint32_t>(out, static_cast<uint32_t>(frame.data.size()));
+        writeRaw<uint32_t>(out, static_cast<uint32_t>(frame.data.size()));
+        out.write(reinterpret_cast<const char*>(frame.data.data()), frame.data.size());
+    }
+    return static_cast<bool>(out);
+}
+
+std::string TrafficGenerator::buildBulkData() {
+    // Записи TLS application data со случайным содержимым
+    std::string data;
+    data.reserve(options.bulkBytes);
+    while (data.size() < options.bulkBytes) {
+        size_t length = std::min<size_t>(16384, options.bulkBytes - data.size());
+        data += "\x17\x03\x03";
+        data += static_cast<char>(length >> 8);
+        data += static_cast<char>(length & 0xff);
+        for (size_t i = 0; i < length; i++) {
+            data += static_cast<char>(nextRandom());
+        }
+    }
+    return data;
+}
+
+void TrafficGenerator::control(std::vector<std::vector<SyntheticFrame>>& perFlow, size_t flow,
+                               uint32_t srcIP, uint32_t dstIP, uint16_t srcPort, uint16_t dstPort,
+                               uint32_t& seqNum, uint8_t flags) {
+    SyntheticFrame frame;
+    frame.timestampUs = 0;
+    frame.data = buildTcpFrame(srcIP, dstIP, srcPort, dstPort, seqNum, flags, nullptr, 0);
+    seqNum++;
+    perFlow[flow].push_back(std::move(frame));
+}
+
+void TrafficGenerator::segment(std::vector<std::vector<SyntheticFrame>>& perFlow, size_t flow,
+                               uint32_t srcIP, uint32_t dstIP, uint16_t srcPort, uint16_t dstPort,
+                               uint32_t& seqNum, const std::string& message) {
+    std::vector<SyntheticFrame> segments;
+    size_t mss = std::max<size_t>(options.segmentSize, 1);
+
+    for (size_t pos = 0; pos < message.size(); pos += mss) {
+        size_t length = std::min(mss, message.size() - pos);
+        SyntheticFrame frame;
+        frame.timestampUs = 0;
+        frame.data = buildTcpFrame(srcIP, dstIP, srcPort, dstPort, seqNum, 0x18,
+                                   reinterpret_cast<const uint8_t*>(message.data()) + pos, length);
+        seqNum += static_cast<uint32_t>(length);
+        segments.push_back(frame);
+
+        // Повторная передача того же сегмента
+        if (nextUnit() < options.retransmitRate) {
+            segments.push_back(frame);
+        }
+    }
+
+    // Перестановка соседних сегментов
+    for (size_t i = 0; i + 1 < segments.size(); i++) {
+        if (nextUnit() < options.outOfOrderRate) {
+            std::swap(segments[i], segments[i + 1]);
+            i++;
+        }
+    }
+
+    for (SyntheticFrame& frame : segments) {
+        perFlow[flow].push_back(std::move(frame));
+    }
+}
+
+void TrafficGenerator::generate() {
+    frameList.clear();
+    expected.clear();
+    bytes = 0;
+
+    size_t totalFlows = options.flows + options.bulkFlows;
+    std::vector<std::vector<SyntheticFrame>> perFlow(totalFlows);
+
+    for (size_t flow = 0; flow < totalFlows; flow++) {
+        uint32_t client = clientAddress(flow);
+        uint16_t port = clientPort(flow);
+        uint16_t serverPort = flow < options.flows ? SERVER_PORT : BULK_PORT;
+        uint32_t clientSeq = nextRandom();
+        uint32_t serverSeq = nextRandom();
+
+        // Установление соединения
+        control(perFlow, flow, client, SERVER_ADDRESS, port, serverPort, clientSeq, 0x02);
+        control(perFlow, flow, SERVER_ADDRESS, client, serverPort, port, serverSeq, 0x12);
+
+        if (flow >= options.flows) {
+            segment(perFlow, flow, SERVER_ADDRESS, client, serverPort, port,
+                    serverSeq, buildBulkData());
+        }
+
+        for (size_t index = 0; flow < options.flows && index < options.requestsPerFlow; index++) {
+            std::string request = buildRequest(flow, index);
+            std::string response = buildResponse(flow, index);
+
+            segment(perFlow, flow, client, SERVER_ADDRESS, port, SERVER_PORT,
+                    clientSeq, request);
+            segment(perFlow, flow, SERVER_ADDRESS, client, SERVER_PORT, port,
+                    serverSeq, response);
+
+            expected.push_back(ExpectedMessage{flow, true, request.substr(0, request.find("\r\n"))});
+            expected.push_back(ExpectedMessage{flow, false, response.substr(0, response.find("\r\n"))});
+        }
+
+        // Закрытие соединения
+        control(perFlow, flow, client, SERVER_ADDRESS, port, serverPort, clientSeq, 0x11);
+        control(perFlow, flow, SERVER_ADDRESS, client, serverPort, port, serverSeq, 0x11);
+    }
+
+    // Чередуем соединения по одному кадру, сохраняя порядок внутри каждого;
+    // временные метки идут с шагом 2 мкс
+    size_t total = 0;
+    for (const auto& frames : perFlow) {
+        total += frames.size();
+    }
+    frameList.reserve(total);
+
+    uint64_t clock = 1000000;
+    std::vector<size_t> cursor(totalFlows, 0);
+    bool added = true;
+    while (added) {
+        added = false;
+        for (size_t flow = 0; flow < totalFlows; flow++) {
+            if (cursor[flow] < perFlow[flow].size()) {
+                SyntheticFrame& frame = perFlow[flow][cursor[flow]++];
+                frame.timestampUs = clock;
+                clock += 2;
+                bytes += frame.data.size();
+                frameList.push_back(std::move(frame));
+                added = true;
+            }
+        }
+    }
+}
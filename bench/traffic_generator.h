@@ -0,0 +1,94 @@
+#ifndef TRAFFIC_GENERATOR_H
+#define TRAFFIC_GENERATOR_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Параметры синтетического трафика
+struct TrafficOptions {
+    size_t flows;               // Число TCP-соединений
+    size_t requestsPerFlow;     // Пар запрос/ответ на соединение
+    size_t segmentSize;         // Максимальный размер TCP-сегмента (MSS)
+    size_t bodySize;            // Размер тела ответа
+    double outOfOrderRate;      // Доля сегментов, переставленных с соседним
+    double retransmitRate;      // Доля сегментов, отправленных повторно
+    bool chunked;               // Transfer-Encoding: chunked вместо Content-Length
+    size_t chunkSize;           // Размер чанка для chunked-ответов
+    size_t bulkFlows;           // Дополнительные не-HTTP соединения (TLS-подобные, порт 443)
+    size_t bulkBytes;           // Объём данных сервера в каждом таком соединении
+    uint32_t seed;
+
+    TrafficOptions();
+};
+
+// Один кадр Ethernet с временной меткой
+struct SyntheticFrame {
+    uint64_t timestampUs;
+    std::vector<uint8_t> data;
+};
+
+// Ожидаемое HTTP-сообщение (для проверки результата разбора)
+struct ExpectedMessage {
+    size_t flow;
+    bool isRequest;
+    std::string firstLine;
+};
+
+// Генератор синтетического HTTP-трафика поверх Ethernet/IPv4/TCP.
+// Соединения чередуются между собой, как на реальном канале.
+class TrafficGenerator {
+public:
+    explicit TrafficGenerator(const TrafficOptions& options);
+
+    // Формирует все кадры заранее, чтобы генерация не попадала в замеры
+    void generate();
+
+    const std::vector<SyntheticFrame>& frames() const { return frameList; }
+    const std::vector<ExpectedMessage>& expectedMessages() const { return expected; }
+    uint64_t totalBytes() const { return bytes; }
+
+    // Сохраняет кадры в файл pcap (для воспроизведения, например tcpreplay на veth)
+    bool writePcap(const std::string& fileName) const { return writePcap(fileName, frameList); }
+    static bool writePcap(const std::string& fileName, const std::vector<SyntheticFrame>& frames);
+
+    // Адрес клиента соединения и обратное преобразование
+    static uint32_t clientAddress(size_t flow);
+    static size_t flowOfAddress(uint32_t ip);
+    static const uint32_t SERVER_ADDRESS = 0x0A640001;   // 10.100.0.1
+    static const uint16_t SERVER_PORT = 80;
+    static const uint16_t BULK_PORT = 443;
+
+    // Строит кадр Ethernet/IPv4/TCP с заданной нагрузкой
+    static std::vector<uint8_t> buildTcpFrame(uint32_t srcIP, uint32_t dstIP,
+                                              uint16_t srcPort, uint16_t dstPort,
+                                              uint32_t seqNum, uint8_t flags,
+                                              const uint8_t* payload, size_t length);
+
+private:
+    TrafficOptions options;
+    std::vector<SyntheticFrame> frameList;
+    std::vector<ExpectedMessage> expected;
+    uint64_t bytes;
+    uint32_t randomState;
+
+    uint32_t nextRandom();
+    double nextUnit();
+
+    std::string buildRequest(size_t flow, size_t index) const;
+    std::string buildResponse(size_t flow, size_t index) const;
+    std::string buildBulkData();
+
+    // Кадр без данных (SYN, FIN); номер последовательности сдвигается на 1
+    void control(std::vector<std::vector<SyntheticFrame>>& perFlow, size_t flow,
+                 uint32_t srcIP, uint32_t dstIP, uint16_t srcPort, uint16_t dstPort,
+                 uint32_t& seqNum, uint8_t flags);
+
+    // Режет сообщение на сегменты с учётом перестановок и повторов
+    void segment(std::vector<std::vector<SyntheticFrame>>& perFlow, size_t flow,
+                 uint32_t srcIP, uint32_t dstIP, uint16_t srcPort, uint16_t dstPort,
+                 uint32_t& seqNum, const std::string& message);
+};
+
+#endif // TRAFFIC_GENERATOR_H
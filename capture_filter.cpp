@@ -0,0 +1,111 @@
+#include "capture_filter.h"
+#include <algorithm>
+
+std::string CaptureFilter::bypassExpression(const std::set<uint16_t>& ports) {
+    if (ports.empty()) return std::string();
+
+    std::string expression = "tcp and (";
+    bool first = true;
+    for (uint16_t port : ports) {
+        if (!first) expression += " or ";
+        expression += "port " + std::to_string(port);
+        first = false;
+    }
+    return expression + ")";
+}
+
+bool CaptureFilter::combine(const bpf_program& accept, const bpf_program& truncate,
+                            uint32_t fullSnaplen, bpf_program& result) {
+    u_int total = accept.bf_len + truncate.bf_len;
+    struct bpf_insn* code = new struct bpf_insn[total];
+
+    // Первая часть: отказ остаётся отказом, принятие - переход ко второй части.
+    // Переходы BPF только вперёд, а вторая часть идёт следом, поэтому
+    // смещения внутри обеих частей не меняются.
+    for (u_int i = 0; i < accept.bf_len; i++) {
+        struct bpf_insn insn = accept.bf_insns[i];
+        if (BPF_CLASS(insn.code) == BPF_RET) {
+            if (BPF_RVAL(insn.code) != BPF_K) {
+                delete[] code;
+                return false;
+            }
+            if (insn.k != 0) {
+                insn.code = BPF_JMP | BPF_JA;
+                insn.jt = 0;
+                insn.jf = 0;
+                insn.k = accept.bf_len - i - 1;
+            }
+        }
+        code[i] = insn;
+    }
+
+    // Вторая часть: совпадение с портами обхода - только заголовки, иначе весь пакет
+    for (u_int i = 0; i < truncate.bf_len; i++) {
+        struct bpf_insn insn = truncate.bf_insns[i];
+        if (BPF_CLASS(insn.code) == BPF_RET) {
+            if (BPF_RVAL(insn.code) != BPF_K) {
+                delete[] code;
+                return false;
+            }
+            insn.k = insn.k != 0 ? std::min<uint32_t>(insn.k, HEADER_SNAPLEN) : fullSnaplen;
+        }
+        code[accept.bf_len + i] = insn;
+    }
+
+    result.bf_len = total;
+    result.bf_insns = code;
+    return true;
+}
+
+bool CaptureFilter::compile(pcap_t* handle, const std::string& userFilter,
+                            const std::set<uint16_t>& bypassPorts, bpf_program& program, std::string& error) {
+    struct bpf_program accept;
+    if (pcap_compile(handle, &accept, userFilter.c_str(), 0, PCAP_NETMASK_UNKNOWN) == -1) {
+        error = std::string("Не удалось скомпилировать фильтр: ") + pcap_geterr(handle);
+        return false;
+    }
+
+    std::string truncateExpression = bypassExpression(bypassPorts);
+    struct bpf_program truncate;
+    bool truncateCompiled = !truncateExpression.empty() &&
+        pcap_compile(handle, &truncate, truncateExpression.c_str(), 0, PCAP_NETMASK_UNKNOWN) == 0;
+
+    // Если склеить не удалось, обрезки нет: обход остаётся только в пространстве пользователя
+    bool isCombined = truncateCompiled &&
+        combine(accept, truncate, static_cast<uint32_t>(pcap_snapshot(handle)), program);
+    if (!isCombined) {
+        // Копия, чтобы любая программа освобождалась одинаково (delete[])
+        program.bf_len = accept.bf_len;
+        program.bf_insns = new struct bpf_insn[accept.bf_len];
+        std::copy(accept.bf_insns, accept.bf_insns + accept.bf_len, program.bf_insns);
+    }
+
+    if (truncateCompiled) pcap_freecode(&truncate);
+    pcap_freecode(&accept);
+    return true;
+}
+
+void CaptureFilter::release(bpf_program& program) {
+    delete[] program.bf_insns;
+    program.bf_insns = nullptr;
+    program.bf_len = 0;
+}
+
+bool CaptureFilter::install(pcap_t* handle, const std::string& userFilter,
+                            const std::set<uint16_t>& bypassPorts, std::string& error) {
+    if (userFilter.empty() && bypassPorts.empty()) {
+        return true;
+    }
+
+    struct bpf_program program;
+    if (!compile(handle, userFilter, bypassPorts, program, error)) {
+        return false;
+    }
+
+    int result = pcap_setfilter(handle, &program);
+    if (result == -1) {
+        error = std::string("Не удалось установить фильтр: ") + pcap_geterr(handle);
+    }
+    release(program);
+    return result != -1;
+}
@@ -0,0 +1,52 @@
+#ifndef CAPTURE_FILTER_H
+#define CAPTURE_FILTER_H
+
+#include <cstdint>
+#include <set>
+#include <string>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#ifndef HAVE_REMOTE
+#define HAVE_REMOTE
+#endif
+#include <pcap.h>
+#else
+#include <pcap.h>
+#endif
+
+// Фильтр захвата с обрезкой обходимых потоков в ядре.
+// Классический BPF возвращает число байт, которые нужно скопировать в
+// пространство пользователя. Программа собирается из двух частей:
+// пользовательский фильтр решает, принимать ли пакет, а выражение по
+// портам обхода - сколько байт копировать: для обходимых потоков только
+// заголовки, длина на проводе (pkthdr->len) при этом сохраняется.
+class CaptureFilter {
+public:
+    // Сколько байт оставлять у обходимых пакетов: Ethernet + IPv4 + TCP с опциями
+    static const int HEADER_SNAPLEN = 128;
+
+    // "tcp and (port 443 or port 22)"; пустая строка для пустого набора
+    static std::string bypassExpression(const std::set<uint16_t>& ports);
+
+    // Компилирует и устанавливает фильтр на handle. Если портов обхода нет,
+    // устанавливается только пользовательский фильтр (пустой - без фильтра).
+    // При ошибке возвращает false и текст ошибки.
+    static bool install(pcap_t* handle, const std::string& userFilter,
+                        const std::set<uint16_t>& bypassPorts, std::string& error);
+
+    // Только компиляция (пустой фильтр - программа, принимающая всё).
+    // handle может быть открыт pcap_open_dead с типом канала и snaplen
+    // работающего захвата: так программа готовится вне потока захвата.
+    // Программу освобождает release.
+    static bool compile(pcap_t* handle, const std::string& userFilter,
+                        const std::set<uint16_t>& bypassPorts, bpf_program& program, std::string& error);
+    static void release(bpf_program& program);
+
+private:
+    // Объединяет две скомпилированные программы; false, если их нельзя склеить
+    static bool combine(const bpf_program& accept, const bpf_program& truncate,
+                        uint32_t fullSnaplen, bpf_program& result);
+};
+
+#endif // CAPTURE_FILTER_H
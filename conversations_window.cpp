@@ -0,0 +1,166 @@
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QSettings>
+
+#include "conversations_window.h"
+
+namespace {
+
+QString ipToString(uint32_t ip) {
+    return QString("%1.%2.%3.%4")
+        .arg((ip >> 24) & 0xff).arg((ip >> 16) & 0xff)
+        .arg((ip >> 8) & 0xff).arg(ip & 0xff);
+}
+
+QString protocolName(uint8_t protocol) {
+    switch (protocol) {
+    case 6: return "TCP";
+    case 17: return "UDP";
+    case 1: return "ICMP";
+    default: return QString::number(protocol);
+    }
+}
+
+// Числовая ячейка, которая сортируется как число
+QTableWidgetItem *numberItem(qulonglong value) {
+    QTableWidgetItem *item = new QTableWidgetItem();
+    item->setData(Qt::DisplayRole, value);
+    return item;
+}
+
+} // namespace
+
+ConversationsWindow::ConversationsWindow(FlowStatistics *statistics, QWidget *parent)
+    : QDialog(parent), statistics(statistics) {
+    setWindowTitle("Диалоги и узлы");
+    resize(750, 450);
+
+    QVBoxLayout *mainLayout = new QVBoxLayout(this);
+
+    // Панель управления
+    QHBoxLayout *controlLayout = new QHBoxLayout();
+
+    modeCombo = new QComboBox(this);
+    modeCombo->addItem("Точный подсчёт", FLOW_STATS_EXACT);
+    modeCombo->addItem("Ограниченная память (top-K)", FLOW_STATS_BOUNDED);
+    modeCombo->setCurrentIndex(statistics->mode() == FLOW_STATS_EXACT ? 0 : 1);
+    connect(modeCombo, QOverload<int>::of(&QComboBox::currentIndexChanged),
+            this, &ConversationsWindow::changeMode);
+
+    topSpin = new QSpinBox(this);
+    topSpin->setRange(1, 1000);
+    topSpin->setValue(QSettings().value("flow_stats_top_n", 20).toInt());
+    connect(topSpin, QOverload<int>::of(&QSpinBox::valueChanged), this, [this](int value) {
+        QSettings().setValue("flow_stats_top_n", value);
+        refresh();
+    });
+
+    controlLayout->addWidget(new QLabel("Режим:", this));
+    controlLayout->addWidget(modeCombo);
+    controlLayout->addWidget(new QLabel("Показать топ:", this));
+    controlLayout->addWidget(topSpin);
+    controlLayout->addStretch();
+
+    mainLayout->addLayout(controlLayout);
+
+    // Вкладки с таблицами
+    tabs = new QTabWidget(this);
+    hostsTable = createTable({"Адрес", "Пакеты", "Байты"});
+    conversationsTable = createTable({"Адрес A", "Адрес B", "Пакеты", "Байты"});
+    flowsTable = createTable({"Протокол", "Адрес A", "Порт A", "Адрес B", "Порт B", "Пакеты", "Байты"});
+    tabs->addTab(hostsTable, "Узлы");
+    tabs->addTab(conversationsTable, "Пары адресов");
+    tabs->addTab(flowsTable, "Потоки");
+    mainLayout->addWidget(tabs);
+
+    infoLabel = new QLabel(this);
+    mainLayout->addWidget(infoLabel);
+
+    // Периодическое обновление без пересчёта: статистика уже агрегирована
+    refreshTimer = new QTimer(this);
+    connect(refreshTimer, &QTimer::timeout, this, &ConversationsWindow::refresh);
+    refreshTimer->start(1000);
+
+    refresh();
+}
+
+QTableWidget *ConversationsWindow::createTable(const QStringList &headers) {
+    QTableWidget *table = new QTableWidget(this);
+    table->setColumnCount(headers.size());
+    table->setHorizontalHeaderLabels(headers);
+    table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    table->setSelectionBehavior(QAbstractItemView::SelectRows);
+    table->horizontalHeader()->setStretchLastSection(true);
+    table->verticalHeader()->setVisible(false);
+    return table;
+}
+
+void ConversationsWindow::fillTable(QTableWidget *table, FlowStatsKind kind) {
+    std::vector<FlowStatsEntry> entries = statistics->top(kind, topSpin->value());
+
+    table->setSortingEnabled(false);
+    table->setRowCount(static_cast<int>(entries.size()));
+
+    for (int row = 0; row < static_cast<int>(entries.size()); ++row) {
+        const FlowStatsEntry &entry = entries[row];
+        int col = 0;
+
+        switch (kind) {
+        case FLOW_STATS_HOSTS:
+            table->setItem(row, col++, new QTableWidgetItem(ipToString(entry.key.ipA)));
+            break;
+        case FLOW_STATS_CONVERSATIONS:
+            table->setItem(row, col++, new QTableWidgetItem(ipToString(entry.key.ipA)));
+            table->setItem(row, col++, new QTableWidgetItem(ipToString(entry.key.ipB)));
+            break;
+        case FLOW_STATS_FLOWS:
+            table->setItem(row, col++, new QTableWidgetItem(protocolName(entry.key.protocol)));
+            table->setItem(row, col++, new QTableWidgetItem(ipToString(entry.key.ipA)));
+            table->setItem(row, col++, numberItem(entry.key.portA));
+            table->setItem(row, col++, new QTableWidgetItem(ipToString(entry.key.ipB)));
+            table->setItem(row, col++, numberItem(entry.key.portB));
+            break;
+        }
+
+        // В режиме скетча значения являются верхней оценкой
+        QTableWidgetItem *packetsItem = numberItem(entry.counters.packets);
+        QTableWidgetItem *bytesItem = numberItem(entry.counters.bytes);
+        if (entry.approximate) {
+            packetsItem->setToolTip("Оценка Count-Min");
+            bytesItem->setToolTip("Оценка Count-Min");
+        }
+        table->setItem(row, col++, packetsItem);
+        table->setItem(row, col++, bytesItem);
+    }
+
+    table->setSortingEnabled(true);
+}
+
+void ConversationsWindow::refresh() {
+    fillTable(hostsTable, FLOW_STATS_HOSTS);
+    fillTable(conversationsTable, FLOW_STATS_CONVERSATIONS);
+    fillTable(flowsTable, FLOW_STATS_FLOWS);
+
+    if (statistics->mode() == FLOW_STATS_EXACT) {
+        infoLabel->setText(QString("Точный режим: узлов %1, пар %2, потоков %3")
+                               .arg(statistics->exactSize(FLOW_STATS_HOSTS))
+                               .arg(statistics->exactSize(FLOW_STATS_CONVERSATIONS))
+                               .arg(statistics->exactSize(FLOW_STATS_FLOWS)));
+        modeCombo->blockSignals(true);
+        modeCombo->setCurrentIndex(0);
+        modeCombo->blockSignals(false);
+    } else {
+        infoLabel->setText("Режим ограниченной памяти: значения являются верхними оценками");
+        modeCombo->blockSignals(true);
+        modeCombo->setCurrentIndex(1);
+        modeCombo->blockSignals(false);
+    }
+}
+
+void ConversationsWindow::changeMode(int index) {
+    FlowStatsMode mode = static_cast<FlowStatsMode>(modeCombo->itemData(index).toInt());
+    statistics->setMode(mode);
+    QSettings().setValue("flow_stats_mode", static_cast<int>(mode));
+    refresh();
+}
@@ -0,0 +1,40 @@
+#ifndef CONVERSATIONS_WINDOW_H
+#define CONVERSATIONS_WINDOW_H
+
+#include <QDialog>
+#include <QTimer>
+#include <QTabWidget>
+#include <QTableWidget>
+#include <QComboBox>
+#include <QSpinBox>
+#include <QLabel>
+
+#include "flow_stats.h"
+
+// Окно "Диалоги и узлы": топ узлов, пар адресов и потоков по объёму трафика
+class ConversationsWindow : public QDialog {
+    Q_OBJECT
+
+public:
+    explicit ConversationsWindow(FlowStatistics *statistics, QWidget *parent = nullptr);
+
+private slots:
+    void refresh();
+    void changeMode(int index);
+
+private:
+    FlowStatistics *statistics;
+    QTimer *refreshTimer;
+    QTabWidget *tabs;
+    QTableWidget *hostsTable;
+    QTableWidget *conversationsTable;
+    QTableWidget *flowsTable;
+    QComboBox *modeCombo;
+    QSpinBox *topSpin;
+    QLabel *infoLabel;
+
+    QTableWidget *createTable(const QStringList &headers);
+    void fillTable(QTableWidget *table, FlowStatsKind kind);
+};
+
+#endif // CONVERSATIONS_WINDOW_H
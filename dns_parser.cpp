@@ -0,0 +1,402 @@
+#include "dns_parser.h"
+#include <cstdio>
+
+namespace {
+
+// Предел переходов по ссылкам сжатия (ссылки идут только назад,
+// так что это лишь защита от очень длинных цепочек)
+const int MAX_POINTER_HOPS = 64;
+
+// Наименьшие размеры вопроса (корневое имя + тип + класс) и записи
+const size_t MIN_QUESTION_SIZE = 5;
+const size_t MIN_RECORD_SIZE = 11;
+
+inline uint16_t read16(const uint8_t* data) {
+    return static_cast<uint16_t>((data[0] << 8) | data[1]);
+}
+
+inline uint32_t read32(const uint8_t* data) {
+    return (uint32_t(data[0]) << 24) | (uint32_t(data[1]) << 16) | (uint32_t(data[2]) << 8) | data[3];
+}
+
+// IPv6 в сокращённой форме (RFC 5952): самая длинная серия нулевых групп -> "::"
+void formatIPv6(const uint8_t* address, char* out, size_t outSize) {
+    uint16_t groups[8];
+    for (int i = 0; i < 8; i++) {
+        groups[i] = read16(address + i * 2);
+    }
+
+    int bestStart = -1, bestLength = 0;
+    for (int i = 0; i < 8; ) {
+        if (groups[i] != 0) {
+            i++;
+            continue;
+        }
+        int start = i;
+        while (i < 8 && groups[i] == 0) i++;
+        if (i - start > bestLength && i - start >= 2) {
+            bestStart = start;
+            bestLength = i - start;
+        }
+    }
+
+    size_t length = 0;
+    out[0] = '\0';
+    for (int i = 0; i < 8 && length < outSize; i++) {
+        if (i == bestStart) {
+            length += snprintf(out + length, outSize - length, "::");
+            i += bestLength - 1;
+            continue;
+        }
+        bool separator = i > 0 && i != bestStart + bestLength;
+        length += snprintf(out + length, outSize - length, separator ? ":%x" : "%x", groups[i]);
+    }
+}
+
+} // namespace
+
+// ------------------ DnsParser ------------------
+
+bool DnsParser::looksLikeDns(const uint8_t* data, size_t size) {
+    if (size < HEADER_SIZE) return false;
+
+    // Коды операций: 0 - запрос, 1 - обратный, 2 - статус, 4 - notify, 5 - update
+    uint8_t opcode = (data[2] >> 3) & 0x0f;
+    if (opcode == 3 || opcode > 5) return false;
+    if (data[3] & 0x40) return false;   // Бит Z зарезервирован
+
+    size_t questions = read16(data + 4);
+    size_t records = size_t(read16(data + 6)) + read16(data + 8) + read16(data + 10);
+    if (questions == 0 && records == 0) return false;
+    return questions * MIN_QUESTION_SIZE + records * MIN_RECORD_SIZE <= size - HEADER_SIZE;
+}
+
+size_t DnsParser::skipName(const uint8_t* data, size_t size, size_t offset) {
+    size_t wireLength = 0;
+    while (offset < size) {
+        uint8_t length = data[offset];
+        if (length == 0) {
+            return offset + 1;
+        }
+        if ((length & 0xc0) == 0xc0) {
+            return offset + 2 <= size ? offset + 2 : 0;
+        }
+        if (length & 0xc0) {
+            return 0;   // Расширенные метки (RFC 6891) не используются
+        }
+        wireLength += length + 1;
+        if (wireLength > 255) {
+            return 0;
+        }
+        offset += length + 1;
+    }
+    return 0;
+}
+
+bool DnsParser::parse(const uint8_t* data, size_t size, DnsMessage& message) {
+    if (size < HEADER_SIZE) return false;
+
+    message = DnsMessage();
+    message.data = data;
+    message.size = size;
+    message.id = read16(data);
+    message.response = (data[2] & 0x80) != 0;
+    message.opcode = (data[2] >> 3) & 0x0f;
+    message.authoritative = (data[2] & 0x04) != 0;
+    message.truncated = (data[2] & 0x02) != 0;
+    message.rcode = data[3] & 0x0f;
+    message.questionCount = read16(data + 4);
+    message.answerCount = read16(data + 6);
+    message.authorityCount = read16(data + 8);
+    message.additionalCount = read16(data + 10);
+
+    size_t offset = HEADER_SIZE;
+    for (uint16_t i = 0; i < message.questionCount; i++) {
+        size_t end = skipName(data, size, offset);
+        if (end == 0 || size - end < 4) return false;
+        if (i == 0) {
+            message.questionName = offset;
+            message.questionType = read16(data + end);
+            message.questionClass = read16(data + end + 2);
+        }
+        offset = end + 4;
+    }
+    message.answersOffset = offset;
+
+    // Усечённый ответ (TC) может обрываться посреди записи - его
+    // записи не проверяются, заголовок и вопрос всё равно полезны
+    if (message.truncated) {
+        return true;
+    }
+
+    uint32_t records = uint32_t(message.answerCount) + message.authorityCount + message.additionalCount;
+    DnsRecord record;
+    for (uint32_t i = 0; i < records; i++) {
+        if (!readRecord(message, offset, record)) return false;
+    }
+    return true;
+}
+
+bool DnsParser::readRecord(const DnsMessage& message, size_t& offset, DnsRecord& record) {
+    size_t end = skipName(message.data, message.size, offset);
+    if (end == 0 || message.size - end < 10) return false;
+
+    const uint8_t* fields = message.data + end;
+    record.name = offset;
+    record.type = read16(fields);
+    record.recordClass = read16(fields + 2);
+    record.ttl = read32(fields + 4);
+    record.dataLength = read16(fields + 8);
+    record.dataOffset = end + 10;
+    if (message.size - record.dataOffset < record.dataLength) return false;
+
+    offset = record.dataOffset + record.dataLength;
+    return true;
+}
+
+bool DnsParser::readName(const DnsMessage& message, size_t offset, char* out, size_t outSize) {
+    if (outSize < MAX_NAME_LENGTH) return false;
+
+    const uint8_t* data = message.data;
+    size_t length = 0;
+    size_t wireLength = 0;
+    int hops = 0;
+
+    // При ошибке возвращается пустая строка, а не обрывок имени
+    auto fail = [out]() {
+        out[0] = '\0';
+        return false;
+    };
+
+    while (offset < message.size) {
+        uint8_t label = data[offset];
+        if (label == 0) {
+            if (length == 0) out[length++] = '.';
+            out[length] = '\0';
+            return true;
+        }
+
+        if ((label & 0xc0) == 0xc0) {
+            if (offset + 1 >= message.size) return fail();
+            size_t target = (size_t(label & 0x3f) << 8) | data[offset + 1];
+            // Только назад: цепочка ссылок строго убывает и конечна
+            if (target >= offset || ++hops > MAX_POINTER_HOPS) return fail();
+            offset = target;
+            continue;
+        }
+        if (label & 0xc0) return fail();
+
+        wireLength += label + 1;
+        if (wireLength > 255 || message.size - offset - 1 < label) return fail();
+
+        if (length > 0) out[length++] = '.';
+        for (size_t i = 0; i < label; i++) {
+            unsigned char c = data[offset + 1 + i];
+            out[length++] = (c > 0x20 && c < 0x7f) ? static_cast<char>(c) : '?';
+        }
+        offset += label + 1;
+    }
+    return fail();
+}
+
+bool DnsParser::formatData(const DnsMessage& message, const DnsRecord& record, char* out, size_t outSize) {
+    const uint8_t* rdata = message.data + record.dataOffset;
+    char name[MAX_NAME_LENGTH];
+
+    switch (record.type) {
+    case DNS_TYPE_A:
+        if (record.dataLength != 4) return false;
+        snprintf(out, outSize, "%u.%u.%u.%u", rdata[0], rdata[1], rdata[2], rdata[3]);
+        return true;
+    case DNS_TYPE_AAAA:
+        if (record.dataLength != 16) return false;
+        formatIPv6(rdata, out, outSize);
+        return true;
+    case DNS_TYPE_NS:
+    case DNS_TYPE_CNAME:
+    case DNS_TYPE_PTR:
+    case DNS_TYPE_SOA:   // Первичный сервер зоны
+        if (!readName(message, record.dataOffset, name, sizeof(name))) return false;
+        snprintf(out, outSize, "%s", name);
+        return true;
+    case DNS_TYPE_MX:
+        if (record.dataLength < 3 || !readName(message, record.dataOffset + 2, name, sizeof(name))) return false;
+        snprintf(out, outSize, "%u %s", read16(rdata), name);
+        return true;
+    case DNS_TYPE_SRV:
+        if (record.dataLength < 7 || !readName(message, record.dataOffset + 6, name, sizeof(name))) return false;
+        snprintf(out, outSize, "%u %u %u %s", read16(rdata), read16(rdata + 2), read16(rdata + 4), name);
+        return true;
+    case DNS_TYPE_TXT: {
+        // Первая строка записи
+        if (record.dataLength < 1 || rdata[0] > record.dataLength - 1) return false;
+        size_t length = rdata[0] < outSize - 1 ? rdata[0] : outSize - 1;
+        for (size_t i = 0; i < length; i++) {
+            unsigned char c = rdata[1 + i];
+            out[i] = (c >= 0x20 && c < 0x7f) ? static_cast<char>(c) : '?';
+        }
+        out[length] = '\0';
+        return true;
+    }
+    default:
+        snprintf(out, outSize, "%u байт", record.dataLength);
+        return true;
+    }
+}
+
+std::string DnsParser::typeName(uint16_t type) {
+    switch (type) {
+    case 1: return "A";
+    case 2: return "NS";
+    case 5: return "CNAME";
+    case 6: return "SOA";
+    case 12: return "PTR";
+    case 15: return "MX";
+    case 16: return "TXT";
+    case 28: return "AAAA";
+    case 33: return "SRV";
+    case 41: return "OPT";
+    case 43: return "DS";
+    case 46: return "RRSIG";
+    case 47: return "NSEC";
+    case 48: return "DNSKEY";
+    case 64: return "SVCB";
+    case 65: return "HTTPS";
+    case 255: return "ANY";
+    case 257: return "CAA";
+    default: {
+        char text[16];
+        snprintf(text, sizeof(text), "TYPE%u", type);
+        return text;
+    }
+    }
+}
+
+std::string DnsParser::rcodeName(uint8_t rcode) {
+    switch (rcode) {
+    case 0: return "NOERROR";
+    case 1: return "FORMERR";
+    case 2: return "SERVFAIL";
+    case 3: return "NXDOMAIN";
+    case 4: return "NOTIMP";
+    case 5: return "REFUSED";
+    case 6: return "YXDOMAIN";
+    case 7: return "YXRRSET";
+    case 8: return "NXRRSET";
+    case 9: return "NOTAUTH";
+    case 10: return "NOTZONE";
+    default: {
+        char text[16];
+        snprintf(text, sizeof(text), "RCODE%u", rcode);
+        return text;
+    }
+    }
+}
+
+// ------------------ DnsTransactionTable ------------------
+
+DnsTransactionTable::DnsTransactionTable(size_t capacity)
+    : pendingCount(0), evictedCount(0) {
+    // Число наборов - степень двойки, чтобы номер набора брался маской
+    size_t sets = 1;
+    while (sets * WAYS < capacity) {
+        sets <<= 1;
+    }
+    setMask = sets - 1;
+    entries.resize(sets * WAYS);
+    clear();
+}
+
+bool DnsTransactionTable::sameKey(const DnsTransactionKey& a, const DnsTransactionKey& b) {
+    return a.id == b.id && a.clientIP == b.clientIP && a.serverIP == b.serverIP &&
+           a.clientPort == b.clientPort && a.serverPort == b.serverPort;
+}
+
+DnsTransactionTable::Entry* DnsTransactionTable::findSet(const DnsTransactionKey& key) {
+    uint64_t a = (uint64_t(key.clientIP) << 32) | key.serverIP;
+    uint64_t b = (uint64_t(key.clientPort) << 32) | (uint64_t(key.serverPort) << 16) | key.id;
+    uint64_t hash = (a * 0x9e3779b97f4a7c15ULL) ^ (b * 0xc2b2ae3d27d4eb4fULL);
+    return &entries[((hash >> 32) & setMask) * WAYS];
+}
+
+void DnsTransactionTable::onQuery(const DnsTransactionKey& key, uint64_t timestampUs) {
+    Entry* set = findSet(key);
+    Entry* target = nullptr;
+    for (size_t i = 0; i < WAYS; i++) {
+        if (set[i].used && sameKey(set[i].key, key)) {
+            return;   // Повтор запроса
+        }
+        if (!set[i].used) {
+            if (!target || target->used) target = &set[i];
+        } else if (!target || (target->used && set[i].timestampUs < target->timestampUs)) {
+            target = &set[i];
+        }
+    }
+
+    if (target->used) {
+        evictedCount++;
+    } else {
+        pendingCount++;
+    }
+    target->key = key;
+    target->timestampUs = timestampUs;
+    target->used = true;
+}
+
+bool DnsTransactionTable::onResponse(const DnsTransactionKey& key, uint64_t timestampUs, uint64_t& latencyUs) {
+    Entry* set = findSet(key);
+    for (size_t i = 0; i < WAYS; i++) {
+        if (set[i].used && sameKey(set[i].key, key)) {
+            latencyUs = timestampUs >= set[i].timestampUs ? timestampUs - set[i].timestampUs : 0;
+            set[i].used = false;
+            pendingCount--;
+            return true;
+        }
+    }
+    return false;
+}
+
+void DnsTransactionTable::clear() {
+    for (Entry& entry : entries) {
+        entry.used = false;
+    }
+    pendingCount = 0;
+    evictedCount = 0;
+}
+
+// ------------------ DnsDissector ------------------
+
+DnsDissector::DnsDissector(MessageCallback callback, size_t maxPending)
+    : callback(callback), table(maxPending) {
+}
+
+std::vector<uint16_t> DnsDissector::defaultPorts() {
+    return {53, 5353, 5355};
+}
+
+bool DnsDissector::matchesSignature(const uint8_t* data, size_t size) const {
+    return DnsParser::looksLikeDns(data, size);
+}
+
+bool DnsDissector::dissect(const UdpDatagram& datagram) {
+    DnsMessage message;
+    if (!DnsParser::parse(datagram.payload, datagram.length, message)) {
+        return false;
+    }
+
+    DnsTransactionInfo transaction;
+    if (!message.response) {
+        table.onQuery(DnsTransactionKey{datagram.srcIP, datagram.dstIP,
+                                        datagram.srcPort, datagram.dstPort, message.id},
+                      datagram.timestampUs);
+    } else {
+        transaction.matched = table.onResponse(
+            DnsTransactionKey{datagram.dstIP, datagram.srcIP, datagram.dstPort, datagram.srcPort, message.id},
+            datagram.timestampUs, transaction.latencyUs);
+    }
+
+    if (callback) {
+        callback(datagram, message, transaction);
+    }
+    return true;
+}
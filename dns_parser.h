@@ -0,0 +1,171 @@
+#ifndef DNS_PARSER_H
+#define DNS_PARSER_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <functional>
+
+#include "udp_dissector.h"
+
+// Коды ответа (RFC 1035, 4.1.1)
+enum DnsRcode {
+    DNS_NOERROR = 0,
+    DNS_FORMERR = 1,
+    DNS_SERVFAIL = 2,
+    DNS_NXDOMAIN = 3,
+    DNS_NOTIMP = 4,
+    DNS_REFUSED = 5
+};
+
+// Типы записей, данные которых выводятся в текстовом виде
+enum DnsRecordType {
+    DNS_TYPE_A = 1,
+    DNS_TYPE_NS = 2,
+    DNS_TYPE_CNAME = 5,
+    DNS_TYPE_SOA = 6,
+    DNS_TYPE_PTR = 12,
+    DNS_TYPE_MX = 15,
+    DNS_TYPE_TXT = 16,
+    DNS_TYPE_AAAA = 28,
+    DNS_TYPE_SRV = 33
+};
+
+// Разобранный заголовок и первый вопрос. Сообщение не копируется:
+// смещения указывают внутрь data, имена распаковываются по запросу.
+struct DnsMessage {
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+    uint16_t id = 0;
+    bool response = false;
+    uint8_t opcode = 0;
+    uint8_t rcode = 0;
+    bool authoritative = false;
+    bool truncated = false;
+    uint16_t questionCount = 0;
+    uint16_t answerCount = 0;
+    uint16_t authorityCount = 0;
+    uint16_t additionalCount = 0;
+    size_t questionName = 0;      // Смещение имени первого вопроса (0 - вопросов нет)
+    uint16_t questionType = 0;
+    uint16_t questionClass = 0;
+    size_t answersOffset = 0;     // Начало секции ответов (за всеми вопросами)
+};
+
+// Ресурсная запись: смещения внутри сообщения
+struct DnsRecord {
+    size_t name = 0;
+    uint16_t type = 0;
+    uint16_t recordClass = 0;
+    uint32_t ttl = 0;
+    size_t dataOffset = 0;
+    uint16_t dataLength = 0;
+};
+
+// Разбор сообщений DNS без выделения памяти. Все чтения проверяют границы,
+// ссылки сжатия имён допускаются только назад (это исключает циклы).
+class DnsParser {
+public:
+    static const size_t HEADER_SIZE = 12;
+    // Буфер под текстовое имя: в сообщении имя не длиннее 255 байт
+    static const size_t MAX_NAME_LENGTH = 256;
+
+    // Дешёвая проверка заголовка: код операции, нулевой бит Z и
+    // число записей, которое может поместиться в датаграмму
+    static bool looksLikeDns(const uint8_t* data, size_t size);
+
+    // Проверяет все секции сообщения; false - сообщение некорректно
+    static bool parse(const uint8_t* data, size_t size, DnsMessage& message);
+
+    // Читает запись с позиции offset и сдвигает её к следующей записи
+    static bool readRecord(const DnsMessage& message, size_t& offset, DnsRecord& record);
+
+    // Имя с позиции offset в виде "www.example.com" ("." - корень);
+    // out должен вмещать MAX_NAME_LENGTH байт, строка завершается нулём
+    static bool readName(const DnsMessage& message, size_t offset, char* out, size_t outSize);
+
+    // Данные записи текстом: адрес для A/AAAA, имя для CNAME/NS/PTR и т.п.
+    static bool formatData(const DnsMessage& message, const DnsRecord& record, char* out, size_t outSize);
+
+    static std::string typeName(uint16_t type);
+    static std::string rcodeName(uint8_t rcode);
+
+private:
+    // Позиция за именем (ссылка сжатия завершает имя); 0 - имя некорректно
+    static size_t skipName(const uint8_t* data, size_t size, size_t offset);
+};
+
+// Ключ транзакции в направлении запроса: ID + адреса и порты (протокол - UDP)
+struct DnsTransactionKey {
+    uint32_t clientIP;
+    uint32_t serverIP;
+    uint16_t clientPort;
+    uint16_t serverPort;
+    uint16_t id;
+};
+
+// Запросы, ожидающие ответа. Таблица фиксированного размера (наборно-
+// ассоциативная, WAYS записей на набор): при заполнении набора вытесняется
+// самый старый запрос, поэтому память не растёт при потере ответов.
+class DnsTransactionTable {
+public:
+    explicit DnsTransactionTable(size_t capacity = 4096);
+
+    // Повторная отправка того же запроса не сбрасывает время первой
+    void onQuery(const DnsTransactionKey& key, uint64_t timestampUs);
+
+    // Находит и удаляет запрос; key - в направлении запроса
+    bool onResponse(const DnsTransactionKey& key, uint64_t timestampUs, uint64_t& latencyUs);
+
+    size_t pending() const { return pendingCount; }
+    uint64_t evicted() const { return evictedCount; }
+    void clear();
+
+    static const size_t WAYS = 4;
+
+private:
+    struct Entry {
+        DnsTransactionKey key;
+        uint64_t timestampUs;
+        bool used;
+    };
+
+    std::vector<Entry> entries;
+    size_t setMask;
+    size_t pendingCount;
+    uint64_t evictedCount;
+
+    Entry* findSet(const DnsTransactionKey& key);
+    static bool sameKey(const DnsTransactionKey& a, const DnsTransactionKey& b);
+};
+
+// Результат сопоставления ответа с запросом
+struct DnsTransactionInfo {
+    bool matched = false;
+    uint64_t latencyUs = 0;
+};
+
+// Разборщик DNS (а также mDNS и LLMNR - формат тот же) для реестра UDP
+class DnsDissector : public UdpDissector {
+public:
+    typedef std::function<void(const UdpDatagram&, const DnsMessage&,
+                               const DnsTransactionInfo&)> MessageCallback;
+
+    explicit DnsDissector(MessageCallback callback, size_t maxPending = 4096);
+
+    const char* name() const override { return "DNS"; }
+    bool matchesSignature(const uint8_t* data, size_t size) const override;
+    bool dissect(const UdpDatagram& datagram) override;
+
+    const DnsTransactionTable& transactions() const { return table; }
+
+    // 53 - DNS, 5353 - mDNS, 5355 - LLMNR
+    static std::vector<uint16_t> defaultPorts();
+
+private:
+    MessageCallback callback;
+    DnsTransactionTable table;
+};
+
+#endif // DNS_PARSER_H
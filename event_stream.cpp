@@ -0,0 +1,517 @@
+#include "event_stream.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// Ячейка: счётчик seqlock, затем запись
+const size_t SEQUENCE_BYTES = sizeof(uint64_t);
+const size_t LAYOUT_BYTES = (sizeof(EventStreamLayout) + 63) / 64 * 64;
+const size_t FIELD_HEADER_BYTES = 2 * sizeof(uint16_t);
+const int CONTROL_POLL_MS = 200;
+const size_t MAX_CONSUMERS = 64;
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "Счётчики в общей памяти должны быть без блокировок");
+
+inline std::atomic<uint64_t>* sequenceAt(uint8_t* slot) {
+    return reinterpret_cast<std::atomic<uint64_t>*>(slot);
+}
+
+inline const std::atomic<uint64_t>* sequenceAt(const uint8_t* slot) {
+    return reinterpret_cast<const std::atomic<uint64_t>*>(slot);
+}
+
+#ifndef _WIN32
+
+bool fillAddress(const std::string& path, sockaddr_un& address, std::string& error) {
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(address.sun_path)) {
+        error = "слишком длинный путь сокета: " + path;
+        return false;
+    }
+    memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    return true;
+}
+
+void sendText(int fd, const std::string& text) {
+#ifdef MSG_NOSIGNAL
+    send(fd, text.data(), text.size(), MSG_NOSIGNAL);
+#else
+    send(fd, text.data(), text.size(), 0);
+#endif
+}
+
+#endif
+
+} // namespace
+
+// ------------------ Писатель ------------------
+
+bool EventStreamPublisher::isSupported() {
+#ifdef _WIN32
+    return false;
+#else
+    return true;
+#endif
+}
+
+std::string EventStreamPublisher::defaultSocketPath() {
+    const char* runtime = getenv("XDG_RUNTIME_DIR");
+    return std::string(runtime && *runtime ? runtime : "/tmp") + "/sniffer-events.sock";
+}
+
+EventStreamPublisher::EventStreamPublisher(size_t slotCount, size_t slotSize)
+    : slotCount(1), slotSize(std::max<size_t>((slotSize + 7) / 8 * 8, 256)), layout(nullptr), mappedSize(0),
+      memoryFd(-1), listenFd(-1), stopping(false), consumerCount(0) {
+    while (this->slotCount < slotCount) {
+        this->slotCount <<= 1;
+    }
+    this->slotSize = std::min<size_t>(this->slotSize, 65536);
+}
+
+EventStreamPublisher::~EventStreamPublisher() {
+    stop();
+}
+
+bool EventStreamPublisher::start(const std::string& path, std::string& error) {
+#ifdef _WIN32
+    (void)path;
+    error = "поток событий поддерживается только в POSIX-системах";
+    return false;
+#else
+    stop();
+
+    // Общая память без имени: имя удаляется сразу, память живёт, пока
+    // открыт хотя бы один дескриптор или отображение
+    char name[64];
+    snprintf(name, sizeof(name), "/sniffer-events-%d-%p", static_cast<int>(getpid()), static_cast<void*>(this));
+    memoryFd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (memoryFd < 0) {
+        error = std::string("shm_open: ") + strerror(errno);
+        return false;
+    }
+    shm_unlink(name);
+
+    mappedSize = LAYOUT_BYTES + slotCount * slotSize;
+    void* mapped = MAP_FAILED;
+    if (ftruncate(memoryFd, static_cast<off_t>(mappedSize)) == 0) {
+        mapped = mmap(nullptr, mappedSize, PROT_READ | PROT_WRITE, MAP_SHARED, memoryFd, 0);
+    }
+    if (mapped == MAP_FAILED) {
+        error = std::string("общая память: ") + strerror(errno);
+        close(memoryFd);
+        memoryFd = -1;
+        return false;
+    }
+    layout = new (mapped) EventStreamLayout();
+    layout->magic = EVENT_STREAM_MAGIC;
+    layout->version = EVENT_STREAM_VERSION;
+    layout->slotSize = static_cast<uint32_t>(slotSize);
+    layout->slotCount = static_cast<uint32_t>(slotCount);
+    layout->published.store(0, std::memory_order_release);
+
+    // Управляющий сокет. Если по пути отвечает другой экземпляр - не трогаем
+    // его; файл, оставшийся от упавшего процесса, удаляется
+    sockaddr_un address;
+    listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenFd < 0 || !fillAddress(path, address, error)) {
+        if (error.empty()) error = std::string("socket: ") + strerror(errno);
+        stop();
+        return false;
+    }
+    int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+    bool busy = probe >= 0 && connect(probe, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0;
+    if (probe >= 0) close(probe);
+    if (busy) {
+        error = "сокет уже используется другим процессом: " + path;
+        stop();
+        return false;
+    }
+    unlink(path.c_str());
+
+    mode_t oldMask = umask(0077);
+    bool bound = bind(listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0;
+    umask(oldMask);
+    if (!bound || listen(listenFd, 16) != 0) {
+        error = "сокет " + path + ": " + strerror(errno);
+        stop();
+        return false;
+    }
+    socketPath = path;
+
+    stopping.store(false);
+    controlThread = std::thread(&EventStreamPublisher::serveControl, this);
+    return true;
+#endif
+}
+
+void EventStreamPublisher::stop() {
+#ifndef _WIN32
+    stopping.store(true);
+    if (controlThread.joinable()) {
+        controlThread.join();
+    }
+    if (listenFd >= 0) {
+        close(listenFd);
+        listenFd = -1;
+        unlink(socketPath.c_str());
+        socketPath.clear();
+    }
+
+    std::lock_guard<std::mutex> lock(writeMutex);
+    if (layout) {
+        munmap(layout, mappedSize);
+        layout = nullptr;
+    }
+    if (memoryFd >= 0) {
+        close(memoryFd);
+        memoryFd = -1;
+    }
+#endif
+}
+
+void EventStreamPublisher::publish(const StreamEventHeader& header, const StreamEventField* fields,
+                                   size_t fieldCount) {
+    TRACE_SCOPE("events.publish");
+    std::lock_guard<std::mutex> lock(writeMutex);
+    if (!layout) {
+        return;
+    }
+
+    uint64_t index = layout->published.load(std::memory_order_relaxed);
+    uint8_t* slot = reinterpret_cast<uint8_t*>(layout) + LAYOUT_BYTES + (index & (slotCount - 1)) * slotSize;
+    std::atomic<uint64_t>* sequence = sequenceAt(slot);
+
+    // Нечётный счётчик: читатели, попавшие на ячейку, отбросят её
+    sequence->store(2 * index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    uint8_t* record = slot + SEQUENCE_BYTES;
+    size_t capacity = slotSize - SEQUENCE_BYTES;
+    size_t used = sizeof(StreamEventHeader);
+    StreamEventHeader stored = header;
+    stored.fieldCount = 0;
+    for (size_t i = 0; i < fieldCount; i++) {
+        if (used + FIELD_HEADER_BYTES > capacity) {
+            stored.flags |= STREAM_EVENT_TRUNCATED;
+            break;
+        }
+        size_t length = std::min(fields[i].length, capacity - used - FIELD_HEADER_BYTES);
+        if (length < fields[i].length) {
+            stored.flags |= STREAM_EVENT_TRUNCATED;
+        }
+        uint16_t fieldHeader[2] = {fields[i].id, static_cast<uint16_t>(length)};
+        memcpy(record + used, fieldHeader, FIELD_HEADER_BYTES);
+        memcpy(record + used + FIELD_HEADER_BYTES, fields[i].data, length);
+        used += FIELD_HEADER_BYTES + length;
+        stored.fieldCount++;
+    }
+    stored.size = static_cast<uint16_t>(used);
+    memcpy(record, &stored, sizeof(stored));
+
+    sequence->store(2 * index + 2, std::memory_order_release);
+    layout->published.store(index + 1, std::memory_order_release);
+}
+
+uint64_t EventStreamPublisher::published() const {
+    return layout ? layout->published.load(std::memory_order_relaxed) : 0;
+}
+
+void EventStreamPublisher::serveControl() {
+#ifndef _WIN32
+    if (Tracer::isEnabled()) {
+        Tracer::setThreadName("event-stream");
+    }
+    std::vector<int> clients;
+
+    while (!stopping.load()) {
+        std::vector<pollfd> fds;
+        fds.push_back(pollfd{listenFd, POLLIN, 0});
+        for (int client : clients) {
+            fds.push_back(pollfd{client, POLLIN, 0});
+        }
+        if (poll(fds.data(), fds.size(), CONTROL_POLL_MS) <= 0) {
+            continue;
+        }
+
+        // Ответы на команды и отключения
+        for (size_t i = fds.size() - 1; i >= 1; i--) {
+            if (!fds[i].revents) continue;
+            char command[256];
+            ssize_t received = recv(fds[i].fd, command, sizeof(command) - 1, 0);
+            if (received <= 0) {
+                close(fds[i].fd);
+                clients.erase(clients.begin() + (i - 1));
+                continue;
+            }
+            command[received] = '\0';
+            if (strncmp(command, "STATS", 5) == 0) {
+                char reply[96];
+                snprintf(reply, sizeof(reply), "published=%llu consumers=%zu\n",
+                         static_cast<unsigned long long>(published()), clients.size());
+                sendText(fds[i].fd, reply);
+            }
+        }
+
+        // Новый читатель: строка описания и дескриптор общей памяти
+        if (fds[0].revents & POLLIN) {
+            int client = accept(listenFd, nullptr, nullptr);
+            if (client >= 0 && clients.size() >= MAX_CONSUMERS) {
+                sendText(client, "ERROR too many consumers\n");
+                close(client);
+            } else if (client >= 0) {
+                char line[96];
+                int length = snprintf(line, sizeof(line), "SNIFFER-EVENTS %u slots=%zu slot=%zu\n",
+                                      EVENT_STREAM_VERSION, slotCount, slotSize);
+                iovec data{line, static_cast<size_t>(length)};
+                char control[CMSG_SPACE(sizeof(int))];
+                memset(control, 0, sizeof(control));
+                msghdr message{};
+                message.msg_iov = &data;
+                message.msg_iovlen = 1;
+                message.msg_control = control;
+                message.msg_controllen = sizeof(control);
+                cmsghdr* rights = CMSG_FIRSTHDR(&message);
+                rights->cmsg_level = SOL_SOCKET;
+                rights->cmsg_type = SCM_RIGHTS;
+                rights->cmsg_len = CMSG_LEN(sizeof(int));
+                memcpy(CMSG_DATA(rights), &memoryFd, sizeof(int));
+#ifdef MSG_NOSIGNAL
+                bool sent = sendmsg(client, &message, MSG_NOSIGNAL) == length;
+#else
+                bool sent = sendmsg(client, &message, 0) == length;
+#endif
+                if (sent) {
+                    clients.push_back(client);
+                } else {
+                    close(client);
+                }
+            }
+        }
+        consumerCount.store(clients.size(), std::memory_order_relaxed);
+    }
+
+    for (int client : clients) {
+        close(client);
+    }
+    consumerCount.store(0, std::memory_order_relaxed);
+#endif
+}
+
+// ------------------ Читатель ------------------
+
+EventStreamReader::EventStreamReader()
+    : layout(nullptr), slots(nullptr), mappedSize(0), slotSize(0), slotCount(0), controlFd(-1), position(0),
+      lostCount(0), current(0) {
+}
+
+EventStreamReader::~EventStreamReader() {
+    detach();
+}
+
+bool EventStreamReader::attach(const std::string& socketPath, bool fromStart, std::string& error) {
+#ifdef _WIN32
+    (void)socketPath;
+    (void)fromStart;
+    error = "поток событий поддерживается только в POSIX-системах";
+    return false;
+#else
+    detach();
+
+    sockaddr_un address;
+    if (!fillAddress(socketPath, address, error)) {
+        return false;
+    }
+    controlFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (controlFd < 0 || connect(controlFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        error = "нет соединения с " + socketPath + ": " + strerror(errno);
+        detach();
+        return false;
+    }
+
+    char line[128];
+    iovec data{line, sizeof(line) - 1};
+    char control[CMSG_SPACE(sizeof(int))];
+    msghdr message{};
+    message.msg_iov = &data;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+    ssize_t received = recvmsg(controlFd, &message, 0);
+    int memory = -1;
+    for (cmsghdr* header = CMSG_FIRSTHDR(&message); received > 0 && header; header = CMSG_NXTHDR(&message, header)) {
+        if (header->cmsg_level == SOL_SOCKET && header->cmsg_type == SCM_RIGHTS) {
+            memcpy(&memory, CMSG_DATA(header), sizeof(int));
+        }
+    }
+    unsigned version = 0;
+    size_t lineSlots = 0;
+    size_t lineSlotSize = 0;
+    if (received > 0) {
+        line[received] = '\0';
+        sscanf(line, "SNIFFER-EVENTS %u slots=%zu slot=%zu", &version, &lineSlots, &lineSlotSize);
+    }
+    if (memory < 0 || version != EVENT_STREAM_VERSION) {
+        error = received > 0 ? "неподдерживаемый ответ: " + std::string(line, strcspn(line, "\n"))
+                             : std::string("писатель закрыл соединение");
+        if (memory >= 0) close(memory);
+        detach();
+        return false;
+    }
+
+    struct stat info;
+    void* mapped = MAP_FAILED;
+    if (fstat(memory, &info) == 0 && static_cast<size_t>(info.st_size) >= LAYOUT_BYTES) {
+        mappedSize = static_cast<size_t>(info.st_size);
+        mapped = mmap(nullptr, mappedSize, PROT_READ, MAP_SHARED, memory, 0);
+    }
+    close(memory);   // Отображение держит память и без дескриптора
+    if (mapped == MAP_FAILED) {
+        error = std::string("общая память: ") + strerror(errno);
+        detach();
+        return false;
+    }
+    layout = static_cast<const EventStreamLayout*>(mapped);
+    slotSize = layout->slotSize;
+    slotCount = layout->slotCount;
+    if (layout->magic != EVENT_STREAM_MAGIC || slotSize != lineSlotSize || slotCount != lineSlots ||
+        slotSize < SEQUENCE_BYTES + sizeof(StreamEventHeader) || (slotCount & (slotCount - 1)) != 0 ||
+        LAYOUT_BYTES + size_t(slotCount) * slotSize > mappedSize) {
+        error = "повреждённое описание общей памяти";
+        detach();
+        return false;
+    }
+    slots = static_cast<const uint8_t*>(mapped) + LAYOUT_BYTES;
+
+    uint64_t published = layout->published.load(std::memory_order_acquire);
+    position = fromStart && published > slotCount ? published - slotCount : fromStart ? 0 : published;
+    lostCount = 0;
+    return true;
+#endif
+}
+
+void EventStreamReader::detach() {
+#ifndef _WIN32
+    if (layout) {
+        munmap(const_cast<EventStreamLayout*>(layout), mappedSize);
+    }
+    if (controlFd >= 0) {
+        close(controlFd);
+    }
+#endif
+    layout = nullptr;
+    slots = nullptr;
+    controlFd = -1;
+}
+
+const StreamEventHeader* EventStreamReader::next() {
+    if (!layout) {
+        return nullptr;
+    }
+    for (;;) {
+        uint64_t published = layout->published.load(std::memory_order_acquire);
+        if (position >= published) {
+            return nullptr;
+        }
+        // Отстали больше чем на кольцо - старые ячейки уже перезаписаны
+        if (published - position > slotCount) {
+            lostCount += published - slotCount - position;
+            position = published - slotCount;
+        }
+
+        const uint8_t* slot = slots + (position & (slotCount - 1)) * size_t(slotSize);
+        uint64_t sequence = sequenceAt(slot)->load(std::memory_order_acquire);
+        if (sequence != 2 * position + 2) {
+            lostCount++;   // Писатель уже пишет в эту ячейку следующий круг
+            position++;
+            continue;
+        }
+        current = position++;
+        return reinterpret_cast<const StreamEventHeader*>(slot + SEQUENCE_BYTES);
+    }
+}
+
+bool EventStreamReader::release() {
+    if (!layout) {
+        return false;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const uint8_t* slot = slots + (current & (slotCount - 1)) * size_t(slotSize);
+    if (sequenceAt(slot)->load(std::memory_order_relaxed) != 2 * current + 2) {
+        lostCount++;
+        return false;
+    }
+    return true;
+}
+
+bool EventStreamReader::publisherGone() {
+#ifdef _WIN32
+    return true;
+#else
+    if (controlFd < 0) {
+        return true;
+    }
+    pollfd fd{controlFd, POLLIN, 0};
+    if (poll(&fd, 1, 0) <= 0) {
+        return false;
+    }
+    char byte;
+    return recv(controlFd, &byte, 1, MSG_PEEK) <= 0;
+#endif
+}
+
+bool EventStreamReader::statistics(std::string& reply) {
+#ifdef _WIN32
+    (void)reply;
+    return false;
+#else
+    if (controlFd < 0 || send(controlFd, "STATS\n", 6, 0) != 6) {
+        return false;
+    }
+    char text[128];
+    ssize_t received = recv(controlFd, text, sizeof(text) - 1, 0);
+    if (received <= 0) {
+        return false;
+    }
+    reply.assign(text, strcspn(text, "\n") < size_t(received) ? strcspn(text, "\n") : size_t(received));
+    return true;
+#endif
+}
+
+bool EventStreamReader::field(const StreamEventHeader* event, uint16_t id, std::string_view& value) const {
+    const uint8_t* record = reinterpret_cast<const uint8_t*>(event);
+    size_t size = std::min<size_t>(event->size, slotSize - SEQUENCE_BYTES);
+    size_t offset = sizeof(StreamEventHeader);
+    for (uint16_t i = 0; i < event->fieldCount && offset + FIELD_HEADER_BYTES <= size; i++) {
+        uint16_t header[2];
+        memcpy(header, record + offset, FIELD_HEADER_BYTES);
+        offset += FIELD_HEADER_BYTES;
+        if (header[1] > size - offset) {
+            return false;
+        }
+        if (header[0] == id) {
+            value = std::string_view(reinterpret_cast<const char*>(record + offset), header[1]);
+            return true;
+        }
+        offset += header[1];
+    }
+    return false;
+}
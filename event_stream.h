@@ -0,0 +1,177 @@
+#ifndef EVENT_STREAM_H
+#define EVENT_STREAM_H
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+
+// Поток событий для внешних программ (оповещения, отправка журналов):
+// разобранные сообщения в общей памяти в виде компактных двоичных записей.
+//
+// Кольцо из slotCount ячеек по slotSize байт; пишет один поток (записи
+// разных потоков захвата упорядочиваются мьютексом), читателей сколько
+// угодно. Каждая ячейка защищена счётчиком (seqlock): нечётный - запись
+// идёт, 2 * (номер + 1) - запись номер готова. Писатель никогда не ждёт
+// читателей: отставший читатель обнаруживает перезаписанные ячейки и
+// теряет только свои события.
+//
+// Общая память создаётся без имени в файловой системе (shm_open и сразу
+// shm_unlink) и передаётся подключившимся к управляющему сокету Unix
+// через SCM_RIGHTS вместе со строкой описания:
+//   SNIFFER-EVENTS 1 slots=<N> slot=<байт>
+// Пока соединение открыто, читатель считается подключённым; команда
+// "STATS\n" возвращает строку published=<N> consumers=<N>.
+// Только POSIX; в Windows isSupported() - false.
+
+static const uint32_t EVENT_STREAM_MAGIC = 0x53455631;   // "SEV1"
+static const uint32_t EVENT_STREAM_VERSION = 1;
+
+enum StreamEventType : uint8_t {
+    STREAM_EVENT_HTTP_REQUEST = 1,
+    STREAM_EVENT_HTTP_RESPONSE = 2,
+    STREAM_EVENT_TLS_HELLO = 3,
+    STREAM_EVENT_DNS = 4
+};
+
+// Флаги записи
+static const uint8_t STREAM_EVENT_TRUNCATED = 0x01;   // Поля обрезаны по размеру ячейки
+static const uint8_t STREAM_EVENT_RESPONSE = 0x02;    // Ответ (TLS ServerHello, ответ DNS)
+
+// Поля записи: за заголовком идут fieldCount пар (id, length) с данными
+enum StreamFieldId : uint16_t {
+    STREAM_FIELD_METHOD = 1,
+    STREAM_FIELD_URI = 2,
+    STREAM_FIELD_HOST = 3,          // Host, SNI или имя в вопросе DNS
+    STREAM_FIELD_VERSION = 4,
+    STREAM_FIELD_STATUS_TEXT = 5,
+    STREAM_FIELD_CONTENT_TYPE = 6,
+    STREAM_FIELD_USER_AGENT = 7,
+    STREAM_FIELD_QUERY_TYPE = 8
+};
+
+// Заголовок записи; адреса и порты - в порядке узла
+struct StreamEventHeader {
+    uint16_t size;              // Байт записи вместе с полями
+    uint8_t type;               // StreamEventType
+    uint8_t flags;
+    uint32_t interfaceIndex;
+    uint64_t timestampUs;
+    uint32_t srcIP;
+    uint32_t dstIP;
+    uint16_t srcPort;
+    uint16_t dstPort;
+    uint32_t code;              // Код ответа HTTP, rcode DNS, версия TLS
+    uint64_t length;            // Тело HTTP, размер датаграммы DNS
+    uint16_t fieldCount;
+    uint16_t reserved[3];
+};
+
+struct StreamEventField {
+    uint16_t id;
+    const char* data;
+    size_t length;
+};
+
+// Начало общей памяти; за ним - ячейки
+struct EventStreamLayout {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slotSize;
+    uint32_t slotCount;
+    alignas(64) std::atomic<uint64_t> published;   // Записей опубликовано
+};
+
+class EventStreamPublisher {
+public:
+    static bool isSupported();
+
+    // Путь сокета по умолчанию: $XDG_RUNTIME_DIR или /tmp
+    static std::string defaultSocketPath();
+
+    // slotCount округляется вверх до степени двойки
+    explicit EventStreamPublisher(size_t slotCount = 16384, size_t slotSize = 1024);
+    ~EventStreamPublisher();
+
+    EventStreamPublisher(const EventStreamPublisher&) = delete;
+    EventStreamPublisher& operator=(const EventStreamPublisher&) = delete;
+
+    // Создаёт общую память и управляющий сокет (права 0600 - как у
+    // владельца процесса); false - причина в error
+    bool start(const std::string& socketPath, std::string& error);
+    void stop();
+    bool isRunning() const { return layout != nullptr; }
+
+    // Записывает событие сразу в ячейку кольца; поля, не поместившиеся
+    // в ячейку, обрезаются (флаг STREAM_EVENT_TRUNCATED). Потокобезопасно
+    void publish(const StreamEventHeader& header, const StreamEventField* fields, size_t fieldCount);
+
+    uint64_t published() const;
+    size_t consumers() const { return consumerCount.load(std::memory_order_relaxed); }
+
+private:
+    size_t slotCount;
+    size_t slotSize;
+    std::mutex writeMutex;
+    EventStreamLayout* layout;
+    size_t mappedSize;
+    int memoryFd;
+
+    std::string socketPath;
+    int listenFd;
+    std::thread controlThread;
+    std::atomic<bool> stopping;
+    std::atomic<size_t> consumerCount;
+
+    void serveControl();
+};
+
+// Читатель потока событий (в другом процессе)
+class EventStreamReader {
+public:
+    EventStreamReader();
+    ~EventStreamReader();
+
+    EventStreamReader(const EventStreamReader&) = delete;
+    EventStreamReader& operator=(const EventStreamReader&) = delete;
+
+    // Подключается к сокету, получает общую память; fromStart - читать
+    // с самой старой записи в кольце, иначе только новые
+    bool attach(const std::string& socketPath, bool fromStart, std::string& error);
+    void detach();
+
+    // Следующая запись - указатель прямо в общую память (без копирования);
+    // nullptr - новых нет. Пока запись используется, писатель может
+    // перезаписать ячейку: после обработки нужно вызвать release(), и если
+    // он вернул false, результат обработки следует отбросить
+    const StreamEventHeader* next();
+    bool release();
+
+    // Потеряно из-за отставания (ячейки перезаписаны до чтения)
+    uint64_t lost() const { return lostCount; }
+
+    // Писатель остановился (управляющий сокет закрыт)
+    bool publisherGone();
+
+    bool statistics(std::string& reply);
+
+    // Первое поле с этим id в записи из next(); false - поля нет.
+    // Размеры проверяются по ячейке: испорченная запись не выводит за её пределы
+    bool field(const StreamEventHeader* event, uint16_t id, std::string_view& value) const;
+
+private:
+    const EventStreamLayout* layout;
+    const uint8_t* slots;
+    size_t mappedSize;
+    uint32_t slotSize;
+    uint32_t slotCount;
+    int controlFd;
+    uint64_t position;          // Номер следующей записи
+    uint64_t lostCount;
+    uint64_t current;           // Номер записи, выданной next()
+};
+
+#endif // EVENT_STREAM_H
@@ -0,0 +1,103 @@
+#include "flow_sampler.h"
+
+namespace {
+
+// Сколько спокойных интервалов подряд нужно, чтобы ослабить выборку
+const int CALM_INTERVALS_TO_RELAX = 5;
+
+uint64_t mix64(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
+}
+
+} // namespace
+
+FlowSampler::FlowSampler()
+    : currentMode(SAMPLING_OFF), currentRate(1), lastKernelDrops(0), calmIntervals(0) {
+}
+
+void FlowSampler::setMode(SamplingMode mode) {
+    currentMode.store(mode, std::memory_order_relaxed);
+    lastKernelDrops = 0;
+    calmIntervals = 0;
+
+    if (mode == SAMPLING_AUTO) {
+        // В автоматическом режиме N округляется вниз до степени двойки
+        uint32_t rate = currentRate.load(std::memory_order_relaxed);
+        uint32_t power = 1;
+        while (power * 2 <= rate && power < MAX_AUTO_RATE) power *= 2;
+        currentRate.store(power, std::memory_order_relaxed);
+    }
+}
+
+void FlowSampler::setRate(uint32_t rate) {
+    currentRate.store(rate > 0 ? rate : 1, std::memory_order_relaxed);
+    if (mode() == SAMPLING_AUTO) {
+        setMode(SAMPLING_AUTO);
+    }
+}
+
+uint64_t FlowSampler::flowHash(uint32_t srcIP, uint32_t dstIP, uint16_t srcPort, uint16_t dstPort,
+                               uint8_t protocol) {
+    // Упорядочиваем концы соединения, чтобы хеш не зависел от направления
+    uint64_t a = (uint64_t(srcIP) << 16) | srcPort;
+    uint64_t b = (uint64_t(dstIP) << 16) | dstPort;
+    if (a > b) {
+        uint64_t t = a;
+        a = b;
+        b = t;
+    }
+    return mix64(mix64(a) ^ (b * 0x9e3779b97f4a7c15ULL) ^ protocol);
+}
+
+bool FlowSampler::isSampled(uint32_t srcIP, uint32_t dstIP, uint16_t srcPort, uint16_t dstPort,
+                            uint8_t protocol) const {
+    SamplingMode mode = currentMode.load(std::memory_order_relaxed);
+    uint32_t rate = currentRate.load(std::memory_order_relaxed);
+    if (mode == SAMPLING_OFF || rate <= 1) {
+        return true;
+    }
+
+    uint64_t hash = flowHash(srcIP, dstIP, srcPort, dstPort, protocol);
+    if (mode == SAMPLING_AUTO) {
+        return (hash & (rate - 1)) == 0;
+    }
+    return hash % rate == 0;
+}
+
+bool FlowSampler::updateLoad(uint64_t kernelDrops, size_t queueDepth) {
+    if (mode() != SAMPLING_AUTO) {
+        lastKernelDrops = kernelDrops;
+        return false;
+    }
+
+    uint64_t newDrops = kernelDrops >= lastKernelDrops ? kernelDrops - lastKernelDrops : 0;
+    lastKernelDrops = kernelDrops;
+
+    uint32_t rate = currentRate.load(std::memory_order_relaxed);
+    uint32_t newRate = rate;
+
+    if (newDrops > 0 || queueDepth > QUEUE_HIGH_WATERMARK) {
+        // Перегрузка: вдвое сокращаем число обрабатываемых потоков
+        calmIntervals = 0;
+        if (rate < MAX_AUTO_RATE) newRate = rate * 2;
+    } else if (queueDepth < QUEUE_LOW_WATERMARK) {
+        // Нагрузка спала: ослабляем выборку не сразу, а после нескольких интервалов
+        if (++calmIntervals >= CALM_INTERVALS_TO_RELAX && rate > 1) {
+            newRate = rate / 2;
+            calmIntervals = 0;
+        }
+    } else {
+        calmIntervals = 0;
+    }
+
+    if (newRate != rate) {
+        currentRate.store(newRate, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
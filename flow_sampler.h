@@ -0,0 +1,56 @@
+#ifndef FLOW_SAMPLER_H
+#define FLOW_SAMPLER_H
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+
+// Политика при перегрузке
+enum SamplingMode {
+    SAMPLING_OFF,     // Обрабатываются все потоки
+    SAMPLING_FIXED,   // Фиксированная выборка 1 из N потоков
+    SAMPLING_AUTO     // N подстраивается по потерям в ядре и очереди GUI
+};
+
+// Детерминированная выборка потоков по хешу 5-tuple. Хеш симметричен,
+// поэтому оба направления соединения попадают в выборку вместе, и
+// выбранные потоки остаются полными. В автоматическом режиме N - степень
+// двойки: при ужесточении выборки оставшиеся потоки - подмножество
+// ранее выбранных, и ни один из них не обрывается посередине.
+class FlowSampler {
+public:
+    FlowSampler();
+
+    void setMode(SamplingMode mode);
+    SamplingMode mode() const { return currentMode.load(std::memory_order_relaxed); }
+
+    // Задаёт N (для автоматического режима - начальное значение)
+    void setRate(uint32_t rate);
+    uint32_t rate() const { return currentRate.load(std::memory_order_relaxed); }
+
+    // Выбран ли поток для полной обработки (сборки потоков и разбора HTTP)
+    bool isSampled(uint32_t srcIP, uint32_t dstIP, uint16_t srcPort, uint16_t dstPort,
+                   uint8_t protocol) const;
+
+    // Симметричный хеш 5-tuple
+    static uint64_t flowHash(uint32_t srcIP, uint32_t dstIP, uint16_t srcPort, uint16_t dstPort,
+                             uint8_t protocol);
+
+    // Обновляет N в автоматическом режиме. Вызывается периодически (раз в секунду)
+    // с накопленным числом потерь в ядре и текущей глубиной очереди.
+    // Возвращает true, если N изменился.
+    bool updateLoad(uint64_t kernelDrops, size_t queueDepth);
+
+    // Пороги очереди для автоматического режима
+    static const size_t QUEUE_HIGH_WATERMARK = 20000;
+    static const size_t QUEUE_LOW_WATERMARK = 2000;
+    static const uint32_t MAX_AUTO_RATE = 1024;
+
+private:
+    std::atomic<SamplingMode> currentMode;
+    std::atomic<uint32_t> currentRate;
+    uint64_t lastKernelDrops;
+    int calmIntervals;
+};
+
+#endif // FLOW_SAMPLER_H
@@ -0,0 +1,282 @@
+#include "flow_stats.h"
+#include <algorithm>
+
+namespace {
+
+// Параметры скетча: 4 строки по 4096 ячеек (~256 КБ на агрегацию)
+const size_t SKETCH_WIDTH = 4096;
+const size_t SKETCH_DEPTH = 4;
+
+uint64_t mix64(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
+}
+
+uint64_t hashKey(const FlowStatsKey& key) {
+    uint64_t a = (uint64_t(key.ipA) << 32) | key.ipB;
+    uint64_t b = (uint64_t(key.portA) << 24) | (uint64_t(key.portB) << 8) | key.protocol;
+    return mix64(a ^ mix64(b + 0x9e3779b97f4a7c15ULL));
+}
+
+bool byBytesDesc(const FlowStatsEntry& a, const FlowStatsEntry& b) {
+    return a.counters.bytes > b.counters.bytes;
+}
+
+} // namespace
+
+size_t FlowStatsKeyHash::operator()(const FlowStatsKey& key) const {
+    return static_cast<size_t>(hashKey(key));
+}
+
+// ------------------ CountMinSketch ------------------
+
+CountMinSketch::CountMinSketch(size_t width, size_t depth)
+    : width(width), depth(depth), cells(width * depth, FlowCounters{0, 0}) {
+}
+
+void CountMinSketch::add(uint64_t hash, uint64_t packets, uint64_t bytes) {
+    // Двойное хеширование: h1 + i * h2 даёт независимые строки
+    uint64_t h1 = hash;
+    uint64_t h2 = mix64(hash) | 1;
+    for (size_t row = 0; row < depth; row++) {
+        FlowCounters& cell = cells[row * width + (h1 + row * h2) % width];
+        cell.packets += packets;
+        cell.bytes += bytes;
+    }
+}
+
+FlowCounters CountMinSketch::estimate(uint64_t hash) const {
+    uint64_t h1 = hash;
+    uint64_t h2 = mix64(hash) | 1;
+    FlowCounters result{UINT64_MAX, UINT64_MAX};
+    for (size_t row = 0; row < depth; row++) {
+        const FlowCounters& cell = cells[row * width + (h1 + row * h2) % width];
+        result.packets = std::min(result.packets, cell.packets);
+        result.bytes = std::min(result.bytes, cell.bytes);
+    }
+    return result;
+}
+
+void CountMinSketch::clear() {
+    std::fill(cells.begin(), cells.end(), FlowCounters{0, 0});
+}
+
+// ------------------ HeavyHitters ------------------
+
+HeavyHitters::HeavyHitters(size_t capacity, size_t sketchWidth, size_t sketchDepth)
+    : capacity(capacity), sketch(sketchWidth, sketchDepth) {
+    heap.reserve(capacity);
+    positions.reserve(capacity * 2);
+}
+
+void HeavyHitters::add(const FlowStatsKey& key, uint64_t hash, uint64_t packets, uint64_t bytes) {
+    sketch.add(hash, packets, bytes);
+
+    auto it = positions.find(key);
+    if (it != positions.end()) {
+        // Ключ уже отслеживается: увеличиваем счётчики и восстанавливаем кучу
+        Slot& slot = heap[it->second];
+        slot.counters.packets += packets;
+        slot.counters.bytes += bytes;
+        siftDown(it->second);
+        return;
+    }
+
+    FlowCounters estimated = sketch.estimate(hash);
+
+    if (heap.size() < capacity) {
+        heap.push_back(Slot{key, estimated});
+        positions[key] = heap.size() - 1;
+        siftUp(heap.size() - 1);
+        return;
+    }
+
+    // Вытесняем наименьший элемент, если оценка нового ключа больше
+    if (capacity > 0 && estimated.bytes > heap[0].counters.bytes) {
+        positions.erase(heap[0].key);
+        heap[0] = Slot{key, estimated};
+        positions[key] = 0;
+        siftDown(0);
+    }
+}
+
+std::vector<FlowStatsEntry> HeavyHitters::top(size_t n) const {
+    std::vector<FlowStatsEntry> result;
+    result.reserve(heap.size());
+    for (const Slot& slot : heap) {
+        result.push_back(FlowStatsEntry{slot.key, slot.counters, true});
+    }
+
+    n = std::min(n, result.size());
+    std::partial_sort(result.begin(), result.begin() + n, result.end(), byBytesDesc);
+    result.resize(n);
+    return result;
+}
+
+void HeavyHitters::clear() {
+    sketch.clear();
+    heap.clear();
+    positions.clear();
+}
+
+void HeavyHitters::siftUp(size_t index) {
+    while (index > 0) {
+        size_t parent = (index - 1) / 2;
+        if (heap[parent].counters.bytes <= heap[index].counters.bytes) {
+            break;
+        }
+        swapSlots(parent, index);
+        index = parent;
+    }
+}
+
+void HeavyHitters::siftDown(size_t index) {
+    for (;;) {
+        size_t smallest = index;
+        size_t left = index * 2 + 1;
+        size_t right = left + 1;
+        if (left < heap.size() && heap[left].counters.bytes < heap[smallest].counters.bytes) {
+            smallest = left;
+        }
+        if (right < heap.size() && heap[right].counters.bytes < heap[smallest].counters.bytes) {
+            smallest = right;
+        }
+        if (smallest == index) {
+            break;
+        }
+        swapSlots(smallest, index);
+        index = smallest;
+    }
+}
+
+void HeavyHitters::swapSlots(size_t a, size_t b) {
+    std::swap(heap[a], heap[b]);
+    positions[heap[a].key] = a;
+    positions[heap[b].key] = b;
+}
+
+// ------------------ FlowStatistics ------------------
+
+FlowStatistics::FlowStatistics(FlowStatsMode mode, size_t topK)
+    : currentMode(mode), topK(topK) {
+    for (int i = 0; i < 3; i++) {
+        bounded[i] = nullptr;
+    }
+    resetLocked();
+}
+
+FlowStatistics::~FlowStatistics() {
+    for (int i = 0; i < 3; i++) {
+        delete bounded[i];
+    }
+}
+
+void FlowStatistics::setMode(FlowStatsMode mode) {
+    std::lock_guard<std::mutex> lock(mutex);
+    currentMode = mode;
+    resetLocked();
+}
+
+FlowStatsMode FlowStatistics::mode() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return currentMode;
+}
+
+void FlowStatistics::addPacket(uint32_t srcIP, uint32_t dstIP, uint16_t srcPort, uint16_t dstPort,
+                               uint8_t protocol, size_t length) {
+    // Нормализуем направление: меньший адрес (и порт) всегда первый
+    bool forward = srcIP < dstIP || (srcIP == dstIP && srcPort <= dstPort);
+
+    FlowStatsKey flow = forward
+        ? FlowStatsKey{srcIP, dstIP, srcPort, dstPort, protocol}
+        : FlowStatsKey{dstIP, srcIP, dstPort, srcPort, protocol};
+    FlowStatsKey conversation{flow.ipA, flow.ipB, 0, 0, 0};
+    FlowStatsKey srcHost{srcIP, 0, 0, 0, 0};
+    FlowStatsKey dstHost{dstIP, 0, 0, 0, 0};
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    account(FLOW_STATS_HOSTS, srcHost, length);
+    if (dstIP != srcIP) {
+        account(FLOW_STATS_HOSTS, dstHost, length);
+    }
+    account(FLOW_STATS_CONVERSATIONS, conversation, length);
+    account(FLOW_STATS_FLOWS, flow, length);
+
+    if (currentMode == FLOW_STATS_EXACT && exact[FLOW_STATS_FLOWS].size() > MAX_EXACT_ENTRIES) {
+        switchToBounded();
+    }
+}
+
+void FlowStatistics::account(FlowStatsKind kind, const FlowStatsKey& key, size_t length) {
+    if (currentMode == FLOW_STATS_EXACT) {
+        FlowCounters& counters = exact[kind][key];
+        counters.packets++;
+        counters.bytes += length;
+    } else {
+        bounded[kind]->add(key, hashKey(key), 1, length);
+    }
+}
+
+std::vector<FlowStatsEntry> FlowStatistics::top(FlowStatsKind kind, size_t n) const {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (currentMode == FLOW_STATS_BOUNDED) {
+        return bounded[kind]->top(n);
+    }
+
+    std::vector<FlowStatsEntry> result;
+    result.reserve(exact[kind].size());
+    for (const auto& item : exact[kind]) {
+        result.push_back(FlowStatsEntry{item.first, item.second, false});
+    }
+
+    n = std::min(n, result.size());
+    std::partial_sort(result.begin(), result.begin() + n, result.end(), byBytesDesc);
+    result.resize(n);
+    return result;
+}
+
+size_t FlowStatistics::exactSize(FlowStatsKind kind) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return currentMode == FLOW_STATS_EXACT ? exact[kind].size() : 0;
+}
+
+void FlowStatistics::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    resetLocked();
+}
+
+void FlowStatistics::switchToBounded() {
+    // Переносим накопленные точные значения в скетчи и освобождаем таблицы
+    currentMode = FLOW_STATS_BOUNDED;
+    for (int kind = 0; kind < 3; kind++) {
+        if (!bounded[kind]) {
+            bounded[kind] = new HeavyHitters(topK, SKETCH_WIDTH, SKETCH_DEPTH);
+        }
+        bounded[kind]->clear();
+        for (const auto& item : exact[kind]) {
+            bounded[kind]->add(item.first, hashKey(item.first), item.second.packets, item.second.bytes);
+        }
+        ExactTable().swap(exact[kind]);
+    }
+}
+
+void FlowStatistics::resetLocked() {
+    for (int kind = 0; kind < 3; kind++) {
+        ExactTable().swap(exact[kind]);
+        if (currentMode == FLOW_STATS_BOUNDED) {
+            if (!bounded[kind]) {
+                bounded[kind] = new HeavyHitters(topK, SKETCH_WIDTH, SKETCH_DEPTH);
+            }
+            bounded[kind]->clear();
+        } else {
+            delete bounded[kind];
+            bounded[kind] = nullptr;
+        }
+    }
+}
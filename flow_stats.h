@@ -0,0 +1,139 @@
+#ifndef FLOW_STATS_H
+#define FLOW_STATS_H
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+
+// Режим агрегации статистики по узлам и диалогам
+enum FlowStatsMode {
+    FLOW_STATS_EXACT,    // Точный подсчёт (хеш-таблица на каждый ключ)
+    FLOW_STATS_BOUNDED   // Ограниченная память: Count-Min + Space-Saving top-K
+};
+
+// Тип агрегации
+enum FlowStatsKind {
+    FLOW_STATS_HOSTS,          // По узлам (IP)
+    FLOW_STATS_CONVERSATIONS,  // По парам адресов
+    FLOW_STATS_FLOWS           // По 5-tuple
+};
+
+// Ключ агрегации. Для пар адресов и 5-tuple ключ нормализуется так,
+// чтобы оба направления попадали в одну запись.
+struct FlowStatsKey {
+    uint32_t ipA;
+    uint32_t ipB;
+    uint16_t portA;
+    uint16_t portB;
+    uint8_t protocol;
+
+    bool operator==(const FlowStatsKey& other) const {
+        return ipA == other.ipA && ipB == other.ipB &&
+               portA == other.portA && portB == other.portB &&
+               protocol == other.protocol;
+    }
+};
+
+struct FlowStatsKeyHash {
+    size_t operator()(const FlowStatsKey& key) const;
+};
+
+// Счётчики пакетов и байт
+struct FlowCounters {
+    uint64_t packets;
+    uint64_t bytes;
+};
+
+// Строка результата для отображения
+struct FlowStatsEntry {
+    FlowStatsKey key;
+    FlowCounters counters;
+    bool approximate;    // true, если значения получены из скетча
+};
+
+// Count-Min скетч фиксированного размера (пакеты и байты в одной ячейке)
+class CountMinSketch {
+public:
+    CountMinSketch(size_t width, size_t depth);
+
+    void add(uint64_t hash, uint64_t packets, uint64_t bytes);
+    FlowCounters estimate(uint64_t hash) const;
+    void clear();
+
+private:
+    size_t width;
+    size_t depth;
+    std::vector<FlowCounters> cells;
+};
+
+// Top-K по байтам с фиксированной памятью: Count-Min оценивает частоту
+// любого ключа, а K самых тяжёлых ключей хранятся в min-куче.
+// Обновление занимает O(log K) и не зависит от числа различных ключей.
+class HeavyHitters {
+public:
+    HeavyHitters(size_t capacity, size_t sketchWidth, size_t sketchDepth);
+
+    void add(const FlowStatsKey& key, uint64_t hash, uint64_t packets, uint64_t bytes);
+    std::vector<FlowStatsEntry> top(size_t n) const;
+    void clear();
+
+private:
+    struct Slot {
+        FlowStatsKey key;
+        FlowCounters counters;
+    };
+
+    size_t capacity;
+    CountMinSketch sketch;
+    std::vector<Slot> heap;                                     // min-куча по байтам
+    std::unordered_map<FlowStatsKey, size_t, FlowStatsKeyHash> positions;
+
+    void siftUp(size_t index);
+    void siftDown(size_t index);
+    void swapSlots(size_t a, size_t b);
+};
+
+// Инкрементальная статистика по узлам, парам адресов и 5-tuple.
+// Обновляется из потока захвата, читается из GUI; все методы потокобезопасны.
+class FlowStatistics {
+public:
+    explicit FlowStatistics(FlowStatsMode mode = FLOW_STATS_EXACT, size_t topK = 1000);
+    ~FlowStatistics();
+
+    // Смена режима сбрасывает накопленную статистику
+    void setMode(FlowStatsMode mode);
+    FlowStatsMode mode() const;
+
+    // Учитывает один пакет (адреса и порты в порядке хоста)
+    void addPacket(uint32_t srcIP, uint32_t dstIP, uint16_t srcPort, uint16_t dstPort,
+                   uint8_t protocol, size_t length);
+
+    // Возвращает n самых активных записей по байтам
+    std::vector<FlowStatsEntry> top(FlowStatsKind kind, size_t n) const;
+
+    // Число различных ключей (только в точном режиме, иначе 0)
+    size_t exactSize(FlowStatsKind kind) const;
+
+    void clear();
+
+    // В точном режиме при превышении этого числа ключей статистика
+    // автоматически переводится в режим ограниченной памяти
+    static const size_t MAX_EXACT_ENTRIES = 1000000;
+
+private:
+    typedef std::unordered_map<FlowStatsKey, FlowCounters, FlowStatsKeyHash> ExactTable;
+
+    mutable std::mutex mutex;
+    FlowStatsMode currentMode;
+    size_t topK;
+    ExactTable exact[3];
+    HeavyHitters *bounded[3];
+
+    void account(FlowStatsKind kind, const FlowStatsKey& key, size_t length);
+    void switchToBounded();
+    void resetLocked();
+};
+
+#endif // FLOW_STATS_H
@@ -0,0 +1,78 @@
+#include "frame_queue.h"
+#include <algorithm>
+#include <cstring>
+
+FrameQueue::FrameQueue(size_t requested)
+    : head(0), tail(0), droppedFrames(0), frontSize(0) {
+    size_t size = 4096;
+    while (size < requested) size *= 2;
+    buffer.resize(size);
+    mask = size - 1;
+}
+
+bool FrameQueue::push(uint64_t timestampUs, uint32_t caplen, uint32_t len, const uint8_t* data) {
+    size_t size = recordSize(caplen);
+    uint64_t writePos = head.load(std::memory_order_relaxed);
+    uint64_t readPos = tail.load(std::memory_order_acquire);
+
+    // Запись не разрезается: если до конца кольца не хватает места, остаток пропускается
+    size_t offset = writePos & mask;
+    size_t untilEnd = buffer.size() - offset;
+    size_t needed = size <= untilEnd ? size : untilEnd + size;
+
+    if (size > buffer.size() / 2 || writePos + needed - readPos > buffer.size()) {
+        droppedFrames.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    if (size > untilEnd) {
+        // Места до конца всегда не меньше 8 байт: отметки хватает
+        RecordHeader marker{0, WRAP_MARKER, 0};
+        memcpy(&buffer[offset], &marker, std::min(untilEnd, sizeof(marker)));
+        writePos += untilEnd;
+        offset = 0;
+    }
+
+    RecordHeader header{timestampUs, caplen, len};
+    memcpy(&buffer[offset], &header, sizeof(header));
+    memcpy(&buffer[offset + sizeof(header)], data, caplen);
+
+    head.store(writePos + size, std::memory_order_release);
+    return true;
+}
+
+bool FrameQueue::front(QueuedFrame& frame) {
+    uint64_t readPos = tail.load(std::memory_order_relaxed);
+    uint64_t writePos = head.load(std::memory_order_acquire);
+    if (readPos == writePos) return false;
+
+    size_t offset = readPos & mask;
+    RecordHeader header;
+    size_t untilEnd = buffer.size() - offset;
+    if (untilEnd < sizeof(header)) {
+        // Хвост короче заголовка - это всегда пропуск
+        header.caplen = WRAP_MARKER;
+    } else {
+        memcpy(&header, &buffer[offset], sizeof(header));
+    }
+
+    if (header.caplen == WRAP_MARKER) {
+        readPos += untilEnd;
+        tail.store(readPos, std::memory_order_release);
+        if (readPos == writePos) return false;
+        offset = 0;
+        memcpy(&header, &buffer[0], sizeof(header));
+    }
+
+    frame.timestampUs = header.timestampUs;
+    frame.caplen = header.caplen;
+    frame.len = header.len;
+    frame.data = &buffer[offset + sizeof(header)];
+    frontSize = recordSize(header.caplen);
+    return true;
+}
+
+void FrameQueue::pop() {
+    tail.store(tail.load(std::memory_order_relaxed) + frontSize, std::memory_order_release);
+    frontSize = 0;
+}
@@ -0,0 +1,63 @@
+#ifndef FRAME_QUEUE_H
+#define FRAME_QUEUE_H
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <vector>
+
+// Кадр в очереди: указатель на данные действителен до вызова FrameQueue::pop()
+struct QueuedFrame {
+    uint64_t timestampUs;
+    uint32_t caplen;
+    uint32_t len;           // Длина на проводе
+    const uint8_t* data;
+};
+
+// Очередь кадров без блокировок для одного производителя и одного потребителя.
+// Кадры записываются подряд в заранее выделенное кольцо байт; если места
+// нет, кадр отбрасывается и учитывается в dropped() - производитель
+// (поток захвата) никогда не ждёт потребителя.
+class FrameQueue {
+public:
+    // Формат записи в кольце (его же использует PreTriggerRing): заголовок,
+    // затем данные; записи выровнены по 8 байт. WRAP_MARKER в caplen -
+    // пропуск до конца кольца (запись не поместилась целиком)
+    struct RecordHeader {
+        uint64_t timestampUs;
+        uint32_t caplen;
+        uint32_t len;
+    };
+    static constexpr uint32_t WRAP_MARKER = 0xffffffff;
+
+    static size_t recordSize(uint32_t caplen) {
+        return (sizeof(RecordHeader) + caplen + 7) & ~size_t(7);
+    }
+
+    // capacity округляется вверх до степени двойки
+    explicit FrameQueue(size_t capacity);
+
+    // Вызывает производитель
+    bool push(uint64_t timestampUs, uint32_t caplen, uint32_t len, const uint8_t* data);
+
+    // Вызывает потребитель: front() возвращает false, если очередь пуста;
+    // pop() освобождает место, занятое кадром из front()
+    bool front(QueuedFrame& frame);
+    void pop();
+
+    uint64_t dropped() const { return droppedFrames.load(std::memory_order_relaxed); }
+    size_t capacity() const { return buffer.size(); }
+
+private:
+    std::vector<uint8_t> buffer;
+    size_t mask;
+
+    // Счётчики байт растут монотонно; позиция в кольце - значение & mask.
+    // head и tail разнесены по разным строкам кэша.
+    alignas(64) std::atomic<uint64_t> head;   // Пишет производитель
+    alignas(64) std::atomic<uint64_t> tail;   // Пишет потребитель
+    alignas(64) std::atomic<uint64_t> droppedFrames;
+    uint64_t frontSize;                       // Размер записи, возвращённой front()
+};
+
+#endif // FRAME_QUEUE_H
@@ -0,0 +1,107 @@
+#include "header_columns_model.h"
+#include <algorithm>
+#include <cctype>
+
+namespace {
+
+std::string toLower(std::string text) {
+    std::transform(text.begin(), text.end(), text.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return text;
+}
+
+} // namespace
+
+HeaderColumnsProxyModel::HeaderColumnsProxyModel(const StringInterner *interner, QObject *parent)
+    : QSortFilterProxyModel(parent), interner(interner), firstColumn(0), processColumn(-1), filterColumn(-1) {
+}
+
+void HeaderColumnsProxyModel::setHeaderColumns(int first, const QStringList &columnNames) {
+    firstColumn = first;
+    names = columnNames;
+    setHeaderFilter(QString());
+}
+
+void HeaderColumnsProxyModel::setProcessColumn(int column, const QString &name) {
+    processColumn = column;
+    processName = name;
+    setHeaderFilter(QString());
+}
+
+void HeaderColumnsProxyModel::setHeaderFilter(const QString &text) {
+    QString filter = text.trimmed();
+    filterColumn = -1;
+
+    // Префикс "Имя:" ограничивает поиск одним столбцом
+    int colon = filter.indexOf(':');
+    if (colon > 0) {
+        QString name = filter.left(colon).trimmed();
+        int column = -1;
+        for (int i = 0; i < names.size() && column < 0; i++) {
+            if (names[i].compare(name, Qt::CaseInsensitive) == 0) {
+                column = i;
+            }
+        }
+        if (column >= 0) {
+            filterColumn = firstColumn + column;
+            filter = filter.mid(colon + 1).trimmed();
+        } else if (processColumn >= 0 && processName.compare(name, Qt::CaseInsensitive) == 0) {
+            filterColumn = processColumn;
+            filter = filter.mid(colon + 1).trimmed();
+        }
+    }
+
+    filterText = toLower(filter.toStdString());
+    matches.clear();
+    invalidateFilter();
+}
+
+bool HeaderColumnsProxyModel::isHeaderColumn(int column) const {
+    return (column >= firstColumn && column < firstColumn + names.size()) || column == processColumn;
+}
+
+bool HeaderColumnsProxyModel::valueMatches(quint32 id) const {
+    auto cached = matches.constFind(id);
+    if (cached != matches.constEnd()) {
+        return cached.value();
+    }
+
+    bool match = toLower(interner->value(id)).find(filterText) != std::string::npos;
+    matches.insert(id, match);
+    return match;
+}
+
+QVariant HeaderColumnsProxyModel::data(const QModelIndex &index, int role) const {
+    if (role == Qt::DisplayRole && isHeaderColumn(index.column())) {
+        quint32 id = QSortFilterProxyModel::data(index, HEADER_VALUE_ID_ROLE).toUInt();
+        return QString::fromStdString(interner->value(id));
+    }
+    return QSortFilterProxyModel::data(index, role);
+}
+
+bool HeaderColumnsProxyModel::lessThan(const QModelIndex &left, const QModelIndex &right) const {
+    if (isHeaderColumn(left.column())) {
+        quint32 leftId = sourceModel()->data(left, HEADER_VALUE_ID_ROLE).toUInt();
+        quint32 rightId = sourceModel()->data(right, HEADER_VALUE_ID_ROLE).toUInt();
+        return leftId != rightId && interner->value(leftId) < interner->value(rightId);
+    }
+    return QSortFilterProxyModel::lessThan(left, right);
+}
+
+bool HeaderColumnsProxyModel::filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const {
+    if (filterText.empty()) {
+        return true;
+    }
+
+    // Строки без HTTP (обычные пакеты) при поиске по заголовкам скрываются
+    int first = filterColumn >= 0 ? filterColumn : firstColumn;
+    int last = filterColumn >= 0 ? filterColumn : firstColumn + static_cast<int>(names.size()) - 1;
+    for (int column = first; column <= last; column++) {
+        QModelIndex index = sourceModel()->index(sourceRow, column, sourceParent);
+        QVariant id = sourceModel()->data(index, HEADER_VALUE_ID_ROLE);
+        if (id.isValid() && valueMatches(id.toUInt())) {
+            return true;
+        }
+    }
+    return false;
+}
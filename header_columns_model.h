@@ -0,0 +1,57 @@
+#ifndef HEADER_COLUMNS_MODEL_H
+#define HEADER_COLUMNS_MODEL_H
+
+#include <QSortFilterProxyModel>
+#include <QStringList>
+#include <QHash>
+#include <string>
+
+#include "string_interner.h"
+
+// Роль, под которой в ячейке столбца заголовка хранится идентификатор
+// значения в StringInterner (сам текст в модели не хранится)
+const int HEADER_VALUE_ID_ROLE = Qt::UserRole + 2;
+
+// Прокси таблицы пакетов: показывает значения столбцов заголовков по их
+// идентификаторам, сортирует по тексту значения и фильтрует строки.
+// Фильтр проверяется один раз на каждое различное значение, а не на строку.
+class HeaderColumnsProxyModel : public QSortFilterProxyModel {
+    Q_OBJECT
+
+public:
+    HeaderColumnsProxyModel(const StringInterner *interner, QObject *parent = nullptr);
+
+    // Столбцы заголовков начинаются с firstColumn исходной модели
+    void setHeaderColumns(int firstColumn, const QStringList &names);
+
+    // Столбец процесса: значения тоже хранятся в таблице строк, фильтр
+    // "Имя: текст" по нему работает так же, как по столбцу заголовка
+    void setProcessColumn(int column, const QString &name);
+
+    // "текст" - подстрока в любом столбце заголовка,
+    // "Имя: текст" - только в столбце Имя (без учёта регистра)
+    void setHeaderFilter(const QString &text);
+
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+protected:
+    bool lessThan(const QModelIndex &left, const QModelIndex &right) const override;
+    bool filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const override;
+
+private:
+    const StringInterner *interner;
+    int firstColumn;
+    QStringList names;
+    int processColumn;                  // -1 - нет
+    QString processName;
+
+    int filterColumn;                   // -1 - все столбцы заголовков
+    std::string filterText;             // В нижнем регистре, UTF-8
+    mutable QHash<quint32, bool> matches;
+
+    // Столбец, значения которого хранятся идентификаторами (заголовки и процесс)
+    bool isHeaderColumn(int column) const;
+    bool valueMatches(quint32 id) const;
+};
+
+#endif // HEADER_COLUMNS_MODEL_H
@@ -0,0 +1,288 @@
+#include "hpack.h"
+#include <algorithm>
+
+namespace {
+
+struct StaticEntry {
+    const char* name;
+    const char* value;
+};
+
+// Статическая таблица (приложение A RFC 7541), индексы с 1
+const StaticEntry STATIC_TABLE[] = {
+    {":authority", ""},
+    {":method", "GET"},
+    {":method", "POST"},
+    {":path", "/"},
+    {":path", "/index.html"},
+    {":scheme", "http"},
+    {":scheme", "https"},
+    {":status", "200"},
+    {":status", "204"},
+    {":status", "206"},
+    {":status", "304"},
+    {":status", "400"},
+    {":status", "404"},
+    {":status", "500"},
+    {"accept-charset", ""},
+    {"accept-encoding", "gzip, deflate"},
+    {"accept-language", ""},
+    {"accept-ranges", ""},
+    {"accept", ""},
+    {"access-control-allow-origin", ""},
+    {"age", ""},
+    {"allow", ""},
+    {"authorization", ""},
+    {"cache-control", ""},
+    {"content-disposition", ""},
+    {"content-encoding", ""},
+    {"content-language", ""},
+    {"content-length", ""},
+    {"content-location", ""},
+    {"content-range", ""},
+    {"content-type", ""},
+    {"cookie", ""},
+    {"date", ""},
+    {"etag", ""},
+    {"expect", ""},
+    {"expires", ""},
+    {"from", ""},
+    {"host", ""},
+    {"if-match", ""},
+    {"if-modified-since", ""},
+    {"if-none-match", ""},
+    {"if-range", ""},
+    {"if-unmodified-since", ""},
+    {"last-modified", ""},
+    {"link", ""},
+    {"location", ""},
+    {"max-forwards", ""},
+    {"proxy-authenticate", ""},
+    {"proxy-authorization", ""},
+    {"range", ""},
+    {"referer", ""},
+    {"refresh", ""},
+    {"retry-after", ""},
+    {"server", ""},
+    {"set-cookie", ""},
+    {"strict-transport-security", ""},
+    {"transfer-encoding", ""},
+    {"user-agent", ""},
+    {"vary", ""},
+    {"via", ""},
+    {"www-authenticate", ""},
+};
+
+const size_t STATIC_TABLE_SIZE = sizeof(STATIC_TABLE) / sizeof(STATIC_TABLE[0]);
+
+// Накладные расходы записи динамической таблицы (RFC 7541, 4.1)
+const size_t ENTRY_OVERHEAD = 32;
+
+// Длины кодов Хаффмана для байтов 0-255 (приложение B RFC 7541).
+// Код канонический: сами коды восстанавливаются по длинам.
+const uint8_t HUFFMAN_CODE_LENGTHS[256] = {
+    13, 23, 28, 28, 28, 28, 28, 28, 28, 24, 30, 28, 28, 30, 28, 28,
+    28, 28, 28, 28, 28, 28, 30, 28, 28, 28, 28, 28, 28, 28, 28, 28,
+    6, 10, 10, 12, 13, 6, 8, 11, 10, 10, 8, 11, 8, 6, 6, 6,
+    5, 5, 5, 6, 6, 6, 6, 6, 6, 6, 7, 8, 15, 6, 12, 10,
+    13, 6, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+    7, 7, 7, 7, 7, 7, 7, 7, 8, 7, 8, 13, 19, 13, 14, 6,
+    15, 5, 6, 5, 6, 5, 6, 6, 6, 5, 7, 7, 6, 6, 6, 5,
+    6, 7, 6, 5, 5, 6, 7, 7, 7, 7, 7, 15, 11, 14, 13, 28,
+    20, 22, 20, 20, 22, 22, 22, 23, 22, 23, 23, 23, 23, 23, 24, 23,
+    24, 24, 22, 23, 24, 23, 23, 23, 23, 21, 22, 23, 22, 23, 23, 24,
+    22, 21, 20, 22, 22, 23, 23, 21, 23, 22, 22, 24, 21, 22, 23, 23,
+    21, 21, 22, 21, 23, 22, 23, 23, 20, 22, 22, 22, 23, 22, 22, 23,
+    26, 26, 20, 19, 22, 23, 22, 25, 26, 26, 26, 27, 27, 26, 24, 25,
+    19, 21, 26, 27, 27, 26, 27, 24, 21, 21, 26, 26, 28, 27, 27, 27,
+    20, 24, 20, 21, 22, 21, 21, 23, 22, 22, 25, 25, 24, 24, 26, 23,
+    26, 27, 26, 26, 27, 27, 27, 27, 27, 28, 27, 27, 27, 27, 27, 26,
+};
+
+const int MAX_CODE_LENGTH = 30;
+
+// Таблицы канонического декодирования: для каждой длины - первый код,
+// число кодов и позиция первого символа в списке, упорядоченном по длине
+struct HuffmanTables {
+    uint32_t firstCode[MAX_CODE_LENGTH + 1];
+    uint32_t count[MAX_CODE_LENGTH + 1];
+    uint32_t firstIndex[MAX_CODE_LENGTH + 1];
+    uint8_t symbols[256];
+
+    HuffmanTables() {
+        std::fill(firstCode, firstCode + MAX_CODE_LENGTH + 1, 0);
+        std::fill(count, count + MAX_CODE_LENGTH + 1, 0);
+        std::fill(firstIndex, firstIndex + MAX_CODE_LENGTH + 1, 0);
+
+        size_t index = 0;
+        for (int length = 1; length <= MAX_CODE_LENGTH; length++) {
+            firstIndex[length] = static_cast<uint32_t>(index);
+            for (int symbol = 0; symbol < 256; symbol++) {
+                if (HUFFMAN_CODE_LENGTHS[symbol] == length) {
+                    symbols[index++] = static_cast<uint8_t>(symbol);
+                    count[length]++;
+                }
+            }
+        }
+
+        uint32_t code = 0;
+        for (int length = 1; length <= MAX_CODE_LENGTH; length++) {
+            firstCode[length] = code;
+            code = (code + count[length]) << 1;
+        }
+    }
+};
+
+const HuffmanTables& huffmanTables() {
+    static const HuffmanTables tables;
+    return tables;
+}
+
+} // namespace
+
+HpackDecoder::HpackDecoder() : dynamicSize(0), maxSize(DEFAULT_TABLE_SIZE) {
+}
+
+bool HpackDecoder::decodeHuffman(const uint8_t* data, size_t size, std::string& out) {
+    const HuffmanTables& tables = huffmanTables();
+
+    uint32_t code = 0;
+    int length = 0;
+    for (size_t i = 0; i < size; i++) {
+        for (int bit = 7; bit >= 0; bit--) {
+            code = (code << 1) | ((data[i] >> bit) & 1);
+            length++;
+            if (code - tables.firstCode[length] < tables.count[length]) {
+                out.push_back(static_cast<char>(tables.symbols[tables.firstIndex[length] + code - tables.firstCode[length]]));
+                code = 0;
+                length = 0;
+            } else if (length == MAX_CODE_LENGTH) {
+                return false;   // EOS или некорректный код
+            }
+        }
+    }
+
+    // Дополнение - не длиннее 7 бит и только из единиц (начало кода EOS)
+    return length < 8 && code == (uint32_t(1) << length) - 1;
+}
+
+bool HpackDecoder::readInteger(const uint8_t* data, size_t size, size_t& pos, int prefixBits, size_t& value) {
+    if (pos >= size) return false;
+
+    size_t mask = (size_t(1) << prefixBits) - 1;
+    value = data[pos++] & mask;
+    if (value < mask) return true;
+
+    // Продолжение по 7 бит; значения больше 2^28 не нужны ни для индексов, ни для длин
+    for (int shift = 0; shift <= 21; shift += 7) {
+        if (pos >= size) return false;
+        uint8_t byte = data[pos++];
+        value += size_t(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+bool HpackDecoder::readString(const uint8_t* data, size_t size, size_t& pos, std::string& out) {
+    if (pos >= size) return false;
+
+    bool huffman = (data[pos] & 0x80) != 0;
+    size_t length = 0;
+    if (!readInteger(data, size, pos, 7, length) || size - pos < length) return false;
+
+    out.clear();
+    bool ok = true;
+    if (huffman) {
+        ok = decodeHuffman(data + pos, length, out);
+    } else {
+        out.assign(reinterpret_cast<const char*>(data) + pos, length);
+    }
+    pos += length;
+    return ok;
+}
+
+bool HpackDecoder::readEntry(size_t index, HpackHeader& header, bool withValue) const {
+    if (index == 0) return false;
+
+    if (index <= STATIC_TABLE_SIZE) {
+        header.name.assign(STATIC_TABLE[index - 1].name);
+        if (withValue) header.value.assign(STATIC_TABLE[index - 1].value);
+        return true;
+    }
+
+    index -= STATIC_TABLE_SIZE + 1;
+    if (index >= dynamicTable.size()) return false;
+    header.name.assign(dynamicTable[index].name);
+    if (withValue) header.value.assign(dynamicTable[index].value);
+    return true;
+}
+
+void HpackDecoder::evict(size_t limit) {
+    while (dynamicSize > limit && !dynamicTable.empty()) {
+        const HpackHeader& oldest = dynamicTable.back();
+        dynamicSize -= oldest.name.size() + oldest.value.size() + ENTRY_OVERHEAD;
+        dynamicTable.pop_back();
+    }
+}
+
+void HpackDecoder::insert(const HpackHeader& header) {
+    size_t entrySize = header.name.size() + header.value.size() + ENTRY_OVERHEAD;
+
+    // Запись больше таблицы просто очищает её (RFC 7541, 4.4)
+    if (entrySize > maxSize) {
+        evict(0);
+        return;
+    }
+    evict(maxSize - entrySize);
+    dynamicTable.push_front(header);
+    dynamicSize += entrySize;
+}
+
+bool HpackDecoder::decode(const uint8_t* data, size_t size, std::vector<HpackHeader>& headers, size_t& count) {
+    count = 0;
+    size_t listSize = 0;
+    size_t pos = 0;
+
+    while (pos < size) {
+        uint8_t first = data[pos];
+
+        // Изменение размера таблицы
+        if ((first & 0xe0) == 0x20) {
+            size_t newSize = 0;
+            if (!readInteger(data, size, pos, 5, newSize) || newSize > MAX_TABLE_SIZE) return false;
+            maxSize = newSize;
+            evict(maxSize);
+            continue;
+        }
+
+        if (count == headers.size()) {
+            headers.emplace_back();
+        }
+        HpackHeader& header = headers[count];
+
+        if (first & 0x80) {
+            // Индексированное поле
+            size_t index = 0;
+            if (!readInteger(data, size, pos, 7, index) || !readEntry(index, header, true)) return false;
+        } else {
+            // Литерал: с индексированием (01), без (0000) или никогда не индексируемый (0001)
+            bool indexing = (first & 0xc0) == 0x40;
+            size_t index = 0;
+            if (!readInteger(data, size, pos, indexing ? 6 : 4, index)) return false;
+            if (index > 0) {
+                if (!readEntry(index, header, false)) return false;
+            } else if (!readString(data, size, pos, header.name)) {
+                return false;
+            }
+            if (!readString(data, size, pos, header.value)) return false;
+            if (indexing) {
+                insert(header);
+            }
+        }
+
+        listSize += header.name.size() + header.value.size() + ENTRY_OVERHEAD;
+        if (listSize > MAX_HEADER_LIST_SIZE) return false;
+        count++;
+    }
+    return true;
+}
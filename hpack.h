@@ -0,0 +1,53 @@
+#ifndef HPACK_H
+#define HPACK_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <deque>
+
+struct HpackHeader {
+    std::string name;
+    std::string value;
+};
+
+// Декодер HPACK (RFC 7541) для одного направления соединения HTTP/2.
+// Динамическая таблица своя у каждого направления и меняется каждым
+// блоком заголовков, поэтому блоки нужно декодировать все и по порядку -
+// в том числе у потоков, которые дальше не отслеживаются.
+class HpackDecoder {
+public:
+    static constexpr size_t DEFAULT_TABLE_SIZE = 4096;
+    // Потолок размера таблицы, который может объявить кодер
+    static constexpr size_t MAX_TABLE_SIZE = 64 * 1024;
+    // Предел суммарного размера заголовков одного блока
+    static constexpr size_t MAX_HEADER_LIST_SIZE = 256 * 1024;
+
+    HpackDecoder();
+
+    // Декодирует блок заголовков. Строки в headers переиспользуются между
+    // вызовами (без выделения памяти на каждый блок): результат - первые
+    // count элементов. false - ошибка сжатия, дальше соединение не декодировать.
+    bool decode(const uint8_t* data, size_t size, std::vector<HpackHeader>& headers, size_t& count);
+
+    size_t tableSize() const { return dynamicSize; }
+    size_t tableEntries() const { return dynamicTable.size(); }
+
+    // Строка, сжатая статическим кодом Хаффмана (приложение B RFC 7541)
+    static bool decodeHuffman(const uint8_t* data, size_t size, std::string& out);
+
+private:
+    std::deque<HpackHeader> dynamicTable;   // В начале - самая новая запись
+    size_t dynamicSize;
+    size_t maxSize;
+
+    bool readEntry(size_t index, HpackHeader& header, bool withValue) const;
+    void insert(const HpackHeader& header);
+    void evict(size_t limit);
+
+    static bool readInteger(const uint8_t* data, size_t size, size_t& pos, int prefixBits, size_t& value);
+    static bool readString(const uint8_t* data, size_t size, size_t& pos, std::string& out);
+};
+
+#endif // HPACK_H
@@ -0,0 +1,252 @@
+#include "http2_decoder.h"
+#include "trace.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+const char PREFACE[] = "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n";
+
+const uint8_t FLAG_END_STREAM = 0x01;
+const uint8_t FLAG_END_HEADERS = 0x04;
+const uint8_t FLAG_PADDED = 0x08;
+const uint8_t FLAG_PRIORITY = 0x20;
+
+inline uint32_t read24(const uint8_t* data) {
+    return (uint32_t(data[0]) << 16) | (uint32_t(data[1]) << 8) | data[2];
+}
+
+inline uint32_t readStreamId(const uint8_t* data) {
+    return ((uint32_t(data[0]) << 24) | (uint32_t(data[1]) << 16) | (uint32_t(data[2]) << 8) | data[3]) & 0x7fffffff;
+}
+
+} // namespace
+
+bool Http2Decoder::matchesPreface(const uint8_t* data, size_t size) {
+    return memcmp(data, PREFACE, std::min(size, PREFACE_LENGTH)) == 0;
+}
+
+bool Http2Decoder::looksLikeServerStart(const uint8_t* data, size_t size) {
+    // Заголовок кадра: длина (кратна 6, параметры SETTINGS), тип 4,
+    // флаги 0, поток 0; для коротких данных - совпадение префикса
+    static const uint8_t expected[9] = {0, 0, 0, H2_SETTINGS, 0, 0, 0, 0, 0};
+    for (size_t i = 0; i < size && i < 9; i++) {
+        if (i != 1 && i != 2 && data[i] != expected[i]) return false;
+    }
+    return size < 9 || read24(data) % 6 == 0;
+}
+
+Http2Decoder::Http2Decoder(bool expectPreface, size_t maxBody)
+    : maxBody(maxBody), bufferedBody(0), prefaceRemaining(expectPreface ? PREFACE_LENGTH : 0), frameCount(0),
+      headerSize(0), payloadLength(0), headerBlockStream(0), headerBlockEndStream(false),
+      headerBlockPromise(false) {
+}
+
+bool Http2Decoder::feed(const uint8_t* data, size_t size, const MessageCallback& callback) {
+    TRACE_SCOPE("http2.feed");
+
+    while (size > 0) {
+        if (prefaceRemaining > 0) {
+            size_t offset = PREFACE_LENGTH - prefaceRemaining;
+            size_t take = std::min(prefaceRemaining, size);
+            if (memcmp(data, PREFACE + offset, take) != 0) return false;
+            prefaceRemaining -= take;
+            data += take;
+            size -= take;
+            continue;
+        }
+
+        if (headerSize == 0 && size >= 9) {
+            // Кадр целиком в сегменте - разбирается на месте, без копирования
+            size_t length = read24(data);
+            if (length > MAX_FRAME_SIZE) return false;
+            if (size - 9 >= length) {
+                if (!processFrame(data[3], data[4], readStreamId(data + 5), data + 9, length, callback)) {
+                    return false;
+                }
+                data += 9 + length;
+                size -= 9 + length;
+                continue;
+            }
+        }
+
+        if (headerSize < 9) {
+            size_t take = std::min(9 - headerSize, size);
+            memcpy(header + headerSize, data, take);
+            headerSize += take;
+            data += take;
+            size -= take;
+            if (headerSize < 9) return true;
+
+            payloadLength = read24(header);
+            if (payloadLength > MAX_FRAME_SIZE) return false;
+            payload.clear();
+        }
+
+        size_t take = std::min(payloadLength - payload.size(), size);
+        payload.insert(payload.end(), data, data + take);
+        data += take;
+        size -= take;
+
+        if (payload.size() == payloadLength) {
+            headerSize = 0;
+            if (!processFrame(header[3], header[4], readStreamId(header + 5), payload.data(), payloadLength, callback)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool Http2Decoder::stripPadding(uint8_t flags, const uint8_t*& data, size_t& length) {
+    if (!(flags & FLAG_PADDED)) return true;
+    if (length < 1 || data[0] >= length) return false;
+    length -= 1 + data[0];
+    data += 1;
+    return true;
+}
+
+bool Http2Decoder::processFrame(uint8_t type, uint8_t flags, uint32_t streamId,
+                                const uint8_t* data, size_t length, const MessageCallback& callback) {
+    frameCount++;
+
+    // Блок заголовков прерывать нельзя: допустимы только его CONTINUATION
+    if (headerBlockStream != 0) {
+        if (type != H2_CONTINUATION || streamId != headerBlockStream ||
+            headerBlock.size() + length > MAX_FRAME_SIZE) {
+            return false;
+        }
+        headerBlock.insert(headerBlock.end(), data, data + length);
+        return (flags & FLAG_END_HEADERS) ? onHeaderBlock(callback) : true;
+    }
+
+    switch (type) {
+    case H2_DATA: {
+        if (streamId == 0 || !stripPadding(flags, data, length)) return false;
+        auto it = streams.find(streamId);
+        if (it == streams.end() || !it->second.headersDone) {
+            return true;   // Поток не отслеживается
+        }
+        // Сверх пределов тело обрезается, но сообщение всё равно выводится
+        std::vector<uint8_t>& body = it->second.body;
+        size_t keep = std::min(length, maxBody - std::min(maxBody, body.size()));
+        keep = std::min(keep, MAX_BUFFERED_BODY - bufferedBody);
+        body.insert(body.end(), data, data + keep);
+        bufferedBody += keep;
+        if (flags & FLAG_END_STREAM) {
+            finishStream(streamId, callback);
+        }
+        return true;
+    }
+    case H2_HEADERS:
+    case H2_PUSH_PROMISE: {
+        if (streamId == 0 || !stripPadding(flags, data, length)) return false;
+        // Приоритет в HEADERS, номер обещанного потока в PUSH_PROMISE
+        size_t skip = type == H2_PUSH_PROMISE ? 4 : (flags & FLAG_PRIORITY) ? 5 : 0;
+        if (length < skip) return false;
+
+        headerBlock.assign(data + skip, data + length);
+        headerBlockStream = streamId;
+        headerBlockEndStream = type == H2_HEADERS && (flags & FLAG_END_STREAM);
+        headerBlockPromise = type == H2_PUSH_PROMISE;
+        return (flags & FLAG_END_HEADERS) ? onHeaderBlock(callback) : true;
+    }
+    case H2_CONTINUATION:
+        return false;   // Вне блока заголовков
+    case H2_RST_STREAM: {
+        auto it = streams.find(streamId);
+        if (it != streams.end()) {
+            eraseStream(it);
+        }
+        return true;
+    }
+    default:
+        // SETTINGS, PING, WINDOW_UPDATE, GOAWAY, PRIORITY и неизвестные типы
+        // на содержимое сообщений не влияют
+        return true;
+    }
+}
+
+bool Http2Decoder::onHeaderBlock(const MessageCallback& callback) {
+    uint32_t streamId = headerBlockStream;
+    headerBlockStream = 0;
+
+    // Декодируются все блоки: иначе разойдётся динамическая таблица
+    size_t count = 0;
+    if (!hpack.decode(headerBlock.data(), headerBlock.size(), headers, count)) {
+        return false;
+    }
+    if (headerBlockPromise) {
+        return true;   // Запрос, обещанный сервером, в таблицу не выводится
+    }
+
+    auto it = streams.find(streamId);
+    if (it == streams.end()) {
+        if (streams.size() >= MAX_STREAMS) return true;
+        it = streams.emplace(streamId, Message()).first;
+    }
+    Message& message = it->second;
+
+    if (!message.headersDone) {
+        const std::string* method = nullptr;
+        const std::string* path = nullptr;
+        const std::string* authority = nullptr;
+        const std::string* status = nullptr;
+        for (size_t i = 0; i < count; i++) {
+            const std::string& name = headers[i].name;
+            if (name == ":method") method = &headers[i].value;
+            else if (name == ":path") path = &headers[i].value;
+            else if (name == ":authority") authority = &headers[i].value;
+            else if (name == ":status") status = &headers[i].value;
+        }
+
+        if (status) {
+            // Промежуточный ответ 1xx: окончательные заголовки придут следующим блоком
+            if (!status->empty() && (*status)[0] == '1') return true;
+            message.head = "HTTP/2 " + *status + "\r\n";
+        } else if (method) {
+            message.head = *method + " " + (path ? *path : std::string("*")) + " HTTP/2\r\n";
+            if (authority) {
+                message.head += "Host: " + *authority + "\r\n";
+            }
+        } else {
+            eraseStream(it);
+            return true;
+        }
+        message.headersDone = true;
+    }
+
+    // Обычные заголовки, а после тела - трейлеры (grpc-status и т.п.)
+    for (size_t i = 0; i < count; i++) {
+        const HpackHeader& field = headers[i];
+        if (field.name.empty() || field.name[0] == ':') continue;
+        message.head += field.name;
+        message.head += ": ";
+        message.head += field.value;
+        message.head += "\r\n";
+    }
+
+    if (headerBlockEndStream) {
+        finishStream(streamId, callback);
+    }
+    return true;
+}
+
+void Http2Decoder::finishStream(uint32_t streamId, const MessageCallback& callback) {
+    auto it = streams.find(streamId);
+    if (it == streams.end()) return;
+
+    const Message& message = it->second;
+    output.assign(message.head.begin(), message.head.end());
+    output.push_back('\r');
+    output.push_back('\n');
+    output.insert(output.end(), message.body.begin(), message.body.end());
+    eraseStream(it);
+
+    callback(streamId, output);
+}
+
+void Http2Decoder::eraseStream(std::unordered_map<uint32_t, Message>::iterator it) {
+    bufferedBody -= it->second.body.size();
+    streams.erase(it);
+}
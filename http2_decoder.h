@@ -0,0 +1,102 @@
+#ifndef HTTP2_DECODER_H
+#define HTTP2_DECODER_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <functional>
+
+#include "hpack.h"
+
+// Типы кадров (RFC 9113, 6)
+enum Http2FrameType {
+    H2_DATA = 0x0,
+    H2_HEADERS = 0x1,
+    H2_PRIORITY = 0x2,
+    H2_RST_STREAM = 0x3,
+    H2_SETTINGS = 0x4,
+    H2_PUSH_PROMISE = 0x5,
+    H2_PING = 0x6,
+    H2_GOAWAY = 0x7,
+    H2_WINDOW_UPDATE = 0x8,
+    H2_CONTINUATION = 0x9
+};
+
+// Разбор одного направления соединения HTTP/2 без шифрования (h2c).
+// Потоки HTTP/2 собираются в сообщения в текстовом виде HTTP/1
+// ("POST /path HTTP/2", заголовки, пустая строка, тело), чтобы дальше
+// они проходили тот же путь, что и HTTP/1: разбор, столбцы заголовков,
+// статистика, распаковка тела. Сообщение отдаётся по END_STREAM.
+class Http2Decoder {
+public:
+    // streamId - номер потока HTTP/2, по нему ответ сопоставляется с запросом
+    typedef std::function<void(uint32_t streamId, const std::vector<uint8_t>&)> MessageCallback;
+
+    // Начало соединения со стороны клиента
+    static constexpr size_t PREFACE_LENGTH = 24;
+
+    // Предел кадра: больше SETTINGS_MAX_FRAME_SIZE по умолчанию с запасом
+    static constexpr size_t MAX_FRAME_SIZE = 1024 * 1024;
+    // Отслеживаемых одновременно потоков; заголовки остальных только декодируются
+    static constexpr size_t MAX_STREAMS = 256;
+    // Тела всех незавершённых потоков направления вместе
+    static constexpr size_t MAX_BUFFERED_BODY = 4 * 1024 * 1024;
+
+    // Совпадение с началом "PRI * HTTP/2.0..." (для коротких данных - с префиксом)
+    static bool matchesPreface(const uint8_t* data, size_t size);
+
+    // Первый кадр сервера - SETTINGS на нулевом потоке
+    static bool looksLikeServerStart(const uint8_t* data, size_t size);
+
+    // expectPreface - направление клиента при prior knowledge;
+    // maxBody - сколько байт тела сохранять (остальное только считается)
+    explicit Http2Decoder(bool expectPreface, size_t maxBody = 1024 * 1024);
+
+    // Передаёт очередные байты направления; false - поток не HTTP/2
+    // или ошибка сжатия заголовков (продолжать разбор нельзя)
+    bool feed(const uint8_t* data, size_t size, const MessageCallback& callback);
+
+    uint64_t frames() const { return frameCount; }
+
+private:
+    struct Message {
+        std::string head;          // Стартовая строка и заголовки в виде HTTP/1
+        std::vector<uint8_t> body;
+        bool headersDone = false;
+    };
+
+    size_t maxBody;
+    size_t bufferedBody;
+    size_t prefaceRemaining;
+    uint64_t frameCount;
+
+    // Кадр, разрезанный между сегментами, собирается здесь
+    uint8_t header[9];
+    size_t headerSize;
+    std::vector<uint8_t> payload;
+    size_t payloadLength;
+
+    // Блок заголовков (HEADERS или PUSH_PROMISE + CONTINUATION)
+    std::vector<uint8_t> headerBlock;
+    uint32_t headerBlockStream;       // 0 - блок не собирается
+    bool headerBlockEndStream;
+    bool headerBlockPromise;
+
+    HpackDecoder hpack;
+    std::vector<HpackHeader> headers;  // Переиспользуется между блоками
+    std::unordered_map<uint32_t, Message> streams;
+    std::vector<uint8_t> output;       // Буфер собранного сообщения
+
+    bool processFrame(uint8_t type, uint8_t flags, uint32_t streamId,
+                      const uint8_t* data, size_t length, const MessageCallback& callback);
+    bool onHeaderBlock(const MessageCallback& callback);
+    void finishStream(uint32_t streamId, const MessageCallback& callback);
+    void eraseStream(std::unordered_map<uint32_t, Message>::iterator it);
+
+    // Полезная нагрузка без дополнения (PADDED); false - некорректная длина
+    static bool stripPadding(uint8_t flags, const uint8_t*& data, size_t& length);
+};
+
+#endif // HTTP2_DECODER_H
@@ -0,0 +1,385 @@
+#include "http_body_decoder.h"
+#include "trace.h"
+#include <algorithm>
+#include <cctype>
+#include <memory>
+#include <vector>
+#include <zlib.h>
+#ifdef SNIFFER_BROTLI
+#include <brotli/decode.h>
+#endif
+
+namespace {
+
+// Размер промежуточного буфера распаковки
+const size_t INFLATE_CHUNK = 16 * 1024;
+
+std::string toLower(std::string text) {
+    std::transform(text.begin(), text.end(), text.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return text;
+}
+
+// Список кодирований через запятую, в нижнем регистре, без identity
+std::vector<std::string> splitEncodings(const std::string& value) {
+    std::vector<std::string> result;
+    size_t start = 0;
+    while (start <= value.size()) {
+        size_t end = value.find(',', start);
+        if (end == std::string::npos) end = value.size();
+
+        std::string item = value.substr(start, end - start);
+        size_t first = item.find_first_not_of(" \t");
+        size_t last = item.find_last_not_of(" \t");
+        if (first != std::string::npos) {
+            item = toLower(item.substr(first, last - first + 1));
+            if (item != "identity") {
+                result.push_back(item);
+            }
+        }
+        start = end + 1;
+    }
+    return result;
+}
+
+// Разбирает строку размера куска "1a;ext\r\n", начиная с pos.
+// Возвращает false, если строка неполная или некорректная.
+bool parseChunkHeader(const uint8_t* data, size_t size, size_t& pos, size_t& chunkSize, bool& valid) {
+    valid = true;
+    size_t value = 0;
+    size_t digits = 0;
+    size_t i = pos;
+    for (; i < size && std::isxdigit(data[i]); i++, digits++) {
+        if (value > (SIZE_MAX >> 8)) {
+            valid = false;
+            return false;
+        }
+        int c = std::tolower(data[i]);
+        value = value * 16 + (c <= '9' ? c - '0' : c - 'a' + 10);
+    }
+    if (i == size) return false;
+    if (digits == 0) {
+        valid = false;
+        return false;
+    }
+
+    // Расширения куска пропускаем до конца строки
+    for (; i + 1 < size; i++) {
+        if (data[i] == '\r' && data[i + 1] == '\n') {
+            pos = i + 2;
+            chunkSize = value;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Звено цепочки декодирования: получает байты и передаёт результат дальше
+class Stage {
+public:
+    virtual ~Stage() {}
+    virtual BodyDecodeStatus write(const uint8_t* data, size_t size) = 0;
+    virtual BodyDecodeStatus finish() = 0;
+};
+
+// Последнее звено: накапливает результат до предела
+class OutputStage : public Stage {
+public:
+    OutputStage(std::string& output, size_t limit) : output(output), limit(limit) {}
+
+    BodyDecodeStatus write(const uint8_t* data, size_t size) override {
+        size_t room = limit - output.size();
+        if (size > room) {
+            output.append(reinterpret_cast<const char*>(data), room);
+            return BODY_LIMIT;
+        }
+        output.append(reinterpret_cast<const char*>(data), size);
+        return BODY_OK;
+    }
+
+    BodyDecodeStatus finish() override { return BODY_OK; }
+
+private:
+    std::string& output;
+    size_t limit;
+};
+
+// gzip и deflate через zlib
+class InflateStage : public Stage {
+public:
+    InflateStage(Stage* next, bool gzip) : next(next), gzip(gzip), initialized(false), ended(false),
+        headerSize(0) {
+        stream = z_stream();
+    }
+
+    ~InflateStage() override {
+        if (initialized) {
+            inflateEnd(&stream);
+        }
+    }
+
+    BodyDecodeStatus write(const uint8_t* data, size_t size) override {
+        if (ended || size == 0) return BODY_OK;
+
+        if (!initialized) {
+            // deflate на практике бывает и в обёртке zlib (RFC 1950), и "сырым"
+            // (RFC 1951): различаем по первым двум байтам
+            if (!gzip && headerSize < 2) {
+                size_t take = std::min(size, 2 - headerSize);
+                std::copy(data, data + take, header + headerSize);
+                headerSize += take;
+                data += take;
+                size -= take;
+                if (headerSize < 2) return BODY_OK;
+            }
+
+            int windowBits = gzip ? 15 + 16 : (isZlibHeader() ? 15 : -15);
+            if (inflateInit2(&stream, windowBits) != Z_OK) return BODY_ERROR;
+            initialized = true;
+
+            if (!gzip) {
+                BodyDecodeStatus status = inflateSome(header, headerSize);
+                if (status != BODY_OK || ended) return status;
+            }
+        }
+
+        return inflateSome(data, size);
+    }
+
+    BodyDecodeStatus finish() override {
+        if (!ended) return BODY_INCOMPLETE;
+        return next->finish();
+    }
+
+private:
+    Stage* next;
+    bool gzip;
+    bool initialized;
+    bool ended;
+    z_stream stream;
+    uint8_t header[2];
+    size_t headerSize;
+
+    bool isZlibHeader() const {
+        return (header[0] & 0x0f) == 8 && (header[0] >> 4) <= 7 &&
+               ((header[0] << 8) | header[1]) % 31 == 0;
+    }
+
+    BodyDecodeStatus inflateSome(const uint8_t* data, size_t size) {
+        uint8_t output[INFLATE_CHUNK];
+        stream.next_in = const_cast<Bytef*>(data);
+        stream.avail_in = static_cast<uInt>(size);
+
+        while (true) {
+            stream.next_out = output;
+            stream.avail_out = sizeof(output);
+            int result = inflate(&stream, Z_NO_FLUSH);
+
+            size_t produced = sizeof(output) - stream.avail_out;
+            if (produced > 0) {
+                BodyDecodeStatus status = next->write(output, produced);
+                if (status != BODY_OK) return status;
+            }
+
+            if (result == Z_STREAM_END) {
+                // gzip может состоять из нескольких членов подряд
+                if (gzip && stream.avail_in > 0) {
+                    inflateReset(&stream);
+                    continue;
+                }
+                ended = true;
+                return BODY_OK;
+            }
+            if (result == Z_BUF_ERROR || (result == Z_OK && stream.avail_in == 0 && stream.avail_out > 0)) {
+                return BODY_OK;   // Нужны следующие данные
+            }
+            if (result != Z_OK) {
+                return BODY_ERROR;
+            }
+        }
+    }
+};
+
+#ifdef SNIFFER_BROTLI
+class BrotliStage : public Stage {
+public:
+    explicit BrotliStage(Stage* next) : next(next), ended(false) {
+        state = BrotliDecoderCreateInstance(nullptr, nullptr, nullptr);
+    }
+
+    ~BrotliStage() override {
+        BrotliDecoderDestroyInstance(state);
+    }
+
+    BodyDecodeStatus write(const uint8_t* data, size_t size) override {
+        if (ended || size == 0) return BODY_OK;
+        if (!state) return BODY_ERROR;
+
+        uint8_t output[INFLATE_CHUNK];
+        size_t availableIn = size;
+        const uint8_t* nextIn = data;
+
+        while (true) {
+            size_t availableOut = sizeof(output);
+            uint8_t* nextOut = output;
+            BrotliDecoderResult result = BrotliDecoderDecompressStream(
+                state, &availableIn, &nextIn, &availableOut, &nextOut, nullptr);
+
+            size_t produced = sizeof(output) - availableOut;
+            if (produced > 0) {
+                BodyDecodeStatus status = next->write(output, produced);
+                if (status != BODY_OK) return status;
+            }
+
+            if (result == BROTLI_DECODER_RESULT_SUCCESS) {
+                ended = true;
+                return BODY_OK;
+            }
+            if (result == BROTLI_DECODER_RESULT_NEEDS_MORE_INPUT) return BODY_OK;
+            if (result == BROTLI_DECODER_RESULT_ERROR) return BODY_ERROR;
+        }
+    }
+
+    BodyDecodeStatus finish() override {
+        if (!ended) return BODY_INCOMPLETE;
+        return next->finish();
+    }
+
+private:
+    Stage* next;
+    BrotliDecoderState* state;
+    bool ended;
+};
+#endif
+
+} // namespace
+
+bool HttpBodyDecoder::isChunked(const std::string& transferEncoding) {
+    std::vector<std::string> codings = splitEncodings(transferEncoding);
+    return !codings.empty() && codings.back() == "chunked";
+}
+
+bool HttpBodyDecoder::isSupportedEncoding(const std::string& encoding) {
+    std::string name = toLower(encoding);
+    if (name == "gzip" || name == "x-gzip" || name == "deflate" || name == "identity") return true;
+#ifdef SNIFFER_BROTLI
+    if (name == "br") return true;
+#endif
+    return false;
+}
+
+size_t HttpBodyDecoder::chunkedLength(const uint8_t* data, size_t size) {
+    size_t pos = 0;
+    while (true) {
+        size_t chunkSize = 0;
+        bool valid = true;
+        if (!parseChunkHeader(data, size, pos, chunkSize, valid)) return 0;
+
+        if (chunkSize == 0) break;
+
+        // Данные куска и завершающий CRLF
+        if (chunkSize > size - pos || size - pos - chunkSize < 2) return 0;
+        pos += chunkSize + 2;
+    }
+
+    // Трейлеры до пустой строки
+    while (true) {
+        if (size - pos < 2) return 0;
+        if (data[pos] == '\r' && data[pos + 1] == '\n') return pos + 2;
+
+        size_t lineEnd = pos;
+        while (lineEnd + 1 < size && !(data[lineEnd] == '\r' && data[lineEnd + 1] == '\n')) lineEnd++;
+        if (lineEnd + 1 >= size) return 0;
+        pos = lineEnd + 2;
+    }
+}
+
+BodyDecodeResult HttpBodyDecoder::decode(const uint8_t* data, size_t size,
+                                         const std::string& transferEncoding,
+                                         const std::string& contentEncoding,
+                                         size_t maxOutput) {
+    TRACE_SCOPE("http.decodeBody");
+
+    BodyDecodeResult result;
+    OutputStage output(result.data, maxOutput);
+
+    // Цепочка строится с конца: первым получает данные распаковщик
+    // последнего из перечисленных кодирований
+    std::vector<std::unique_ptr<Stage>> stages;
+    Stage* head = &output;
+    bool unsupported = false;
+    for (const std::string& encoding : splitEncodings(contentEncoding)) {
+        if (encoding == "gzip" || encoding == "x-gzip") {
+            stages.emplace_back(new InflateStage(head, true));
+        } else if (encoding == "deflate") {
+            stages.emplace_back(new InflateStage(head, false));
+#ifdef SNIFFER_BROTLI
+        } else if (encoding == "br") {
+            stages.emplace_back(new BrotliStage(head));
+#endif
+        } else {
+            result.message = "Кодирование \"" + encoding + "\" не поддерживается, показаны исходные байты";
+            unsupported = true;
+            break;
+        }
+        head = stages.back().get();
+    }
+    if (unsupported) {
+        stages.clear();
+        head = &output;
+    }
+
+    BodyDecodeStatus status = BODY_OK;
+    bool truncatedChunks = false;
+    if (isChunked(transferEncoding)) {
+        size_t pos = 0;
+        while (status == BODY_OK) {
+            size_t chunkSize = 0;
+            bool valid = true;
+            if (!parseChunkHeader(data, size, pos, chunkSize, valid)) {
+                if (!valid) status = BODY_ERROR;
+                truncatedChunks = valid;
+                break;
+            }
+            if (chunkSize == 0) break;
+
+            size_t available = std::min(chunkSize, size - pos);
+            status = head->write(data + pos, available);
+            if (available < chunkSize || size - pos - chunkSize < 2) {
+                truncatedChunks = true;
+                break;
+            }
+            pos += chunkSize + 2;
+        }
+    } else {
+        status = head->write(data, size);
+    }
+
+    if (status == BODY_OK) {
+        status = head->finish();
+        if (status == BODY_OK && truncatedChunks) {
+            status = BODY_INCOMPLETE;
+        }
+    }
+
+    if (unsupported && status == BODY_OK) {
+        status = BODY_UNSUPPORTED;
+    }
+
+    result.status = status;
+    switch (status) {
+    case BODY_LIMIT:
+        result.message = "Показаны первые " + std::to_string(maxOutput / 1024) +
+                         " КБ: распакованное тело больше предела";
+        break;
+    case BODY_INCOMPLETE:
+        result.message = "Тело получено не полностью";
+        break;
+    case BODY_ERROR:
+        result.message = "Тело повреждено: распаковано " + std::to_string(result.data.size()) + " байт";
+        break;
+    default:
+        break;
+    }
+    return result;
+}
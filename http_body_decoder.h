@@ -0,0 +1,48 @@
+#ifndef HTTP_BODY_DECODER_H
+#define HTTP_BODY_DECODER_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+// Результат декодирования тела
+enum BodyDecodeStatus {
+    BODY_OK,            // Тело декодировано полностью
+    BODY_LIMIT,         // Достигнут предел размера результата (тело обрезано)
+    BODY_INCOMPLETE,    // Данные закончились раньше, чем поток сжатия или chunked
+    BODY_UNSUPPORTED,   // Неизвестное кодирование (результат - исходные байты)
+    BODY_ERROR          // Повреждённые данные
+};
+
+struct BodyDecodeResult {
+    BodyDecodeStatus status = BODY_OK;
+    std::string data;           // Декодированные байты (не более maxOutput)
+    std::string message;        // Пояснение для пользователя при status != BODY_OK
+};
+
+// Декодирование тела HTTP/1.x по Transfer-Encoding (chunked) и
+// Content-Encoding (gzip, deflate, br). Разбор chunked и распаковка идут
+// одним потоком: куски передаются распаковщику без промежуточной копии
+// всего тела, а распаковка прекращается, как только результат достиг
+// maxOutput, поэтому "бомба" не занимает больше памяти, чем задано.
+class HttpBodyDecoder {
+public:
+    static const size_t DEFAULT_MAX_OUTPUT = 16 * 1024 * 1024;
+
+    static BodyDecodeResult decode(const uint8_t* data, size_t size,
+                                   const std::string& transferEncoding,
+                                   const std::string& contentEncoding,
+                                   size_t maxOutput = DEFAULT_MAX_OUTPUT);
+
+    // Есть ли chunked в значении Transfer-Encoding
+    static bool isChunked(const std::string& transferEncoding);
+
+    // Длина chunked-тела вместе с последним куском и трейлерами;
+    // 0 - тело ещё не получено целиком или повреждено
+    static size_t chunkedLength(const uint8_t* data, size_t size);
+
+    // Поддерживается ли кодирование сборкой (br - только с CONFIG+=brotli)
+    static bool isSupportedEncoding(const std::string& encoding);
+};
+
+#endif // HTTP_BODY_DECODER_H
@@ -1,7 +1,10 @@
 #include "http_parser.h"
+#include "string_interner.h"
+#include "trace.h"
 #include <sstream>
 #include <algorithm>
 #include <cstring>
+#include <cctype>
 
 bool HTTPParser::isHTTP(const unsigned char* data, size_t size) {
     if (size < 10) return false;
@@ -11,7 +14,8 @@ bool HTTPParser::isHTTP(const unsigned char* data, size_t size) {
     // Проверка запроса HTTP
     if (start.find("GET ") == 0 || start.find("POST ") == 0 ||
         start.find("PUT ") == 0 || start.find("DELETE ") == 0 ||
-        start.find("HEAD ") == 0 || start.find("OPTIONS ") == 0) {
+        start.find("HEAD ") == 0 || start.find("OPTIONS ") == 0 ||
+        start.find("CONNECT ") == 0) {
         return true;
     }
 
@@ -30,10 +34,13 @@ HTTPMethod HTTPParser::stringToMethod(const std::string& method) {
     if (method == "DELETE") return HTTP_DELETE;
     if (method == "HEAD") return HTTP_HEAD;
     if (method == "OPTIONS") return HTTP_OPTIONS;
+    if (method == "CONNECT") return HTTP_CONNECT;
     return HTTP_UNKNOWN;
 }
 
 HTTPMessage HTTPParser::parseHTTP(const unsigned char* data, size_t size) {
+    TRACE_SCOPE("http.parse");
+
     HTTPMessage message;
     std::string httpData(reinterpret_cast<const char*>(data), size);
     std::istringstream stream(httpData);
@@ -96,12 +103,71 @@ HTTPMessage HTTPParser::parseHTTP(const unsigned char* data, size_t size) {
         }
     }
 
-    // Разбор тела сообщения
-    std::string body;
-    while (std::getline(stream, line)) {
-        body += line + "\n";
+    // Тело сохраняется байт в байт: оно может быть сжатым или двоичным
+    // и декодируется только при просмотре (см. HttpBodyDecoder)
+    std::streamoff bodyStart = stream.tellg();
+    if (bodyStart > 0 && static_cast<size_t>(bodyStart) < size) {
+        message.body.assign(reinterpret_cast<const char*>(data) + bodyStart, size - bodyStart);
     }
-    message.body = body;
 
     return message;
 }
+
+std::string HTTPParser::getHeader(const HTTPMessage& message, const std::string& name) {
+    for (const auto& header : message.headers) {
+        if (header.first.size() == name.size() &&
+            std::equal(header.first.begin(), header.first.end(), name.begin(),
+                       [](char a, char b) {
+                           return std::tolower(static_cast<unsigned char>(a)) ==
+                                  std::tolower(static_cast<unsigned char>(b));
+                       })) {
+            return header.second;
+        }
+    }
+    return std::string();
+}
+
+void HTTPParser::internHeaders(const unsigned char* data, size_t size,
+                               const std::vector<std::string>& columns, StringInterner& interner,
+                               std::vector<uint32_t>& lines, std::vector<uint32_t>& values) {
+    TRACE_SCOPE("http.internHeaders");
+
+    lines.clear();
+    values.assign(columns.size(), StringInterner::EMPTY_ID);
+
+    const char* text = reinterpret_cast<const char*>(data);
+    const char* end = text + size;
+
+    // Первая строка - стартовая
+    const char* line = static_cast<const char*>(memchr(text, '\n', size));
+    while (line && ++line < end) {
+        const char* next = static_cast<const char*>(memchr(line, '\n', end - line));
+        size_t length = (next ? next : end) - line;
+        if (length > 0 && line[length - 1] == '\r') length--;
+        if (length == 0) break;   // Конец заголовков
+
+        lines.push_back(interner.intern(std::string_view(line, length)));
+
+        const char* colon = static_cast<const char*>(memchr(line, ':', length));
+        if (colon) {
+            size_t nameLength = colon - line;
+            for (size_t i = 0; i < columns.size(); i++) {
+                const std::string& column = columns[i];
+                if (column.size() != nameLength) continue;
+
+                bool match = true;
+                for (size_t k = 0; k < nameLength && match; k++) {
+                    match = std::tolower(static_cast<unsigned char>(line[k])) == column[k];
+                }
+                if (match) {
+                    const char* value = colon + 1;
+                    const char* valueEnd = line + length;
+                    while (value < valueEnd && (*value == ' ' || *value == '\t')) value++;
+                    values[i] = interner.intern(std::string_view(value, valueEnd - value));
+                    break;
+                }
+            }
+        }
+        line = next;
+    }
+}
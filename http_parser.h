@@ -5,6 +5,8 @@
 #include <map>
 #include <vector>
 
+class StringInterner;
+
 // Перечисление HTTP методов - выносим за пределы класса
 enum HTTPMethod {
     HTTP_GET,
@@ -13,6 +15,7 @@ enum HTTPMethod {
     HTTP_DELETE,
     HTTP_HEAD,
     HTTP_OPTIONS,
+    HTTP_CONNECT,
     HTTP_UNKNOWN
 };
 
@@ -25,7 +28,7 @@ struct HTTPMessage {
     int statusCode;
     std::string statusText;
     std::map<std::string, std::string> headers;
-    std::string body;
+    std::string body;          // Тело как получено (с chunked и сжатием)
 };
 
 // Класс для разбора HTTP сообщений
@@ -37,6 +40,16 @@ public:
     // Разбирает HTTP сообщение
     static HTTPMessage parseHTTP(const unsigned char* data, size_t size);
 
+    // Возвращает значение заголовка без учёта регистра имени (или пустую строку)
+    static std::string getHeader(const HTTPMessage& message, const std::string& name);
+
+    // Интернирует заголовки без копирования уже известных значений:
+    // lines - строки "Имя: значение" по порядку, values[i] - значение
+    // заголовка columns[i] (имена в нижнем регистре) или EMPTY_ID
+    static void internHeaders(const unsigned char* data, size_t size,
+                              const std::vector<std::string>& columns, StringInterner& interner,
+                              std::vector<uint32_t>& lines, std::vector<uint32_t>& values);
+
 private:
     // Преобразует строку в HTTP метод
     static HTTPMethod stringToMethod(const std::string& method);
@@ -0,0 +1,316 @@
+#include "http_stats.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+namespace {
+
+// Максимальное число ожидающих ответа запросов (на все соединения)
+const size_t MAX_PENDING_REQUESTS = 100000;
+// ... и на одно соединение (конвейеризация HTTP/1.1)
+const size_t MAX_PENDING_PER_CONNECTION = 64;
+
+const char* OVERFLOW_HOST = "(прочие)";
+
+bool isNumber(const std::string& segment) {
+    if (segment.empty()) return false;
+    for (char c : segment) {
+        if (!std::isdigit(static_cast<unsigned char>(c))) return false;
+    }
+    return true;
+}
+
+bool isHex(const std::string& segment) {
+    for (char c : segment) {
+        if (!std::isxdigit(static_cast<unsigned char>(c))) return false;
+    }
+    return true;
+}
+
+// 8-4-4-4-12 шестнадцатеричных символов
+bool isUuid(const std::string& segment) {
+    if (segment.size() != 36) return false;
+    for (size_t i = 0; i < segment.size(); i++) {
+        bool dash = (i == 8 || i == 13 || i == 18 || i == 23);
+        if (dash != (segment[i] == '-')) return false;
+        if (!dash && !std::isxdigit(static_cast<unsigned char>(segment[i]))) return false;
+    }
+    return true;
+}
+
+} // namespace
+
+// ------------------ LatencyHistogram ------------------
+
+LatencyHistogram::LatencyHistogram() {
+    clear();
+}
+
+int LatencyHistogram::bucketIndex(uint64_t value) {
+    if (value < SUB_BUCKETS) {
+        return static_cast<int>(value);
+    }
+
+    // Номер старшего бита определяет порядок, следующие 4 бита - подкорзину
+    int exponent = 63;
+    while (!(value & (uint64_t(1) << exponent))) {
+        exponent--;
+    }
+    int magnitude = exponent - 3;
+    if (magnitude >= MAGNITUDES) {
+        return BUCKET_COUNT - 1;
+    }
+    int sub = static_cast<int>(value >> (exponent - 4)) - SUB_BUCKETS;
+    return magnitude * SUB_BUCKETS + sub;
+}
+
+uint64_t LatencyHistogram::bucketUpperBound(int index) {
+    if (index < SUB_BUCKETS) {
+        return static_cast<uint64_t>(index);
+    }
+    int magnitude = index / SUB_BUCKETS;
+    int sub = index % SUB_BUCKETS;
+    int shift = magnitude - 1;
+    return ((uint64_t(SUB_BUCKETS + sub + 1)) << shift) - 1;
+}
+
+void LatencyHistogram::record(uint64_t valueUs) {
+    buckets[bucketIndex(valueUs)]++;
+    total++;
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other) {
+    for (int i = 0; i < BUCKET_COUNT; i++) {
+        buckets[i] += other.buckets[i];
+    }
+    total += other.total;
+}
+
+void LatencyHistogram::clear() {
+    memset(buckets, 0, sizeof(buckets));
+    total = 0;
+}
+
+uint64_t LatencyHistogram::percentile(double q) const {
+    if (total == 0) return 0;
+
+    uint64_t rank = static_cast<uint64_t>(q * total);
+    if (rank >= total) rank = total - 1;
+
+    uint64_t seen = 0;
+    for (int i = 0; i < BUCKET_COUNT; i++) {
+        seen += buckets[i];
+        if (seen > rank) {
+            return bucketUpperBound(i);
+        }
+    }
+    return bucketUpperBound(BUCKET_COUNT - 1);
+}
+
+// ------------------ HttpEndpointStats ------------------
+
+size_t HttpEndpointStats::StreamKeyHash::operator()(const StreamKey& key) const {
+    uint64_t a = (uint64_t(key.srcIP) << 32) | key.dstIP;
+    uint64_t b = (uint64_t(key.srcPort) << 16) | key.dstPort;
+    return std::hash<uint64_t>()(a * 0x9e3779b97f4a7c15ULL ^ b);
+}
+
+bool HttpEndpointStats::StreamKeyEqual::operator()(const StreamKey& a, const StreamKey& b) const {
+    return a.srcIP == b.srcIP && a.dstIP == b.dstIP &&
+           a.srcPort == b.srcPort && a.dstPort == b.dstPort;
+}
+
+HttpEndpointStats::HttpEndpointStats(size_t maxEndpoints)
+    : maxEndpoints(maxEndpoints), pendingCount(0) {
+}
+
+std::string HttpEndpointStats::normalizeUri(const std::string& uri) {
+    // Отбрасываем строку запроса и фрагмент
+    size_t end = uri.find_first_of("?#");
+    std::string path = uri.substr(0, end);
+
+    // Абсолютная форма (прокси): http://host/path -> /path
+    size_t scheme = path.find("://");
+    if (scheme != std::string::npos) {
+        size_t slash = path.find('/', scheme + 3);
+        path = slash == std::string::npos ? "/" : path.substr(slash);
+    }
+
+    std::string result;
+    result.reserve(path.size());
+
+    size_t pos = 0;
+    while (pos < path.size()) {
+        size_t next = path.find('/', pos);
+        if (next == std::string::npos) next = path.size();
+
+        std::string segment = path.substr(pos, next - pos);
+        if (isNumber(segment)) {
+            result += "{id}";
+        } else if (isUuid(segment)) {
+            result += "{uuid}";
+        } else if (segment.size() >= 16 && isHex(segment)) {
+            result += "{hex}";
+        } else {
+            result += segment;
+        }
+
+        if (next < path.size()) {
+            result += '/';
+        }
+        pos = next + 1;
+    }
+
+    return result.empty() ? "/" : result;
+}
+
+size_t HttpEndpointStats::findOrCreateEndpoint(const std::string& host, const std::string& path) {
+    std::string id = host + '\n' + path;
+    auto it = endpointIndex.find(id);
+    if (it != endpointIndex.end()) {
+        return it->second;
+    }
+
+    // Лимит достигнут: все новые эндпоинты учитываются в одной записи
+    if (endpoints.size() >= maxEndpoints) {
+        id = std::string(OVERFLOW_HOST) + '\n';
+        it = endpointIndex.find(id);
+        if (it != endpointIndex.end()) {
+            return it->second;
+        }
+        endpoints.push_back(Endpoint{OVERFLOW_HOST, "", 0, 0, 0, 0, LatencyHistogram()});
+    } else {
+        endpoints.push_back(Endpoint{host, path, 0, 0, 0, 0, LatencyHistogram()});
+    }
+
+    endpointIndex[id] = endpoints.size() - 1;
+    return endpoints.size() - 1;
+}
+
+void HttpEndpointStats::onRequest(const StreamKey& key, const std::string& host,
+                                  const std::string& uri, uint64_t timestampUs, uint32_t streamId) {
+    std::string path = normalizeUri(uri);
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    size_t index = findOrCreateEndpoint(host, path);
+    endpoints[index].requests++;
+
+    if (pendingCount >= MAX_PENDING_REQUESTS) {
+        return;
+    }
+
+    std::deque<PendingRequest>& queue = pending[key];
+    if (queue.size() >= MAX_PENDING_PER_CONNECTION) {
+        queue.pop_front();
+        pendingCount--;
+    }
+    queue.push_back(PendingRequest{index, timestampUs, streamId});
+    pendingCount++;
+}
+
+void HttpEndpointStats::onResponse(const StreamKey& key, int statusCode, uint64_t timestampUs, uint32_t streamId) {
+    // Запрос шёл в обратном направлении
+    StreamKey requestKey{key.dstIP, key.srcIP, key.dstPort, key.srcPort};
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto it = pending.find(requestKey);
+    if (it == pending.end() || it->second.empty()) {
+        return;
+    }
+
+    // 1xx - промежуточные ответы, запрос остаётся в ожидании
+    if (statusCode >= 100 && statusCode < 200) {
+        return;
+    }
+
+    // HTTP/2: запрос того же потока. Если его нет, берём самый старый запрос
+    // HTTP/1 - ответ на запрос Upgrade: h2c приходит уже в потоке 1
+    std::deque<PendingRequest>& queue = it->second;
+    auto match = queue.begin();
+    if (streamId != 0) {
+        match = std::find_if(queue.begin(), queue.end(),
+                             [streamId](const PendingRequest& r) { return r.streamId == streamId; });
+        if (match == queue.end()) {
+            match = std::find_if(queue.begin(), queue.end(),
+                                 [](const PendingRequest& r) { return r.streamId == 0; });
+        }
+        if (match == queue.end()) {
+            return;
+        }
+    }
+
+    PendingRequest request = *match;
+    queue.erase(match);
+    pendingCount--;
+    if (it->second.empty()) {
+        pending.erase(it);
+    }
+
+    Endpoint& endpoint = endpoints[request.endpoint];
+    endpoint.responses++;
+    if (statusCode >= 400 && statusCode < 500) endpoint.clientErrors++;
+    if (statusCode >= 500) endpoint.serverErrors++;
+    endpoint.latency.record(timestampUs >= request.timestampUs ? timestampUs - request.timestampUs : 0);
+}
+
+void HttpEndpointStats::onMatchedRequest(const std::string& host, const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex);
+    endpoints[findOrCreateEndpoint(host, path)].requests++;
+}
+
+void HttpEndpointStats::onMatchedResponse(const std::string& host, const std::string& path,
+                                          bool clientError, bool serverError, uint64_t latencyUs) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    Endpoint& endpoint = endpoints[findOrCreateEndpoint(host, path)];
+    endpoint.responses++;
+    if (clientError) endpoint.clientErrors++;
+    if (serverError) endpoint.serverErrors++;
+    endpoint.latency.record(latencyUs);
+}
+
+void HttpEndpointStats::expirePending(uint64_t nowUs, uint64_t maxAgeUs) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto it = pending.begin();
+    while (it != pending.end()) {
+        std::deque<PendingRequest>& queue = it->second;
+        while (!queue.empty() && nowUs > queue.front().timestampUs + maxAgeUs) {
+            queue.pop_front();
+            pendingCount--;
+        }
+        if (queue.empty()) {
+            it = pending.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+std::vector<HttpEndpointSnapshot> HttpEndpointStats::snapshot() const {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    std::vector<HttpEndpointSnapshot> result;
+    result.reserve(endpoints.size());
+    for (const Endpoint& endpoint : endpoints) {
+        result.push_back(HttpEndpointSnapshot{
+            endpoint.host, endpoint.path,
+            endpoint.requests, endpoint.responses,
+            endpoint.clientErrors, endpoint.serverErrors,
+            endpoint.latency.percentile(0.50),
+            endpoint.latency.percentile(0.95),
+            endpoint.latency.percentile(0.99)
+        });
+    }
+    return result;
+}
+
+void HttpEndpointStats::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    endpoints.clear();
+    endpointIndex.clear();
+    pending.clear();
+    pendingCount = 0;
+}
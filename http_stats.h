@@ -0,0 +1,120 @@
+#ifndef HTTP_STATS_H
+#define HTTP_STATS_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <mutex>
+
+#include "tcp_stream_assembler.h"
+
+// Гистограмма задержек с логарифмически-линейными корзинами (как в HdrHistogram):
+// 16 подкорзин на каждую степень двойки, относительная погрешность ~6%.
+// Фиксированный размер, гистограммы можно складывать.
+class LatencyHistogram {
+public:
+    LatencyHistogram();
+
+    void record(uint64_t valueUs);
+    void merge(const LatencyHistogram& other);
+    void clear();
+
+    // Значение перцентиля (q от 0 до 1) в микросекундах
+    uint64_t percentile(double q) const;
+    uint64_t count() const { return total; }
+
+    static const int SUB_BUCKETS = 16;
+    static const int MAGNITUDES = 40;
+    static const int BUCKET_COUNT = SUB_BUCKETS * MAGNITUDES;
+
+private:
+    uint32_t buckets[BUCKET_COUNT];
+    uint64_t total;
+
+    static int bucketIndex(uint64_t value);
+    static uint64_t bucketUpperBound(int index);
+};
+
+// Сводка по одному эндпоинту для отображения
+struct HttpEndpointSnapshot {
+    std::string host;
+    std::string path;
+    uint64_t requests;
+    uint64_t responses;
+    uint64_t clientErrors;   // 4xx
+    uint64_t serverErrors;   // 5xx
+    uint64_t p50Us;
+    uint64_t p95Us;
+    uint64_t p99Us;
+};
+
+// Агрегация производительности HTTP по Host + нормализованному пути.
+// Запросы сопоставляются с ответами по соединению: в HTTP/1.x по порядку (FIFO),
+// в HTTP/2 - по номеру потока, т.к. ответы мультиплексированных потоков
+// приходят в любом порядке.
+// Число отслеживаемых эндпоинтов ограничено; лишние попадают в общую запись.
+class HttpEndpointStats {
+public:
+    explicit HttpEndpointStats(size_t maxEndpoints = 2000);
+
+    // Регистрирует запрос; key - направление клиент -> сервер,
+    // streamId - номер потока HTTP/2 (0 - HTTP/1.x)
+    void onRequest(const StreamKey& key, const std::string& host,
+                   const std::string& uri, uint64_t timestampUs, uint32_t streamId = 0);
+
+    // Регистрирует ответ; key - направление сервер -> клиент
+    void onResponse(const StreamKey& key, int statusCode, uint64_t timestampUs, uint32_t streamId = 0);
+
+    // Протоколы, которые сами сопоставляют ответы с запросами (DNS),
+    // учитываются в тех же эндпоинтах; ошибки клиента и сервера - аналоги 4xx и 5xx
+    void onMatchedRequest(const std::string& host, const std::string& path);
+    void onMatchedResponse(const std::string& host, const std::string& path,
+                           bool clientError, bool serverError, uint64_t latencyUs);
+
+    // Удаляет запросы без ответа старше указанного возраста
+    void expirePending(uint64_t nowUs, uint64_t maxAgeUs);
+
+    std::vector<HttpEndpointSnapshot> snapshot() const;
+    void clear();
+
+    // Приводит путь к шаблону: /users/123?x=1 -> /users/{id}
+    static std::string normalizeUri(const std::string& uri);
+
+private:
+    struct Endpoint {
+        std::string host;
+        std::string path;
+        uint64_t requests;
+        uint64_t responses;
+        uint64_t clientErrors;
+        uint64_t serverErrors;
+        LatencyHistogram latency;
+    };
+
+    struct PendingRequest {
+        size_t endpoint;
+        uint64_t timestampUs;
+        uint32_t streamId;
+    };
+
+    struct StreamKeyHash {
+        size_t operator()(const StreamKey& key) const;
+    };
+
+    struct StreamKeyEqual {
+        bool operator()(const StreamKey& a, const StreamKey& b) const;
+    };
+
+    mutable std::mutex mutex;
+    size_t maxEndpoints;
+    std::vector<Endpoint> endpoints;
+    std::unordered_map<std::string, size_t> endpointIndex;
+    std::unordered_map<StreamKey, std::deque<PendingRequest>, StreamKeyHash, StreamKeyEqual> pending;
+    size_t pendingCount;
+
+    size_t findOrCreateEndpoint(const std::string& host, const std::string& path);
+};
+
+#endif // HTTP_STATS_H
@@ -0,0 +1,90 @@
+#include <QVBoxLayout>
+#include <QHeaderView>
+
+#include "http_stats_window.h"
+
+namespace {
+
+QTableWidgetItem *numberItem(const QVariant &value) {
+    QTableWidgetItem *item = new QTableWidgetItem();
+    item->setData(Qt::DisplayRole, value);
+    return item;
+}
+
+// Микросекунды -> миллисекунды с одним знаком после запятой
+double toMs(uint64_t us) {
+    return qRound(us / 100.0) / 10.0;
+}
+
+} // namespace
+
+HttpStatsWindow::HttpStatsWindow(HttpEndpointStats *statistics, QWidget *parent)
+    : QDialog(parent), statistics(statistics) {
+    setWindowTitle("Производительность HTTP и DNS");
+    resize(900, 450);
+
+    QVBoxLayout *mainLayout = new QVBoxLayout(this);
+
+    endpointsTable = new QTableWidget(this);
+    QStringList headers = {"Host", "Путь", "Запросов", "Запросов/с", "Ответов",
+                           "Ошибки 4xx, %", "Ошибки 5xx, %", "p50, мс", "p95, мс", "p99, мс"};
+    endpointsTable->setColumnCount(headers.size());
+    endpointsTable->setHorizontalHeaderLabels(headers);
+    endpointsTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    endpointsTable->setSelectionBehavior(QAbstractItemView::SelectRows);
+    endpointsTable->horizontalHeader()->setStretchLastSection(true);
+    endpointsTable->verticalHeader()->setVisible(false);
+    mainLayout->addWidget(endpointsTable);
+
+    infoLabel = new QLabel(this);
+    mainLayout->addWidget(infoLabel);
+
+    refreshTimer = new QTimer(this);
+    connect(refreshTimer, &QTimer::timeout, this, &HttpStatsWindow::refresh);
+    refreshTimer->start(1000);
+
+    sinceRefresh.start();
+    refresh();
+}
+
+void HttpStatsWindow::refresh() {
+    std::vector<HttpEndpointSnapshot> endpoints = statistics->snapshot();
+
+    double elapsed = sinceRefresh.restart() / 1000.0;
+    QMap<QString, quint64> currentRequests;
+
+    endpointsTable->setSortingEnabled(false);
+    endpointsTable->setRowCount(static_cast<int>(endpoints.size()));
+
+    for (int row = 0; row < static_cast<int>(endpoints.size()); ++row) {
+        const HttpEndpointSnapshot &endpoint = endpoints[row];
+        QString host = QString::fromStdString(endpoint.host);
+        QString path = QString::fromStdString(endpoint.path);
+
+        // Скорость считается по приросту с прошлого обновления
+        QString id = host + '\n' + path;
+        currentRequests[id] = endpoint.requests;
+        double rate = 0;
+        if (elapsed > 0 && previousRequests.contains(id)) {
+            rate = (endpoint.requests - previousRequests[id]) / elapsed;
+        }
+
+        double responses = endpoint.responses > 0 ? static_cast<double>(endpoint.responses) : 1.0;
+
+        endpointsTable->setItem(row, 0, new QTableWidgetItem(host));
+        endpointsTable->setItem(row, 1, new QTableWidgetItem(path));
+        endpointsTable->setItem(row, 2, numberItem(qulonglong(endpoint.requests)));
+        endpointsTable->setItem(row, 3, numberItem(qRound(rate * 10) / 10.0));
+        endpointsTable->setItem(row, 4, numberItem(qulonglong(endpoint.responses)));
+        endpointsTable->setItem(row, 5, numberItem(qRound(endpoint.clientErrors * 1000 / responses) / 10.0));
+        endpointsTable->setItem(row, 6, numberItem(qRound(endpoint.serverErrors * 1000 / responses) / 10.0));
+        endpointsTable->setItem(row, 7, numberItem(toMs(endpoint.p50Us)));
+        endpointsTable->setItem(row, 8, numberItem(toMs(endpoint.p95Us)));
+        endpointsTable->setItem(row, 9, numberItem(toMs(endpoint.p99Us)));
+    }
+
+    endpointsTable->setSortingEnabled(true);
+    previousRequests = currentRequests;
+
+    infoLabel->setText(QString("Эндпоинтов: %1").arg(endpoints.size()));
+}
@@ -0,0 +1,36 @@
+#ifndef HTTP_STATS_WINDOW_H
+#define HTTP_STATS_WINDOW_H
+
+#include <QDialog>
+#include <QTimer>
+#include <QTableWidget>
+#include <QLabel>
+#include <QMap>
+#include <QElapsedTimer>
+
+#include "http_stats.h"
+
+// Окно "Производительность HTTP и DNS": запросы/с, доля ошибок и перцентили
+// задержки по Host + нормализованному пути. Обновляется из уже
+// агрегированной статистики без повторного просмотра сессии.
+class HttpStatsWindow : public QDialog {
+    Q_OBJECT
+
+public:
+    explicit HttpStatsWindow(HttpEndpointStats *statistics, QWidget *parent = nullptr);
+
+private slots:
+    void refresh();
+
+private:
+    HttpEndpointStats *statistics;
+    QTimer *refreshTimer;
+    QTableWidget *endpointsTable;
+    QLabel *infoLabel;
+
+    // Число запросов при предыдущем обновлении (для расчёта запросов/с)
+    QMap<QString, quint64> previousRequests;
+    QElapsedTimer sinceRefresh;
+};
+
+#endif // HTTP_STATS_WINDOW_H
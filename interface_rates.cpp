@@ -0,0 +1,115 @@
+#include "interface_rates.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+bool InterfaceRateMonitor::isSupported() {
+#ifdef __linux__
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool InterfaceRateMonitor::parseProcNetDev(const std::string& text,
+                                           std::unordered_map<std::string, InterfaceCounters>& counters) {
+    counters.clear();
+
+    // Две строки заголовка, затем "  eth0: rx_bytes rx_packets ... (8 полей) tx_bytes tx_packets ..."
+    size_t pos = 0;
+    int line = 0;
+    while (pos < text.size()) {
+        size_t end = text.find('\n', pos);
+        if (end == std::string::npos) end = text.size();
+        size_t lineStart = pos;
+        pos = end + 1;
+        if (line++ < 2) continue;
+
+        size_t colon = text.find(':', lineStart);
+        if (colon == std::string::npos || colon >= end) return false;
+        size_t nameStart = text.find_first_not_of(' ', lineStart);
+        std::string name = text.substr(nameStart, colon - nameStart);
+
+        uint64_t fields[16];
+        const char* cursor = text.c_str() + colon + 1;
+        for (int i = 0; i < 16; i++) {
+            char* rest = nullptr;
+            fields[i] = std::strtoull(cursor, &rest, 10);
+            if (rest == cursor || rest > text.c_str() + end) return false;
+            cursor = rest;
+        }
+
+        InterfaceCounters& entry = counters[name];
+        entry.bytes = fields[0] + fields[8];
+        entry.packets = fields[1] + fields[9];
+    }
+    return line > 2;
+}
+
+bool InterfaceRateMonitor::update(uint64_t nowUs) {
+#ifdef __linux__
+    FILE* file = fopen("/proc/net/dev", "r");
+    if (!file) return false;
+    text.clear();
+    char chunk[4096];
+    size_t read;
+    while ((read = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+        text.append(chunk, read);
+    }
+    fclose(file);
+
+    if (!parseProcNetDev(text, current)) return false;
+
+    rates.clear();
+    double seconds = (nowUs - previousUs) / 1e6;
+    if (previousUs != 0 && seconds > 0) {
+        for (const auto& entry : current) {
+            auto old = previous.find(entry.first);
+            if (old == previous.end()) continue;
+            // Сброс счётчиков (интерфейс пересоздан) даёт нулевую скорость
+            InterfaceRate& rate = rates[entry.first];
+            if (entry.second.packets >= old->second.packets && entry.second.bytes >= old->second.bytes) {
+                rate.packetsPerSecond = (entry.second.packets - old->second.packets) / seconds;
+                rate.bytesPerSecond = (entry.second.bytes - old->second.bytes) / seconds;
+            }
+        }
+    }
+    previous.swap(current);
+    previousUs = nowUs;
+    return true;
+#else
+    (void)nowUs;
+    return false;
+#endif
+}
+
+bool InterfaceRateMonitor::rate(const std::string& name, InterfaceRate& result) const {
+    auto found = rates.find(name);
+    if (found == rates.end()) return false;
+    result = found->second;
+    return true;
+}
+
+std::string InterfaceRateMonitor::format(const InterfaceRate& rate) {
+    char packets[32];
+    if (rate.packetsPerSecond >= 1e6) {
+        snprintf(packets, sizeof(packets), "%.1f млн пак/с", rate.packetsPerSecond / 1e6);
+    } else if (rate.packetsPerSecond >= 1e3) {
+        snprintf(packets, sizeof(packets), "%.1f тыс. пак/с", rate.packetsPerSecond / 1e3);
+    } else {
+        snprintf(packets, sizeof(packets), "%.0f пак/с", rate.packetsPerSecond);
+    }
+
+    char bytes[32];
+    if (rate.bytesPerSecond >= 1024.0 * 1024 * 1024) {
+        snprintf(bytes, sizeof(bytes), "%.1f ГБ/с", rate.bytesPerSecond / (1024.0 * 1024 * 1024));
+    } else if (rate.bytesPerSecond >= 1024.0 * 1024) {
+        snprintf(bytes, sizeof(bytes), "%.1f МБ/с", rate.bytesPerSecond / (1024.0 * 1024));
+    } else if (rate.bytesPerSecond >= 1024.0) {
+        snprintf(bytes, sizeof(bytes), "%.1f КБ/с", rate.bytesPerSecond / 1024.0);
+    } else {
+        snprintf(bytes, sizeof(bytes), "%.0f Б/с", rate.bytesPerSecond);
+    }
+
+    return std::string(packets) + ", " + bytes;
+}
@@ -0,0 +1,47 @@
+#ifndef INTERFACE_RATES_H
+#define INTERFACE_RATES_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+// Счётчики интерфейса (приём и передача вместе - захват видит оба направления)
+struct InterfaceCounters {
+    uint64_t packets = 0;
+    uint64_t bytes = 0;
+};
+
+struct InterfaceRate {
+    double packetsPerSecond = 0;
+    double bytesPerSecond = 0;
+};
+
+// Скорость трафика по интерфейсам для выбора интерфейса до захвата.
+// Источник - счётчики ядра из /proc/net/dev (одно чтение файла на все
+// интерфейсы, без открытия устройств); на других платформах недоступен.
+class InterfaceRateMonitor {
+public:
+    static bool isSupported();
+
+    // Разбор текста /proc/net/dev; false - формат не распознан
+    static bool parseProcNetDev(const std::string& text,
+                                std::unordered_map<std::string, InterfaceCounters>& counters);
+
+    // Читает счётчики и пересчитывает скорость с прошлого вызова
+    bool update(uint64_t nowUs);
+
+    // false - для интерфейса ещё нет двух замеров
+    bool rate(const std::string& name, InterfaceRate& rate) const;
+
+    // "1.2 тыс. пак/с, 3.4 МБ/с"
+    static std::string format(const InterfaceRate& rate);
+
+private:
+    std::unordered_map<std::string, InterfaceCounters> previous;
+    std::unordered_map<std::string, InterfaceCounters> current;
+    std::unordered_map<std::string, InterfaceRate> rates;
+    uint64_t previousUs = 0;
+    std::string text;   // Буфер чтения файла (переиспользуется)
+};
+
+#endif // INTERFACE_RATES_H
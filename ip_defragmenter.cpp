@@ -0,0 +1,206 @@
+#include "ip_defragmenter.h"
+#include <algorithm>
+#include <cstring>
+
+IpDefragmenter::IpDefragmenter(size_t maxDatagrams, size_t maxMemory, uint64_t timeoutUs)
+    : maxMemory(maxMemory), timeoutUs(timeoutUs), memoryUsed(0) {
+    // Число наборов - степень двойки, чтобы номер набора брался маской
+    size_t sets = 1;
+    while (sets * WAYS < maxDatagrams) {
+        sets <<= 1;
+    }
+    setMask = sets - 1;
+    entries.resize(sets * WAYS);
+    for (Entry& entry : entries) {
+        entry.used = false;
+    }
+}
+
+IpDefragmenter::Entry* IpDefragmenter::findSet(uint32_t srcIP, uint32_t dstIP, uint16_t id, uint8_t protocol) {
+    uint64_t a = (uint64_t(srcIP) << 32) | dstIP;
+    uint64_t b = (uint64_t(id) << 8) | protocol;
+    uint64_t hash = (a * 0x9e3779b97f4a7c15ULL) ^ (b * 0xc2b2ae3d27d4eb4fULL);
+    return &entries[((hash >> 32) & setMask) * WAYS];
+}
+
+void IpDefragmenter::release(Entry& entry) {
+    memoryUsed -= entry.buffer.capacity();
+    std::vector<uint8_t>().swap(entry.buffer);
+    entry.used = false;
+}
+
+bool IpDefragmenter::reserve(Entry& entry, size_t size) {
+    if (size <= entry.buffer.size()) {
+        return true;
+    }
+
+    // Пока длина датаграммы неизвестна, буфер растёт вдвое (перенос данных
+    // при росте - единственное дополнительное копирование); когда известна -
+    // выделяется ровно по ней
+    size_t capacity = entry.buffer.capacity();
+    if (size > capacity) {
+        size_t newCapacity = entry.totalLength ? size
+                                               : std::min(std::max(size, capacity * 2), MAX_DATAGRAM_SIZE);
+        if (memoryUsed - capacity + newCapacity > maxMemory) {
+            return false;
+        }
+        entry.buffer.reserve(newCapacity);
+        memoryUsed += entry.buffer.capacity() - capacity;
+    }
+    entry.buffer.resize(size);
+    return true;
+}
+
+bool IpDefragmenter::addRange(Entry& entry, uint32_t start, uint32_t end, const uint8_t* data) {
+    // Перекрытие допускается только с теми же данными (повторная передача)
+    for (size_t i = 0; i < entry.rangeCount; i++) {
+        uint32_t from = std::max(start, entry.ranges[i].start);
+        uint32_t to = std::min(end, entry.ranges[i].end);
+        if (from < to && memcmp(entry.buffer.data() + from, data + (from - start), to - from) != 0) {
+            return false;
+        }
+    }
+
+    // Слияние с соседними кусками; список остаётся упорядоченным
+    Range merged{start, end};
+    Range result[MAX_RANGES + 1];
+    size_t count = 0;
+    bool placed = false;
+    for (size_t i = 0; i < entry.rangeCount; i++) {
+        const Range& range = entry.ranges[i];
+        if (range.end < merged.start) {
+            result[count++] = range;
+        } else if (range.start > merged.end) {
+            if (!placed) {
+                result[count++] = merged;
+                placed = true;
+            }
+            result[count++] = range;
+        } else {
+            merged.start = std::min(merged.start, range.start);
+            merged.end = std::max(merged.end, range.end);
+        }
+    }
+    if (!placed) {
+        result[count++] = merged;
+    }
+    if (count > MAX_RANGES) {
+        return false;
+    }
+
+    memcpy(entry.buffer.data() + start, data, end - start);
+    std::copy(result, result + count, entry.ranges);
+    entry.rangeCount = count;
+    return true;
+}
+
+bool IpDefragmenter::addFragment(const DecodedPacket& packet, uint32_t wireLength,
+                                 uint64_t timestampUs, IpDatagram& datagram) {
+    counters.fragments++;
+
+    Entry* set = findSet(packet.srcIP, packet.dstIP, packet.ipId, packet.protocol);
+    Entry* entry = nullptr;
+    Entry* victim = nullptr;
+    for (size_t i = 0; i < WAYS && !entry; i++) {
+        Entry& candidate = set[i];
+        if (candidate.used && candidate.srcIP == packet.srcIP && candidate.dstIP == packet.dstIP &&
+            candidate.id == packet.ipId && candidate.protocol == packet.protocol) {
+            entry = &candidate;
+        } else if (!victim || (victim->used && (!candidate.used || candidate.firstSeenUs < victim->firstSeenUs))) {
+            victim = &candidate;
+        }
+    }
+
+    // Идентификатор мог быть использован повторно после истечения срока
+    if (entry && timestampUs > entry->firstSeenUs + timeoutUs) {
+        counters.timedOut++;
+        release(*entry);
+        victim = entry;
+        entry = nullptr;
+    }
+
+    if (!entry) {
+        if (victim->used) {
+            counters.evicted++;
+            release(*victim);
+        }
+        entry = victim;
+        entry->used = true;
+        entry->srcIP = packet.srcIP;
+        entry->dstIP = packet.dstIP;
+        entry->id = packet.ipId;
+        entry->protocol = packet.protocol;
+        entry->firstSeenUs = timestampUs;
+        entry->wireBytes = 0;
+        entry->totalLength = 0;
+        entry->rangeCount = 0;
+    }
+
+    uint32_t start = packet.fragmentOffset;
+    uint32_t end = start + static_cast<uint32_t>(packet.payloadLength);
+    entry->wireBytes += wireLength;
+
+    // Обрезанный snaplen фрагмент, выход за 64 КБ, не кратный 8 байтам
+    // промежуточный фрагмент, противоречивая длина - датаграмму не собрать
+    bool valid = packet.payloadLength == packet.wirePayloadLength && end <= MAX_DATAGRAM_SIZE &&
+                 end > start && (!packet.moreFragments || (end - start) % 8 == 0);
+    if (valid && !packet.moreFragments) {
+        valid = (entry->totalLength == 0 || entry->totalLength == end) &&
+                (entry->rangeCount == 0 || entry->ranges[entry->rangeCount - 1].end <= end);
+        entry->totalLength = end;
+    } else if (valid && entry->totalLength != 0) {
+        valid = end <= entry->totalLength;
+    }
+    if (!valid) {
+        counters.conflicts++;
+        release(*entry);
+        return false;
+    }
+
+    if (!reserve(*entry, end)) {
+        counters.overMemory++;
+        release(*entry);
+        return false;
+    }
+    if (!addRange(*entry, start, end, packet.payload)) {
+        counters.conflicts++;
+        release(*entry);
+        return false;
+    }
+
+    if (entry->totalLength == 0 || entry->rangeCount != 1 ||
+        entry->ranges[0].start != 0 || entry->ranges[0].end != entry->totalLength) {
+        return false;
+    }
+
+    // Датаграмма собрана: буфер передаётся без копирования
+    counters.completed++;
+    memoryUsed -= entry->buffer.capacity();
+    completed.swap(entry->buffer);
+    std::vector<uint8_t>().swap(entry->buffer);
+    entry->used = false;
+
+    datagram.data = completed.data();
+    datagram.length = entry->totalLength;
+    datagram.wireBytes = entry->wireBytes;
+    return true;
+}
+
+void IpDefragmenter::expire(uint64_t nowUs) {
+    for (Entry& entry : entries) {
+        if (entry.used && nowUs > entry.firstSeenUs + timeoutUs) {
+            counters.timedOut++;
+            release(entry);
+        }
+    }
+}
+
+void IpDefragmenter::clear() {
+    for (Entry& entry : entries) {
+        if (entry.used) {
+            release(entry);
+        }
+    }
+    std::vector<uint8_t>().swap(completed);
+    counters = DefragmentStats();
+}
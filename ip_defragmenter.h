@@ -0,0 +1,91 @@
+#ifndef IP_DEFRAGMENTER_H
+#define IP_DEFRAGMENTER_H
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+#include "packet_decoder.h"
+
+// Датаграмма, собранная из фрагментов: данные транспортного уровня
+// (заголовок TCP/UDP и нагрузка) и суммарная длина фрагментов на проводе
+struct IpDatagram {
+    const uint8_t* data;
+    size_t length;
+    uint64_t wireBytes;
+};
+
+// Счётчики сборки (для строки состояния и отладки)
+struct DefragmentStats {
+    uint64_t fragments = 0;
+    uint64_t completed = 0;
+    uint64_t timedOut = 0;
+    uint64_t evicted = 0;       // Вытеснены из полного набора таблицы
+    uint64_t overMemory = 0;    // Отброшены из-за общего лимита памяти
+    uint64_t conflicts = 0;     // Перекрытия с разными данными, некорректные фрагменты
+};
+
+// Сборка фрагментов IPv4 по (src, dst, id, protocol).
+// Таблица фиксированного размера (наборно-ассоциативная, как таблица
+// запросов DNS): при заполнении набора вытесняется самая старая датаграмма.
+// Фрагмент копируется один раз - сразу на своё место в буфере датаграммы;
+// собранная датаграмма отдаётся указателем на этот буфер. Перекрытия с
+// одинаковыми данными (повторы) допускаются, с разными - датаграмма
+// отбрасывается: такие фрагменты разные стеки собирают по-разному.
+class IpDefragmenter {
+public:
+    explicit IpDefragmenter(size_t maxDatagrams = 1024, size_t maxMemory = 8 * 1024 * 1024,
+                            uint64_t timeoutUs = 30ULL * 1000000);
+
+    // Добавляет фрагмент (packet.fragmented). true - датаграмма собрана;
+    // datagram.data действует до следующего вызова addFragment или clear
+    bool addFragment(const DecodedPacket& packet, uint32_t wireLength,
+                     uint64_t timestampUs, IpDatagram& datagram);
+
+    // Отбрасывает датаграммы, не собранные за timeoutUs
+    void expire(uint64_t nowUs);
+
+    size_t memoryUsage() const { return memoryUsed; }
+    const DefragmentStats& stats() const { return counters; }
+    void clear();
+
+    static constexpr size_t WAYS = 4;
+    // Полученные куски датаграммы; больше - признак атаки, датаграмма отбрасывается
+    static constexpr size_t MAX_RANGES = 16;
+    static constexpr size_t MAX_DATAGRAM_SIZE = 65535 - 20;
+
+private:
+    struct Range {
+        uint32_t start;
+        uint32_t end;
+    };
+
+    struct Entry {
+        bool used;
+        uint32_t srcIP;
+        uint32_t dstIP;
+        uint16_t id;
+        uint8_t protocol;
+        uint64_t firstSeenUs;
+        uint64_t wireBytes;
+        uint32_t totalLength;     // 0 - последний фрагмент ещё не получен
+        size_t rangeCount;
+        Range ranges[MAX_RANGES]; // Упорядочены, не пересекаются и не соприкасаются
+        std::vector<uint8_t> buffer;
+    };
+
+    std::vector<Entry> entries;
+    size_t setMask;
+    size_t maxMemory;
+    uint64_t timeoutUs;
+    size_t memoryUsed;
+    std::vector<uint8_t> completed;   // Буфер последней собранной датаграммы
+    DefragmentStats counters;
+
+    Entry* findSet(uint32_t srcIP, uint32_t dstIP, uint16_t id, uint8_t protocol);
+    void release(Entry& entry);
+    bool reserve(Entry& entry, size_t size);
+    bool addRange(Entry& entry, uint32_t start, uint32_t end, const uint8_t* data);
+};
+
+#endif // IP_DEFRAGMENTER_H
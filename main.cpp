@@ -1,13 +1,174 @@
 #include <QApplication>
 #include <QMessageBox>
+#include <QCommandLineParser>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
 #include "mainwindow.h"
+#include "thread_tuning.h"
+#include "offline_analyzer.h"
+#include "http_stats.h"
 
 #ifdef _WIN32
 #include <winsock2.h>
 #include <windows.h>
 #endif
 
+// Разбор файла pcap без окна: сообщения в файл, итоги и скорость - в консоль
+static int runOfflineAnalysis(QCoreApplication &app) {
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Разбор файла pcap на всех ядрах (без захвата и окна)");
+    parser.addHelpOption();
+    QCommandLineOption analyzeOption("analyze", "Файл pcap для разбора.", "файл");
+    QCommandLineOption threadsOption("analyze-threads", "Число потоков (по умолчанию - по числу ядер).", "N");
+    QCommandLineOption outputOption("analyze-output", "Куда записать разобранные сообщения, по строке на каждое.",
+                                    "файл");
+    parser.addOption(analyzeOption);
+    parser.addOption(threadsOption);
+    parser.addOption(outputOption);
+    parser.process(app);
+
+    OfflineOptions options;
+    if (parser.isSet(threadsOption)) {
+        bool ok = false;
+        int threads = parser.value(threadsOption).toInt(&ok);
+        if (!ok || threads < 1 || threads > 256) {
+            std::cerr << "Некорректное число потоков" << std::endl;
+            return EXIT_FAILURE;
+        }
+        options.threads = static_cast<unsigned>(threads);
+    }
+    HttpEndpointStats httpStats;
+    options.httpStats = &httpStats;
+
+    OfflineAnalyzer analyzer(options);
+    OfflineResult result;
+    if (!analyzer.analyze(parser.value(analyzeOption).toStdString(), result)) {
+        std::cerr << "Ошибка: " << result.error << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if (parser.isSet(outputOption)) {
+        std::ofstream out(parser.value(outputOption).toStdString());
+        for (const OfflineEvent &event : result.events) {
+            out << OfflineAnalyzer::formatEvent(event) << '\n';
+        }
+        if (!out) {
+            std::cerr << "Не удалось записать " << parser.value(outputOption).toStdString() << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    double megabytes = result.fileBytes / (1024.0 * 1024.0);
+    std::cout << "Кадров: " << result.frames << ", разобрано: " << result.decoded
+              << " (TCP " << result.tcpPackets << ", UDP " << result.udpPackets
+              << "), не разобрано: " << result.undecoded << ", собрано из фрагментов: " << result.reassembled << "\n";
+    std::cout << "Сообщений: " << result.events.size() << "\n";
+    if (result.truncated) {
+        std::cout << "Последняя запись обрезана или повреждена - файл разобран до неё\n";
+    }
+    std::cout << "Потоков разбора заголовков: " << result.decodeThreads << ", сборщиков: " << result.shardThreads << "\n";
+    std::cout << "Время: " << result.seconds << " с, " << megabytes / std::max(result.seconds, 1e-9) << " МБ/с, "
+              << result.frames / std::max(result.seconds, 1e-9) << " кадров/с\n";
+    if (result.shardThreads > 1 || result.decodeThreads > 1) {
+        // Кто кого ждал: разборщики - чтения (диск) или чтение - обработки (процессор)
+        std::cout << "Ожидание чтения: " << result.readWaitSeconds << " с, ожидание обработки: "
+                  << result.workWaitSeconds << " с - упор в "
+                  << (result.readWaitSeconds >= result.workWaitSeconds ? "диск" : "процессор") << "\n";
+    }
+
+    std::vector<HttpEndpointSnapshot> endpoints = httpStats.snapshot();
+    std::sort(endpoints.begin(), endpoints.end(), [](const HttpEndpointSnapshot &a, const HttpEndpointSnapshot &b) {
+        return a.requests > b.requests;
+    });
+    for (size_t i = 0; i < endpoints.size() && i < 10; i++) {
+        const HttpEndpointSnapshot &endpoint = endpoints[i];
+        std::cout << "  " << endpoint.host << endpoint.path << ": запросов " << endpoint.requests
+                  << ", ответов " << endpoint.responses << ", 4xx " << endpoint.clientErrors
+                  << ", 5xx " << endpoint.serverErrors << ", p95 " << endpoint.p95Us / 1000.0 << " мс\n";
+    }
+    return EXIT_SUCCESS;
+}
+
+// Размещение потоков захвата можно задать при запуске (не сохраняется в настройках).
+// Вызывается до проверки прав, чтобы --help и ошибки в параметрах не требовали
+// sudo; тогда параметры Qt (-style, -platform) ещё не убраны и strict = false
+// пропускает неизвестные. Возвращает код выхода или -1, если запуск продолжается
+static int parseCaptureOptions(const QStringList &arguments, bool strict, QVariantMap &overrides) {
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Сетевой сниффер с поддержкой HTTP");
+    QCommandLineOption helpOption = parser.addHelpOption();
+    QCommandLineOption threadsOption("capture-threads",
+                                     "Число потоков захвата (PACKET_FANOUT, только Linux).", "N");
+    QCommandLineOption cpusOption("capture-cpus",
+                                  "Ядра для потоков захвата, например 2-5,8, или numa - ядра узла сетевой карты.",
+                                  "список");
+    QCommandLineOption policyOption("priority",
+                                    "Приоритет потоков захвата: normal, high или realtime.", "приоритет");
+    parser.addOption(threadsOption);
+    parser.addOption(cpusOption);
+    parser.addOption(policyOption);
+
+    if (!parser.parse(arguments) && (strict || parser.unknownOptionNames().isEmpty())) {
+        std::cerr << parser.errorText().toStdString() << std::endl;
+        return EXIT_FAILURE;
+    }
+    if (parser.isSet(helpOption)) {
+        std::cout << parser.helpText().toStdString();
+        return EXIT_SUCCESS;
+    }
+
+    overrides.clear();
+    if (parser.isSet(threadsOption)) {
+        bool ok = false;
+        int threads = parser.value(threadsOption).toInt(&ok);
+        if (!ok || threads < 1 || threads > 64) {
+            std::cerr << "Некорректное число потоков захвата" << std::endl;
+            return EXIT_FAILURE;
+        }
+        overrides["capture_threads"] = threads;
+    }
+    if (parser.isSet(cpusOption)) {
+        std::vector<int> cpus;
+        QString list = parser.value(cpusOption);
+        if (list != "numa" && !ThreadTuning::parseCpuList(list.toStdString(), cpus)) {
+            std::cerr << "Некорректный список ядер: " << list.toStdString() << std::endl;
+            return EXIT_FAILURE;
+        }
+        overrides["capture_cpus"] = list;
+    }
+    if (parser.isSet(policyOption)) {
+        SchedulingPolicy policy;
+        if (!ThreadTuning::parsePolicy(parser.value(policyOption).toStdString(), policy)) {
+            std::cerr << "Некорректный приоритет: " << parser.value(policyOption).toStdString() << std::endl;
+            return EXIT_FAILURE;
+        }
+        overrides["capture_policy"] = parser.value(policyOption);
+    }
+    return -1;
+}
+
 int main(int argc, char *argv[]) {
+    // Разбор файла не требует прав суперпользователя и графики
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--analyze") == 0 || strncmp(argv[i], "--analyze=", 10) == 0) {
+            QCoreApplication app(argc, argv);
+            app.setApplicationName("Сетевой Сниффер");
+            return runOfflineAnalysis(app);
+        }
+    }
+
+    QStringList arguments;
+    for (int i = 0; i < argc; i++) {
+        arguments << QString::fromLocal8Bit(argv[i]);
+    }
+    QVariantMap overrides;
+    int status = parseCaptureOptions(arguments, false, overrides);
+    if (status >= 0) {
+        return status;
+    }
+
 #ifdef _WIN32
     // Инициализация Winsock для Windows
     WSADATA wsaData;
@@ -30,8 +191,15 @@ int main(int argc, char *argv[]) {
     app.setApplicationName("Сетевой Сниффер");
     app.setOrganizationName("QwantJ");
 
+    // Параметры Qt уже убраны QApplication: оставшиеся неизвестные - ошибка
+    status = parseCaptureOptions(app.arguments(), true, overrides);
+    if (status >= 0) {
+        return status;
+    }
+
     // Создаем и отображаем главное окно
     MainWindow mainWindow;
+    mainWindow.setSettingOverrides(overrides);
     mainWindow.show();
 
     // Запускаем цикл событий
@@ -16,50 +16,524 @@
 #include <QInputDialog>
 #include <QSplitter>
 #include <QGroupBox>
+#include <QDialog>
+#include <QTableWidget>
+#include <QCoreApplication>
 #include <iostream>
+#include <algorithm>
+#include <chrono>
 #ifdef _WIN32
 #include <winsock2.h>
 #include <ws2tcpip.h>
 #include <windows.h>
 #else
 #include <arpa/inet.h>
-#include <netinet/ip.h>
-#include <netinet/tcp.h>
-#include <netinet/udp.h>
-#include <net/ethernet.h>
 #include <unistd.h>
 #endif
 
+#ifdef __linux__
+#include <sys/socket.h>
+#include <linux/if_packet.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
 #include "mainwindow.h"
+#include "packet_decoder.h"
+#include "capture_filter.h"
+#include "thread_tuning.h"
+#include "http_body_decoder.h"
+#include "trace.h"
+#include "conversations_window.h"
+#include "http_stats_window.h"
+
+// Адрес IPv4 (в порядке хоста) в точечной записи
+static QString ipToString(uint32_t ip) {
+    return QString("%1.%2.%3.%4")
+        .arg((ip >> 24) & 0xff).arg((ip >> 16) & 0xff)
+        .arg((ip >> 8) & 0xff).arg(ip & 0xff);
+}
+
+// Подпись интерфейса без скорости (текст пункта обновляется раз в секунду)
+static const int INTERFACE_LABEL_ROLE = Qt::UserRole + 1;
+
+// Сколько тела показывать в панели деталей (полностью - через сохранение)
+static const int BODY_DISPLAY_LIMIT = 1024 * 1024;
+
+// Постоянные столбцы таблицы пакетов; за ними - столбцы заголовков HTTP
+static const int BASE_COLUMN_COUNT = 10;
+
+// Столбец интерфейса виден только при захвате с нескольких интерфейсов
+static const int INTERFACE_COLUMN = 8;
+
+// Локальный процесс потока (значение - идентификатор в headerInterner)
+static const int PROCESS_COLUMN = 9;
+
+// Строка заголовка Host (её значение ищется, даже если столбца Host нет)
+static bool isHostLine(const std::string &line) {
+    return line.size() >= 5 && (line[0] | 0x20) == 'h' && (line[1] | 0x20) == 'o' &&
+           (line[2] | 0x20) == 's' && (line[3] | 0x20) == 't' && line[4] == ':';
+}
+
+static const char *httpMethodName(HTTPMethod method) {
+    switch (method) {
+    case HTTP_GET: return "GET";
+    case HTTP_POST: return "POST";
+    case HTTP_PUT: return "PUT";
+    case HTTP_DELETE: return "DELETE";
+    case HTTP_HEAD: return "HEAD";
+    case HTTP_OPTIONS: return "OPTIONS";
+    case HTTP_CONNECT: return "CONNECT";
+    default: return "UNKNOWN";
+    }
+}
+
+// Поле записи потока событий (пустые не передаются)
+static void addStreamField(StreamEventField *fields, size_t &count, uint16_t id, const std::string &value) {
+    if (!value.empty()) {
+        fields[count++] = StreamEventField{id, value.data(), value.size()};
+    }
+}
 
 // ------------------ Реализация CaptureThread ------------------
 
+// Захват с нескольких интерфейсов: таймаут чтения задаёт, как быстро пакеты
+// молчащего интерфейса попадают в очередь; дольше MERGE_MAX_DELAY_US пакет
+// не ждёт более ранних пакетов других интерфейсов
+static const int MERGE_READ_TIMEOUT_MS = 100;
+static const uint64_t MERGE_MAX_DELAY_US = 250000;
+static const size_t MERGE_QUEUE_BYTES = 16 * 1024 * 1024;   // На интерфейс
+static const int MERGE_BATCH = 4096;
+
 CaptureThread::CaptureThread(QObject *parent) : QThread(parent),
-    running(false), handle(nullptr), packetCount(0), tcpCount(0),
-    udpCount(0), httpCount(0), tcpAssembler(nullptr) {
+    running(false), handle(nullptr), currentInterface(0), merger(nullptr), readersRunning(false),
+    packetCount(0), tcpCount(0),
+    udpCount(0), httpCount(0), tcpAssembler(nullptr), udpDissectors(nullptr), defragmenter(nullptr), flowStats(nullptr),
+    httpStats(nullptr), currentTimestampUs(0), processResolver(nullptr), processGeneration(0),
+    eventStream(nullptr), truncateBypassed(false), snaplen(65536),
+    fanoutGroup(0), cpu(-1), threadIndex(0), policy(SCHEDULING_NORMAL), frameQueue(nullptr),
+    triggerEnabled(false), triggerSignal(nullptr), triggerRecorder(nullptr),
+    headerInterner(nullptr),
+    pendingSettings(nullptr), linkType(-1),
+    queuedRows(0), lastLoadCheckUs(0) {
 }
 
 CaptureThread::~CaptureThread() {
     stopCapture();
     wait(); // Ожидаем завершения потока
+    applyPendingSettings();   // Освобождает не забранные настройки
 
     if (tcpAssembler) {
         delete tcpAssembler;
     }
+    delete udpDissectors;
+    delete defragmenter;
+    delete triggerRecorder;
 }
 
 void CaptureThread::setInterface(const QString &name) {
-    interfaceName = name;
+    interfaceNames = QStringList{name};
+}
+
+void CaptureThread::setInterfaces(const QStringList &names) {
+    interfaceNames = names;
 }
 
 void CaptureThread::setFilter(const QString &filter) {
     filterExpr = filter;
 }
 
+void CaptureThread::setFlowStatistics(FlowStatistics *statistics) {
+    flowStats = statistics;
+}
+
+void CaptureThread::setHttpStatistics(HttpEndpointStats *statistics) {
+    httpStats = statistics;
+}
+
+void CaptureThread::setSampling(SamplingMode mode, uint32_t rate) {
+    sampler.setRate(rate);
+    sampler.setMode(mode);
+}
+
+void CaptureThread::setBypass(const AssemblerConfig &config, bool truncateInKernel) {
+    assemblerConfig = config;
+    truncateBypassed = truncateInKernel;
+}
+
+void CaptureThread::setSnaplen(int value) {
+    snaplen = value;
+}
+
+bool CaptureThread::reconfigure(const QString &filter, const AssemblerConfig &config,
+                                bool truncateInKernel, QString &errorMessage) {
+    if (!isRunning()) {
+        filterExpr = filter;
+        setBypass(config, truncateInKernel);
+        return true;
+    }
+
+    int currentLinkType = linkType.load(std::memory_order_acquire);
+    if (currentLinkType < 0) {
+        errorMessage = "Устройство захвата ещё не открыто, повторите позже";
+        return false;
+    }
+
+    // Программа компилируется для того же типа канала и snaplen, что и у
+    // открытого устройства, но без обращения к нему
+    pcap_t *dead = pcap_open_dead(currentLinkType, snaplen);
+    if (!dead) {
+        errorMessage = "Не удалось подготовить компиляцию фильтра";
+        return false;
+    }
+    LiveSettings *settings = new LiveSettings();
+    settings->filter = filter;
+    settings->assembler = config;
+    settings->truncateInKernel = truncateInKernel;
+    std::string compileError;
+    bool compiled = CaptureFilter::compile(dead, filter.toStdString(),
+                                           truncateInKernel ? config.bypassPorts : std::set<uint16_t>(),
+                                           settings->program, compileError);
+    pcap_close(dead);
+    if (!compiled) {
+        errorMessage = QString::fromStdString(compileError);
+        delete settings;
+        return false;
+    }
+
+    // Не забранные потоком прошлые настройки заменяются новыми
+    LiveSettings *previous = pendingSettings.exchange(settings, std::memory_order_acq_rel);
+    if (previous) {
+        CaptureFilter::release(previous->program);
+        delete previous;
+    }
+    return true;
+}
+
+void CaptureThread::applyPendingSettings() {
+    LiveSettings *settings = pendingSettings.exchange(nullptr, std::memory_order_acq_rel);
+    if (!settings) {
+        return;
+    }
+
+    // Установка фильтра - только подмена программы в ядре; при ошибке
+    // остаётся прежний фильтр, захват продолжается
+    if (handle && pcap_setfilter(handle, &settings->program) == -1) {
+        emit warning(QString("Не удалось установить фильтр, действует прежний: %1").arg(pcap_geterr(handle)));
+    } else {
+        filterExpr = settings->filter;
+    }
+
+    // Интерфейсы читают свои потоки: каждому передаётся копия программы,
+    // устанавливает её сам поток чтения между вызовами pcap_dispatch
+    for (InterfaceReader *reader : readers) {
+        bpf_program *program = new bpf_program;
+        program->bf_len = settings->program.bf_len;
+        program->bf_insns = new struct bpf_insn[program->bf_len];
+        std::copy(settings->program.bf_insns, settings->program.bf_insns + program->bf_len, program->bf_insns);
+        bpf_program *previous = reader->pendingFilter.exchange(program, std::memory_order_acq_rel);
+        if (previous) {
+            CaptureFilter::release(*previous);
+            delete previous;
+        }
+    }
+
+    // Сборщик и его потоки сохраняются, меняются только правила
+    assemblerConfig = settings->assembler;
+    truncateBypassed = settings->truncateInKernel;
+    if (tcpAssembler) {
+        tcpAssembler->setConfig(assemblerConfig);
+    }
+
+    CaptureFilter::release(settings->program);
+    delete settings;
+}
+
+bool CaptureThread::isFanoutSupported() {
+#ifdef __linux__
+    return true;
+#else
+    return false;
+#endif
+}
+
+void CaptureThread::setFanoutGroup(int groupId) {
+    fanoutGroup = groupId;
+}
+
+void CaptureThread::setCpu(int value) {
+    cpu = value;
+}
+
+void CaptureThread::setSchedulingPolicy(SchedulingPolicy value) {
+    policy = value;
+}
+
+void CaptureThread::setFrameQueue(FrameQueue *queue) {
+    frameQueue = queue;
+}
+
+void CaptureThread::setTrigger(bool enabled, const TriggerOptions &options, TriggerSignal *signal) {
+    triggerEnabled = enabled;
+    triggerOptions = options;
+    triggerSignal = signal;
+}
+
+void CaptureThread::setProcessResolver(ProcessResolver *resolver) {
+    processResolver = resolver;
+}
+
+uint32_t CaptureThread::lookupProcess(uint8_t protocol, uint32_t srcIP, uint16_t srcPort,
+                                      uint32_t dstIP, uint16_t dstPort) {
+    if (!processResolver || !headerInterner) {
+        return StringInterner::EMPTY_ID;
+    }
+
+    // Новый снимок забирается только при смене поколения (не чаще раза в
+    // полсекунды), между сменами поиск идёт по своей копии без блокировок
+    uint64_t generation = processResolver->generation();
+    if (generation != processGeneration) {
+        processGeneration = generation;
+        processSnapshot = processResolver->snapshot();
+        processLabelIds.assign(processSnapshot ? processSnapshot->processCount() : 0, UINT32_MAX);
+    }
+    if (!processSnapshot) {
+        return StringInterner::EMPTY_ID;
+    }
+
+    uint32_t index = processSnapshot->find(protocol, srcIP, srcPort, dstIP, dstPort);
+    if (index == ProcessSnapshot::NOT_FOUND) {
+        return StringInterner::EMPTY_ID;
+    }
+    uint32_t &id = processLabelIds[index];
+    if (id == UINT32_MAX) {
+        id = headerInterner->intern(processSnapshot->process(index).label);
+    }
+    return id;
+}
+
+void CaptureThread::setEventStream(EventStreamPublisher *stream) {
+    eventStream = stream;
+}
+
+void CaptureThread::publishEvent(StreamEventHeader &header, uint32_t srcIP, uint16_t srcPort, uint32_t dstIP,
+                                 uint16_t dstPort, const StreamEventField *fields, size_t fieldCount) {
+    header.interfaceIndex = static_cast<uint32_t>(currentInterface);
+    header.timestampUs = currentTimestampUs;
+    header.srcIP = srcIP;
+    header.dstIP = dstIP;
+    header.srcPort = srcPort;
+    header.dstPort = dstPort;
+    eventStream->publish(header, fields, fieldCount);
+}
+
+void CaptureThread::setHeaderColumns(StringInterner *interner, const QStringList &names) {
+    headerInterner = interner;
+    headerColumns.clear();
+    for (const QString &name : names) {
+        headerColumns.push_back(name.toLower().toStdString());
+    }
+}
+
+void CaptureThread::setThreadIndex(int index) {
+    threadIndex = index;
+}
+
+int CaptureThread::probeLinkType(const QString &interfaceName) {
+    char errbuf[PCAP_ERRBUF_SIZE];
+    pcap_t *probe = pcap_open_live(interfaceName.toLocal8Bit().constData(), 64, 0, 0, errbuf);
+    if (!probe) {
+        return -1;
+    }
+    int type = pcap_datalink(probe);
+    pcap_close(probe);
+    return type;
+}
+
+bool CaptureThread::joinFanoutGroup(QString &message) {
+#ifdef __linux__
+    // Хеш ядра симметричен, поэтому оба направления соединения попадают
+    // в один поток и один сборщик; фрагменты собираются до распределения
+    int value = (fanoutGroup & 0xffff) | ((PACKET_FANOUT_HASH | PACKET_FANOUT_FLAG_DEFRAG) << 16);
+    if (setsockopt(pcap_fileno(handle), SOL_PACKET, PACKET_FANOUT, &value, sizeof(value)) == -1) {
+        message = QString("Не удалось присоединиться к группе PACKET_FANOUT: %1").arg(strerror(errno));
+        return false;
+    }
+    return true;
+#else
+    message = "PACKET_FANOUT поддерживается только в Linux";
+    return false;
+#endif
+}
+
 void CaptureThread::stopCapture() {
     running = false;
 }
 
+// Кадр соединения, перешедшего на WebSocket: в таблицу уходит только начало данных
+void CaptureThread::onWebSocketFrame(const StreamKey &key, const WebSocketFrame &frame) {
+    QString info = QString("%1%2%3, %4 байт")
+        .arg(WebSocketFrameParser::opcodeName(frame.opcode))
+        .arg(frame.fin ? "" : " (фрагмент)")
+        .arg(frame.compressed ? ", сжат" : "")
+        .arg(frame.length);
+
+    queuedRows.fetch_add(1, std::memory_order_relaxed);
+    emit webSocketFrameCaptured(
+        ipToString(key.srcIP), QString::number(key.srcPort),
+        ipToString(key.dstIP), QString::number(key.dstPort),
+        info, static_cast<qint64>(frame.length),
+        QByteArray(frame.payload.data(), static_cast<int>(frame.payload.size())), currentInterface,
+        lookupProcess(IP_PROTO_TCP, key.srcIP, key.srcPort, key.dstIP, key.dstPort));
+}
+
+// Открытая часть рукопожатия TLS: одна строка на ClientHello и на ServerHello
+void CaptureThread::onTlsHello(const StreamKey &key, const TlsHello &hello) {
+    QString serverName = QString::fromStdString(hello.serverName);
+    QString version = QString::fromStdString(TlsSniffer::versionName(hello.version));
+
+    QStringList alpn;
+    for (const std::string &protocol : hello.alpn) {
+        alpn << QString::fromStdString(protocol);
+    }
+
+    QString info;
+    QString details = "<p><b>Версия:</b> " + version + "</p>";
+    if (hello.client) {
+        info = QString("ClientHello %1%2").arg(serverName.isEmpty() ? "(без SNI)" : serverName,
+                                               alpn.isEmpty() ? "" : " [" + alpn.join(", ") + "]");
+        details += "<p><b>Имя сервера (SNI):</b> " + (serverName.isEmpty() ? "нет" : serverName.toHtmlEscaped()) + "</p>";
+        details += "<p><b>ALPN:</b> " + (alpn.isEmpty() ? "нет" : alpn.join(", ").toHtmlEscaped()) + "</p>";
+        details += QString("<p><b>Предложено наборов шифров:</b> %1</p>").arg(hello.offeredCipherSuites);
+    } else {
+        QString cipher = QString::fromStdString(TlsSniffer::cipherSuiteName(hello.cipherSuite));
+        info = QString("ServerHello %1, %2").arg(version, cipher);
+        details += "<p><b>Набор шифров:</b> " + cipher + "</p>";
+        details += "<p><b>Имя сервера (из ClientHello):</b> " + (serverName.isEmpty() ? "неизвестно" : serverName.toHtmlEscaped()) + "</p>";
+        details += "<p><b>ALPN:</b> " + (!alpn.isEmpty() ? alpn.join(", ").toHtmlEscaped()
+                                        : hello.version == 0x0304 ? QString("в TLS 1.3 выбор сервера зашифрован")
+                                                                  : QString("нет")) + "</p>";
+    }
+
+    if (eventStream) {
+        StreamEventHeader header = {};
+        header.type = STREAM_EVENT_TLS_HELLO;
+        header.flags = hello.client ? 0 : STREAM_EVENT_RESPONSE;
+        header.code = hello.version;
+        StreamEventField fields[1];
+        size_t fieldCount = 0;
+        addStreamField(fields, fieldCount, STREAM_FIELD_HOST, hello.serverName);
+        publishEvent(header, key.srcIP, key.srcPort, key.dstIP, key.dstPort, fields, fieldCount);
+    }
+
+    queuedRows.fetch_add(1, std::memory_order_relaxed);
+    emit tlsHelloCaptured(hello.client ? "ClientHello" : "ServerHello",
+                          ipToString(key.srcIP), QString::number(key.srcPort),
+                          ipToString(key.dstIP), QString::number(key.dstPort),
+                          info, serverName, details, currentInterface,
+                          lookupProcess(IP_PROTO_TCP, key.srcIP, key.srcPort, key.dstIP, key.dstPort));
+}
+
+// Сообщение DNS: строка таблицы и задержка ответа в статистике эндпоинтов
+void CaptureThread::onDnsMessage(const UdpDatagram &datagram, const DnsMessage &message,
+                                 const DnsTransactionInfo &transaction) {
+    char name[DnsParser::MAX_NAME_LENGTH] = "";
+    if (message.questionCount > 0) {
+        DnsParser::readName(message, message.questionName, name, sizeof(name));
+    }
+    QString queryName = QString::fromLatin1(name);
+    QString queryType = QString::fromStdString(DnsParser::typeName(message.questionType));
+    QString rcode = QString::fromStdString(DnsParser::rcodeName(message.rcode));
+    double latencyMs = transaction.latencyUs / 1000.0;
+
+    // Эндпоинт DNS - сервер и тип запроса (имена не ограничены, типов немного)
+    if (httpStats && message.opcode == 0 && message.questionCount > 0) {
+        uint32_t server = message.response ? datagram.srcIP : datagram.dstIP;
+        std::string host = "DNS " + ipToString(server).toStdString();
+        std::string path = queryType.toStdString();
+        if (!message.response) {
+            httpStats->onMatchedRequest(host, path);
+        } else if (transaction.matched) {
+            bool serverError = message.rcode == DNS_SERVFAIL || message.rcode == DNS_NOTIMP;
+            bool clientError = message.rcode != DNS_NOERROR && !serverError;
+            httpStats->onMatchedResponse(host, path, clientError, serverError, transaction.latencyUs);
+        }
+    }
+
+    QString details = QString("<p><b>ID:</b> 0x%1</p>").arg(message.id, 4, 16, QChar('0'));
+    details += "<p><b>Вопрос:</b> " + queryType + " " + queryName.toHtmlEscaped() + "</p>";
+
+    QString info;
+    if (!message.response) {
+        info = QString("Запрос %1 %2").arg(queryType, queryName);
+    } else {
+        // Секция ответов: адреса и имена, в строку таблицы - первые три
+        QStringList answers;
+        QString answersHtml;
+        size_t offset = message.answersOffset;
+        DnsRecord record;
+        char data[DnsParser::MAX_NAME_LENGTH + 32];
+        for (uint16_t i = 0; i < message.answerCount && DnsParser::readRecord(message, offset, record); i++) {
+            if (!DnsParser::formatData(message, record, data, sizeof(data))) {
+                continue;
+            }
+            DnsParser::readName(message, record.name, name, sizeof(name));
+            QString text = QString::fromLatin1(data);
+            answers << text;
+            answersHtml += QString("<tr><td>%1</td><td>%2</td><td>%3</td><td>%4</td></tr>")
+                .arg(QString::fromLatin1(name).toHtmlEscaped(),
+                     QString::fromStdString(DnsParser::typeName(record.type)))
+                .arg(record.ttl)
+                .arg(text.toHtmlEscaped());
+        }
+
+        QString result = message.rcode != DNS_NOERROR ? rcode
+                       : answers.isEmpty() ? QString("нет записей")
+                       : QStringList(answers.mid(0, 3)).join(", ") + (answers.size() > 3 ? ", ..." : "");
+        info = QString("Ответ %1 %2: %3").arg(queryType, queryName, result);
+        if (transaction.matched) {
+            info += QString(" (%1 мс)").arg(latencyMs, 0, 'f', 1);
+        }
+
+        details += "<p><b>Код ответа:</b> " + rcode + "</p>";
+        details += "<p><b>Задержка:</b> " + (transaction.matched ? QString("%1 мс").arg(latencyMs, 0, 'f', 1)
+                                                                : QString("запрос не найден")) + "</p>";
+        details += QString("<p><b>Флаги:</b>%1%2</p>")
+            .arg(QString(message.authoritative ? " авторитетный" : ""),
+                 QString(message.truncated ? " усечён (TC)" : ""));
+        if (!answersHtml.isEmpty()) {
+            details += "<table border=\"1\" cellpadding=\"2\"><tr><th>Имя</th><th>Тип</th><th>TTL</th>"
+                       "<th>Данные</th></tr>" + answersHtml + "</table>";
+        }
+        details += QString("<p>Записей в секциях полномочий: %1, дополнительных: %2</p>")
+            .arg(message.authorityCount).arg(message.additionalCount);
+    }
+
+    if (eventStream) {
+        StreamEventHeader header = {};
+        header.type = STREAM_EVENT_DNS;
+        header.flags = message.response ? STREAM_EVENT_RESPONSE : 0;
+        header.code = message.rcode;
+        header.length = datagram.length;
+        std::string host = name;
+        std::string type = queryType.toStdString();
+        StreamEventField fields[2];
+        size_t fieldCount = 0;
+        addStreamField(fields, fieldCount, STREAM_FIELD_HOST, host);
+        addStreamField(fields, fieldCount, STREAM_FIELD_QUERY_TYPE, type);
+        publishEvent(header, datagram.srcIP, datagram.srcPort, datagram.dstIP, datagram.dstPort,
+                     fields, fieldCount);
+    }
+
+    queuedRows.fetch_add(1, std::memory_order_relaxed);
+    emit datagramCaptured("DNS", message.response ? "ответ" : "запрос",
+                          ipToString(datagram.srcIP), QString::number(datagram.srcPort),
+                          ipToString(datagram.dstIP), QString::number(datagram.dstPort),
+                          static_cast<int>(datagram.length), info, queryName, details, currentInterface,
+                          lookupProcess(IP_PROTO_UDP, datagram.srcIP, datagram.srcPort,
+                                        datagram.dstIP, datagram.dstPort));
+}
+
 // Адаптер для вызова метода экземпляра из статической функции обратного вызова
 void CaptureThread::packetHandler(u_char *userData, const struct pcap_pkthdr *pkthdr, const u_char *packet) {
     CaptureThread *thread = reinterpret_cast<CaptureThread*>(userData);
@@ -68,18 +542,55 @@ void CaptureThread::packetHandler(u_char *userData, const struct pcap_pkthdr *pk
 
 // Функция HTTP-обработчика для сборщика TCP-потоков
 void CaptureThread::onHttpMessage(const StreamKey &key, const std::vector<uint8_t> &data) {
+    TRACE_SCOPE("capture.onHttpMessage");
+
     if (HTTPParser::isHTTP(data.data(), data.size())) {
         httpCount++;
 
         HTTPMessage message = HTTPParser::parseHTTP(data.data(), data.size());
 
-        // Получаем IP-адреса в читаемом формате
-        char srcIP[INET_ADDRSTRLEN];
-        char dstIP[INET_ADDRSTRLEN];
-        struct in_addr src_addr = {htonl(key.srcIP)};
-        struct in_addr dst_addr = {htonl(key.dstIP)};
-        inet_ntop(AF_INET, &src_addr, srcIP, INET_ADDRSTRLEN);
-        inet_ntop(AF_INET, &dst_addr, dstIP, INET_ADDRSTRLEN);
+        // Учитываем сообщение в статистике производительности эндпоинтов
+        if (httpStats) {
+            if (message.isRequest) {
+                httpStats->onRequest(key, HTTPParser::getHeader(message, "Host"),
+                                     message.uri, currentTimestampUs, tcpAssembler->messageStreamId());
+            } else {
+                httpStats->onResponse(key, message.statusCode, currentTimestampUs,
+                                      tcpAssembler->messageStreamId());
+            }
+        }
+
+        // Проверяем правила записи по событию
+        if (triggerRecorder) {
+            if (message.isRequest) {
+                triggerRecorder->onHttpRequest(HTTPParser::getHeader(message, "Host"),
+                                               message.uri, currentTimestampUs);
+            } else {
+                triggerRecorder->onHttpResponse(message.statusCode, currentTimestampUs);
+            }
+        }
+
+        // Внешним программам - сразу в общую память, без строк Qt
+        if (eventStream) {
+            StreamEventHeader header = {};
+            header.type = message.isRequest ? STREAM_EVENT_HTTP_REQUEST : STREAM_EVENT_HTTP_RESPONSE;
+            header.code = message.isRequest ? 0 : static_cast<uint32_t>(message.statusCode);
+            header.length = message.body.size();
+            std::string method = message.isRequest ? httpMethodName(message.method) : "";
+            std::string host = HTTPParser::getHeader(message, "Host");
+            std::string contentType = HTTPParser::getHeader(message, "Content-Type");
+            std::string userAgent = HTTPParser::getHeader(message, "User-Agent");
+            StreamEventField fields[7];
+            size_t fieldCount = 0;
+            addStreamField(fields, fieldCount, STREAM_FIELD_METHOD, method);
+            addStreamField(fields, fieldCount, STREAM_FIELD_URI, message.uri);
+            addStreamField(fields, fieldCount, STREAM_FIELD_HOST, host);
+            addStreamField(fields, fieldCount, STREAM_FIELD_VERSION, message.version);
+            addStreamField(fields, fieldCount, STREAM_FIELD_STATUS_TEXT, message.statusText);
+            addStreamField(fields, fieldCount, STREAM_FIELD_CONTENT_TYPE, contentType);
+            addStreamField(fields, fieldCount, STREAM_FIELD_USER_AGENT, userAgent);
+            publishEvent(header, key.srcIP, key.srcPort, key.dstIP, key.dstPort, fields, fieldCount);
+        }
 
         // Тип сообщения (запрос/ответ)
         QString type = message.isRequest ? "Запрос" : "Ответ";
@@ -87,17 +598,7 @@ void CaptureThread::onHttpMessage(const StreamKey &key, const std::vector<uint8_
         // Основная информация для заголовка
         QString info;
         if (message.isRequest) {
-            QString method;
-            switch (message.method) {
-            case HTTP_GET: method = "GET"; break;
-            case HTTP_POST: method = "POST"; break;
-            case HTTP_PUT: method = "PUT"; break;
-            case HTTP_DELETE: method = "DELETE"; break;
-            case HTTP_HEAD: method = "HEAD"; break;
-            case HTTP_OPTIONS: method = "OPTIONS"; break;
-            default: method = "UNKNOWN"; break;
-            }
-            info = method + " " + QString::fromStdString(message.uri) + " " +
+            info = QString(httpMethodName(message.method)) + " " + QString::fromStdString(message.uri) + " " +
                    QString::fromStdString(message.version);
         } else {
             info = QString::fromStdString(message.version) + " " +
@@ -105,22 +606,30 @@ void CaptureThread::onHttpMessage(const StreamKey &key, const std::vector<uint8_
                    QString::fromStdString(message.statusText);
         }
 
-        // Собираем заголовки
-        QString headers;
-        for (const auto& header : message.headers) {
-            headers += QString::fromStdString(header.first) + ": " +
-                       QString::fromStdString(header.second) + "\n";
+        // Заголовки уходят в GUI номерами строк в общей таблице значений
+        QList<quint32> headerLines;
+        QList<quint32> headerValues;
+        if (headerInterner) {
+            HTTPParser::internHeaders(data.data(), data.size(), headerColumns, *headerInterner,
+                                      headerLineIds, headerValueIds);
+            headerLines = QList<quint32>(headerLineIds.begin(), headerLineIds.end());
+            headerValues = QList<quint32>(headerValueIds.begin(), headerValueIds.end());
         }
 
-        // Тело сообщения
-        QString body = QString::fromStdString(message.body);
+        // Тело передаётся как есть: chunked и сжатие снимаются при просмотре
+        QByteArray body(message.body.data(), static_cast<int>(message.body.size()));
 
         // Отправляем сигнал в основной поток с информацией о HTTP-сообщении
+        queuedRows.fetch_add(1, std::memory_order_relaxed);
         emit httpMessageCaptured(
             type,
-            QString(srcIP), QString::number(key.srcPort),
-            QString(dstIP), QString::number(key.dstPort),
-            info, headers, body
+            ipToString(key.srcIP), QString::number(key.srcPort),
+            ipToString(key.dstIP), QString::number(key.dstPort),
+            info, headerLines, headerValues, body,
+            QString::fromStdString(HTTPParser::getHeader(message, "Transfer-Encoding")),
+            QString::fromStdString(HTTPParser::getHeader(message, "Content-Encoding")),
+            currentInterface,
+            lookupProcess(IP_PROTO_TCP, key.srcIP, key.srcPort, key.dstIP, key.dstPort)
             );
 
         // Обновляем статистику
@@ -129,200 +638,320 @@ void CaptureThread::onHttpMessage(const StreamKey &key, const std::vector<uint8_
 }
 
 void CaptureThread::processPacket(const pcap_pkthdr *pkthdr, const u_char *packet) {
+    TRACE_SCOPE("capture.processPacket");
+
     packetCount++;
+    currentTimestampUs = uint64_t(pkthdr->ts.tv_sec) * 1000000 + pkthdr->ts.tv_usec;
 
-#ifdef _WIN32
-    // Структуры для Windows
-    struct ether_header {
-        u_char ether_dhost[6];
-        u_char ether_shost[6];
-        u_short ether_type;
-    };
-
-    struct ip_header {
-        u_char  ip_vhl;
-        u_char  ip_tos;
-        u_short ip_len;
-        u_short ip_id;
-        u_short ip_off;
-        u_char  ip_ttl;
-        u_char  ip_p;
-        u_short ip_sum;
-        struct in_addr ip_src;
-        struct in_addr ip_dst;
-    };
-
-    struct tcp_header {
-        u_short th_sport;
-        u_short th_dport;
-        u_int   th_seq;
-        u_int   th_ack;
-        u_char  th_offx2;
-        u_char  th_flags;
-        u_short th_win;
-        u_short th_sum;
-        u_short th_urp;
-    };
-
-    struct udp_header {
-        u_short uh_sport;
-        u_short uh_dport;
-        u_short uh_len;
-        u_short uh_sum;
-    };
-
-// Константы для Windows
-#define IPPROTO_TCP 6
-#define IPPROTO_UDP 17
-
-    // Обработка для Windows
-    struct ether_header* ethHeader = (struct ether_header*)packet;
-    struct ip_header* ipHeader = (struct ip_header*)(packet + sizeof(struct ether_header));
-
-    if (ipHeader->ip_p == IPPROTO_TCP) {
-        tcpCount++;
-
-        // Получаем длину IP-заголовка
-        int ipHeaderLength = (ipHeader->ip_vhl & 0x0f) * 4;
-        struct tcp_header* tcpHeader = (struct tcp_header*)(packet + sizeof(struct ether_header) + ipHeaderLength);
-
-        // Получаем длину TCP-заголовка
-        int tcpHeaderLength = ((tcpHeader->th_offx2 & 0xf0) >> 4) * 4;
-
-        // Данные и их длина
-        const u_char* tcpData = packet + sizeof(struct ether_header) + ipHeaderLength + tcpHeaderLength;
-        int dataLength = ntohs(ipHeader->ip_len) - ipHeaderLength - tcpHeaderLength;
-
-        if (dataLength > 0) {
-            // IP-адреса и порты
-            QString srcIp = QString(inet_ntoa(ipHeader->ip_src));
-            QString dstIp = QString(inet_ntoa(ipHeader->ip_dst));
-            QString srcPort = QString::number(ntohs(tcpHeader->th_sport));
-            QString dstPort = QString::number(ntohs(tcpHeader->th_dport));
-
-            // Отправляем информацию о TCP пакете в основной поток
-            emit packetCaptured("TCP", srcIp, srcPort, dstIp, dstPort, dataLength);
-
-            // Передаем пакет в TCP сборщик для анализа HTTP
-            if (tcpAssembler) {
-                tcpAssembler->processPacket(
-                    ntohl(ipHeader->ip_src.s_addr),
-                    ntohl(ipHeader->ip_dst.s_addr),
-                    ntohs(tcpHeader->th_sport),
-                    ntohs(tcpHeader->th_dport),
-                    ntohl(tcpHeader->th_seq),
-                    tcpData,
-                    dataLength
-                    );
-            }
+    // Запись на диск - только копирование в очередь; при переполнении кадр
+    // отбрасывается и учитывается очередью
+    if (frameQueue) {
+        frameQueue->push(currentTimestampUs, pkthdr->caplen, pkthdr->len, packet);
+    }
+
+    // Кольцо кадров до события (без обращений к диску, пока событие не наступило)
+    if (triggerRecorder) {
+        triggerRecorder->onPacket(currentTimestampUs, pkthdr->caplen, pkthdr->len, packet);
+    }
+
+    DecodedPacket decoded;
+    bool decodedOk = PacketDecoder::decode(packet, pkthdr->caplen, decoded);
+    uint64_t wireLength = pkthdr->len;
+
+    // Фрагменты IP до сборки датаграммы дальше не передаются; собранная
+    // датаграмма разбирается и учитывается один раз, с длиной всех фрагментов
+    if (decodedOk && decoded.fragmented) {
+        IpDatagram datagram;
+        decodedOk = defragmenter && defragmenter->addFragment(decoded, pkthdr->len, currentTimestampUs, datagram);
+        if (decodedOk) {
+            PacketDecoder::decodeTransport(datagram.data, datagram.length, datagram.length, decoded);
+            wireLength = datagram.wireBytes;
         }
     }
-    else if (ipHeader->ip_p == IPPROTO_UDP) {
-        udpCount++;
 
-        // Получаем длину IP-заголовка
-        int ipHeaderLength = (ipHeader->ip_vhl & 0x0f) * 4;
-        struct udp_header* udpHeader = (struct udp_header*)(packet + sizeof(struct ether_header) + ipHeaderLength);
+    if (decodedOk) {
+        if (flowStats) {
+            flowStats->addPacket(decoded.srcIP, decoded.dstIP, decoded.srcPort, decoded.dstPort,
+                                 decoded.protocol, wireLength);
+        }
+
+        // Потоки вне выборки обрабатываются только по заголовкам:
+        // учитываются в счётчиках, но не собираются и не выводятся в таблицу
+        bool sampled = sampler.isSampled(decoded.srcIP, decoded.dstIP,
+                                         decoded.srcPort, decoded.dstPort, decoded.protocol);
+
+        if (decoded.protocol == IP_PROTO_TCP) {
+            tcpCount++;
+
+            if (decoded.wirePayloadLength > 0 && sampled) {
+                // Отправляем информацию о TCP пакете в основной поток
+                queuedRows.fetch_add(1, std::memory_order_relaxed);
+                emit packetCaptured("TCP",
+                                    ipToString(decoded.srcIP), QString::number(decoded.srcPort),
+                                    ipToString(decoded.dstIP), QString::number(decoded.dstPort),
+                                    static_cast<int>(decoded.wirePayloadLength), currentInterface,
+                                    lookupProcess(IP_PROTO_TCP, decoded.srcIP, decoded.srcPort,
+                                                  decoded.dstIP, decoded.dstPort));
+            }
+
+            // Передаем пакет в TCP сборщик для анализа HTTP (пакеты без данных
+            // нужны ради SYN/FIN/RST). Поток с обрезанной нагрузкой собрать
+            // нельзя - он сразу переводится в обход.
+            if (tcpAssembler && sampled) {
+                if (decoded.payloadLength < decoded.wirePayloadLength) {
+                    tcpAssembler->bypassStream(decoded.srcIP, decoded.dstIP,
+                                               decoded.srcPort, decoded.dstPort);
+                } else {
+                    tcpAssembler->processPacket(
+                        decoded.srcIP,
+                        decoded.dstIP,
+                        decoded.srcPort,
+                        decoded.dstPort,
+                        decoded.seqNum,
+                        decoded.payload,
+                        decoded.payloadLength,
+                        decoded.tcpFlags
+                        );
+                }
+            }
+        }
+        else if (decoded.protocol == IP_PROTO_UDP) {
+            udpCount++;
+
+            if (decoded.wirePayloadLength > 0 && sampled) {
+                // Известные протоколы (DNS) выводятся разобранными, остальные - как UDP
+                UdpDatagram datagram{decoded.srcIP, decoded.dstIP, decoded.srcPort, decoded.dstPort,
+                                     decoded.payload, decoded.payloadLength, currentTimestampUs};
+                if (!udpDissectors || !udpDissectors->dissect(datagram)) {
+                    // Отправляем информацию о UDP пакете в основной поток
+                    queuedRows.fetch_add(1, std::memory_order_relaxed);
+                    emit packetCaptured("UDP",
+                                        ipToString(decoded.srcIP), QString::number(decoded.srcPort),
+                                        ipToString(decoded.dstIP), QString::number(decoded.dstPort),
+                                        static_cast<int>(decoded.wirePayloadLength), currentInterface,
+                                        lookupProcess(IP_PROTO_UDP, decoded.srcIP, decoded.srcPort,
+                                                      decoded.dstIP, decoded.dstPort));
+                }
+            }
+        }
+    }
 
-        // Данные и их длина
-        const u_char* udpData = packet + sizeof(struct ether_header) + ipHeaderLength + sizeof(struct udp_header);
-        int dataLength = ntohs(udpHeader->uh_len) - sizeof(struct udp_header);
+    // Периодическое обновление статистики
+    if (packetCount % 10 == 0) {
+        emit statisticsUpdated(packetCount, tcpCount, udpCount, httpCount);
+    }
 
-        if (dataLength > 0) {
-            // IP-адреса и порты
-            QString srcIp = QString(inet_ntoa(ipHeader->ip_src));
-            QString dstIp = QString(inet_ntoa(ipHeader->ip_dst));
-            QString srcPort = QString::number(ntohs(udpHeader->uh_sport));
-            QString dstPort = QString::number(ntohs(udpHeader->uh_dport));
+    // Раз в секунду оцениваем нагрузку для автоматической выборки
+    // и очищаем старые потоки (обход всей таблицы потоков)
+    if (currentTimestampUs - lastLoadCheckUs >= 1000000) {
+        lastLoadCheckUs = currentTimestampUs;
+        checkLoad();
 
-            // Отправляем информацию о UDP пакете в основной поток
-            emit packetCaptured("UDP", srcIp, srcPort, dstIp, dstPort, dataLength);
+        if (tcpAssembler) {
+            tcpAssembler->clearOldStreams();
+        }
+        if (defragmenter) {
+            defragmenter->expire(currentTimestampUs);
         }
     }
-#else
-    // Обработка для Unix/Linux
-    struct ethhdr* ethHeader = (struct ethhdr*)packet;
-    struct iphdr* ipHeader = (struct iphdr*)(packet + sizeof(struct ethhdr));
-
-    if (ipHeader->protocol == IPPROTO_TCP) {
-        tcpCount++;
-
-        // Рассчитываем смещение для TCP заголовка
-        int ipHeaderLength = ipHeader->ihl * 4;
-        struct tcphdr* tcpHeader = (struct tcphdr*)(packet + sizeof(struct ethhdr) + ipHeaderLength);
-
-        // Длина TCP заголовка
-        int tcpHeaderLength = tcpHeader->doff * 4;
-
-        // Рассчитываем указатель на данные и их длину
-        const u_char* tcpData = packet + sizeof(struct ethhdr) + ipHeaderLength + tcpHeaderLength;
-        int dataLength = ntohs(ipHeader->tot_len) - ipHeaderLength - tcpHeaderLength;
-
-        if (dataLength > 0) {
-            // IP-адреса и порты
-            struct in_addr src_addr, dst_addr;
-            src_addr.s_addr = ipHeader->saddr;
-            dst_addr.s_addr = ipHeader->daddr;
-
-            QString srcIp = QString(inet_ntoa(src_addr));
-            QString dstIp = QString(inet_ntoa(dst_addr));
-            QString srcPort = QString::number(ntohs(tcpHeader->source));
-            QString dstPort = QString::number(ntohs(tcpHeader->dest));
-
-            // Отправляем информацию о TCP пакете в основной поток
-            emit packetCaptured("TCP", srcIp, srcPort, dstIp, dstPort, dataLength);
-
-            // Передаем пакет в TCP сборщик для анализа HTTP
-            if (tcpAssembler) {
-                tcpAssembler->processPacket(
-                    ntohl(ipHeader->saddr),
-                    ntohl(ipHeader->daddr),
-                    ntohs(tcpHeader->source),
-                    ntohs(tcpHeader->dest),
-                    ntohl(tcpHeader->seq),
-                    tcpData,
-                    dataLength
-                    );
+
+    // Запросы, оставшиеся без ответа дольше 5 минут, не учитываются
+    if (httpStats && packetCount % 10000 == 0) {
+        httpStats->expirePending(currentTimestampUs, 300ULL * 1000000);
+    }
+}
+
+// Пакет интерфейса копируется в его очередь слияния; разбор - в потоке CaptureThread
+void CaptureThread::queueHandler(u_char *userData, const struct pcap_pkthdr *pkthdr, const u_char *packet) {
+    InterfaceReader *reader = reinterpret_cast<InterfaceReader*>(userData);
+    reader->queue->push(uint64_t(pkthdr->ts.tv_sec) * 1000000 + pkthdr->ts.tv_usec,
+                        pkthdr->caplen, pkthdr->len, packet);
+}
+
+void CaptureThread::readInterface(InterfaceReader *reader) {
+    if (Tracer::isEnabled()) {
+        Tracer::setThreadName("capture-reader");
+    }
+    QElapsedTimer statsClock;
+    statsClock.start();
+
+    while (readersRunning.load(std::memory_order_relaxed)) {
+        int dispatched;
+        {
+            TRACE_SCOPE("pcap_dispatch");
+            dispatched = pcap_dispatch(reader->handle, -1, queueHandler, reinterpret_cast<u_char*>(reader));
+        }
+
+        bpf_program *program = reader->pendingFilter.exchange(nullptr, std::memory_order_acq_rel);
+        if (program) {
+            if (pcap_setfilter(reader->handle, program) == -1) {
+                emit warning(QString("Не удалось установить фильтр, действует прежний: %1")
+                                 .arg(pcap_geterr(reader->handle)));
+            }
+            CaptureFilter::release(*program);
+            delete program;
+        }
+
+        // Счётчики ядра читает сам поток чтения: pcap_t не разделяется между потоками
+        if (statsClock.elapsed() >= 1000) {
+            struct pcap_stat stats;
+            if (pcap_stats(reader->handle, &stats) == 0) {
+                reader->kernelDrops.store(uint64_t(stats.ps_drop) + stats.ps_ifdrop, std::memory_order_relaxed);
             }
+            statsClock.restart();
+        }
+
+        if (dispatched == -1) {
+            reader->errorMessage = QString(pcap_geterr(reader->handle));
+            reader->failed.store(true, std::memory_order_release);
+            break;
         }
     }
-    else if (ipHeader->protocol == IPPROTO_UDP) {
-        udpCount++;
+}
+
+bool CaptureThread::openReaders(QString &message) {
+    char errbuf[PCAP_ERRBUF_SIZE];
+    int commonLinkType = -1;
+
+    // Интерфейсы открываются все сразу, чтобы ленты начались одновременно
+    merger = new PacketMerger(interfaceNames.size(), MERGE_QUEUE_BYTES, MERGE_MAX_DELAY_US);
+    for (int i = 0; i < interfaceNames.size(); i++) {
+        const QString &name = interfaceNames[i];
+        pcap_t *device = pcap_open_live(name.toLocal8Bit().constData(), snaplen, 1, MERGE_READ_TIMEOUT_MS, errbuf);
+        if (!device) {
+            message = QString("Не удалось открыть интерфейс %1: %2").arg(name, QString(errbuf));
+            closeReaders();
+            return false;
+        }
 
-        // Рассчитываем смещение для UDP заголовка
-        int ipHeaderLength = ipHeader->ihl * 4;
-        struct udphdr* udpHeader = (struct udphdr*)(packet + sizeof(struct ethhdr) + ipHeaderLength);
+        InterfaceReader *reader = new InterfaceReader();
+        reader->handle = device;
+        reader->queue = &merger->queue(i);
+        reader->pendingFilter = nullptr;
+        reader->kernelDrops = 0;
+        reader->failed = false;
+        readers.push_back(reader);
+
+        // Одна программа BPF (и смена фильтра на ходу) годится только для одного типа канала
+        if (commonLinkType == -1) {
+            commonLinkType = pcap_datalink(device);
+        } else if (pcap_datalink(device) != commonLinkType) {
+            message = QString("Интерфейс %1 имеет другой тип канала и не может захватываться вместе с %2")
+                          .arg(name, interfaceNames[0]);
+            closeReaders();
+            return false;
+        }
 
-        // Рассчитываем указатель на данные и их длину
-        const u_char* udpData = packet + sizeof(struct ethhdr) + ipHeaderLength + sizeof(struct udphdr);
-        int dataLength = ntohs(udpHeader->len) - sizeof(struct udphdr);
+        std::string filterError;
+        if (!CaptureFilter::install(device, filterExpr.toStdString(),
+                                    truncateBypassed ? assemblerConfig.bypassPorts : std::set<uint16_t>(),
+                                    filterError)) {
+            message = QString("%1: %2").arg(name, QString::fromStdString(filterError));
+            closeReaders();
+            return false;
+        }
+    }
 
-        if (dataLength > 0) {
-            // IP-адреса и порты
-            struct in_addr src_addr, dst_addr;
-            src_addr.s_addr = ipHeader->saddr;
-            dst_addr.s_addr = ipHeader->daddr;
+    readersRunning = true;
+    for (InterfaceReader *reader : readers) {
+        reader->thread = std::thread(&CaptureThread::readInterface, this, reader);
+    }
+    linkType.store(commonLinkType, std::memory_order_release);
+    return true;
+}
 
-            QString srcIp = QString(inet_ntoa(src_addr));
-            QString dstIp = QString(inet_ntoa(dst_addr));
-            QString srcPort = QString::number(ntohs(udpHeader->source));
-            QString dstPort = QString::number(ntohs(udpHeader->dest));
+void CaptureThread::closeReaders() {
+    readersRunning = false;
+    for (InterfaceReader *reader : readers) {
+        if (reader->thread.joinable()) {
+            reader->thread.join();
+        }
+    }
 
-            // Отправляем информацию о UDP пакете в основной поток
-            emit packetCaptured("UDP", srcIp, srcPort, dstIp, dstPort, dataLength);
+    // Пакеты, оставшиеся в очередях после остановки, разбираются до конца
+    if (merger && !readers.empty()) {
+        QueuedFrame frame;
+        size_t source;
+        while (merger->next(frame, source, UINT64_MAX)) {
+            struct pcap_pkthdr header;
+            header.ts.tv_sec = static_cast<long>(frame.timestampUs / 1000000);
+            header.ts.tv_usec = static_cast<long>(frame.timestampUs % 1000000);
+            header.caplen = frame.caplen;
+            header.len = frame.len;
+            currentInterface = static_cast<int>(source);
+            processPacket(&header, frame.data);
+            merger->pop();
         }
     }
-#endif
 
-    // Периодическое обновление статистики
-    if (packetCount % 10 == 0) {
-        emit statisticsUpdated(packetCount, tcpCount, udpCount, httpCount);
+    for (InterfaceReader *reader : readers) {
+        bpf_program *program = reader->pendingFilter.exchange(nullptr);
+        if (program) {
+            CaptureFilter::release(*program);
+            delete program;
+        }
+        pcap_close(reader->handle);
+        delete reader;
+    }
+    readers.clear();
+    delete merger;
+    merger = nullptr;
+    currentInterface = 0;
+}
 
-        // Очистка старых потоков
-        if (tcpAssembler) {
-            tcpAssembler->clearOldStreams(300); // 5 минут
+int CaptureThread::dispatchMerged() {
+    TRACE_SCOPE("capture.merge");
+
+    for (InterfaceReader *reader : readers) {
+        if (reader->failed.load(std::memory_order_acquire)) {
+            mergeError = reader->errorMessage;
+            return -1;
         }
     }
+
+    // Пачка ограничена, чтобы настройки и загрузка CPU проверялись регулярно
+    uint64_t nowUs = uint64_t(QDateTime::currentMSecsSinceEpoch()) * 1000;
+    int processed = 0;
+    QueuedFrame frame;
+    size_t source;
+    while (processed < MERGE_BATCH && merger->next(frame, source, nowUs)) {
+        struct pcap_pkthdr header;
+        header.ts.tv_sec = static_cast<long>(frame.timestampUs / 1000000);
+        header.ts.tv_usec = static_cast<long>(frame.timestampUs % 1000000);
+        header.caplen = frame.caplen;
+        header.len = frame.len;
+        currentInterface = static_cast<int>(source);
+        processPacket(&header, frame.data);
+        merger->pop();
+        processed++;
+    }
+
+    if (processed == 0) {
+        // Очереди пусты или ждут отстающий интерфейс
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return processed;
+}
+
+void CaptureThread::checkLoad() {
+    uint64_t kernelDrops = 0;
+    struct pcap_stat stats;
+    if (handle && pcap_stats(handle, &stats) == 0) {
+        kernelDrops = uint64_t(stats.ps_drop) + stats.ps_ifdrop;
+    }
+
+    // При нескольких интерфейсах потерями считаются и переполнения очередей слияния
+    for (InterfaceReader *reader : readers) {
+        kernelDrops += reader->kernelDrops.load(std::memory_order_relaxed);
+    }
+    if (merger) {
+        kernelDrops += merger->dropped();
+    }
+
+    int depth = queuedRows.load(std::memory_order_relaxed);
+    if (sampler.updateLoad(kernelDrops, depth > 0 ? size_t(depth) : 0)) {
+        emit samplingRateChanged(static_cast<int>(sampler.rate()));
+    }
 }
 
 void CaptureThread::run() {
@@ -331,81 +960,233 @@ void CaptureThread::run() {
     udpCount = 0;
     httpCount = 0;
     running = true;
+    queuedRows = 0;
+    lastLoadCheckUs = 0;
+
+    // Подписи прошлого запуска могли быть интернированы в уже очищенную таблицу
+    processSnapshot.reset();
+    processGeneration = 0;
+    processLabelIds.clear();
+
+    // Размещение задаётся до первых выделений памяти: буферы трассировки,
+    // сборщика и кольцо pcap в ядре выделяются уже на узле NUMA выбранного ядра
+    if (cpu >= 0 && !ThreadTuning::pinCurrentThread(cpu)) {
+        emit warning(QString("Не удалось привязать поток захвата к ядру %1").arg(cpu));
+    }
+    std::string policyError;
+    if (policy != SCHEDULING_NORMAL && !ThreadTuning::setCurrentThreadPolicy(policy, policyError)) {
+        emit warning(QString("Не удалось изменить приоритет потока захвата: %1")
+                         .arg(QString::fromStdString(policyError)));
+    }
+
+    // Имя заводит потоку буфер трассировки навсегда, а поток захвата
+    // создаётся заново при каждом запуске - только при включённой трассировке
+    if (Tracer::isEnabled()) {
+        QByteArray traceName = threadIndex > 0 ? QByteArray("capture-") + QByteArray::number(threadIndex)
+                                               : QByteArray("capture");
+        Tracer::setThreadName(traceName.constData());
+    }
+    emit samplingRateChanged(sampler.mode() == SAMPLING_OFF ? 1 : static_cast<int>(sampler.rate()));
 
     char errbuf[PCAP_ERRBUF_SIZE];
 
     // Создаем обработчик HTTP сообщений
+    delete tcpAssembler;
     tcpAssembler = new TCPStreamAssembler([this](const StreamKey &key, const std::vector<uint8_t> &data) {
         this->onHttpMessage(key, data);
     });
+    tcpAssembler->setConfig(assemblerConfig);
+    tcpAssembler->setWebSocketCallback([this](const StreamKey &key, const WebSocketFrame &frame) {
+        this->onWebSocketFrame(key, frame);
+    });
+    tcpAssembler->setTlsCallback([this](const StreamKey &key, const TlsHello &hello) {
+        this->onTlsHello(key, hello);
+    });
+
+    // Сборка фрагментов IP (таблица и лимит памяти - на поток захвата)
+    delete defragmenter;
+    defragmenter = new IpDefragmenter();
+
+    // Разборщики UDP: таблица запросов DNS тоже создаётся после привязки к ядру
+    delete udpDissectors;
+    udpDissectors = new UdpDissectorRegistry();
+    udpDissectors->add(std::unique_ptr<UdpDissector>(new DnsDissector(
+        [this](const UdpDatagram &datagram, const DnsMessage &message, const DnsTransactionInfo &transaction) {
+            this->onDnsMessage(datagram, message, transaction);
+        })), DnsDissector::defaultPorts());
 
     // Открываем интерфейс для захвата
-    handle = pcap_open_live(interfaceName.toLocal8Bit().constData(), 65536, 1, 1000, errbuf);
-    if (!handle) {
-        emit error(QString("Не удалось открыть интерфейс %1: %2").arg(interfaceName).arg(errbuf));
-        return;
-    }
+    currentInterface = 0;
+    if (interfaceNames.size() > 1) {
+        QString readerError;
+        if (!openReaders(readerError)) {
+            emit error(readerError);
+            return;
+        }
+    } else {
+        QString interfaceName = interfaceNames.value(0);
+        handle = pcap_open_live(interfaceName.toLocal8Bit().constData(), snaplen, 1, 1000, errbuf);
+        if (!handle) {
+            emit error(QString("Не удалось открыть интерфейс %1: %2").arg(interfaceName).arg(errbuf));
+            return;
+        }
 
-    // Компиляция фильтра
-    struct bpf_program fp;
-    if (!filterExpr.isEmpty()) {
-        if (pcap_compile(handle, &fp, filterExpr.toLocal8Bit().constData(), 0, PCAP_NETMASK_UNKNOWN) == -1) {
-            emit error(QString("Не удалось скомпилировать фильтр: %1").arg(pcap_geterr(handle)));
+        // Компиляция фильтра; порты обхода при необходимости обрезаются в ядре
+        std::string filterError;
+        if (!CaptureFilter::install(handle, filterExpr.toStdString(),
+                                    truncateBypassed ? assemblerConfig.bypassPorts : std::set<uint16_t>(),
+                                    filterError)) {
+            emit error(QString::fromStdString(filterError));
             pcap_close(handle);
             handle = nullptr;
             return;
         }
 
-        if (pcap_setfilter(handle, &fp) == -1) {
-            emit error(QString("Не удалось установить фильтр: %1").arg(pcap_geterr(handle)));
-            pcap_freecode(&fp);
+        // Присоединяемся к группе после установки фильтра; пакеты, пришедшие
+        // на сокет до этого момента, могут быть получены и другими потоками группы
+        QString fanoutError;
+        if (fanoutGroup != 0 && !joinFanoutGroup(fanoutError)) {
+            emit error(fanoutError);
             pcap_close(handle);
             handle = nullptr;
             return;
         }
 
-        pcap_freecode(&fp);
+        // С этого момента фильтр можно менять из GUI
+        linkType.store(pcap_datalink(handle), std::memory_order_release);
     }
 
+    // Кольцо до события выделяется здесь, после привязки к ядру; файлы
+    // записываются с типом канала и snaplen открытого устройства
+    delete triggerRecorder;
+    triggerRecorder = nullptr;
+    if (triggerEnabled) {
+        triggerOptions.threadIndex = threadIndex;
+        triggerOptions.linkType = linkType.load(std::memory_order_acquire);
+        triggerOptions.snaplen = static_cast<uint32_t>(snaplen);
+        triggerRecorder = new TriggerRecorder(triggerOptions);
+        triggerRecorder->setSignal(triggerSignal);
+        triggerRecorder->setFiredCallback([this](const std::string &reason, const std::string &fileName) {
+            emit triggerFired(QString::fromStdString(reason), QString::fromStdString(fileName));
+        });
+    }
+
+    // Загрузка CPU считается по времени потока, а не по меткам пакетов
+    QElapsedTimer cpuClock;
+    cpuClock.start();
+    uint64_t cpuTimeUs = ThreadTuning::currentThreadCpuTimeUs();
+
     // Основной цикл захвата пакетов
     while (running) {
-        if (pcap_dispatch(handle, -1, packetHandler, reinterpret_cast<u_char*>(this)) == -1) {
+        int dispatched;
+        if (merger) {
+            dispatched = dispatchMerged();
+        } else {
+            TRACE_SCOPE("pcap_dispatch");
+            dispatched = pcap_dispatch(handle, -1, packetHandler, reinterpret_cast<u_char*>(this));
+        }
+
+        // Новые настройки из GUI; в остальное время - одна проверка указателя
+        if (pendingSettings.load(std::memory_order_relaxed)) {
+            applyPendingSettings();
+        }
+
+        if (cpuClock.elapsed() >= 1000) {
+            uint64_t now = ThreadTuning::currentThreadCpuTimeUs();
+            emit cpuUsageUpdated(100.0 * (now - cpuTimeUs) / (cpuClock.nsecsElapsed() / 1000.0));
+            cpuTimeUs = now;
+            cpuClock.restart();
+        }
+
+        if (dispatched == -1) {
             if (running) { // Проверяем, что мы не остановились намеренно
-                emit error(QString("Ошибка при захвате пакетов: %1").arg(pcap_geterr(handle)));
+                emit error(QString("Ошибка при захвате пакетов: %1").arg(merger ? mergeError : QString(pcap_geterr(handle))));
             }
             break;
         }
     }
 
     // Закрываем устройство захвата
+    linkType.store(-1, std::memory_order_release);
     if (handle) {
         pcap_close(handle);
         handle = nullptr;
     }
+    closeReaders();
+
+    // Настройки, пришедшие под конец, остаются до следующего запуска
+    applyPendingSettings();
+
+    // Незавершённая запись по событию закрывается вместе с захватом
+    delete triggerRecorder;
+    triggerRecorder = nullptr;
 
     // Отправляем финальную статистику
     emit statisticsUpdated(packetCount, tcpCount, udpCount, httpCount);
 }
 
+// ------------------ Реализация InterfaceScanner ------------------
+
+void InterfaceScanner::run() {
+    QStringList names;
+    QStringList descriptions;
+
+    pcap_if_t *alldevs;
+    char errbuf[PCAP_ERRBUF_SIZE];
+    if (pcap_findalldevs(&alldevs, errbuf) == -1) {
+        emit interfacesFound(names, descriptions, QString::fromLocal8Bit(errbuf));
+        return;
+    }
+
+    for (pcap_if_t *d = alldevs; d != nullptr; d = d->next) {
+        names.append(QString::fromLocal8Bit(d->name));
+        descriptions.append(d->description ? QString::fromLocal8Bit(d->description) : QString());
+    }
+    pcap_freealldevs(alldevs);
+
+    emit interfacesFound(names, descriptions, QString());
+}
+
 // ------------------ Реализация MainWindow ------------------
 
-MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent), captureThread(nullptr) {
+MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent), captureErrorShown(false),
+    guiCpuTimeUs(0), guiCpuPercent(0), ringWriter(nullptr),
+    packetsProxy(nullptr), headerFilterEdit(nullptr), processResolver(nullptr),
+    eventStream(nullptr),
+    searchEdit(nullptr), searchPosition(-1), searchedRows(0),
+    interfaceScanner(nullptr), flowStats(nullptr), conversationsWindow(nullptr),
+    httpStats(nullptr), httpStatsWindow(nullptr) {
+    // Статистика по узлам и диалогам (режим сохраняется в настройках)
+    QSettings settings;
+    flowStats = new FlowStatistics(
+        static_cast<FlowStatsMode>(settings.value("flow_stats_mode", FLOW_STATS_EXACT).toInt()),
+        settings.value("flow_stats_top_k", 1000).toUInt());
+    httpStats = new HttpEndpointStats(settings.value("http_stats_max_endpoints", 2000).toUInt());
+    processResolver = new ProcessResolver();
+    eventStream = new EventStreamPublisher(settings.value("event_stream_slots", 16384).toUInt());
+    searchIndex.setMaxBytes(size_t(settings.value("search_index_mb", 128).toUInt()) * 1024 * 1024);
+
     setupUi();
     createActions();
     createMenus();
     createStatusBar();
 
-    // Загружаем список интерфейсов
+    // Список интерфейсов загружается в фоне: окно показывается сразу
+    interfaceScanner = new InterfaceScanner(this);
+    connect(interfaceScanner, &InterfaceScanner::interfacesFound, this, &MainWindow::onInterfacesFound);
     loadInterfaces();
 
     // Создаем поток захвата
-    captureThread = new CaptureThread(this);
+    createCaptureThreads(1);
 
-    // Подключаем сигналы потока
-    connect(captureThread, &CaptureThread::packetCaptured, this, &MainWindow::onPacketCaptured);
-    connect(captureThread, &CaptureThread::httpMessageCaptured, this, &MainWindow::onHttpMessageCaptured);
-    connect(captureThread, &CaptureThread::error, this, &MainWindow::onCaptureError);
-    connect(captureThread, &CaptureThread::statisticsUpdated, this, &MainWindow::onStatisticsUpdated);
+    // Загрузка CPU потоком GUI
+    guiCpuClock.start();
+    guiCpuTimeUs = ThreadTuning::currentThreadCpuTimeUs();
+    QTimer *cpuTimer = new QTimer(this);
+    connect(cpuTimer, &QTimer::timeout, this, &MainWindow::updateGuiCpuUsage);
+    connect(cpuTimer, &QTimer::timeout, this, &MainWindow::updateRingStatus);
+    connect(cpuTimer, &QTimer::timeout, this, &MainWindow::updateInterfaceRates);
+    cpuTimer->start(1000);
 
     // Настраиваем размер окна
     resize(900, 600);
@@ -413,10 +1194,19 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent), captureThread(nul
 }
 
 MainWindow::~MainWindow() {
-    if (captureThread && captureThread->isRunning()) {
-        captureThread->stopCapture();
-        captureThread->wait();
+    // pcap_findalldevs не прерывается - дожидаемся окончания поиска
+    interfaceScanner->wait();
+
+    for (CaptureThread *thread : captureThreads) {
+        thread->stopCapture();
+        thread->wait();
     }
+    stopRingWriter();
+
+    delete processResolver;
+    delete eventStream;
+    delete flowStats;
+    delete httpStats;
 }
 
 void MainWindow::setupUi() {
@@ -434,12 +1224,14 @@ void MainWindow::setupUi() {
     interfaceCombo = new QComboBox(this);
     interfaceCombo->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Fixed);
 
-    QPushButton *refreshButton = new QPushButton("Обновить", this);
+    refreshButton = new QPushButton("Обновить", this);
     connect(refreshButton, &QPushButton::clicked, this, &MainWindow::refreshInterfaces);
 
     QLabel *filterLabel = new QLabel("Фильтр:", this);
     filterEdit = new QLineEdit(this);
     filterEdit->setPlaceholderText("Например: tcp port 80 or port 443");
+    filterEdit->setToolTip("Во время захвата новый фильтр применяется по Enter, без перезапуска");
+    connect(filterEdit, &QLineEdit::returnPressed, this, &MainWindow::applyLiveSettings);
 
     startButton = new QPushButton("Начать", this);
     connect(startButton, &QPushButton::clicked, this, &MainWindow::startCapture);
@@ -459,6 +1251,32 @@ void MainWindow::setupUi() {
 
     mainLayout->addLayout(controlLayout);
 
+    // Поиск по столбцам заголовков HTTP
+    QHBoxLayout *searchLayout = new QHBoxLayout();
+    QLabel *headerFilterLabel = new QLabel("Поиск по заголовкам:", this);
+    headerFilterEdit = new QLineEdit(this);
+    headerFilterEdit->setPlaceholderText("Текст в любом столбце заголовка или, например, Host: example.com, Процесс: nginx");
+    headerFilterEdit->setClearButtonEnabled(true);
+    searchLayout->addWidget(headerFilterLabel);
+    searchLayout->addWidget(headerFilterEdit);
+
+    // Переход к строкам с подстрокой в URI, Host или значении заголовка
+    QLabel *searchLabel = new QLabel("Найти:", this);
+    searchEdit = new QLineEdit(this);
+    searchEdit->setPlaceholderText("Часть URI, Host или заголовка, например /checkout");
+    searchEdit->setClearButtonEnabled(true);
+    QPushButton *findPreviousButton = new QPushButton("Назад", this);
+    QPushButton *findNextButton = new QPushButton("Далее", this);
+    connect(searchEdit, &QLineEdit::textChanged, this, [this]() { findMatches(true); });
+    connect(searchEdit, &QLineEdit::returnPressed, this, &MainWindow::findNext);
+    connect(findPreviousButton, &QPushButton::clicked, this, &MainWindow::findPrevious);
+    connect(findNextButton, &QPushButton::clicked, this, &MainWindow::findNext);
+    searchLayout->addWidget(searchLabel);
+    searchLayout->addWidget(searchEdit);
+    searchLayout->addWidget(findPreviousButton);
+    searchLayout->addWidget(findNextButton);
+    mainLayout->addLayout(searchLayout);
+
     // Разделитель для таблицы и детализации
     QSplitter *splitter = new QSplitter(Qt::Vertical, this);
 
@@ -473,7 +1291,7 @@ void MainWindow::setupUi() {
 
     // Модель данных для таблицы
     packetsModel = new QStandardItemModel(this);
-    packetsModel->setColumnCount(7);
+    packetsModel->setColumnCount(BASE_COLUMN_COUNT);
     packetsModel->setHeaderData(0, Qt::Horizontal, "№");
     packetsModel->setHeaderData(1, Qt::Horizontal, "Время");
     packetsModel->setHeaderData(2, Qt::Horizontal, "Протокол");
@@ -482,7 +1300,19 @@ void MainWindow::setupUi() {
     packetsModel->setHeaderData(5, Qt::Horizontal, "Получатель");
     packetsModel->setHeaderData(6, Qt::Horizontal, "Порт");
     packetsModel->setHeaderData(7, Qt::Horizontal, "Размер (байт)");
-    packetsTable->setModel(packetsModel);
+    packetsModel->setHeaderData(INTERFACE_COLUMN, Qt::Horizontal, "Интерфейс");
+    packetsModel->setHeaderData(PROCESS_COLUMN, Qt::Horizontal, "Процесс");
+
+    // Сортировка и фильтр - в прокси, значения заголовков берутся из таблицы интернирования
+    packetsProxy = new HeaderColumnsProxyModel(&headerInterner, this);
+    packetsProxy->setSourceModel(packetsModel);
+    packetsTable->setModel(packetsProxy);
+    applyHeaderColumns(QSettings().value("header_columns", "Host,Content-Type,User-Agent")
+                           .toString().split(',', Qt::SkipEmptyParts));
+    connect(headerFilterEdit, &QLineEdit::textChanged, packetsProxy, &HeaderColumnsProxyModel::setHeaderFilter);
+    packetsTable->setColumnHidden(INTERFACE_COLUMN, true);
+    packetsProxy->setProcessColumn(PROCESS_COLUMN, "Процесс");
+    packetsTable->setColumnHidden(PROCESS_COLUMN, !processAttributionEnabled());
 
     // Обработка выбора строки
     connect(packetsTable, &QTableView::clicked, this, &MainWindow::showPacketDetails);
@@ -512,23 +1342,105 @@ void MainWindow::createMenus() {
     QAction *saveAction = fileMenu->addAction("&Сохранить пакеты...");
     connect(saveAction, &QAction::triggered, this, &MainWindow::savePackets);
 
+    // Распакованное тело выбранного HTTP-сообщения
+    QAction *saveBodyAction = fileMenu->addAction("Сохранить &тело сообщения...");
+    connect(saveBodyAction, &QAction::triggered, this, &MainWindow::saveMessageBody);
+
     // Действие "Очистить"
     QAction *clearAction = fileMenu->addAction("О&чистить");
     connect(clearAction, &QAction::triggered, this, &MainWindow::clearPackets);
 
     fileMenu->addSeparator();
 
-    // Действие "Выход"
-    QAction *exitAction = fileMenu->addAction("&Выход");
-    connect(exitAction, &QAction::triggered, this, &QWidget::close);
+    // Непрерывная запись сырых кадров в кольцо файлов pcap
+    QAction *ringAction = fileMenu->addAction("&Непрерывная запись на диск");
+    ringAction->setCheckable(true);
+    ringAction->setChecked(QSettings().value("ring_enabled", false).toBool());
+    connect(ringAction, &QAction::toggled, this, &MainWindow::toggleRingWriter);
 
-    // Меню "Настройки"
+    QAction *ringSettingsAction = fileMenu->addAction("Параметры &записи...");
+    connect(ringSettingsAction, &QAction::triggered, this, &MainWindow::configureRingWriter);
+
+    // Кольцо в памяти, сохраняемое при срабатывании правил
+    QAction *triggerAction = fileMenu->addAction("Запись по &событию...");
+    connect(triggerAction, &QAction::triggered, this, &MainWindow::configureTrigger);
+
+    fileMenu->addSeparator();
+
+    // Действие "Выход"
+    QAction *exitAction = fileMenu->addAction("&Выход");
+    connect(exitAction, &QAction::triggered, this, &QWidget::close);
+
+    // Меню "Настройки"
     QMenu *settingsMenu = menuBar()->addMenu("&Настройки");
 
     // Действие "Параметры"
     QAction *settingsAction = settingsMenu->addAction("&Параметры...");
     connect(settingsAction, &QAction::triggered, this, &MainWindow::displaySettings);
 
+    // Действие "Обход потоков"
+    QAction *bypassAction = settingsMenu->addAction("&Обход потоков и snaplen...");
+    connect(bypassAction, &QAction::triggered, this, &MainWindow::configureBypass);
+
+    // Действие "Потоки захвата"
+    QAction *threadsAction = settingsMenu->addAction("По&токи захвата...");
+    connect(threadsAction, &QAction::triggered, this, &MainWindow::configureCaptureThreads);
+
+    QAction *extraInterfacesAction = settingsMenu->addAction("Дополнительные &интерфейсы...");
+    connect(extraInterfacesAction, &QAction::triggered, this, &MainWindow::configureExtraInterfaces);
+
+    // Процесс-владелец локального конца потока (как ss -p), только Linux
+    QAction *processAction = settingsMenu->addAction("Определять &процессы");
+    processAction->setCheckable(true);
+    processAction->setChecked(processAttributionEnabled());
+    processAction->setEnabled(ProcessResolver::isSupported());
+    connect(processAction, &QAction::toggled, this, &MainWindow::toggleProcessAttribution);
+
+    // Поток событий в общей памяти (клиент - tools/event-consumer), только POSIX
+    QAction *eventStreamAction = settingsMenu->addAction("Публиковать &события для внешних программ");
+    eventStreamAction->setCheckable(true);
+    eventStreamAction->setChecked(eventStreamEnabled());
+    eventStreamAction->setEnabled(EventStreamPublisher::isSupported());
+    connect(eventStreamAction, &QAction::toggled, this, &MainWindow::toggleEventStream);
+
+    // Действие "Выборка при перегрузке"
+    QAction *headerColumnsAction = settingsMenu->addAction("&Столбцы заголовков HTTP...");
+    connect(headerColumnsAction, &QAction::triggered, this, &MainWindow::configureHeaderColumns);
+
+    QAction *samplingAction = settingsMenu->addAction("&Выборка потоков при перегрузке...");
+    connect(samplingAction, &QAction::triggered, this, &MainWindow::configureSampling);
+
+    // Меню "Статистика"
+    QMenu *statsMenu = menuBar()->addMenu("С&татистика");
+
+    // Действие "Диалоги и узлы"
+    QAction *conversationsAction = statsMenu->addAction("&Диалоги и узлы...");
+    connect(conversationsAction, &QAction::triggered, this, &MainWindow::showConversations);
+
+    // Действие "Производительность HTTP и DNS"
+    QAction *httpStatsAction = statsMenu->addAction("&Производительность HTTP и DNS...");
+    connect(httpStatsAction, &QAction::triggered, this, &MainWindow::showHttpStatistics);
+
+    // Подменю "Трассировка" (доступно при сборке с CONFIG+=tracing)
+    QMenu *traceMenu = statsMenu->addMenu("&Трассировка");
+    traceMenu->setEnabled(Tracer::isCompiledIn());
+    if (!Tracer::isCompiledIn()) {
+        traceMenu->setTitle("&Трассировка (не включена при сборке)");
+    }
+
+    QAction *traceEnableAction = traceMenu->addAction("&Записывать");
+    traceEnableAction->setCheckable(true);
+    connect(traceEnableAction, &QAction::toggled, this, &MainWindow::toggleTracing);
+
+    QAction *traceExportAction = traceMenu->addAction("&Экспорт Chrome trace...");
+    connect(traceExportAction, &QAction::triggered, this, &MainWindow::exportTrace);
+
+    QAction *traceSummaryAction = traceMenu->addAction("&Время по стадиям...");
+    connect(traceSummaryAction, &QAction::triggered, this, &MainWindow::showTraceSummary);
+
+    QAction *traceClearAction = traceMenu->addAction("&Очистить");
+    connect(traceClearAction, &QAction::triggered, this, []() { Tracer::clear(); });
+
     // Меню "Справка"
     QMenu *helpMenu = menuBar()->addMenu("&Справка");
 
@@ -543,35 +1455,88 @@ void MainWindow::createStatusBar() {
 
     statsLabel = new QLabel("Пакетов: 0, TCP: 0, UDP: 0, HTTP: 0", this);
     statusBar()->addPermanentWidget(statsLabel);
+
+    samplingLabel = new QLabel("Выборка: все потоки", this);
+    statusBar()->addPermanentWidget(samplingLabel);
+
+    cpuLabel = new QLabel(this);
+    statusBar()->addPermanentWidget(cpuLabel);
+
+    ringLabel = new QLabel(this);
+    statusBar()->addPermanentWidget(ringLabel);
 }
 
 void MainWindow::loadInterfaces() {
+    if (interfaceScanner->isRunning()) {
+        return;
+    }
+
     interfaceCombo->clear();
     interfaces.clear();
+    interfaceCombo->addItem("Поиск интерфейсов...");
+    interfaceCombo->setEnabled(false);
+    refreshButton->setEnabled(false);
+    startButton->setEnabled(false);
 
-    pcap_if_t *alldevs;
-    char errbuf[PCAP_ERRBUF_SIZE];
+    interfaceScanner->start();
+}
 
-    if (pcap_findalldevs(&alldevs, errbuf) == -1) {
-        QMessageBox::warning(this, "Ошибка", QString("Не удалось получить список интерфейсов: %1").arg(errbuf));
+void MainWindow::onInterfacesFound(const QStringList &names, const QStringList &descriptions,
+                                   const QString &errorMessage) {
+    interfaceCombo->clear();
+    refreshButton->setEnabled(true);
+    interfaceCombo->setEnabled(!isCapturing());
+
+    if (!errorMessage.isEmpty()) {
+        interfaceCombo->addItem("Интерфейсы не найдены");
+        QMessageBox::warning(this, "Ошибка", QString("Не удалось получить список интерфейсов: %1").arg(errorMessage));
         return;
     }
 
-    for (pcap_if_t *d = alldevs; d != nullptr; d = d->next) {
-        QString name = d->name;
-        QString description = d->description ? d->description : "Нет описания";
-
-        interfaceCombo->addItem(description, name);
-        interfaces[description] = name;
+    for (int i = 0; i < names.size(); i++) {
+        // В Linux описания обычно нет - тогда подписью служит имя
+        QString description = descriptions[i].isEmpty() ? names[i]
+                                                        : QString("%1 (%2)").arg(descriptions[i], names[i]);
+        interfaceCombo->addItem(description, names[i]);
+        interfaceCombo->setItemData(i, description, INTERFACE_LABEL_ROLE);
+        interfaces[description] = names[i];
     }
 
-    pcap_freealldevs(alldevs);
-
     if (interfaceCombo->count() == 0) {
         interfaceCombo->addItem("Интерфейсы не найдены");
         startButton->setEnabled(false);
     } else {
-        startButton->setEnabled(true);
+        int index = interfaceCombo->findData(selectedInterface);
+        interfaceCombo->setCurrentIndex(index >= 0 ? index : 0);
+        startButton->setEnabled(!isCapturing());
+    }
+    updateInterfaceRates();
+}
+
+void MainWindow::updateInterfaceRates() {
+    // Выбор запоминается отдельно: при пересоздании списка он не теряется
+    QString selected = interfaceCombo->currentData().toString();
+    if (!selected.isEmpty()) {
+        selectedInterface = selected;
+    }
+
+    // Одно чтение /proc/net/dev на все интерфейсы; устройства не открываются
+    if (!InterfaceRateMonitor::isSupported() ||
+        !interfaceRates.update(uint64_t(QDateTime::currentMSecsSinceEpoch()) * 1000)) {
+        return;
+    }
+
+    for (int i = 0; i < interfaceCombo->count(); i++) {
+        QString name = interfaceCombo->itemData(i).toString();
+        if (name.isEmpty()) {
+            continue;
+        }
+        QString label = interfaceCombo->itemData(i, INTERFACE_LABEL_ROLE).toString();
+        InterfaceRate rate;
+        if (interfaceRates.rate(name.toStdString(), rate)) {
+            label += QString(" - %1").arg(QString::fromStdString(InterfaceRateMonitor::format(rate)));
+        }
+        interfaceCombo->setItemText(i, label);
     }
 }
 
@@ -579,12 +1544,104 @@ void MainWindow::refreshInterfaces() {
     loadInterfaces();
 }
 
+void MainWindow::setSettingOverrides(const QVariantMap &overrides) {
+    settingOverrides = overrides;
+}
+
+QVariant MainWindow::setting(const QString &key, const QVariant &defaultValue) const {
+    if (settingOverrides.contains(key)) {
+        return settingOverrides.value(key);
+    }
+    QSettings settings;
+    return settings.value(key, defaultValue);
+}
+
+AssemblerConfig MainWindow::assemblerSettings() const {
+    QSettings settings;
+    AssemblerConfig config;
+    for (const QString &port : settings.value("bypass_ports").toString().split(',', Qt::SkipEmptyParts)) {
+        bool ok = false;
+        uint16_t value = port.trimmed().toUShort(&ok);
+        if (ok && value != 0) {
+            config.bypassPorts.insert(value);
+        }
+    }
+    config.streamTimeout = settings.value("tcp_stream_timeout", 300).toInt();
+    config.maxStreamBuffer = size_t(settings.value("stream_buffer_mb", 16).toUInt()) * 1024 * 1024;
+    return config;
+}
+
+void MainWindow::applyLiveSettings() {
+    if (!isCapturing()) {
+        return;
+    }
+
+    // Каждый поток получает свою программу: компиляция идёт здесь,
+    // захват и собранные потоки при этом не прерываются
+    QString filter = filterEdit->text().trimmed();
+    AssemblerConfig config = assemblerSettings();
+    bool truncate = QSettings().value("bypass_truncate", true).toBool();
+    for (CaptureThread *thread : captureThreads) {
+        QString message;
+        if (!thread->reconfigure(filter, config, truncate, message)) {
+            QMessageBox::warning(this, "Фильтр", message);
+            return;
+        }
+    }
+    statusLabel->setText("Фильтр и настройки сборки применены без перезапуска захвата");
+}
+
+bool MainWindow::isCapturing() const {
+    for (CaptureThread *thread : captureThreads) {
+        if (thread->isRunning()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void MainWindow::createCaptureThreads(int count) {
+    if (captureThreads.size() == count) {
+        return;
+    }
+
+    // Вызывается только при остановленном захвате; deleteLater - чтобы
+    // уже поставленные в очередь сигналы старых потоков были обработаны раньше
+    for (CaptureThread *thread : captureThreads) {
+        thread->deleteLater();
+    }
+    captureThreads.clear();
+    threadCounters.clear();
+
+    for (int i = 0; i < count; i++) {
+        CaptureThread *thread = new CaptureThread(this);
+        thread->setFlowStatistics(flowStats);
+        thread->setHttpStatistics(httpStats);
+        thread->setProcessResolver(processAttributionEnabled() ? processResolver : nullptr);
+
+        // Подключаем сигналы потока
+        connect(thread, &CaptureThread::packetCaptured, this, &MainWindow::onPacketCaptured);
+        connect(thread, &CaptureThread::httpMessageCaptured, this, &MainWindow::onHttpMessageCaptured);
+        connect(thread, &CaptureThread::webSocketFrameCaptured, this, &MainWindow::onWebSocketFrameCaptured);
+        connect(thread, &CaptureThread::tlsHelloCaptured, this, &MainWindow::onTlsHelloCaptured);
+        connect(thread, &CaptureThread::datagramCaptured, this, &MainWindow::onDatagramCaptured);
+        connect(thread, &CaptureThread::error, this, &MainWindow::onCaptureError);
+        connect(thread, &CaptureThread::warning, this, &MainWindow::onCaptureWarning);
+        connect(thread, &CaptureThread::statisticsUpdated, this, &MainWindow::onStatisticsUpdated);
+        connect(thread, &CaptureThread::samplingRateChanged, this, &MainWindow::onSamplingRateChanged);
+        connect(thread, &CaptureThread::cpuUsageUpdated, this, &MainWindow::onCpuUsageUpdated);
+        connect(thread, &CaptureThread::triggerFired, this, &MainWindow::onTriggerFired);
+
+        captureThreads.append(thread);
+    }
+}
+
 void MainWindow::startCapture() {
-    if (captureThread && captureThread->isRunning()) {
+    if (isCapturing()) {
         return;
     }
 
-    if (interfaceCombo->count() == 0) {
+    if (interfaceCombo->currentData().toString().isEmpty()) {
         QMessageBox::warning(this, "Ошибка", "Нет доступных интерфейсов.");
         return;
     }
@@ -593,31 +1650,141 @@ void MainWindow::startCapture() {
     QString interfaceName = interfaceCombo->currentData().toString();
     QString filter = filterEdit->text().trimmed();
 
-    // Настраиваем и запускаем поток
-    captureThread->setInterface(interfaceName);
-    captureThread->setFilter(filter);
-    captureThread->start();
+    QSettings settings;
+
+    // Изменённый во время прошлого захвата набор столбцов заголовков
+    applyHeaderColumns(settings.value("header_columns", "Host,Content-Type,User-Agent")
+                           .toString().split(',', Qt::SkipEmptyParts));
+
+    // Выбранный интерфейс и дополнительные из настроек (без повторов)
+    QStringList interfaceNames{interfaceName};
+    for (const QString &name : setting("extra_interfaces").toString().split(',', Qt::SkipEmptyParts)) {
+        if (!interfaceNames.contains(name.trimmed())) {
+            interfaceNames << name.trimmed();
+        }
+    }
+    if (interfaceNames.size() > 64) {
+        interfaceNames = interfaceNames.mid(0, 64);
+    }
+    captureInterfaceNames = interfaceNames;
+    packetsTable->setColumnHidden(INTERFACE_COLUMN, interfaceNames.size() < 2);
+
+    // Число потоков захвата; без PACKET_FANOUT - всегда один. Несколько
+    // интерфейсов сливаются в одну ленту одним потоком разбора
+    int threadCount = qBound(1, setting("capture_threads", 1).toInt(), 64);
+    if (threadCount > 1 && (!CaptureThread::isFanoutSupported() || interfaceNames.size() > 1)) {
+        threadCount = 1;
+    }
+    createCaptureThreads(threadCount);
+
+    // Ядра для потоков: явный список или "numa" - ядра узла, к которому подключена карта
+    std::vector<int> cpus;
+    QString cpuList = setting("capture_cpus").toString().trimmed();
+    if (cpuList == "numa") {
+        int node = ThreadTuning::interfaceNumaNode(interfaceName.toStdString());
+        if (!ThreadTuning::numaNodeCpus(node, cpus)) {
+            statusLabel->setText("Узел NUMA интерфейса не определён, потоки не привязаны");
+        }
+    } else {
+        ThreadTuning::parseCpuList(cpuList.toStdString(), cpus);
+    }
+
+    SchedulingPolicy policy = SCHEDULING_NORMAL;
+    ThreadTuning::parsePolicy(setting("capture_policy", "normal").toString().toStdString(), policy);
+
+    AssemblerConfig assemblerConfig = assemblerSettings();
+
+    // Запись по событию: правила проверяются до запуска
+    TriggerOptions triggerOptions;
+    triggerOptions.rules = settings.value("trigger_rules").toString().toStdString();
+    triggerOptions.directory = settings.value("trigger_directory", QDir::homePath()).toString().toStdString();
+    triggerOptions.ringBytes = settings.value("trigger_ring_mb", 64).toULongLong() * 1024 * 1024;
+    triggerOptions.preSeconds = settings.value("trigger_pre_seconds", 10).toUInt();
+    triggerOptions.postSeconds = settings.value("trigger_post_seconds", 10).toUInt();
+
+    std::vector<TriggerRule> triggerRules;
+    std::string triggerError;
+    if (!TriggerRecorder::parseRules(triggerOptions.rules, triggerRules, triggerError)) {
+        QMessageBox::warning(this, "Запись по событию", QString::fromStdString(triggerError));
+        return;
+    }
+
+    // Настраиваем и запускаем потоки. Номер группы - от PID, в диапазоне
+    // 1..65535: ноль означает работу без PACKET_FANOUT
+    int fanoutGroup = threadCount > 1 ? int(QCoreApplication::applicationPid() % 0xffff) + 1 : 0;
+    for (int i = 0; i < captureThreads.size(); i++) {
+        CaptureThread *thread = captureThreads[i];
+        thread->setInterfaces(interfaceNames);
+        thread->setFilter(filter);
+        thread->setSampling(
+            static_cast<SamplingMode>(settings.value("sampling_mode", SAMPLING_OFF).toInt()),
+            settings.value("sampling_rate", 1).toUInt());
+        thread->setBypass(assemblerConfig, settings.value("bypass_truncate", true).toBool());
+        thread->setSnaplen(settings.value("snaplen", 65536).toInt());
+        thread->setFanoutGroup(fanoutGroup);
+        thread->setCpu(cpus.empty() ? -1 : cpus[i % cpus.size()]);
+        thread->setSchedulingPolicy(policy);
+        thread->setTrigger(!triggerRules.empty(), triggerOptions, &triggerSignal);
+        thread->setHeaderColumns(&headerInterner, headerColumns);
+        thread->setThreadIndex(threadCount > 1 ? i + 1 : 0);
+    }
+
+    if (!startRingWriter()) {
+        return;
+    }
+
+    flowStats->clear();
+    httpStats->clear();
+    threadCounters.clear();
+    captureErrorShown = false;
+    packetsTable->setColumnHidden(PROCESS_COLUMN, !processAttributionEnabled());
+    if (processAttributionEnabled()) {
+        processResolver->start();
+    }
+
+    // Поток событий не обязателен: если сокет занят, захват идёт без него
+    QString eventStreamError;
+    if (eventStreamEnabled()) {
+        std::string error;
+        QString socketPath = setting("event_stream_socket",
+                                     QString::fromStdString(EventStreamPublisher::defaultSocketPath())).toString();
+        if (!eventStream->start(socketPath.toStdString(), error)) {
+            eventStreamError = QString::fromStdString(error);
+        }
+    }
+    for (CaptureThread *thread : captureThreads) {
+        thread->setEventStream(eventStream->isRunning() ? eventStream : nullptr);
+        thread->start();
+    }
 
     // Обновляем состояние UI
     startButton->setEnabled(false);
     stopButton->setEnabled(true);
     interfaceCombo->setEnabled(false);
-    filterEdit->setEnabled(false);
 
-    statusLabel->setText("Захват пакетов...");
+    statusLabel->setText(threadCount > 1 ? QString("Захват пакетов (потоков: %1)...").arg(threadCount)
+                                         : QString("Захват пакетов..."));
+    if (!eventStreamError.isEmpty()) {
+        statusLabel->setText(statusLabel->text() + " Поток событий не запущен: " + eventStreamError);
+    }
 }
 
 void MainWindow::stopCapture() {
-    if (captureThread && captureThread->isRunning()) {
-        captureThread->stopCapture();
-        captureThread->wait(); // Ждем завершения потока
+    for (CaptureThread *thread : captureThreads) {
+        thread->stopCapture();
+    }
+    for (CaptureThread *thread : captureThreads) {
+        thread->wait(); // Ждем завершения потока
     }
+    stopRingWriter();
+    processResolver->stop();
+    eventStream->stop();
 
-    // Обновляем состояние UI
-    startButton->setEnabled(true);
+    // Обновляем состояние UI (пока идёт поиск интерфейсов, выбирать нечего)
+    bool scanning = interfaceScanner->isRunning();
+    startButton->setEnabled(!scanning);
     stopButton->setEnabled(false);
-    interfaceCombo->setEnabled(true);
-    filterEdit->setEnabled(true);
+    interfaceCombo->setEnabled(!scanning);
 
     statusLabel->setText("Готов");
 }
@@ -632,14 +1799,408 @@ void MainWindow::showAbout() {
 }
 
 void MainWindow::displaySettings() {
-    // Простое диалоговое окно настроек
+    QSettings settings;
+    bool ok = false;
+
     int timeout = QInputDialog::getInt(this, "Настройки",
                                        "Таймаут очистки TCP-потоков (секунды):",
-                                       300, 10, 3600);
+                                       settings.value("tcp_stream_timeout", 300).toInt(), 10, 3600, 1, &ok);
+    if (!ok) {
+        return;
+    }
+
+    int bufferMb = QInputDialog::getInt(this, "Настройки",
+                                        "Предел несобранных данных на TCP-поток (МБ):",
+                                        settings.value("stream_buffer_mb", 16).toInt(), 1, 1024, 1, &ok);
+    if (!ok) {
+        return;
+    }
 
-    // Можно сохранить настройки для использования в программе
-    QSettings settings;
     settings.setValue("tcp_stream_timeout", timeout);
+    settings.setValue("stream_buffer_mb", bufferMb);
+
+    // Работающий захват получает новые значения сразу
+    applyLiveSettings();
+}
+
+void MainWindow::configureSampling() {
+    QSettings settings;
+    QStringList modes = {"Выключена (все потоки)", "Фиксированная: 1 из N потоков",
+                         "Автоматическая (по потерям и очереди)"};
+
+    bool ok = false;
+    int current = settings.value("sampling_mode", SAMPLING_OFF).toInt();
+    QString mode = QInputDialog::getItem(this, "Выборка потоков",
+                                         "Политика при перегрузке:", modes,
+                                         qBound(0, current, modes.size() - 1), false, &ok);
+    if (!ok) {
+        return;
+    }
+
+    int modeIndex = modes.indexOf(mode);
+    int rate = settings.value("sampling_rate", 1).toInt();
+    if (modeIndex != SAMPLING_OFF) {
+        rate = QInputDialog::getInt(this, "Выборка потоков",
+                                    modeIndex == SAMPLING_AUTO ? "Начальное N (степень двойки):"
+                                                               : "Обрабатывать 1 из N потоков, N =",
+                                    rate, 1, 1024, 1, &ok);
+        if (!ok) {
+            return;
+        }
+    }
+
+    settings.setValue("sampling_mode", modeIndex);
+    settings.setValue("sampling_rate", rate);
+
+    if (isCapturing()) {
+        statusLabel->setText("Выборка будет применена при следующем запуске захвата");
+    }
+}
+
+void MainWindow::configureBypass() {
+    QSettings settings;
+    bool ok = false;
+
+    // Потоки, не похожие на HTTP, обходятся всегда; порты - дополнительное правило
+    QString ports = QInputDialog::getText(this, "Обход потоков",
+                                          "Порты, которые не инспектируются (через запятую, например 443,22):",
+                                          QLineEdit::Normal,
+                                          settings.value("bypass_ports").toString(), &ok);
+    if (!ok) {
+        return;
+    }
+
+    QStringList truncateModes = {"Копировать только заголовки (фильтр в ядре)",
+                                 "Копировать пакеты целиком"};
+    QString truncate = QInputDialog::getItem(this, "Обход потоков",
+                                             "Пакеты обходимых портов:", truncateModes,
+                                             settings.value("bypass_truncate", true).toBool() ? 0 : 1,
+                                             false, &ok);
+    if (!ok) {
+        return;
+    }
+
+    int snaplen = QInputDialog::getInt(this, "Обход потоков",
+                                       "Максимальный размер захвата (snaplen), байт:",
+                                       settings.value("snaplen", 65536).toInt(), 64, 262144, 1, &ok);
+    if (!ok) {
+        return;
+    }
+
+    bool snaplenChanged = snaplen != settings.value("snaplen", 65536).toInt();
+    settings.setValue("bypass_ports", ports.trimmed());
+    settings.setValue("bypass_truncate", truncateModes.indexOf(truncate) == 0);
+    settings.setValue("snaplen", snaplen);
+
+    // Порты и обрезка в ядре меняются на ходу; snaplen задаётся при открытии устройства
+    applyLiveSettings();
+    if (isCapturing() && snaplenChanged) {
+        statusLabel->setText("Snaplen будет применён при следующем запуске захвата");
+    }
+}
+
+void MainWindow::configureExtraInterfaces() {
+    QSettings settings;
+    bool ok = false;
+
+    QStringList available;
+    for (int i = 0; i < interfaceCombo->count(); i++) {
+        QString name = interfaceCombo->itemData(i).toString();
+        if (!name.isEmpty()) {
+            available << name;
+        }
+    }
+
+    QString names = QInputDialog::getText(this, "Дополнительные интерфейсы",
+                                          QString("Интерфейсы, захватываемые вместе с выбранным (через запятую).\n"
+                                                  "Пакеты сливаются в одну ленту по времени, TCP-потоки собираются\n"
+                                                  "через все интерфейсы. Доступны: %1")
+                                              .arg(available.join(", ")),
+                                          QLineEdit::Normal, settings.value("extra_interfaces").toString(), &ok);
+    if (!ok) {
+        return;
+    }
+    settings.setValue("extra_interfaces", names.trimmed());
+
+    if (isCapturing()) {
+        statusLabel->setText("Набор интерфейсов будет применён при следующем запуске захвата");
+    }
+}
+
+void MainWindow::configureCaptureThreads() {
+    QSettings settings;
+    bool ok = false;
+
+    if (!CaptureThread::isFanoutSupported()) {
+        QMessageBox::information(this, "Потоки захвата",
+                                 "Несколько потоков захвата (PACKET_FANOUT) поддерживаются только в Linux.");
+    } else {
+        int threads = QInputDialog::getInt(this, "Потоки захвата",
+                                           "Число потоков захвата на интерфейсе (группа PACKET_FANOUT):",
+                                           settings.value("capture_threads", 1).toInt(),
+                                           1, qMin(64, ThreadTuning::cpuCount() * 2), 1, &ok);
+        if (!ok) {
+            return;
+        }
+        settings.setValue("capture_threads", threads);
+    }
+
+    // Ядра назначаются потокам по кругу
+    QString cpus = settings.value("capture_cpus").toString();
+    std::vector<int> parsed;
+    bool valid = false;
+    do {
+        cpus = QInputDialog::getText(this, "Потоки захвата",
+                                     QString("Ядра для потоков захвата (например 2-5,8; \"numa\" - ядра узла\n"
+                                             "сетевой карты; пусто - без привязки). Логических процессоров: %1")
+                                         .arg(ThreadTuning::cpuCount()),
+                                     QLineEdit::Normal, cpus, &ok);
+        if (!ok) {
+            return;
+        }
+        valid = cpus.trimmed() == "numa" || ThreadTuning::parseCpuList(cpus.toStdString(), parsed);
+    } while (!valid &&
+             QMessageBox::warning(this, "Потоки захвата", "Некорректный список ядер.",
+                                  QMessageBox::Retry | QMessageBox::Cancel) == QMessageBox::Retry);
+
+    if (!valid) {
+        return;
+    }
+    settings.setValue("capture_cpus", cpus.trimmed());
+
+    QStringList policies = {"Обычный", "Повышенный (nice -10)", "Реальное время (SCHED_FIFO)"};
+    SchedulingPolicy current = SCHEDULING_NORMAL;
+    ThreadTuning::parsePolicy(settings.value("capture_policy", "normal").toString().toStdString(), current);
+    QString policy = QInputDialog::getItem(this, "Потоки захвата", "Приоритет потоков захвата:",
+                                           policies, current, false, &ok);
+    if (!ok) {
+        return;
+    }
+    settings.setValue("capture_policy",
+                      ThreadTuning::policyName(static_cast<SchedulingPolicy>(policies.indexOf(policy))));
+
+    if (settingOverrides.contains("capture_threads") || settingOverrides.contains("capture_cpus") ||
+        settingOverrides.contains("capture_policy")) {
+        statusLabel->setText("Параметры командной строки действуют до перезапуска программы");
+    } else if (isCapturing()) {
+        statusLabel->setText("Потоки захвата будут перенастроены при следующем запуске");
+    }
+}
+
+bool MainWindow::startRingWriter() {
+    QSettings settings;
+    if (!settings.value("ring_enabled", false).toBool()) {
+        for (CaptureThread *thread : captureThreads) {
+            thread->setFrameQueue(nullptr);
+        }
+        return true;
+    }
+
+    RingWriterOptions options;
+    options.directory = settings.value("ring_directory", QDir::homePath()).toString().toStdString();
+    options.maxFileBytes = settings.value("ring_file_mb", 100).toULongLong() * 1024 * 1024;
+    options.maxFileSeconds = settings.value("ring_file_seconds", 0).toUInt();
+    options.maxFiles = settings.value("ring_files", 10).toUInt();
+    options.queueBytes = settings.value("ring_queue_mb", 64).toULongLong() * 1024 * 1024;
+    options.snaplen = settings.value("snaplen", 65536).toUInt();
+
+    // Заголовок файлов - с типом канала захвата (Linux cooked для any, raw IP
+    // для туннелей). Потоки захвата ещё не открыли устройство, поэтому тип
+    // узнаётся отдельным открытием; несколько интерфейсов захватываются только
+    // с общим типом канала. Если открыть не удалось, ошибку покажет поток захвата
+    int linkType = CaptureThread::probeLinkType(captureInterfaceNames.value(0));
+    if (linkType >= 0) {
+        options.linkType = linkType;
+    }
+
+    ringWriter = new PcapRingWriter(options);
+    for (CaptureThread *thread : captureThreads) {
+        thread->setFrameQueue(ringWriter->addProducer());
+    }
+
+    std::string error;
+    if (!ringWriter->start(error)) {
+        stopRingWriter();
+        QMessageBox::critical(this, "Запись на диск", QString::fromStdString(error));
+        return false;
+    }
+    return true;
+}
+
+void MainWindow::stopRingWriter() {
+    for (CaptureThread *thread : captureThreads) {
+        thread->setFrameQueue(nullptr);
+    }
+    if (ringWriter) {
+        // Потоки захвата уже остановлены: остаток очередей дописывается
+        ringWriter->stop();
+        updateRingStatus();
+        delete ringWriter;
+        ringWriter = nullptr;
+    }
+}
+
+void MainWindow::updateRingStatus() {
+    if (!ringWriter) {
+        return;
+    }
+
+    RingWriterStats stats = ringWriter->stats();
+    ringLabel->setText(QString("Запись: %1 МБ, файлов %2, потеряно %3%4")
+                           .arg(stats.bytesWritten / (1024.0 * 1024.0), 0, 'f', 1)
+                           .arg(stats.filesCreated)
+                           .arg(stats.framesDropped)
+                           .arg(stats.writeFailed ? ", ошибка записи" : ""));
+    ringLabel->setToolTip(QString::fromStdString(stats.currentFile));
+}
+
+void MainWindow::toggleRingWriter(bool enabled) {
+    QSettings settings;
+    settings.setValue("ring_enabled", enabled);
+    if (!enabled) {
+        ringLabel->clear();
+    }
+    if (isCapturing()) {
+        statusLabel->setText("Запись на диск будет применена при следующем запуске захвата");
+    }
+}
+
+bool MainWindow::processAttributionEnabled() const {
+    return ProcessResolver::isSupported() && setting("process_attribution", true).toBool();
+}
+
+void MainWindow::toggleProcessAttribution(bool enabled) {
+    QSettings settings;
+    settings.setValue("process_attribution", enabled);
+    if (isCapturing()) {
+        statusLabel->setText("Определение процессов будет применено при следующем запуске захвата");
+    } else {
+        packetsTable->setColumnHidden(PROCESS_COLUMN, !processAttributionEnabled());
+    }
+}
+
+bool MainWindow::eventStreamEnabled() const {
+    return EventStreamPublisher::isSupported() && setting("event_stream", false).toBool();
+}
+
+void MainWindow::toggleEventStream(bool enabled) {
+    QSettings settings;
+    settings.setValue("event_stream", enabled);
+    if (isCapturing()) {
+        statusLabel->setText("Поток событий будет применён при следующем запуске захвата");
+    }
+}
+
+void MainWindow::configureRingWriter() {
+    QSettings settings;
+    bool ok = false;
+
+    QString directory = QFileDialog::getExistingDirectory(this, "Каталог для записи",
+                                                          settings.value("ring_directory", QDir::homePath()).toString());
+    if (directory.isEmpty()) {
+        return;
+    }
+
+    int fileMb = QInputDialog::getInt(this, "Запись на диск", "Размер одного файла, МБ:",
+                                      settings.value("ring_file_mb", 100).toInt(), 1, 1024 * 1024, 1, &ok);
+    if (!ok) {
+        return;
+    }
+
+    int fileSeconds = QInputDialog::getInt(this, "Запись на диск",
+                                           "Длительность одного файла, секунд (0 - без ограничения):",
+                                           settings.value("ring_file_seconds", 0).toInt(), 0, 86400 * 7, 1, &ok);
+    if (!ok) {
+        return;
+    }
+
+    int files = QInputDialog::getInt(this, "Запись на диск",
+                                     "Сколько файлов хранить (0 - все; старые удаляются):",
+                                     settings.value("ring_files", 10).toInt(), 0, 100000, 1, &ok);
+    if (!ok) {
+        return;
+    }
+
+    settings.setValue("ring_directory", directory);
+    settings.setValue("ring_file_mb", fileMb);
+    settings.setValue("ring_file_seconds", fileSeconds);
+    settings.setValue("ring_files", files);
+
+    if (isCapturing()) {
+        statusLabel->setText("Параметры записи будут применены при следующем запуске захвата");
+    }
+}
+
+void MainWindow::configureTrigger() {
+    QSettings settings;
+    bool ok = false;
+
+    QString rules = settings.value("trigger_rules").toString();
+    std::vector<TriggerRule> parsed;
+    std::string error;
+    do {
+        rules = QInputDialog::getText(this, "Запись по событию",
+                                      "Правила через \";\" (пусто - выключено):\n"
+                                      "  status=500-599/10 - 10 ответов 5xx за секунду\n"
+                                      "  uri~/login - URI содержит подстроку\n"
+                                      "  host=example.com - запрос к узлу\n"
+                                      "  rate>100000 - больше 100000 пакетов в секунду",
+                                      QLineEdit::Normal, rules, &ok);
+        if (!ok) {
+            return;
+        }
+    } while (!TriggerRecorder::parseRules(rules.toStdString(), parsed, error) &&
+             QMessageBox::warning(this, "Запись по событию", QString::fromStdString(error),
+                                  QMessageBox::Retry | QMessageBox::Cancel) == QMessageBox::Retry);
+
+    if (!TriggerRecorder::parseRules(rules.toStdString(), parsed, error)) {
+        return;
+    }
+    settings.setValue("trigger_rules", rules.trimmed());
+    if (parsed.empty()) {
+        return;
+    }
+
+    int ringMb = QInputDialog::getInt(this, "Запись по событию", "Размер кольца в памяти, МБ:",
+                                      settings.value("trigger_ring_mb", 64).toInt(), 1, 16384, 1, &ok);
+    if (!ok) {
+        return;
+    }
+
+    int preSeconds = QInputDialog::getInt(this, "Запись по событию", "Секунд до события:",
+                                          settings.value("trigger_pre_seconds", 10).toInt(), 0, 3600, 1, &ok);
+    if (!ok) {
+        return;
+    }
+
+    int postSeconds = QInputDialog::getInt(this, "Запись по событию", "Секунд после события:",
+                                           settings.value("trigger_post_seconds", 10).toInt(), 0, 3600, 1, &ok);
+    if (!ok) {
+        return;
+    }
+
+    QString directory = QFileDialog::getExistingDirectory(this, "Каталог для записи по событию",
+                                                          settings.value("trigger_directory", QDir::homePath()).toString());
+    if (directory.isEmpty()) {
+        return;
+    }
+
+    settings.setValue("trigger_ring_mb", ringMb);
+    settings.setValue("trigger_pre_seconds", preSeconds);
+    settings.setValue("trigger_post_seconds", postSeconds);
+    settings.setValue("trigger_directory", directory);
+
+    if (isCapturing()) {
+        statusLabel->setText("Запись по событию будет применена при следующем запуске захвата");
+    }
+}
+
+void MainWindow::onTriggerFired(const QString &reason, const QString &fileName) {
+    if (fileName.isEmpty()) {
+        statusLabel->setText(QString("Событие «%1»: не удалось создать файл записи").arg(reason));
+    } else {
+        statusLabel->setText(QString("Событие «%1»: запись в %2").arg(reason, fileName));
+    }
 }
 
 void MainWindow::savePackets() {
@@ -665,12 +2226,23 @@ void MainWindow::savePackets() {
     QTextStream out(&file);
 
     // Заголовок CSV
-    out << "№,Время,Протокол,Отправитель,Порт,Получатель,Порт,Размер\n";
+    out << "№,Время,Протокол,Отправитель,Порт,Получатель,Порт,Размер,Интерфейс,Процесс";
+    for (const QString &column : headerColumns) {
+        out << "," << column;
+    }
+    out << "\n";
 
     // Данные
     for (int row = 0; row < packetsModel->rowCount(); ++row) {
         for (int col = 0; col < packetsModel->columnCount(); ++col) {
-            out << packetsModel->data(packetsModel->index(row, col)).toString();
+            if (col < BASE_COLUMN_COUNT && col != PROCESS_COLUMN) {
+                out << packetsModel->data(packetsModel->index(row, col)).toString();
+            } else {
+                // Значения заголовков и имена процессов могут содержать запятые и кавычки
+                quint32 id = packetsModel->data(packetsModel->index(row, col), HEADER_VALUE_ID_ROLE).toUInt();
+                QString value = QString::fromStdString(headerInterner.value(id));
+                out << "\"" << value.replace("\"", "\"\"") << "\"";
+            }
             if (col < packetsModel->columnCount() - 1) {
                 out << ",";
             }
@@ -682,16 +2254,223 @@ void MainWindow::savePackets() {
     statusLabel->setText(QString("Пакеты сохранены в %1").arg(fileName));
 }
 
+void MainWindow::saveMessageBody() {
+    QModelIndex current = packetsProxy->mapToSource(packetsTable->currentIndex());
+    if (!current.isValid() ||
+        packetsModel->data(packetsModel->index(current.row(), 0), Qt::UserRole).toMap()["body"].toByteArray().isEmpty()) {
+        QMessageBox::information(this, "Информация", "Выберите HTTP-сообщение с телом.");
+        return;
+    }
+
+    QString fileName = QFileDialog::getSaveFileName(this, "Сохранить тело сообщения",
+                                                    QDir::homePath() + "/body.bin");
+    if (fileName.isEmpty()) {
+        return;
+    }
+
+    QFile file(fileName);
+    QVariantMap decoded = decodedBody(current.row());
+    if (!file.open(QIODevice::WriteOnly) || file.write(decoded["data"].toByteArray()) < 0) {
+        QMessageBox::warning(this, "Ошибка", "Не удалось записать файл.");
+        return;
+    }
+    file.close();
+
+    QString note = decoded["note"].toString();
+    statusLabel->setText(note.isEmpty() ? QString("Тело сохранено в %1").arg(fileName)
+                                        : QString("Тело сохранено в %1 (%2)").arg(fileName, note));
+}
+
+QVariantMap MainWindow::decodedBody(int row) {
+    auto cached = decodedBodies.constFind(row);
+    if (cached != decodedBodies.constEnd()) {
+        decodedBodyOrder.removeOne(row);
+        decodedBodyOrder.append(row);
+        return cached.value();
+    }
+
+    QVariantMap details = packetsModel->data(packetsModel->index(row, 0), Qt::UserRole).toMap();
+    QByteArray body = details["body"].toByteArray();
+
+    BodyDecodeResult result = HttpBodyDecoder::decode(
+        reinterpret_cast<const uint8_t*>(body.constData()), static_cast<size_t>(body.size()),
+        details["transferEncoding"].toString().toStdString(),
+        details["contentEncoding"].toString().toStdString());
+
+    QVariantMap decoded;
+    decoded["data"] = QByteArray(result.data.data(), static_cast<int>(result.data.size()));
+    decoded["note"] = QString::fromStdString(result.message);
+
+    // Тело может занимать до 16 МБ: в кеше - только последние строки
+    if (decodedBodyOrder.size() >= DECODED_BODY_CACHE_SIZE) {
+        decodedBodies.remove(decodedBodyOrder.takeFirst());
+    }
+    decodedBodies.insert(row, decoded);
+    decodedBodyOrder.append(row);
+    return decoded;
+}
+
+QString MainWindow::headersText(int row) const {
+    QVariantMap details = packetsModel->data(packetsModel->index(row, 0), Qt::UserRole).toMap();
+
+    QString text;
+    for (quint32 line : details["headerLines"].value<QList<quint32>>()) {
+        text += QString::fromStdString(headerInterner.value(line)) + "\n";
+    }
+    return text;
+}
+
+void MainWindow::applyHeaderColumns(const QStringList &names) {
+    QStringList columns;
+    for (const QString &name : names) {
+        if (!name.trimmed().isEmpty()) {
+            columns << name.trimmed();
+        }
+    }
+    if (columns == headerColumns && packetsModel->columnCount() == BASE_COLUMN_COUNT + columns.size()) {
+        return;
+    }
+
+    // Значения прежних столбцов не переносятся: у строк их номера другого заголовка
+    if (packetsModel->columnCount() > BASE_COLUMN_COUNT) {
+        packetsModel->removeColumns(BASE_COLUMN_COUNT, packetsModel->columnCount() - BASE_COLUMN_COUNT);
+    }
+    if (!columns.isEmpty()) {
+        packetsModel->insertColumns(BASE_COLUMN_COUNT, columns.size());
+    }
+    for (int i = 0; i < columns.size(); i++) {
+        packetsModel->setHeaderData(BASE_COLUMN_COUNT + i, Qt::Horizontal, columns[i]);
+    }
+
+    headerColumns = columns;
+    packetsProxy->setHeaderColumns(BASE_COLUMN_COUNT, headerColumns);
+    packetsProxy->setHeaderFilter(headerFilterEdit->text());
+}
+
+void MainWindow::configureHeaderColumns() {
+    bool ok = false;
+    QString names = QInputDialog::getText(this, "Столбцы заголовков",
+                                          "Заголовки HTTP, показываемые столбцами (через запятую):",
+                                          QLineEdit::Normal, headerColumns.join(","), &ok);
+    if (!ok) {
+        return;
+    }
+
+    QSettings settings;
+    settings.setValue("header_columns", names);
+
+    // Потоки захвата получают набор столбцов при запуске
+    if (isCapturing()) {
+        statusLabel->setText("Столбцы заголовков будут изменены при следующем запуске захвата");
+    } else {
+        applyHeaderColumns(names.split(',', Qt::SkipEmptyParts));
+    }
+}
+
 void MainWindow::clearPackets() {
     packetsModel->removeRows(0, packetsModel->rowCount());
+    decodedBodies.clear();
+    decodedBodyOrder.clear();
+    searchIndex.clear();
+    searchMatches.clear();
+    searchPosition = -1;
+    searchedRows = 0;
+
+    // Таблицу значений можно освободить, только когда её никто не пополняет
+    if (!isCapturing()) {
+        headerInterner.clear();
+        packetsProxy->setHeaderFilter(headerFilterEdit->text());
+    }
     detailsText->clear();
+    flowStats->clear();
+    httpStats->clear();
     statusLabel->setText("Готов");
 }
 
+void MainWindow::showConversations() {
+    if (!conversationsWindow) {
+        conversationsWindow = new ConversationsWindow(flowStats, this);
+    }
+
+    conversationsWindow->show();
+    conversationsWindow->raise();
+    conversationsWindow->activateWindow();
+}
+
+void MainWindow::showHttpStatistics() {
+    if (!httpStatsWindow) {
+        httpStatsWindow = new HttpStatsWindow(httpStats, this);
+    }
+
+    httpStatsWindow->show();
+    httpStatsWindow->raise();
+    httpStatsWindow->activateWindow();
+}
+
+void MainWindow::toggleTracing(bool enabled) {
+    Tracer::setEnabled(enabled);
+    // Буфер потока GUI заводится только при первом включении трассировки
+    if (Tracer::isEnabled()) {
+        Tracer::setThreadName("gui");
+    }
+    statusLabel->setText(enabled ? "Трассировка включена" : "Трассировка выключена");
+}
+
+void MainWindow::exportTrace() {
+    QString fileName = QFileDialog::getSaveFileName(this, "Экспорт трассировки",
+                                                    QDir::homePath() + "/sniffer-trace.json",
+                                                    "Chrome trace (*.json)");
+    if (fileName.isEmpty()) {
+        return;
+    }
+
+    if (!Tracer::exportChromeTrace(fileName.toStdString())) {
+        QMessageBox::warning(this, "Ошибка", "Не удалось записать файл трассировки.");
+        return;
+    }
+
+    statusLabel->setText(QString("Трассировка сохранена в %1 (откройте в ui.perfetto.dev)").arg(fileName));
+}
+
+void MainWindow::showTraceSummary() {
+    std::vector<TraceStageSummary> stages = Tracer::summary();
+
+    QDialog dialog(this);
+    dialog.setWindowTitle("Время по стадиям");
+    dialog.resize(650, 350);
+    QVBoxLayout *layout = new QVBoxLayout(&dialog);
+
+    QTableWidget *table = new QTableWidget(static_cast<int>(stages.size()), 5, &dialog);
+    table->setHorizontalHeaderLabels({"Стадия", "Вызовов", "Всего, мс", "Среднее, мкс", "Максимум, мкс"});
+    table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    table->verticalHeader()->setVisible(false);
+    table->horizontalHeader()->setStretchLastSection(true);
+
+    for (int row = 0; row < static_cast<int>(stages.size()); ++row) {
+        const TraceStageSummary &stage = stages[row];
+        double average = stage.count ? stage.totalNs / 1000.0 / stage.count : 0;
+
+        table->setItem(row, 0, new QTableWidgetItem(QString::fromStdString(stage.name)));
+        table->setItem(row, 1, new QTableWidgetItem(QString::number(stage.count)));
+        table->setItem(row, 2, new QTableWidgetItem(QString::number(stage.totalNs / 1e6, 'f', 2)));
+        table->setItem(row, 3, new QTableWidgetItem(QString::number(average, 'f', 2)));
+        table->setItem(row, 4, new QTableWidgetItem(QString::number(stage.maxNs / 1000.0, 'f', 1)));
+    }
+
+    layout->addWidget(table);
+    layout->addWidget(new QLabel("Вложенные стадии входят во время внешних (pcap_dispatch включает обработку пакетов).", &dialog));
+    dialog.exec();
+}
+
 void MainWindow::onPacketCaptured(const QString &protocol,
                                   const QString &srcIp, const QString &srcPort,
                                   const QString &dstIp, const QString &dstPort,
-                                  int dataLength) {
+                                  int dataLength, int interfaceIndex, quint32 processId) {
+    TRACE_SCOPE("gui.onPacketCaptured");
+    if (CaptureThread *thread = qobject_cast<CaptureThread*>(sender())) {
+        thread->rowConsumed();
+    }
+
     int row = packetsModel->rowCount();
 
     // Добавляем строку с данными пакета
@@ -703,6 +2482,8 @@ void MainWindow::onPacketCaptured(const QString &protocol,
     packetsModel->setData(packetsModel->index(row, 4), srcPort);
     packetsModel->setData(packetsModel->index(row, 5), dstIp);
     packetsModel->setData(packetsModel->index(row, 6), dstPort);
+    setInterfaceColumn(row, interfaceIndex);
+    setProcessColumn(row, processId);
     packetsModel->setData(packetsModel->index(row, 7), dataLength);
 
     // Прокрутка к последней строке
@@ -712,8 +2493,15 @@ void MainWindow::onPacketCaptured(const QString &protocol,
 void MainWindow::onHttpMessageCaptured(const QString &type,
                                        const QString &srcIp, const QString &srcPort,
                                        const QString &dstIp, const QString &dstPort,
-                                       const QString &info, const QString &headers,
-                                       const QString &body) {
+                                       const QString &info, const QList<quint32> &headerLines,
+                                       const QList<quint32> &headerValues,
+                                       const QByteArray &body, const QString &transferEncoding,
+                                       const QString &contentEncoding, int interfaceIndex, quint32 processId) {
+    TRACE_SCOPE("gui.onHttpMessageCaptured");
+    if (CaptureThread *thread = qobject_cast<CaptureThread*>(sender())) {
+        thread->rowConsumed();
+    }
+
     int row = packetsModel->rowCount();
 
     // Добавляем строку с данными HTTP пакета
@@ -725,46 +2513,437 @@ void MainWindow::onHttpMessageCaptured(const QString &type,
     packetsModel->setData(packetsModel->index(row, 4), srcPort);
     packetsModel->setData(packetsModel->index(row, 5), dstIp);
     packetsModel->setData(packetsModel->index(row, 6), dstPort);
-    packetsModel->setData(packetsModel->index(row, 7), headers.size() + body.size());
+    setInterfaceColumn(row, interfaceIndex);
+    setProcessColumn(row, processId);
+    int headersSize = 0;
+    for (quint32 line : headerLines) {
+        headersSize += static_cast<int>(headerInterner.value(line).size()) + 2;
+    }
+    packetsModel->setData(packetsModel->index(row, 7), headersSize + body.size());
+
+    // Столбцы заголовков: в ячейке только номер значения
+    for (int i = 0; i < headerValues.size() && i < headerColumns.size(); i++) {
+        if (headerValues[i] != StringInterner::EMPTY_ID) {
+            packetsModel->setData(packetsModel->index(row, BASE_COLUMN_COUNT + i), headerValues[i],
+                                  HEADER_VALUE_ID_ROLE);
+        }
+    }
 
     // Сохраняем полные данные для отображения в деталях
     QMap<QString, QVariant> details;
     details["type"] = type;
     details["info"] = info;
-    details["headers"] = headers;
+    details["headerLines"] = QVariant::fromValue(headerLines);
     details["body"] = body;
+    details["transferEncoding"] = transferEncoding;
+    details["contentEncoding"] = contentEncoding;
     packetsModel->setData(packetsModel->index(row, 0), QVariant::fromValue(details), Qt::UserRole);
+    indexHttpRow(row, info, headerLines, headerValues);
 
     // Прокрутка к последней строке
     packetsTable->scrollToBottom();
 }
 
+void MainWindow::onWebSocketFrameCaptured(const QString &srcIp, const QString &srcPort,
+                                          const QString &dstIp, const QString &dstPort,
+                                          const QString &info, qint64 length, const QByteArray &payload,
+                                          int interfaceIndex, quint32 processId) {
+    TRACE_SCOPE("gui.onWebSocketFrameCaptured");
+    if (CaptureThread *thread = qobject_cast<CaptureThread*>(sender())) {
+        thread->rowConsumed();
+    }
+
+    int row = packetsModel->rowCount();
+
+    packetsModel->insertRow(row);
+    packetsModel->setData(packetsModel->index(row, 0), row + 1);
+    packetsModel->setData(packetsModel->index(row, 1), QTime::currentTime().toString("hh:mm:ss.zzz"));
+    packetsModel->setData(packetsModel->index(row, 2), "WebSocket");
+    packetsModel->setData(packetsModel->index(row, 3), srcIp);
+    packetsModel->setData(packetsModel->index(row, 4), srcPort);
+    packetsModel->setData(packetsModel->index(row, 5), dstIp);
+    packetsModel->setData(packetsModel->index(row, 6), dstPort);
+    setInterfaceColumn(row, interfaceIndex);
+    setProcessColumn(row, processId);
+    packetsModel->setData(packetsModel->index(row, 7), length);
+
+    QMap<QString, QVariant> details;
+    details["type"] = "WebSocket";
+    details["info"] = info;
+    details["body"] = payload;
+    details["frame"] = true;
+    packetsModel->setData(packetsModel->index(row, 0), QVariant::fromValue(details), Qt::UserRole);
+
+    packetsTable->scrollToBottom();
+}
+
+void MainWindow::onTlsHelloCaptured(const QString &type,
+                                    const QString &srcIp, const QString &srcPort,
+                                    const QString &dstIp, const QString &dstPort,
+                                    const QString &info, const QString &serverName, const QString &detailsHtml,
+                                    int interfaceIndex, quint32 processId) {
+    TRACE_SCOPE("gui.onTlsHelloCaptured");
+    if (CaptureThread *thread = qobject_cast<CaptureThread*>(sender())) {
+        thread->rowConsumed();
+    }
+
+    int row = packetsModel->rowCount();
+
+    packetsModel->insertRow(row);
+    packetsModel->setData(packetsModel->index(row, 0), row + 1);
+    packetsModel->setData(packetsModel->index(row, 1), QTime::currentTime().toString("hh:mm:ss.zzz"));
+    packetsModel->setData(packetsModel->index(row, 2), "TLS");
+    packetsModel->setData(packetsModel->index(row, 3), srcIp);
+    packetsModel->setData(packetsModel->index(row, 4), srcPort);
+    packetsModel->setData(packetsModel->index(row, 5), dstIp);
+    packetsModel->setData(packetsModel->index(row, 6), dstPort);
+    setInterfaceColumn(row, interfaceIndex);
+    setProcessColumn(row, processId);
+
+    setHostColumn(row, serverName);
+
+    QMap<QString, QVariant> details;
+    details["type"] = "TLS " + type;
+    details["info"] = info;
+    details["html"] = detailsHtml;
+    packetsModel->setData(packetsModel->index(row, 0), QVariant::fromValue(details), Qt::UserRole);
+
+    packetsTable->scrollToBottom();
+}
+
+void MainWindow::onDatagramCaptured(const QString &protocol, const QString &type,
+                                    const QString &srcIp, const QString &srcPort,
+                                    const QString &dstIp, const QString &dstPort,
+                                    int dataLength, const QString &info, const QString &hostName,
+                                    const QString &detailsHtml, int interfaceIndex, quint32 processId) {
+    TRACE_SCOPE("gui.onDatagramCaptured");
+    if (CaptureThread *thread = qobject_cast<CaptureThread*>(sender())) {
+        thread->rowConsumed();
+    }
+
+    int row = packetsModel->rowCount();
+
+    packetsModel->insertRow(row);
+    packetsModel->setData(packetsModel->index(row, 0), row + 1);
+    packetsModel->setData(packetsModel->index(row, 1), QTime::currentTime().toString("hh:mm:ss.zzz"));
+    packetsModel->setData(packetsModel->index(row, 2), protocol);
+    packetsModel->setData(packetsModel->index(row, 3), srcIp);
+    packetsModel->setData(packetsModel->index(row, 4), srcPort);
+    packetsModel->setData(packetsModel->index(row, 5), dstIp);
+    packetsModel->setData(packetsModel->index(row, 6), dstPort);
+    setInterfaceColumn(row, interfaceIndex);
+    setProcessColumn(row, processId);
+    packetsModel->setData(packetsModel->index(row, 7), dataLength);
+    setHostColumn(row, hostName);
+
+    QMap<QString, QVariant> details;
+    details["type"] = protocol + " " + type;
+    details["info"] = info;
+    details["html"] = "<p><b>" + info.toHtmlEscaped() + "</b></p>" + detailsHtml;
+    packetsModel->setData(packetsModel->index(row, 0), QVariant::fromValue(details), Qt::UserRole);
+
+    packetsTable->scrollToBottom();
+}
+
+void MainWindow::setInterfaceColumn(int row, int interfaceIndex) {
+    if (captureInterfaceNames.size() > 1) {
+        packetsModel->setData(packetsModel->index(row, INTERFACE_COLUMN),
+                              captureInterfaceNames.value(interfaceIndex));
+    }
+}
+
+void MainWindow::setProcessColumn(int row, quint32 processId) {
+    if (processId != StringInterner::EMPTY_ID) {
+        packetsModel->setData(packetsModel->index(row, PROCESS_COLUMN), processId, HEADER_VALUE_ID_ROLE);
+    }
+}
+
+void MainWindow::setHostColumn(int row, const QString &name) {
+    if (name.isEmpty()) {
+        return;
+    }
+    for (int i = 0; i < headerColumns.size(); i++) {
+        if (headerColumns[i].compare("Host", Qt::CaseInsensitive) == 0) {
+            packetsModel->setData(packetsModel->index(row, BASE_COLUMN_COUNT + i),
+                                  headerInterner.intern(name.toStdString()), HEADER_VALUE_ID_ROLE);
+        }
+    }
+}
+
+void MainWindow::indexHttpRow(int row, const QString &info, const QList<quint32> &headerLines,
+                               const QList<quint32> &headerValues) {
+    if (!searchIndex.beginRow(static_cast<uint32_t>(row))) {
+        return;   // Предел памяти индекса: дальше строки ищутся перебором
+    }
+    QByteArray infoText = info.toUtf8();
+    searchIndex.addText(std::string_view(infoText.constData(), infoText.size()));
+    for (quint32 line : headerLines) {
+        const std::string &text = headerInterner.value(line);
+        if (isHostLine(text)) {
+            searchIndex.addText(text);
+        }
+    }
+    for (quint32 value : headerValues) {
+        if (value != StringInterner::EMPTY_ID) {
+            searchIndex.addText(headerInterner.value(value));
+        }
+    }
+}
+
+bool MainWindow::rowMatches(int row, const std::string &query) const {
+    QVariant detailsVariant = packetsModel->data(packetsModel->index(row, 0), Qt::UserRole);
+    QMap<QString, QVariant> details = detailsVariant.value<QMap<QString, QVariant>>();
+    if (!details.contains("headerLines")) {
+        return false;   // Ищутся только HTTP-строки
+    }
+
+    QByteArray info = details["info"].toString().toUtf8();
+    if (TrigramIndex::contains(std::string_view(info.constData(), info.size()), query)) {
+        return true;
+    }
+    for (quint32 line : details["headerLines"].value<QList<quint32>>()) {
+        const std::string &text = headerInterner.value(line);
+        if (isHostLine(text) && TrigramIndex::contains(text, query)) {
+            return true;
+        }
+    }
+    for (int column = BASE_COLUMN_COUNT; column < packetsModel->columnCount(); column++) {
+        quint32 id = packetsModel->data(packetsModel->index(row, column), HEADER_VALUE_ID_ROLE).toUInt();
+        if (id != StringInterner::EMPTY_ID && TrigramIndex::contains(headerInterner.value(id), query)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void MainWindow::findMatches(bool typing) {
+    TRACE_SCOPE("gui.findMatches");
+    QString text = searchEdit->text();
+    searchMatches.clear();
+    searchPosition = -1;
+
+    // Короткий запрос при наборе не ищется: перебор всей таблицы - по Enter.
+    // Запрос не запоминается, чтобы findNext не счёл его уже выполненным
+    QByteArray utf8 = text.toUtf8();
+    if (!text.isEmpty() && static_cast<size_t>(utf8.size()) < TrigramIndex::MIN_QUERY && typing) {
+        searchQuery.clear();
+        return;
+    }
+    searchQuery = text;
+    searchedRows = packetsModel->rowCount();
+    if (searchQuery.isEmpty()) {
+        return;
+    }
+    std::string query;
+    TrigramIndex::toLower(std::string_view(utf8.constData(), utf8.size()), query);
+
+    QElapsedTimer timer;
+    timer.start();
+
+    // Кандидаты из индекса; строки после его предела и короткие запросы - перебором
+    std::vector<uint32_t> candidates;
+    int scanFrom = 0;
+    if (searchIndex.candidates(query, candidates)) {
+        for (uint32_t row : candidates) {
+            if (static_cast<int>(row) < searchedRows && rowMatches(static_cast<int>(row), query)) {
+                searchMatches << static_cast<int>(row);
+            }
+        }
+        scanFrom = static_cast<int>(searchIndex.coveredRows());
+    }
+    for (int row = scanFrom; row < searchedRows; row++) {
+        if (rowMatches(row, query)) {
+            searchMatches << row;
+        }
+    }
+
+    statusLabel->setText(QString("Найдено строк: %1 (%2 мс, индекс %3 МБ)")
+                             .arg(searchMatches.size()).arg(timer.elapsed())
+                             .arg(searchIndex.memoryUsage() / (1024.0 * 1024.0), 0, 'f', 1));
+    jumpToMatch(1);
+}
+
+void MainWindow::findNext() {
+    // Запрос изменился или пришли новые строки - ищем заново
+    if (searchEdit->text() != searchQuery || packetsModel->rowCount() != searchedRows) {
+        findMatches(false);
+        return;
+    }
+    jumpToMatch(1);
+}
+
+void MainWindow::findPrevious() {
+    if (searchEdit->text() != searchQuery || packetsModel->rowCount() != searchedRows) {
+        findMatches(false);
+        return;
+    }
+    jumpToMatch(-1);
+}
+
+void MainWindow::jumpToMatch(int step) {
+    if (searchMatches.isEmpty()) {
+        return;
+    }
+    if (searchPosition < 0) {
+        searchPosition = step > 0 ? -1 : 0;
+    }
+
+    // Строки, скрытые фильтром заголовков, пропускаются
+    for (int i = 0; i < searchMatches.size(); i++) {
+        searchPosition = (searchPosition + step + searchMatches.size()) % searchMatches.size();
+        QModelIndex index = packetsProxy->mapFromSource(packetsModel->index(searchMatches[searchPosition], 0));
+        if (index.isValid()) {
+            packetsTable->setCurrentIndex(index);
+            packetsTable->scrollTo(index, QAbstractItemView::PositionAtCenter);
+            showPacketDetails(index);
+            return;
+        }
+    }
+}
+
 void MainWindow::onCaptureError(const QString &message) {
-    QMessageBox::critical(this, "Ошибка захвата", message);
+    // При нескольких потоках ошибка обычно приходит от каждого - показываем одну
+    if (captureErrorShown) {
+        return;
+    }
+    captureErrorShown = true;
+
     stopCapture();
+    QMessageBox::critical(this, "Ошибка захвата", message);
+}
+
+void MainWindow::onCaptureWarning(const QString &message) {
+    statusLabel->setText(message);
 }
 
 void MainWindow::onStatisticsUpdated(int total, int tcp, int udp, int http) {
+    TRACE_SCOPE("gui.onStatisticsUpdated");
+
+    CaptureThread *thread = qobject_cast<CaptureThread*>(sender());
+    if (!captureThreads.contains(thread)) {
+        return;
+    }
+
+    CaptureCounters &counters = threadCounters[thread];
+    counters.total = total;
+    counters.tcp = tcp;
+    counters.udp = udp;
+    counters.http = http;
+
+    CaptureCounters sum;
+    for (const CaptureCounters &threadSum : threadCounters) {
+        sum.total += threadSum.total;
+        sum.tcp += threadSum.tcp;
+        sum.udp += threadSum.udp;
+        sum.http += threadSum.http;
+    }
+
     statsLabel->setText(QString("Пакетов: %1, TCP: %2, UDP: %3, HTTP: %4")
-                            .arg(total).arg(tcp).arg(udp).arg(http));
+                            .arg(sum.total).arg(sum.tcp).arg(sum.udp).arg(sum.http));
+}
+
+void MainWindow::onSamplingRateChanged(int threadRate) {
+    // Каждый поток подстраивает выборку сам; показываем самую строгую
+    CaptureThread *thread = qobject_cast<CaptureThread*>(sender());
+    if (!captureThreads.contains(thread)) {
+        return;
+    }
+    threadCounters[thread].samplingRate = threadRate;
+    int rate = 1;
+    for (const CaptureCounters &counters : threadCounters) {
+        rate = qMax(rate, counters.samplingRate);
+    }
+
+    // Строки и HTTP-статистика отражают только выбранные потоки:
+    // для оценки полного объёма их нужно умножить на N
+    if (rate <= 1) {
+        samplingLabel->setText("Выборка: все потоки");
+        samplingLabel->setToolTip(QString());
+    } else {
+        samplingLabel->setText(QString("Выборка: 1/%1 потоков").arg(rate));
+        samplingLabel->setToolTip(QString("Таблица и статистика HTTP содержат только выбранные потоки; "
+                                          "умножьте их на %1 для оценки полного трафика").arg(rate));
+    }
+}
+
+void MainWindow::onCpuUsageUpdated(double percent) {
+    CaptureThread *thread = qobject_cast<CaptureThread*>(sender());
+    if (!captureThreads.contains(thread)) {
+        return;
+    }
+    threadCounters[thread].cpuPercent = percent;
+    showCpuUsage();
+}
+
+void MainWindow::updateGuiCpuUsage() {
+    uint64_t now = ThreadTuning::currentThreadCpuTimeUs();
+    qint64 elapsedUs = guiCpuClock.nsecsElapsed() / 1000;
+    if (elapsedUs > 0) {
+        guiCpuPercent = 100.0 * (now - guiCpuTimeUs) / elapsedUs;
+    }
+    guiCpuTimeUs = now;
+    guiCpuClock.restart();
+    showCpuUsage();
+}
+
+void MainWindow::showCpuUsage() {
+    // Загрузка ядра каждым потоком захвата в порядке их номеров и потоком GUI
+    QStringList capture;
+    if (isCapturing()) {
+        for (CaptureThread *thread : captureThreads) {
+            capture << QString("%1%").arg(threadCounters.value(thread).cpuPercent, 0, 'f', 0);
+        }
+    }
+
+    QString text = QString("CPU GUI: %1%").arg(guiCpuPercent, 0, 'f', 0);
+    if (!capture.isEmpty()) {
+        text = QString("CPU захвата: %1, GUI: %2%").arg(capture.join(" / ")).arg(guiCpuPercent, 0, 'f', 0);
+    }
+    cpuLabel->setText(text);
 }
 
 void MainWindow::showPacketDetails(const QModelIndex &index) {
-    int row = index.row();
+    int row = packetsProxy->mapToSource(index).row();
 
     // Проверяем, есть ли расширенные детали для HTTP
     QVariant detailsVariant = packetsModel->data(packetsModel->index(row, 0), Qt::UserRole);
     if (detailsVariant.isValid()) {
         QMap<QString, QVariant> details = detailsVariant.value<QMap<QString, QVariant>>();
 
-        QString htmlDetails = "<h3>HTTP " + details["type"].toString() + "</h3>";
+        // Разобранные TLS и UDP: описание уже собрано в HTML
+        if (details.contains("html")) {
+            detailsText->setHtml("<h3>" + details["type"].toString() + "</h3>" + details["html"].toString());
+            return;
+        }
+
+        bool frame = details.contains("frame");
+        QString htmlDetails = frame ? QString("<h3>Кадр WebSocket</h3>")
+                                    : "<h3>HTTP " + details["type"].toString() + "</h3>";
         htmlDetails += "<p><b>" + details["info"].toString() + "</b></p>";
-        htmlDetails += "<h4>Заголовки:</h4>";
-        htmlDetails += "<pre>" + details["headers"].toString() + "</pre>";
+        if (!frame) {
+            htmlDetails += "<h4>Заголовки:</h4>";
+            htmlDetails += "<pre>" + headersText(row).toHtmlEscaped() + "</pre>";
+        }
+
+        if (!details["body"].toByteArray().isEmpty()) {
+            QVariantMap decoded = decodedBody(row);
+            QByteArray data = decoded["data"].toByteArray();
 
-        if (!details["body"].toString().isEmpty()) {
-            htmlDetails += "<h4>Тело сообщения:</h4>";
-            htmlDetails += "<pre>" + details["body"].toString().replace("<", "&lt;").replace(">", "&gt;") + "</pre>";
+            htmlDetails += frame ? "<h4>Данные кадра (начало):</h4>" : "<h4>Тело сообщения:</h4>";
+            if (!decoded["note"].toString().isEmpty()) {
+                htmlDetails += "<p><i>" + decoded["note"].toString().toHtmlEscaped() + "</i></p>";
+            }
+
+            if (data.contains('\0')) {
+                htmlDetails += QString("<p>Двоичные данные, %1 байт</p>").arg(data.size());
+            } else {
+                if (data.size() > BODY_DISPLAY_LIMIT) {
+                    htmlDetails += QString("<p><i>Показан первый 1 МБ из %1 байт; полностью - "
+                                           "\"Файл - Сохранить тело сообщения\"</i></p>").arg(data.size());
+                    data.truncate(BODY_DISPLAY_LIMIT);
+                }
+                htmlDetails += "<pre>" + QString::fromUtf8(data).toHtmlEscaped() + "</pre>";
+            }
         }
 
         detailsText->setHtml(htmlDetails);
@@ -6,12 +6,19 @@
 #include <QThread>
 #include <QStandardItemModel>
 #include <QMap>
+#include <QHash>
+#include <QList>
 #include <QLabel>
 #include <QComboBox>
 #include <QLineEdit>
 #include <QPushButton>
 #include <QTableView>
 #include <QTextEdit>
+#include <QVariantMap>
+#include <QElapsedTimer>
+#include <atomic>
+#include <thread>
+#include <vector>
 
 // Подключаем WinPcap/Npcap с учётом платформы
 #ifdef _WIN32
@@ -29,6 +36,25 @@
 
 #include "tcp_stream_assembler.h"
 #include "http_parser.h"
+#include "flow_stats.h"
+#include "http_stats.h"
+#include "flow_sampler.h"
+#include "thread_tuning.h"
+#include "pcap_ring_writer.h"
+#include "trigger_capture.h"
+#include "string_interner.h"
+#include "header_columns_model.h"
+#include "udp_dissector.h"
+#include "dns_parser.h"
+#include "ip_defragmenter.h"
+#include "interface_rates.h"
+#include "packet_merger.h"
+#include "process_resolver.h"
+#include "trigram_index.h"
+#include "event_stream.h"
+
+class ConversationsWindow;
+class HttpStatsWindow;
 
 // Остальная часть файла остается без изменений
 // ...
@@ -42,39 +68,215 @@ public:
     ~CaptureThread();
 
     void setInterface(const QString &interfaceName);
+
+    // Захват с нескольких интерфейсов одним сеансом: каждый интерфейс читает
+    // свой поток, пакеты сливаются по меткам времени и разбираются здесь
+    // общим сборщиком (поток TCP собирается, даже если его пакеты идут через
+    // разные интерфейсы). Номер интерфейса в списке приходит в сигналах строк.
+    void setInterfaces(const QStringList &interfaceNames);
     void setFilter(const QString &filter);
+    void setFlowStatistics(FlowStatistics *statistics);
+    void setHttpStatistics(HttpEndpointStats *statistics);
+
+    // Определение локального процесса для строк (nullptr - выключено);
+    // подпись процесса интернируется в таблицу setHeaderColumns
+    void setProcessResolver(ProcessResolver *resolver);
+
+    // Публикация разобранных сообщений для внешних программ (nullptr - выключено)
+    void setEventStream(EventStreamPublisher *stream);
+    void setSampling(SamplingMode mode, uint32_t rate);
+    void setBypass(const AssemblerConfig &config, bool truncateInKernel);
+    void setSnaplen(int snaplen);
+
+    // Смена фильтра и настроек сборщика без остановки захвата (вызывается из GUI).
+    // Фильтр компилируется здесь же, в вызывающем потоке; поток захвата
+    // забирает готовые настройки между пачками пакетов. Если захват не
+    // запущен, значения просто запоминаются до следующего запуска.
+    bool reconfigure(const QString &filter, const AssemblerConfig &config,
+                     bool truncateInKernel, QString &errorMessage);
+
+    // Несколько потоков захвата на одном интерфейсе: сокеты объединяются
+    // в группу PACKET_FANOUT (только Linux), ядро распределяет пакеты по хешу потока
+    static bool isFanoutSupported();
+    // Тип канала интерфейса (pcap_datalink) до запуска захвата; -1 - не открылся
+    static int probeLinkType(const QString &interfaceName);
+    void setFanoutGroup(int groupId);   // 0 - без группы
+    void setCpu(int cpu);               // -1 - без привязки
+    void setSchedulingPolicy(SchedulingPolicy policy);
+
+    // Очередь непрерывной записи на диск (nullptr - запись выключена)
+    void setFrameQueue(FrameQueue *queue);
+
+    // Запись по событию; signal общий для всех потоков захвата
+    void setTrigger(bool enabled, const TriggerOptions &options, TriggerSignal *signal);
+
+    // Заголовки HTTP интернируются в общую таблицу; names - столбцы таблицы пакетов
+    void setHeaderColumns(StringInterner *interner, const QStringList &names);
+    void setThreadIndex(int index);
     void stopCapture();
 
+    // GUI сообщает, что обработал строку (для оценки глубины очереди)
+    void rowConsumed() { queuedRows.fetch_sub(1, std::memory_order_relaxed); }
+
 signals:
     void packetCaptured(const QString &protocol,
                         const QString &srcIp, const QString &srcPort,
                         const QString &dstIp, const QString &dstPort,
-                        int dataLength);
+                        int dataLength, int interfaceIndex, quint32 processId);
     void httpMessageCaptured(const QString &type,
                              const QString &srcIp, const QString &srcPort,
                              const QString &dstIp, const QString &dstPort,
-                             const QString &info, const QString &headers,
-                             const QString &body);
+                             const QString &info, const QList<quint32> &headerLines,
+                             const QList<quint32> &headerValues,
+                             const QByteArray &body, const QString &transferEncoding,
+                             const QString &contentEncoding, int interfaceIndex, quint32 processId);
+    void webSocketFrameCaptured(const QString &srcIp, const QString &srcPort,
+                                const QString &dstIp, const QString &dstPort,
+                                const QString &info, qint64 length, const QByteArray &payload,
+                                int interfaceIndex, quint32 processId);
+    void tlsHelloCaptured(const QString &type,
+                          const QString &srcIp, const QString &srcPort,
+                          const QString &dstIp, const QString &dstPort,
+                          const QString &info, const QString &serverName, const QString &details,
+                          int interfaceIndex, quint32 processId);
+    void datagramCaptured(const QString &protocol, const QString &type,
+                          const QString &srcIp, const QString &srcPort,
+                          const QString &dstIp, const QString &dstPort,
+                          int dataLength, const QString &info, const QString &hostName,
+                          const QString &details, int interfaceIndex, quint32 processId);
     void error(const QString &message);
+    // Некритичная ошибка: захват продолжается, сообщение - в строку состояния
+    void warning(const QString &message);
     void statisticsUpdated(int total, int tcp, int udp, int http);
+    void samplingRateChanged(int rate);
+    void cpuUsageUpdated(double percent);   // Загрузка ядра потоком за последнюю секунду
+    void triggerFired(const QString &reason, const QString &fileName);
 
 protected:
     void run() override;
 
 private:
-    QString interfaceName;
+    QStringList interfaceNames;
     QString filterExpr;
     volatile bool running;
-    pcap_t *handle;
+    pcap_t *handle;                // При захвате с нескольких интерфейсов - nullptr
+    int currentInterface;          // Интерфейс разбираемого пакета (номер в interfaceNames)
+
+    // Чтение одного интерфейса при захвате с нескольких интерфейсов
+    struct InterfaceReader {
+        pcap_t *handle;
+        FrameQueue *queue;                  // Очередь в PacketMerger
+        std::thread thread;
+        std::atomic<bpf_program*> pendingFilter;   // Новый фильтр от applyPendingSettings
+        std::atomic<uint64_t> kernelDrops;
+        std::atomic<bool> failed;
+        QString errorMessage;               // Действителен после failed
+    };
+    std::vector<InterfaceReader*> readers;
+    PacketMerger *merger;
+    std::atomic<bool> readersRunning;
+    QString mergeError;
+
+    bool openReaders(QString &message);
+    void closeReaders();
+    int dispatchMerged();
+    void readInterface(InterfaceReader *reader);
+    static void queueHandler(u_char *userData, const struct pcap_pkthdr *pkthdr, const u_char *packet);
     int packetCount;
     int tcpCount;
     int udpCount;
     int httpCount;
     TCPStreamAssembler *tcpAssembler;
+    UdpDissectorRegistry *udpDissectors;   // Разбор нагрузки UDP по порту и сигнатуре
+    IpDefragmenter *defragmenter;          // Сборка фрагментов IPv4 до разбора TCP/UDP
+    FlowStatistics *flowStats;
+    HttpEndpointStats *httpStats;
+    uint64_t currentTimestampUs;   // Время текущего пакета (для задержек HTTP)
+
+    // Процессы: снимок берётся у ProcessResolver только при смене поколения,
+    // подписи интернируются один раз на процесс снимка
+    ProcessResolver *processResolver;
+    std::shared_ptr<const ProcessSnapshot> processSnapshot;
+    uint64_t processGeneration;
+    std::vector<uint32_t> processLabelIds;   // По номеру процесса в снимке; UINT32_MAX - не интернирована
+
+    // StringInterner::EMPTY_ID - процесс не найден
+    uint32_t lookupProcess(uint8_t protocol, uint32_t srcIP, uint16_t srcPort, uint32_t dstIP, uint16_t dstPort);
+
+    // Поток событий: заполняет общие поля заголовка (интерфейс, время, адреса) и публикует
+    EventStreamPublisher *eventStream;
+    void publishEvent(StreamEventHeader &header, uint32_t srcIP, uint16_t srcPort, uint32_t dstIP,
+                      uint16_t dstPort, const StreamEventField *fields, size_t fieldCount);
+
+    // Настройки, подготовленные GUI для работающего захвата
+    struct LiveSettings {
+        QString filter;
+        bpf_program program;   // Готовая программа BPF (CaptureFilter::release)
+        AssemblerConfig assembler;
+        bool truncateInKernel;
+    };
+    std::atomic<LiveSettings*> pendingSettings;   // Передаётся потоку захвата целиком
+    std::atomic<int> linkType;                    // Тип канала открытого устройства, -1 - не открыто
+
+    void applyPendingSettings();
+
+    // Обход неинтересных потоков
+    AssemblerConfig assemblerConfig;
+    bool truncateBypassed;         // Обрезать обходимые порты в ядре до заголовков
+    int snaplen;
+
+    // Размещение потока
+    int fanoutGroup;
+    int cpu;
+    int threadIndex;
+    SchedulingPolicy policy;
+    FrameQueue *frameQueue;
+
+    // Запись по событию
+    bool triggerEnabled;
+    TriggerOptions triggerOptions;
+    TriggerSignal *triggerSignal;
+    TriggerRecorder *triggerRecorder;
+
+    // Интернирование заголовков (буферы переиспользуются между сообщениями)
+    StringInterner *headerInterner;
+    std::vector<std::string> headerColumns;   // Имена в нижнем регистре
+    std::vector<uint32_t> headerLineIds;
+    std::vector<uint32_t> headerValueIds;
+
+    bool joinFanoutGroup(QString &message);
+
+    // Политика при перегрузке
+    FlowSampler sampler;
+    std::atomic<int> queuedRows;   // Строки, отправленные в GUI, но ещё не обработанные
+    uint64_t lastLoadCheckUs;
+
+    void checkLoad();
 
     static void packetHandler(u_char *userData, const struct pcap_pkthdr *pkthdr, const u_char *packet);
     void processPacket(const pcap_pkthdr *pkthdr, const u_char *packet);
     void onHttpMessage(const StreamKey &key, const std::vector<uint8_t> &data);
+    void onWebSocketFrame(const StreamKey &key, const WebSocketFrame &frame);
+    void onTlsHello(const StreamKey &key, const TlsHello &hello);
+    void onDnsMessage(const UdpDatagram &datagram, const DnsMessage &message,
+                      const DnsTransactionInfo &transaction);
+};
+
+// Поиск интерфейсов вне потока GUI: на хостах с сотнями veth/docker
+// интерфейсов pcap_findalldevs работает заметное время
+class InterfaceScanner : public QThread {
+    Q_OBJECT
+
+public:
+    explicit InterfaceScanner(QObject *parent = nullptr) : QThread(parent) {}
+
+signals:
+    // names и descriptions - параллельные списки; errorMessage пуст при успехе
+    void interfacesFound(const QStringList &names, const QStringList &descriptions,
+                         const QString &errorMessage);
+
+protected:
+    void run() override;
 };
 
 // Главное окно приложения
@@ -85,31 +287,89 @@ public:
     explicit MainWindow(QWidget *parent = nullptr);
     ~MainWindow();
 
+    // Значения из командной строки; заменяют сохранённые настройки на время работы
+    void setSettingOverrides(const QVariantMap &overrides);
+
 private slots:
     void startCapture();
     void stopCapture();
     void refreshInterfaces();
+    void onInterfacesFound(const QStringList &names, const QStringList &descriptions,
+                           const QString &errorMessage);
+    void updateInterfaceRates();
     void showAbout();
     void displaySettings();
     void savePackets();
+    void saveMessageBody();
+    void configureHeaderColumns();
     void clearPackets();
+    void showConversations();
+    void showHttpStatistics();
+    void toggleTracing(bool enabled);
+    void exportTrace();
+    void showTraceSummary();
+    void configureSampling();
+    void configureBypass();
+    void applyLiveSettings();
+    void configureCaptureThreads();
+    void configureExtraInterfaces();
+    void configureRingWriter();
+    void toggleRingWriter(bool enabled);
+    void toggleProcessAttribution(bool enabled);
+    void toggleEventStream(bool enabled);
+    void findNext();
+    void findPrevious();
+    void updateRingStatus();
+    void configureTrigger();
+    void onTriggerFired(const QString &reason, const QString &fileName);
 
     void onPacketCaptured(const QString &protocol,
                           const QString &srcIp, const QString &srcPort,
                           const QString &dstIp, const QString &dstPort,
-                          int dataLength);
+                          int dataLength, int interfaceIndex, quint32 processId);
     void onHttpMessageCaptured(const QString &type,
                                const QString &srcIp, const QString &srcPort,
                                const QString &dstIp, const QString &dstPort,
-                               const QString &info, const QString &headers,
-                               const QString &body);
+                               const QString &info, const QList<quint32> &headerLines,
+                               const QList<quint32> &headerValues,
+                               const QByteArray &body, const QString &transferEncoding,
+                               const QString &contentEncoding, int interfaceIndex, quint32 processId);
+    void onWebSocketFrameCaptured(const QString &srcIp, const QString &srcPort,
+                                  const QString &dstIp, const QString &dstPort,
+                                  const QString &info, qint64 length, const QByteArray &payload,
+                                  int interfaceIndex, quint32 processId);
+    void onTlsHelloCaptured(const QString &type,
+                            const QString &srcIp, const QString &srcPort,
+                            const QString &dstIp, const QString &dstPort,
+                            const QString &info, const QString &serverName, const QString &detailsHtml,
+                            int interfaceIndex, quint32 processId);
+    void onDatagramCaptured(const QString &protocol, const QString &type,
+                            const QString &srcIp, const QString &srcPort,
+                            const QString &dstIp, const QString &dstPort,
+                            int dataLength, const QString &info, const QString &hostName,
+                            const QString &detailsHtml, int interfaceIndex, quint32 processId);
     void onCaptureError(const QString &message);
+    void onCaptureWarning(const QString &message);
     void onStatisticsUpdated(int total, int tcp, int udp, int http);
+    void onSamplingRateChanged(int rate);
+    void onCpuUsageUpdated(double percent);
+    void updateGuiCpuUsage();
     void showPacketDetails(const QModelIndex &index);
 
+    // Декодированное тело HTTP-строки; несколько последних просмотренных
+    // хранятся, чтобы переход между строками не распаковывал тело заново
+    QVariantMap decodedBody(int row);
+    static const int DECODED_BODY_CACHE_SIZE = 8;
+    QHash<int, QVariantMap> decodedBodies;    // Строка модели -> тело и примечание
+    QList<int> decodedBodyOrder;              // Строки кеша, от давних к недавним
+
+    // Заголовки HTTP-строки одним текстом (из интернированных строк)
+    QString headersText(int row) const;
+
 private:
     // Интерфейс
     QComboBox *interfaceCombo;
+    QPushButton *refreshButton;
     QLineEdit *filterEdit;
     QPushButton *startButton;
     QPushButton *stopButton;
@@ -117,15 +377,102 @@ private:
     QTextEdit *detailsText;
     QLabel *statusLabel;
     QLabel *statsLabel;
+    QLabel *samplingLabel;
+    QLabel *cpuLabel;
+    QLabel *ringLabel;
 
     // Модель данных
     QStandardItemModel *packetsModel;
 
-    // Поток захвата
-    CaptureThread *captureThread;
+    // Значения заголовков хранятся один раз, строки ссылаются на них по номеру
+    StringInterner headerInterner;
+    QStringList headerColumns;
+    HeaderColumnsProxyModel *packetsProxy;
+    QLineEdit *headerFilterEdit;
+    void applyHeaderColumns(const QStringList &names);
+
+    // Имя узла (SNI, имя DNS) в столбце Host, чтобы оно искалось вместе с HTTP
+    void setHostColumn(int row, const QString &name);
+
+    // Интерфейсы текущего захвата; номер из сигналов строки - индекс в списке
+    QStringList captureInterfaceNames;
+    void setInterfaceColumn(int row, int interfaceIndex);
+
+    // Процесс-владелец потока (идентификатор в headerInterner)
+    ProcessResolver *processResolver;
+    bool processAttributionEnabled() const;
+    void setProcessColumn(int row, quint32 processId);
+
+    // Разобранные сообщения в общей памяти для внешних программ
+    EventStreamPublisher *eventStream;
+    bool eventStreamEnabled() const;
+
+    // Поиск подстроки в URI, Host и столбцах заголовков HTTP-строк: индекс
+    // триграмм пополняется по мере прихода строк, кандидаты проверяются по тексту
+    TrigramIndex searchIndex;
+    QLineEdit *searchEdit;
+    QString searchQuery;
+    QList<int> searchMatches;       // Строки исходной модели по возрастанию
+    int searchPosition;
+    int searchedRows;               // Строк в таблице на момент поиска
+    void indexHttpRow(int row, const QString &info, const QList<quint32> &headerLines,
+                      const QList<quint32> &headerValues);
+    bool rowMatches(int row, const std::string &query) const;
+    void findMatches(bool typing);
+    void jumpToMatch(int step);
+
+    // Потоки захвата (больше одного - в режиме PACKET_FANOUT)
+    QList<CaptureThread*> captureThreads;
+
+    // Последние значения от каждого потока; в строке состояния - сумма
+    struct CaptureCounters {
+        int total = 0;
+        int tcp = 0;
+        int udp = 0;
+        int http = 0;
+        int samplingRate = 1;
+        double cpuPercent = 0;
+    };
+    QHash<QObject*, CaptureCounters> threadCounters;
+    bool captureErrorShown;
+
+    // Загрузка CPU потоком GUI
+    QElapsedTimer guiCpuClock;
+    uint64_t guiCpuTimeUs;
+    double guiCpuPercent;
+    void showCpuUsage();
+
+    // Настройки с учётом переопределений из командной строки
+    QVariantMap settingOverrides;
+    QVariant setting(const QString &key, const QVariant &defaultValue = QVariant()) const;
+
+    // Непрерывная запись сырых кадров на диск
+    PcapRingWriter *ringWriter;
+
+    // Общий сигнал записи по событию
+    TriggerSignal triggerSignal;
+    bool startRingWriter();
+    void stopRingWriter();
+
+    bool isCapturing() const;
+
+    // Порты обхода, таймаут и предел буфера потока из настроек
+    AssemblerConfig assemblerSettings() const;
+    void createCaptureThreads(int count);
+
+    // Статистика по узлам и диалогам
+    FlowStatistics *flowStats;
+    ConversationsWindow *conversationsWindow;
+
+    // Производительность HTTP по эндпоинтам
+    HttpEndpointStats *httpStats;
+    HttpStatsWindow *httpStatsWindow;
 
     // Список интерфейсов
     QMap<QString, QString> interfaces;
+    InterfaceScanner *interfaceScanner;
+    QString selectedInterface;             // Сохраняется при повторном поиске
+    InterfaceRateMonitor interfaceRates;   // Скорость по счётчикам ядра для подписей списка
 
     // Инициализация UI
     void setupUi();
@@ -133,7 +480,7 @@ private:
     void createMenus();
     void createStatusBar();
 
-    // Загрузка списка интерфейсов
+    // Загрузка списка интерфейсов (асинхронно, результат - onInterfacesFound)
     void loadInterfaces();
 };
 
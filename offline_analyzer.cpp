@@ -0,0 +1,736 @@
+#include "offline_analyzer.h"
+#include "packet_decoder.h"
+#include "ip_defragmenter.h"
+#include "udp_dissector.h"
+#include "dns_parser.h"
+#include "http_parser.h"
+#include "flow_stats.h"
+#include "http_stats.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+const size_t BATCH_FRAMES = 4096;
+const size_t READ_QUEUE_BATCHES = 32;
+const size_t MAX_DECODED_AHEAD = 64;         // Разобранных пачек, ждущих маршрутизатора
+const size_t SHARD_QUEUE_BATCHES = 16;
+const uint32_t MAX_CAPLEN = 256 * 1024;      // Больше - запись повреждена
+const uint64_t CLEANUP_INTERVAL_US = 1000000;
+const uint64_t HTTP_EXPIRE_FRAMES = 10000;    // Как в CaptureThread::processPacket
+const uint64_t HTTP_PENDING_MAX_AGE_US = 300ULL * 1000000;
+
+typedef std::chrono::steady_clock Clock;
+
+double secondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// Имя потока заводит ему буфер трассировки навсегда, а потоки создаются
+// на каждый разбор - поэтому только при включённой трассировке
+void nameThread(const char* name) {
+    if (Tracer::isEnabled()) {
+        Tracer::setThreadName(name);
+    }
+}
+
+// Файл, отображённый в память только для чтения
+class MappedFile {
+public:
+    MappedFile() : data(nullptr), size(0) {
+#ifdef _WIN32
+        file = INVALID_HANDLE_VALUE;
+        mapping = nullptr;
+#endif
+    }
+
+    ~MappedFile() {
+#ifdef _WIN32
+        if (data) UnmapViewOfFile(data);
+        if (mapping) CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+#else
+        if (data) munmap(const_cast<uint8_t*>(data), size);
+#endif
+    }
+
+    bool open(const std::string& fileName, std::string& error) {
+#ifdef _WIN32
+        file = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                           FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        LARGE_INTEGER fileSize;
+        if (file == INVALID_HANDLE_VALUE || !GetFileSizeEx(file, &fileSize)) {
+            error = "не удалось открыть " + fileName;
+            return false;
+        }
+        size = static_cast<size_t>(fileSize.QuadPart);
+        if (size == 0) return true;
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        data = mapping ? static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0)) : nullptr;
+#else
+        int fd = ::open(fileName.c_str(), O_RDONLY);
+        struct stat info;
+        if (fd < 0 || fstat(fd, &info) != 0) {
+            if (fd >= 0) ::close(fd);
+            error = "не удалось открыть " + fileName;
+            return false;
+        }
+        size = static_cast<size_t>(info.st_size);
+        if (size == 0) {
+            ::close(fd);
+            return true;
+        }
+        void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        data = mapped == MAP_FAILED ? nullptr : static_cast<const uint8_t*>(mapped);
+        if (data) {
+            madvise(const_cast<uint8_t*>(data), size, MADV_SEQUENTIAL);
+        }
+#endif
+        if (!data) {
+            error = "не удалось отобразить файл в память: " + fileName;
+            return false;
+        }
+        return true;
+    }
+
+    // Просьба системе прочитать блок заранее (чтение не ждёт разбора)
+    void prefetch(size_t offset, size_t length) const {
+#ifndef _WIN32
+        if (offset >= size) return;
+        long page = sysconf(_SC_PAGESIZE);
+        size_t start = offset - offset % static_cast<size_t>(page);
+        length = std::min(length + (offset - start), size - start);
+        madvise(const_cast<uint8_t*>(data) + start, length, MADV_WILLNEED);
+#else
+        (void)offset;
+        (void)length;
+#endif
+    }
+
+    const uint8_t* data;
+    size_t size;
+
+private:
+#ifdef _WIN32
+    HANDLE file;
+    HANDLE mapping;
+#endif
+};
+
+// Очередь с ограниченной ёмкостью; время ожидания копится в счётчиках
+template <typename T>
+class BlockingQueue {
+public:
+    explicit BlockingQueue(size_t capacity) : capacity(capacity), closed(false) {}
+
+    void push(T item, double& waitSeconds) {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (items.size() >= capacity) {
+            Clock::time_point start = Clock::now();
+            notFull.wait(lock, [this] { return items.size() < capacity; });
+            waitSeconds += secondsSince(start);
+        }
+        items.push_back(std::move(item));
+        notEmpty.notify_one();
+    }
+
+    // false - очередь закрыта и пуста
+    bool pop(T& item, double& waitSeconds) {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (items.empty() && !closed) {
+            Clock::time_point start = Clock::now();
+            notEmpty.wait(lock, [this] { return !items.empty() || closed; });
+            waitSeconds += secondsSince(start);
+        }
+        if (items.empty()) return false;
+        item = std::move(items.front());
+        items.pop_front();
+        notFull.notify_one();
+        return true;
+    }
+
+    void close() {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+        notEmpty.notify_all();
+    }
+
+private:
+    size_t capacity;
+    bool closed;
+    std::deque<T> items;
+    std::mutex mutex;
+    std::condition_variable notEmpty;
+    std::condition_variable notFull;
+};
+
+struct FrameRef {
+    const uint8_t* data;
+    uint32_t caplen;
+    uint32_t len;
+    uint64_t timestampUs;
+};
+
+// Пачка записей файла; после разбора - с заголовками пакетов
+struct Batch {
+    uint64_t index = 0;
+    std::vector<FrameRef> frames;
+    std::vector<DecodedPacket> packets;
+    std::vector<uint8_t> decoded;
+};
+
+// Пакет для сборщика; cleanup - только очистка старых потоков
+struct WorkItem {
+    uint64_t frame;
+    uint64_t timestampUs;
+    bool cleanup;
+    DecodedPacket packet;
+    std::vector<uint8_t> reassembled;   // Нагрузка собранной датаграммы (packet.payload указывает сюда)
+};
+
+typedef std::vector<WorkItem> WorkList;
+
+// Хеш потока, одинаковый для обоих направлений
+uint64_t flowHash(const DecodedPacket& packet) {
+    uint64_t a = (uint64_t(packet.srcIP) << 16) | packet.srcPort;
+    uint64_t b = (uint64_t(packet.dstIP) << 16) | packet.dstPort;
+    if (a > b) std::swap(a, b);
+    uint64_t x = a * 0x9e3779b97f4a7c15ULL ^ (b + packet.protocol);
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+std::string endpoint(uint32_t ip, uint16_t port) {
+    char text[32];
+    snprintf(text, sizeof(text), "%u.%u.%u.%u:%u", ip >> 24, (ip >> 16) & 0xff, (ip >> 8) & 0xff, ip & 0xff, port);
+    return text;
+}
+
+uint32_t fnv1a(const uint8_t* data, size_t size) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ data[i]) * 16777619u;
+    }
+    return hash;
+}
+
+std::string ipText(uint32_t ip) {
+    char text[16];
+    snprintf(text, sizeof(text), "%u.%u.%u.%u", ip >> 24, (ip >> 16) & 0xff, (ip >> 8) & 0xff, ip & 0xff);
+    return text;
+}
+
+// Сборщик одного ядра: свои потоки TCP и таблица запросов DNS
+class Shard {
+public:
+    explicit Shard(const AssemblerConfig& config)
+        : queue(SHARD_QUEUE_BATCHES), waitSeconds(0), frame(0), timestampUs(0),
+          assembler([this](const StreamKey& key, const std::vector<uint8_t>& data) { onMessage(key, data); }) {
+        assembler.setConfig(config);
+        assembler.setWebSocketCallback([this](const StreamKey& key, const WebSocketFrame& wsFrame) {
+            OfflineEvent& event = addEvent(OFFLINE_WEBSOCKET, key, wsFrame.length);
+            char info[64];
+            snprintf(info, sizeof(info), "opcode=%u fin=%d", wsFrame.opcode, wsFrame.fin ? 1 : 0);
+            event.info = info;
+        });
+        assembler.setTlsCallback([this](const StreamKey& key, const TlsHello& hello) {
+            OfflineEvent& event = addEvent(OFFLINE_TLS, key, 0);
+            char version[48];
+            snprintf(version, sizeof(version), " version=%04x cipher=%04x", hello.version, hello.cipherSuite);
+            event.info = (hello.client ? "ClientHello sni=" + hello.serverName : std::string("ServerHello")) + version;
+            event.request = hello.client;
+        });
+        udpDissectors.add(std::unique_ptr<UdpDissector>(new DnsDissector(
+            [this](const UdpDatagram& datagram, const DnsMessage& message, const DnsTransactionInfo& transaction) {
+                onDns(datagram, message, transaction);
+            })), DnsDissector::defaultPorts());
+    }
+
+    void process(const WorkItem& item) {
+        frame = item.frame;
+        timestampUs = item.timestampUs;
+        // Ноль означал бы системные часы
+        assembler.setPacketTime(std::max<time_t>(1, static_cast<time_t>(item.timestampUs / 1000000)));
+
+        if (item.cleanup) {
+            assembler.clearOldStreams();
+            return;
+        }
+
+        const DecodedPacket& packet = item.packet;
+        if (packet.protocol == IP_PROTO_TCP) {
+            if (packet.payloadLength < packet.wirePayloadLength) {
+                assembler.bypassStream(packet.srcIP, packet.dstIP, packet.srcPort, packet.dstPort);
+            } else {
+                assembler.processPacket(packet.srcIP, packet.dstIP, packet.srcPort, packet.dstPort,
+                                        packet.seqNum, packet.payload, packet.payloadLength, packet.tcpFlags);
+            }
+        } else {
+            UdpDatagram datagram{packet.srcIP, packet.dstIP, packet.srcPort, packet.dstPort,
+                                 packet.payload, packet.payloadLength, item.timestampUs};
+            udpDissectors.dissect(datagram);
+        }
+    }
+
+    void run() {
+        nameThread("offline-shard");
+        WorkList items;
+        while (queue.pop(items, waitSeconds)) {
+            TRACE_SCOPE("offline.shard");
+            for (const WorkItem& item : items) {
+                process(item);
+            }
+        }
+    }
+
+    BlockingQueue<WorkList> queue;
+    std::vector<OfflineEvent> events;   // По порядку кадров этого сборщика
+    double waitSeconds;
+
+private:
+    uint64_t frame;                     // Кадр и метка обрабатываемого пакета - для событий
+    uint64_t timestampUs;
+    TCPStreamAssembler assembler;
+    UdpDissectorRegistry udpDissectors;
+
+    OfflineEvent& addEvent(OfflineEventKind kind, const StreamKey& key, uint64_t size) {
+        events.emplace_back();
+        OfflineEvent& event = events.back();
+        event.frame = frame;
+        event.timestampUs = timestampUs;
+        event.kind = kind;
+        event.key = key;
+        event.size = size;
+        return event;
+    }
+
+    void onMessage(const StreamKey& key, const std::vector<uint8_t>& data) {
+        if (!HTTPParser::isHTTP(data.data(), data.size())) {
+            return;   // Как в CaptureThread: выводятся только сообщения HTTP
+        }
+        HTTPMessage message = HTTPParser::parseHTTP(data.data(), data.size());
+
+        OfflineEvent& event = addEvent(OFFLINE_HTTP, key, data.size());
+        const uint8_t* end = std::search(data.data(), data.data() + data.size(), "\r\n", "\r\n" + 2);
+        event.info.assign(data.data(), end);
+        event.digest = fnv1a(data.data(), data.size());
+        event.request = message.isRequest;
+        event.streamId = assembler.messageStreamId();
+        if (message.isRequest) {
+            event.host = HTTPParser::getHeader(message, "Host");
+            event.path = message.uri;
+        } else {
+            event.status = message.statusCode;
+        }
+    }
+
+    void onDns(const UdpDatagram& datagram, const DnsMessage& message, const DnsTransactionInfo& transaction) {
+        StreamKey key{datagram.srcIP, datagram.dstIP, datagram.srcPort, datagram.dstPort};
+        OfflineEvent& event = addEvent(OFFLINE_DNS, key, datagram.length);
+
+        char name[DnsParser::MAX_NAME_LENGTH] = "";
+        if (message.questionCount > 0) {
+            DnsParser::readName(message, message.questionName, name, sizeof(name));
+        }
+        std::string type = DnsParser::typeName(message.questionType);
+        char info[64];
+        snprintf(info, sizeof(info), "id=%04x answers=%u ", message.id, message.answerCount);
+        event.info = info + std::string(message.response ? "ответ " : "запрос ") + type + " " + name;
+        if (message.response) {
+            event.info += " " + DnsParser::rcodeName(message.rcode);
+
+            // Записи ответа с именами - ошибки сжатия имён видны в выводе
+            size_t offset = message.answersOffset;
+            DnsRecord record;
+            char text[DnsParser::MAX_NAME_LENGTH + 32];
+            for (uint16_t i = 0; i < message.answerCount && DnsParser::readRecord(message, offset, record); i++) {
+                if (!DnsParser::readName(message, record.name, text, sizeof(text))) break;
+                event.info += std::string(" | ") + text + " " + DnsParser::typeName(record.type);
+                if (DnsParser::formatData(message, record, text, sizeof(text))) {
+                    event.info += std::string(" ") + text;
+                }
+            }
+            if (transaction.matched) {
+                snprintf(text, sizeof(text), " (%llu мкс)", static_cast<unsigned long long>(transaction.latencyUs));
+                event.info += text;
+            }
+        }
+
+        // Эндпоинт - сервер и тип вопроса, как в CaptureThread::onDnsMessage
+        if (message.opcode == 0 && message.questionCount > 0) {
+            event.host = "DNS " + ipText(message.response ? datagram.srcIP : datagram.dstIP);
+            event.path = type;
+        }
+        event.request = !message.response;
+        event.status = message.rcode;
+        event.matched = transaction.matched;
+        event.latencyUs = transaction.latencyUs;
+    }
+};
+
+} // namespace
+
+OfflineAnalyzer::OfflineAnalyzer(const OfflineOptions& options) : options(options) {
+}
+
+bool OfflineAnalyzer::analyze(const std::string& fileName, OfflineResult& result) {
+    TRACE_SCOPE("offline.analyze");
+    result = OfflineResult();
+    Clock::time_point started = Clock::now();
+
+    MappedFile file;
+    if (!file.open(fileName, result.error)) {
+        return false;
+    }
+    result.fileBytes = file.size;
+
+    // Заголовок pcap: порядок байт и точность меток
+    if (file.size < 24) {
+        result.error = "файл короче заголовка pcap";
+        return false;
+    }
+    uint32_t magic;
+    memcpy(&magic, file.data, 4);
+    bool swapped = magic == 0xd4c3b2a1 || magic == 0x4d3cb2a1;
+    bool nanoseconds = magic == 0xa1b23c4d || magic == 0x4d3cb2a1;
+    if (!swapped && magic != 0xa1b2c3d4 && !nanoseconds) {
+        result.error = "не формат pcap (pcapng не поддерживается)";
+        return false;
+    }
+    auto read32 = [swapped](const uint8_t* p) {
+        uint32_t value;
+        memcpy(&value, p, 4);
+        return swapped ? (value >> 24) | ((value >> 8) & 0xff00) | ((value << 8) & 0xff0000) | (value << 24) : value;
+    };
+    uint32_t linkType = read32(file.data + 20);
+    if (linkType != 1) {
+        result.error = "поддерживается только Ethernet (тип канала " + std::to_string(linkType) + ")";
+        return false;
+    }
+
+    unsigned threads = options.threads != 0 ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+    bool parallel = threads > 1;
+    unsigned decodeThreads = parallel ? std::max(1u, threads / 4) : 0;
+    unsigned shardThreads = parallel ? std::max(1u, threads - 1 - decodeThreads) : 1;
+    result.decodeThreads = std::max(1u, decodeThreads);
+    result.shardThreads = shardThreads;
+
+    std::vector<std::unique_ptr<Shard>> shards;
+    for (unsigned i = 0; i < shardThreads; i++) {
+        shards.emplace_back(new Shard(options.assembler));
+    }
+
+    // Чтение: записи файла по порядку, пачками. Следующий блок файла
+    // запрашивается заранее, пока разбирается текущий
+    size_t position = 24;
+    size_t prefetched = 0;
+    uint64_t batchIndex = 0;
+    bool truncated = false;
+    auto readBatch = [&](Batch& batch) {
+        batch.index = batchIndex++;
+        batch.frames.clear();
+        while (batch.frames.size() < BATCH_FRAMES && position + 16 <= file.size) {
+            if (position + options.blockSize / 2 >= prefetched) {
+                file.prefetch(prefetched, options.blockSize);
+                prefetched += options.blockSize;
+            }
+            const uint8_t* header = file.data + position;
+            uint32_t caplen = read32(header + 8);
+            if (caplen > MAX_CAPLEN || caplen > file.size - position - 16) {
+                truncated = true;   // Обрезанная или повреждённая запись - конец разбора
+                position = file.size;
+                break;
+            }
+            uint32_t fraction = read32(header + 4);
+            FrameRef frame;
+            frame.data = header + 16;
+            frame.caplen = caplen;
+            frame.len = read32(header + 12);
+            frame.timestampUs = uint64_t(read32(header)) * 1000000 + (nanoseconds ? fraction / 1000 : fraction);
+            batch.frames.push_back(frame);
+            position += 16 + caplen;
+        }
+        return !batch.frames.empty();
+    };
+
+    auto decodeBatch = [](Batch& batch) {
+        TRACE_SCOPE("offline.decode");
+        batch.packets.resize(batch.frames.size());
+        batch.decoded.resize(batch.frames.size());
+        for (size_t i = 0; i < batch.frames.size(); i++) {
+            batch.decoded[i] = PacketDecoder::decode(batch.frames[i].data, batch.frames[i].caplen, batch.packets[i]);
+        }
+    };
+
+    // Маршрутизатор: пачки строго по порядку. Сборка фрагментов, статистика
+    // потоков и очистка зависят от порядка кадров - они выполняются здесь
+    IpDefragmenter defragmenter;
+    uint64_t frameNumber = 0;
+    uint64_t lastCleanupUs = 0;
+    std::vector<std::pair<uint64_t, uint64_t>> expireMarks;   // Кадр, метка - очистка ожидающих запросов HTTP
+    std::vector<WorkList> pending(shards.size());
+
+    auto routeBatch = [&](Batch& batch) {
+        TRACE_SCOPE("offline.route");
+        for (size_t i = 0; i < batch.frames.size(); i++) {
+            const FrameRef& frame = batch.frames[i];
+            frameNumber++;
+
+            WorkItem item;
+            item.frame = frameNumber;
+            item.timestampUs = frame.timestampUs;
+            item.cleanup = false;
+            item.packet = batch.packets[i];
+            bool ok = batch.decoded[i] != 0;
+            uint64_t wireLength = frame.len;
+
+            if (ok && item.packet.fragmented) {
+                IpDatagram datagram;
+                ok = defragmenter.addFragment(item.packet, frame.len, frame.timestampUs, datagram);
+                if (ok) {
+                    item.reassembled.assign(datagram.data, datagram.data + datagram.length);
+                    PacketDecoder::decodeTransport(item.reassembled.data(), item.reassembled.size(),
+                                                   item.reassembled.size(), item.packet);
+                    wireLength = datagram.wireBytes;
+                    result.reassembled++;
+                }
+            } else if (!ok) {
+                result.undecoded++;
+            }
+
+            if (ok) {
+                result.decoded++;
+                const DecodedPacket& packet = item.packet;
+                if (options.flowStats) {
+                    options.flowStats->addPacket(packet.srcIP, packet.dstIP, packet.srcPort, packet.dstPort,
+                                                 packet.protocol, wireLength);
+                }
+                bool route = false;
+                if (packet.protocol == IP_PROTO_TCP) {
+                    result.tcpPackets++;
+                    route = true;
+                } else if (packet.protocol == IP_PROTO_UDP) {
+                    result.udpPackets++;
+                    route = packet.wirePayloadLength > 0;
+                }
+                if (route) {
+                    pending[flowHash(packet) % pending.size()].push_back(std::move(item));
+                }
+            }
+
+            // Раз в секунду по меткам пакетов - очистка во всех сборщиках на этом кадре
+            if (frame.timestampUs - lastCleanupUs >= CLEANUP_INTERVAL_US) {
+                lastCleanupUs = frame.timestampUs;
+                for (WorkList& list : pending) {
+                    WorkItem cleanup;
+                    cleanup.frame = frameNumber;
+                    cleanup.timestampUs = frame.timestampUs;
+                    cleanup.cleanup = true;
+                    list.push_back(std::move(cleanup));
+                }
+                defragmenter.expire(frame.timestampUs);
+            }
+            if (frameNumber % HTTP_EXPIRE_FRAMES == 0) {
+                expireMarks.emplace_back(frameNumber, frame.timestampUs);
+            }
+        }
+        result.frames = frameNumber;
+    };
+
+    if (!parallel) {
+        // Один поток: те же шаги подряд - эталон для параллельного разбора
+        Batch batch;
+        while (readBatch(batch)) {
+            decodeBatch(batch);
+            routeBatch(batch);
+            for (WorkItem& item : pending[0]) {
+                shards[0]->process(item);
+            }
+            pending[0].clear();
+        }
+    } else {
+        BlockingQueue<Batch> readQueue(READ_QUEUE_BATCHES);
+        std::mutex decodedMutex;
+        std::condition_variable decodedReady;
+        std::condition_variable routerAdvanced;
+        std::vector<std::unique_ptr<Batch>> decodedBatches(MAX_DECODED_AHEAD);
+        uint64_t nextToRoute = 0;
+        bool decodersDone = false;
+        double readerWait = 0;
+        std::vector<double> decoderWaits(decodeThreads, 0.0);
+
+        std::thread reader([&]() {
+            nameThread("offline-reader");
+            Batch batch;
+            while (readBatch(batch)) {
+                TRACE_SCOPE("offline.read");
+                readQueue.push(std::move(batch), readerWait);
+                batch = Batch();
+            }
+            readQueue.close();
+        });
+
+        std::vector<std::thread> decoders;
+        for (unsigned d = 0; d < decodeThreads; d++) {
+            decoders.emplace_back([&, d]() {
+                nameThread("offline-decoder");
+                Batch batch;
+                while (readQueue.pop(batch, decoderWaits[d])) {
+                    decodeBatch(batch);
+                    std::unique_lock<std::mutex> lock(decodedMutex);
+                    // Пачка со следующим номером проходит всегда - ожидание не зацикливается
+                    routerAdvanced.wait(lock, [&] { return batch.index < nextToRoute + MAX_DECODED_AHEAD; });
+                    decodedBatches[batch.index % MAX_DECODED_AHEAD].reset(new Batch(std::move(batch)));
+                    decodedReady.notify_all();
+                    batch = Batch();
+                }
+            });
+        }
+
+        std::vector<std::thread> workers;
+        for (auto& shard : shards) {
+            workers.emplace_back(&Shard::run, shard.get());
+        }
+
+        // Как только все разборщики закончили, маршрутизатору больше нечего ждать
+        std::thread finisher([&]() {
+            for (std::thread& decoder : decoders) {
+                decoder.join();
+            }
+            std::lock_guard<std::mutex> lock(decodedMutex);
+            decodersDone = true;
+            decodedReady.notify_all();
+        });
+
+        double routerWait = 0;   // Ожидание разборщиков и сборщиков (в итог не входит)
+        for (;;) {
+            std::unique_ptr<Batch> batch;
+            {
+                std::unique_lock<std::mutex> lock(decodedMutex);
+                std::unique_ptr<Batch>& slot = decodedBatches[nextToRoute % MAX_DECODED_AHEAD];
+                if (!slot && !decodersDone) {
+                    Clock::time_point start = Clock::now();
+                    decodedReady.wait(lock, [&] { return slot || decodersDone; });
+                    routerWait += secondsSince(start);
+                }
+                if (!slot) break;
+                batch = std::move(slot);
+                nextToRoute++;
+                routerAdvanced.notify_all();
+            }
+            routeBatch(*batch);
+            for (size_t s = 0; s < shards.size(); s++) {
+                if (!pending[s].empty()) {
+                    shards[s]->queue.push(std::move(pending[s]), routerWait);
+                    pending[s] = WorkList();
+                }
+            }
+        }
+
+        finisher.join();
+        reader.join();
+        for (auto& shard : shards) {
+            shard->queue.close();
+        }
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+
+        // Разборщики ждали чтения - упор в диск; чтение ждало места в очереди - упор в обработку
+        double decoderWait = 0;
+        for (double wait : decoderWaits) {
+            decoderWait += wait;
+        }
+        result.readWaitSeconds = decoderWait / decodeThreads;
+        result.workWaitSeconds = readerWait;
+    }
+
+    result.fragments = defragmenter.stats().fragments;
+
+    // Слияние событий сборщиков по номеру кадра: кадр попадает ровно в один
+    // сборщик, внутри сборщика порядок уже верный
+    {
+        TRACE_SCOPE("offline.merge");
+        size_t total = 0;
+        for (auto& shard : shards) {
+            total += shard->events.size();
+        }
+        result.events.reserve(total);
+        for (auto& shard : shards) {
+            std::move(shard->events.begin(), shard->events.end(), std::back_inserter(result.events));
+            std::vector<OfflineEvent>().swap(shard->events);
+        }
+        std::stable_sort(result.events.begin(), result.events.end(),
+                         [](const OfflineEvent& a, const OfflineEvent& b) { return a.frame < b.frame; });
+    }
+
+    // Статистика эндпоинтов зависит от порядка сообщений - заполняется после слияния
+    if (options.httpStats) {
+        size_t mark = 0;
+        for (const OfflineEvent& event : result.events) {
+            while (mark < expireMarks.size() && expireMarks[mark].first < event.frame) {
+                options.httpStats->expirePending(expireMarks[mark].second, HTTP_PENDING_MAX_AGE_US);
+                mark++;
+            }
+            if (event.kind == OFFLINE_HTTP) {
+                if (event.request) {
+                    options.httpStats->onRequest(event.key, event.host, event.path, event.timestampUs, event.streamId);
+                } else {
+                    options.httpStats->onResponse(event.key, event.status, event.timestampUs, event.streamId);
+                }
+            } else if (event.kind == OFFLINE_DNS && !event.host.empty()) {
+                if (event.request) {
+                    options.httpStats->onMatchedRequest(event.host, event.path);
+                } else if (event.matched) {
+                    bool serverError = event.status == DNS_SERVFAIL || event.status == DNS_NOTIMP;
+                    bool clientError = event.status != DNS_NOERROR && !serverError;
+                    options.httpStats->onMatchedResponse(event.host, event.path, clientError, serverError,
+                                                         event.latencyUs);
+                }
+            }
+        }
+    }
+
+    result.truncated = truncated;
+    result.seconds = secondsSince(started);
+    return true;
+}
+
+std::string OfflineAnalyzer::formatEvent(const OfflineEvent& event) {
+    static const char* const kinds[] = {"http", "ws", "tls", "dns"};
+    char head[64];
+    snprintf(head, sizeof(head), "%llu %llu.%06llu %s ", static_cast<unsigned long long>(event.frame),
+             static_cast<unsigned long long>(event.timestampUs / 1000000),
+             static_cast<unsigned long long>(event.timestampUs % 1000000), kinds[event.kind]);
+    char size[48];
+    if (event.kind == OFFLINE_HTTP) {
+        snprintf(size, sizeof(size), " bytes=%llu fnv=%08x", static_cast<unsigned long long>(event.size), event.digest);
+    } else {
+        snprintf(size, sizeof(size), " bytes=%llu", static_cast<unsigned long long>(event.size));
+    }
+    return head + endpoint(event.key.srcIP, event.key.srcPort) + " > " + endpoint(event.key.dstIP, event.key.dstPort) +
+           " " + event.info + size;
+}
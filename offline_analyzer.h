@@ -0,0 +1,98 @@
+#ifndef OFFLINE_ANALYZER_H
+#define OFFLINE_ANALYZER_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "tcp_stream_assembler.h"
+
+class FlowStatistics;
+class HttpEndpointStats;
+
+// Что разобрано из файла (те же сообщения, что видит CaptureThread)
+enum OfflineEventKind {
+    OFFLINE_HTTP,
+    OFFLINE_WEBSOCKET,
+    OFFLINE_TLS,
+    OFFLINE_DNS
+};
+
+struct OfflineEvent {
+    uint64_t frame;          // Номер кадра в файле (с 1), на котором сообщение собралось
+    uint64_t timestampUs;
+    OfflineEventKind kind;
+    StreamKey key;           // Направление сообщения (для DNS - датаграммы)
+    uint64_t size;           // Байт сообщения, кадра WebSocket или датаграммы
+    std::string info;        // Первая строка HTTP, SNI, вопрос и ответы DNS и т.п.
+    uint32_t digest = 0;     // FNV-1a сообщения HTTP: сообщения с одинаковой первой строкой различимы
+
+    // Для статистики эндпоинтов: HTTP - Host и URI запроса или код ответа;
+    // DNS - сервер, тип вопроса и rcode
+    bool request = false;
+    int status = 0;
+    bool matched = false;    // Ответ DNS сопоставлен с запросом
+    uint32_t streamId = 0;   // Поток HTTP/2 (0 - HTTP/1.x)
+    uint64_t latencyUs = 0;
+    std::string host;
+    std::string path;
+};
+
+struct OfflineOptions {
+    unsigned threads = 0;                  // 0 - по числу ядер; 1 - весь разбор в вызывающем потоке
+    size_t blockSize = 64 * 1024 * 1024;   // Упреждающее чтение файла, байт
+    AssemblerConfig assembler;
+    FlowStatistics* flowStats = nullptr;   // Необязательно: заполняются в порядке кадров
+    HttpEndpointStats* httpStats = nullptr;
+};
+
+struct OfflineResult {
+    std::vector<OfflineEvent> events;      // В порядке кадров, как при разборе в одном потоке
+
+    uint64_t fileBytes = 0;
+    uint64_t frames = 0;
+    uint64_t decoded = 0;
+    uint64_t undecoded = 0;
+    uint64_t tcpPackets = 0;
+    uint64_t udpPackets = 0;
+    uint64_t fragments = 0;
+    uint64_t reassembled = 0;
+    bool truncated = false;                // Последняя запись обрезана или повреждена - разбор до неё
+
+    unsigned decodeThreads = 0;
+    unsigned shardThreads = 0;
+    double seconds = 0;
+    // Ожидание чтения (упор в диск) и ожидание сборщиков (упор в процессор)
+    double readWaitSeconds = 0;
+    double workWaitSeconds = 0;
+
+    std::string error;                     // Непусто, если файл не разобран
+};
+
+// Разбор большого файла pcap на всех ядрах.
+// Поток чтения отображает файл в память и идёт по нему блоками
+// blockSize (упреждающее чтение следующего блока), нарезая записи в пачки.
+// Пачки параллельно разбираются по заголовкам, затем в исходном порядке
+// проходят маршрутизатор: сборка фрагментов IP, статистика потоков и
+// раздача пакетов по хешу потока (одинаковому для обоих направлений)
+// сборщикам TCP и разборщикам DNS - у каждого ядра свои. События сборщиков
+// помечены номером кадра и сливаются по нему, поэтому результат совпадает
+// с threads = 1. Время простоя потоков берётся из меток пакетов, а очистка
+// рассылается всем сборщикам на одних и тех же кадрах.
+// Совпадение точное, пока не переполнены таблицы с общим лимитом (ожидающие
+// запросы DNS у каждого сборщика свои); IPv6 и pcapng не разбираются.
+class OfflineAnalyzer {
+public:
+    explicit OfflineAnalyzer(const OfflineOptions& options);
+
+    bool analyze(const std::string& fileName, OfflineResult& result);
+
+    // Событие одной строкой текста (для вывода и сравнения прогонов)
+    static std::string formatEvent(const OfflineEvent& event);
+
+private:
+    OfflineOptions options;
+};
+
+#endif // OFFLINE_ANALYZER_H
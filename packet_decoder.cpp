@@ -0,0 +1,129 @@
+#include "packet_decoder.h"
+#include "trace.h"
+
+namespace {
+
+const size_t ETHERNET_HEADER_LENGTH = 14;
+const uint16_t ETHERTYPE_IPV4 = 0x0800;
+const uint16_t ETHERTYPE_VLAN = 0x8100;      // 802.1Q
+const uint16_t ETHERTYPE_QINQ = 0x88a8;      // 802.1ad (внешняя метка)
+const size_t VLAN_TAG_LENGTH = 4;
+const int MAX_VLAN_TAGS = 2;
+
+inline uint16_t readU16(const uint8_t* p) {
+    return static_cast<uint16_t>((p[0] << 8) | p[1]);
+}
+
+inline uint32_t readU32(const uint8_t* p) {
+    return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | p[3];
+}
+
+} // namespace
+
+bool PacketDecoder::decode(const uint8_t* data, size_t caplen, DecodedPacket& packet) {
+    TRACE_SCOPE("decode");
+
+    packet.protocol = 0;
+    packet.srcIP = 0;
+    packet.dstIP = 0;
+    packet.srcPort = 0;
+    packet.dstPort = 0;
+    packet.seqNum = 0;
+    packet.tcpFlags = 0;
+    packet.payload = nullptr;
+    packet.payloadLength = 0;
+    packet.wirePayloadLength = 0;
+    packet.fragmented = false;
+    packet.moreFragments = false;
+    packet.ipId = 0;
+    packet.fragmentOffset = 0;
+
+    // Ethernet; метки 802.1Q/802.1ad (до двух) пропускаем
+    if (caplen < ETHERNET_HEADER_LENGTH) return false;
+    size_t headerLength = ETHERNET_HEADER_LENGTH;
+    uint16_t etherType = readU16(data + 12);
+    for (int tags = 0; (etherType == ETHERTYPE_VLAN || etherType == ETHERTYPE_QINQ) && tags < MAX_VLAN_TAGS; tags++) {
+        if (caplen < headerLength + VLAN_TAG_LENGTH) return false;
+        etherType = readU16(data + headerLength + 2);
+        headerLength += VLAN_TAG_LENGTH;
+    }
+    if (etherType != ETHERTYPE_IPV4) return false;
+
+    // IPv4
+    const uint8_t* ip = data + headerLength;
+    size_t available = caplen - headerLength;
+    if (available < 20 || (ip[0] >> 4) != 4) return false;
+
+    size_t ipHeaderLength = (ip[0] & 0x0f) * 4;
+    size_t totalLength = readU16(ip + 2);
+    if (ipHeaderLength < 20 || available < ipHeaderLength || totalLength < ipHeaderLength) return false;
+
+    // Данные за пределами IP-пакета (padding Ethernet) отбрасываем,
+    // обрезанные snaplen - ограничиваем захваченным
+    size_t wireTransportLength = totalLength - ipHeaderLength;
+    if (totalLength < available) available = totalLength;
+
+    packet.protocol = ip[9];
+    packet.srcIP = readU32(ip + 12);
+    packet.dstIP = readU32(ip + 16);
+
+    const uint8_t* transport = ip + ipHeaderLength;
+    size_t transportLength = available - ipHeaderLength;
+
+    // Фрагмент: заголовок транспорта есть только в первом, разбор - после сборки
+    uint16_t fragment = readU16(ip + 6);
+    packet.moreFragments = (fragment & 0x2000) != 0;
+    packet.fragmentOffset = uint32_t(fragment & 0x1fff) * 8;
+    if (packet.moreFragments || packet.fragmentOffset != 0) {
+        packet.fragmented = true;
+        packet.ipId = readU16(ip + 4);
+        packet.payload = transport;
+        packet.payloadLength = transportLength;
+        packet.wirePayloadLength = wireTransportLength;
+        return true;
+    }
+
+    decodeTransport(transport, transportLength, wireTransportLength, packet);
+    return true;
+}
+
+void PacketDecoder::decodeTransport(const uint8_t* transport, size_t transportLength,
+                                    size_t wireTransportLength, DecodedPacket& packet) {
+    packet.srcPort = 0;
+    packet.dstPort = 0;
+    packet.seqNum = 0;
+    packet.tcpFlags = 0;
+    packet.payload = nullptr;
+    packet.payloadLength = 0;
+    packet.wirePayloadLength = 0;
+
+    if (packet.protocol == IP_PROTO_TCP) {
+        if (transportLength < 20) return;
+
+        size_t tcpHeaderLength = (transport[12] >> 4) * 4;
+        if (tcpHeaderLength < 20 || transportLength < tcpHeaderLength) return;
+
+        packet.srcPort = readU16(transport);
+        packet.dstPort = readU16(transport + 2);
+        packet.seqNum = readU32(transport + 4);
+        packet.tcpFlags = transport[13];
+        packet.payload = transport + tcpHeaderLength;
+        packet.payloadLength = transportLength - tcpHeaderLength;
+        packet.wirePayloadLength = wireTransportLength - tcpHeaderLength;
+    } else if (packet.protocol == IP_PROTO_UDP) {
+        if (transportLength < 8) return;
+
+        size_t udpLength = readU16(transport + 4);
+        packet.srcPort = readU16(transport);
+        packet.dstPort = readU16(transport + 2);
+        packet.payload = transport + 8;
+        packet.payloadLength = transportLength - 8;
+        packet.wirePayloadLength = wireTransportLength - 8;
+        if (udpLength >= 8 && udpLength - 8 < packet.wirePayloadLength) {
+            packet.wirePayloadLength = udpLength - 8;
+        }
+        if (packet.wirePayloadLength < packet.payloadLength) {
+            packet.payloadLength = packet.wirePayloadLength;
+        }
+    }
+}
@@ -0,0 +1,56 @@
+#ifndef PACKET_DECODER_H
+#define PACKET_DECODER_H
+
+#include <cstdint>
+#include <cstddef>
+
+// Номера протоколов IP (без зависимости от системных заголовков)
+enum IPProtocol {
+    IP_PROTO_ICMP = 1,
+    IP_PROTO_TCP = 6,
+    IP_PROTO_UDP = 17
+};
+
+// Флаги TCP
+enum TCPFlag {
+    TCP_FLAG_FIN = 0x01,
+    TCP_FLAG_SYN = 0x02,
+    TCP_FLAG_RST = 0x04,
+    TCP_FLAG_PSH = 0x08,
+    TCP_FLAG_ACK = 0x10
+};
+
+// Результат разбора заголовков кадра. Адреса и порты - в порядке хоста,
+// payload указывает внутрь исходного буфера (без копирования).
+// У фрагмента IP транспорт не разбирается: payload - данные фрагмента
+// (в первом фрагменте вместе с заголовком TCP/UDP), порты нулевые.
+struct DecodedPacket {
+    uint8_t protocol;
+    uint32_t srcIP;
+    uint32_t dstIP;
+    uint16_t srcPort;
+    uint16_t dstPort;
+    uint32_t seqNum;        // Только для TCP
+    uint8_t tcpFlags;       // Только для TCP
+    const uint8_t* payload;
+    size_t payloadLength;       // Захваченная часть нагрузки
+    size_t wirePayloadLength;   // Длина нагрузки по заголовкам (больше при обрезке snaplen)
+    bool fragmented;            // Фрагмент IPv4 (MF или ненулевое смещение)
+    bool moreFragments;
+    uint16_t ipId;
+    uint32_t fragmentOffset;    // Смещение фрагмента в байтах
+};
+
+// Разбор заголовков Ethernet (в т.ч. с метками VLAN)/IPv4/TCP/UDP с проверкой границ
+class PacketDecoder {
+public:
+    // Возвращает false, если кадр не является корректным пакетом IPv4
+    static bool decode(const uint8_t* data, size_t caplen, DecodedPacket& packet);
+
+    // Разбор заголовка TCP/UDP (протокол и адреса уже заполнены);
+    // используется и для датаграмм, собранных из фрагментов
+    static void decodeTransport(const uint8_t* transport, size_t transportLength,
+                                size_t wireTransportLength, DecodedPacket& packet);
+};
+
+#endif // PACKET_DECODER_H
@@ -0,0 +1,62 @@
+#include "packet_merger.h"
+
+PacketMerger::PacketMerger(size_t sources, size_t queueBytes, uint64_t maxDelayUs)
+    : heads(sources), hasHead(sources, false), maxDelayUs(maxDelayUs),
+      current(SIZE_MAX), lastTimestampUs(0), lateCount(0) {
+    for (size_t i = 0; i < sources; i++) {
+        queues.emplace_back(new FrameQueue(queueBytes));
+    }
+}
+
+bool PacketMerger::next(QueuedFrame& frame, size_t& source, uint64_t nowUs) {
+    // Источников немного (до десятков), поэтому минимум ищется перебором
+    // закешированных меток: это дешевле кучи и не требует её перестройки
+    size_t best = SIZE_MAX;
+    bool allPresent = true;
+    for (size_t i = 0; i < queues.size(); i++) {
+        if (!hasHead[i]) {
+            hasHead[i] = queues[i]->front(heads[i]);
+        }
+        if (!hasHead[i]) {
+            allPresent = false;
+            continue;
+        }
+        if (best == SIZE_MAX || heads[i].timestampUs < heads[best].timestampUs) {
+            best = i;
+        }
+    }
+    if (best == SIZE_MAX) {
+        return false;
+    }
+
+    const QueuedFrame& candidate = heads[best];
+    if (!allPresent && nowUs != UINT64_MAX && candidate.timestampUs + maxDelayUs > nowUs) {
+        return false;   // Молчащий источник ещё может прислать более ранний пакет
+    }
+
+    if (candidate.timestampUs < lastTimestampUs) {
+        lateCount++;
+    } else {
+        lastTimestampUs = candidate.timestampUs;
+    }
+
+    frame = candidate;
+    source = best;
+    current = best;
+    return true;
+}
+
+void PacketMerger::pop() {
+    if (current == SIZE_MAX) return;
+    queues[current]->pop();
+    hasHead[current] = false;
+    current = SIZE_MAX;
+}
+
+uint64_t PacketMerger::dropped() const {
+    uint64_t total = 0;
+    for (const auto& queue : queues) {
+        total += queue->dropped();
+    }
+    return total;
+}
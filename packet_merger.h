@@ -0,0 +1,52 @@
+#ifndef PACKET_MERGER_H
+#define PACKET_MERGER_H
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "frame_queue.h"
+
+// Слияние пакетов нескольких интерфейсов в одну ленту по меткам времени.
+// У каждого источника своя очередь FrameQueue (один производитель - поток
+// чтения интерфейса, один потребитель - поток разбора), поэтому ни чтение,
+// ни слияние не берут блокировок. Внутри очереди пакеты уже упорядочены,
+// и слияние выбирает наименьшую метку среди первых пакетов очередей.
+// Пакет выдаётся, когда первые пакеты есть во всех очередях (тогда порядок
+// точный) или когда он ждёт дольше maxDelayUs: пустая очередь молчащего
+// интерфейса не задерживает ленту больше чем на это время.
+class PacketMerger {
+public:
+    static constexpr size_t MAX_SOURCES = 64;
+
+    PacketMerger(size_t sources, size_t queueBytes, uint64_t maxDelayUs);
+
+    size_t sourceCount() const { return queues.size(); }
+
+    // Очередь источника - для его потока чтения
+    FrameQueue& queue(size_t source) { return *queues[source]; }
+
+    // Следующий по времени пакет. nowUs - текущее время в тех же единицах,
+    // что и метки пакетов; UINT64_MAX - выдать всё, не дожидаясь остальных
+    // (остановка). false - выдавать пока нечего.
+    bool next(QueuedFrame& frame, size_t& source, uint64_t nowUs);
+
+    // Освобождает пакет, возвращённый next
+    void pop();
+
+    // Пакеты, выданные раньше пакета с меньшей меткой из другой очереди
+    uint64_t lateFrames() const { return lateCount; }
+    uint64_t dropped() const;
+
+private:
+    std::vector<std::unique_ptr<FrameQueue>> queues;
+    std::vector<QueuedFrame> heads;     // Первые пакеты очередей (кеш front)
+    std::vector<bool> hasHead;
+    uint64_t maxDelayUs;
+    size_t current;                      // Источник пакета, выданного next
+    uint64_t lastTimestampUs;
+    uint64_t lateCount;
+};
+
+#endif // PACKET_MERGER_H
@@ -0,0 +1,103 @@
+#include "pcap_file_writer.h"
+#include <cstring>
+
+namespace {
+
+struct PcapFileHeader {
+    uint32_t magic;
+    uint16_t versionMajor;
+    uint16_t versionMinor;
+    int32_t thiszone;
+    uint32_t sigfigs;
+    uint32_t snaplen;
+    uint32_t linkType;
+};
+
+struct PcapRecordHeader {
+    uint32_t seconds;
+    uint32_t microseconds;
+    uint32_t caplen;
+    uint32_t len;
+};
+
+} // namespace
+
+PcapFileWriter::PcapFileWriter()
+    : file(nullptr), written(0), buffer(nullptr), bufferSize(0), bufferUsed(0), failed(false) {
+}
+
+PcapFileWriter::~PcapFileWriter() {
+    close();
+}
+
+bool PcapFileWriter::open(const std::string& fileName, int linkType, uint32_t snaplen, size_t size) {
+    close();
+
+    file = fopen(fileName.c_str(), "wb");
+    if (!file) return false;
+
+    // Буферизация stdio отключена: блоки собираются в собственном буфере
+    setvbuf(file, nullptr, _IONBF, 0);
+    name = fileName;
+    written = 0;
+    failed = false;
+    bufferSize = size > 0 ? size : 1;
+    bufferUsed = 0;
+    buffer = new char[bufferSize];
+
+    // Порядок байт - как у записавшей машины, читатели определяют его по magic
+    PcapFileHeader header{0xa1b2c3d4, 2, 4, 0, 0, snaplen, static_cast<uint32_t>(linkType)};
+    return append(&header, sizeof(header));
+}
+
+bool PcapFileWriter::write(uint64_t timestampUs, uint32_t caplen, uint32_t len, const uint8_t* data) {
+    if (!file) return false;
+
+    PcapRecordHeader header{static_cast<uint32_t>(timestampUs / 1000000),
+                            static_cast<uint32_t>(timestampUs % 1000000), caplen, len};
+    return append(&header, sizeof(header)) && append(data, caplen);
+}
+
+bool PcapFileWriter::append(const void* data, size_t size) {
+    if (failed) return false;
+
+    if (bufferUsed + size > bufferSize) {
+        if (!flush()) return false;
+
+        // Кадр больше буфера пишется напрямую
+        if (size > bufferSize) {
+            if (fwrite(data, 1, size, file) != size) {
+                failed = true;
+                return false;
+            }
+            written += size;
+            return true;
+        }
+    }
+
+    memcpy(buffer + bufferUsed, data, size);
+    bufferUsed += size;
+    written += size;
+    return true;
+}
+
+bool PcapFileWriter::flush() {
+    if (!file || failed) return false;
+    if (bufferUsed > 0 && fwrite(buffer, 1, bufferUsed, file) != bufferUsed) {
+        failed = true;
+        return false;
+    }
+    bufferUsed = 0;
+    return true;
+}
+
+bool PcapFileWriter::close() {
+    if (!file) return true;
+
+    bool ok = flush();
+    ok = fclose(file) == 0 && ok;
+    file = nullptr;
+    delete[] buffer;
+    buffer = nullptr;
+    return ok;
+}
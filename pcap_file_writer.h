@@ -0,0 +1,44 @@
+#ifndef PCAP_FILE_WRITER_H
+#define PCAP_FILE_WRITER_H
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <string>
+
+// Запись кадров в файл формата pcap (микросекундные метки).
+// Пишет через собственный большой буфер, чтобы на диск уходили
+// крупные последовательные блоки.
+class PcapFileWriter {
+public:
+    static const int LINKTYPE_ETHERNET = 1;
+
+    PcapFileWriter();
+    ~PcapFileWriter();
+
+    bool open(const std::string& fileName, int linkType = LINKTYPE_ETHERNET, uint32_t snaplen = 65535,
+              size_t bufferSize = 4 * 1024 * 1024);
+    bool write(uint64_t timestampUs, uint32_t caplen, uint32_t len, const uint8_t* data);
+    bool flush();
+    bool close();
+
+    bool isOpen() const { return file != nullptr; }
+    const std::string& fileName() const { return name; }
+    uint64_t bytesWritten() const { return written; }
+
+private:
+    FILE* file;
+    std::string name;
+    uint64_t written;
+    char* buffer;
+    size_t bufferSize;
+    size_t bufferUsed;
+    bool failed;
+
+    bool append(const void* data, size_t size);
+
+    PcapFileWriter(const PcapFileWriter&) = delete;
+    PcapFileWriter& operator=(const PcapFileWriter&) = delete;
+};
+
+#endif // PCAP_FILE_WRITER_H
@@ -0,0 +1,169 @@
+#include "pcap_ring_writer.h"
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+
+RingWriterOptions::RingWriterOptions()
+    : prefix("capture"), maxFileBytes(100ULL * 1024 * 1024), maxFileSeconds(0), maxFiles(10),
+      queueBytes(64 * 1024 * 1024), snaplen(65535), linkType(PcapFileWriter::LINKTYPE_ETHERNET) {
+}
+
+PcapRingWriter::PcapRingWriter(const RingWriterOptions& options)
+    : options(options), running(false), fileIndex(0), fileStartUs(0),
+      framesWritten(0), bytesWritten(0), filesCreated(0), writeFailed(false) {
+}
+
+PcapRingWriter::~PcapRingWriter() {
+    stop();
+}
+
+FrameQueue* PcapRingWriter::addProducer() {
+    queues.emplace_back(new FrameQueue(options.queueBytes));
+    return queues.back().get();
+}
+
+bool PcapRingWriter::start(std::string& error) {
+    if (running) return true;
+
+    // Первый файл открывается сразу, чтобы ошибка каталога была видна при запуске
+    uint64_t nowUs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+    if (!openNextFile(nowUs)) {
+        error = "Не удалось создать файл " + makeFileName(nowUs);
+        return false;
+    }
+
+    running = true;
+    thread = std::thread(&PcapRingWriter::run, this);
+    return true;
+}
+
+void PcapRingWriter::stop() {
+    if (!running) return;
+
+    running = false;
+    thread.join();
+    writer.close();
+}
+
+RingWriterStats PcapRingWriter::stats() const {
+    RingWriterStats result;
+    result.framesWritten = framesWritten.load(std::memory_order_relaxed);
+    result.bytesWritten = bytesWritten.load(std::memory_order_relaxed);
+    result.filesCreated = filesCreated.load(std::memory_order_relaxed);
+    result.writeFailed = writeFailed.load(std::memory_order_relaxed);
+    result.framesDropped = 0;
+    for (const auto& queue : queues) {
+        result.framesDropped += queue->dropped();
+    }
+
+    std::lock_guard<std::mutex> lock(fileMutex);
+    result.currentFile = currentFile;
+    return result;
+}
+
+void PcapRingWriter::run() {
+    auto lastWrite = std::chrono::steady_clock::now();
+    bool pendingFlush = false;
+
+    while (true) {
+        bool stopping = !running.load(std::memory_order_acquire);
+
+        if (writeNext()) {
+            pendingFlush = true;
+            lastWrite = std::chrono::steady_clock::now();
+            continue;
+        }
+
+        // Очереди пусты: при остановке всё уже записано
+        if (stopping) break;
+
+        // В тишине буфер сбрасывается на диск, чтобы файл не отставал надолго
+        if (pendingFlush && std::chrono::steady_clock::now() - lastWrite > std::chrono::seconds(1)) {
+            writer.flush();
+            pendingFlush = false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+bool PcapRingWriter::writeNext() {
+    // Из голов очередей берётся самый ранний кадр, чтобы файл шёл по времени
+    FrameQueue* source = nullptr;
+    QueuedFrame frame;
+    for (const auto& queue : queues) {
+        QueuedFrame candidate;
+        if (queue->front(candidate) && (!source || candidate.timestampUs < frame.timestampUs)) {
+            source = queue.get();
+            frame = candidate;
+        }
+    }
+    if (!source) return false;
+
+    bool rotateBySize = options.maxFileBytes > 0 && writer.bytesWritten() >= options.maxFileBytes;
+    bool rotateByTime = options.maxFileSeconds > 0 && frame.timestampUs >= fileStartUs &&
+                        frame.timestampUs - fileStartUs >= uint64_t(options.maxFileSeconds) * 1000000;
+    if (!writer.isOpen() || rotateBySize || rotateByTime) {
+        openNextFile(frame.timestampUs);
+    }
+
+    if (writer.isOpen()) {
+        if (writer.write(frame.timestampUs, frame.caplen, frame.len, frame.data)) {
+            framesWritten.fetch_add(1, std::memory_order_relaxed);
+            bytesWritten.fetch_add(frame.caplen + 16, std::memory_order_relaxed);
+        } else {
+            writeFailed = true;
+        }
+    }
+
+    // Кадр освобождается и при ошибке записи, иначе очереди встанут
+    source->pop();
+    return true;
+}
+
+bool PcapRingWriter::openNextFile(uint64_t timestampUs) {
+    if (writer.isOpen() && !writer.close()) {
+        writeFailed = true;
+    }
+
+    std::string fileName = makeFileName(timestampUs);
+    if (!writer.open(fileName, options.linkType, options.snaplen)) {
+        writeFailed = true;
+        return false;
+    }
+
+    fileIndex++;
+    fileStartUs = timestampUs;
+    filesCreated.fetch_add(1, std::memory_order_relaxed);
+    files.push_back(fileName);
+
+    // Старейшие файлы кольца удаляются
+    while (options.maxFiles > 0 && files.size() > options.maxFiles) {
+        std::remove(files.front().c_str());
+        files.pop_front();
+    }
+
+    std::lock_guard<std::mutex> lock(fileMutex);
+    currentFile = fileName;
+    return true;
+}
+
+std::string PcapRingWriter::makeFileName(uint64_t timestampUs) const {
+    // prefix_00001_20240131235959.pcap, как у dumpcap
+    time_t seconds = static_cast<time_t>(timestampUs / 1000000);
+    struct tm local;
+#ifdef _WIN32
+    localtime_s(&local, &seconds);
+#else
+    localtime_r(&seconds, &local);
+#endif
+    char stamp[32];
+    strftime(stamp, sizeof(stamp), "%Y%m%d%H%M%S", &local);
+
+    char index[16];
+    snprintf(index, sizeof(index), "%05llu", static_cast<unsigned long long>(fileIndex + 1));
+
+    std::string path = options.directory;
+    if (!path.empty() && path.back() != '/' && path.back() != '\\') path += '/';
+    return path + options.prefix + "_" + index + "_" + stamp + ".pcap";
+}
@@ -0,0 +1,82 @@
+#ifndef PCAP_RING_WRITER_H
+#define PCAP_RING_WRITER_H
+
+#include <cstdint>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "frame_queue.h"
+#include "pcap_file_writer.h"
+
+// Параметры непрерывной записи (аналог dumpcap -b filesize:...,duration:...,files:...)
+struct RingWriterOptions {
+    std::string directory;
+    std::string prefix;
+    uint64_t maxFileBytes;      // Размер файла до переключения (0 - без ограничения)
+    uint32_t maxFileSeconds;    // Длительность файла по меткам пакетов (0 - без ограничения)
+    uint32_t maxFiles;          // Сколько файлов хранить (0 - все)
+    size_t queueBytes;          // Размер очереди каждого потока захвата
+    uint32_t snaplen;
+    int linkType;               // Тип канала захвата (DLT_*) для заголовка файлов
+
+    RingWriterOptions();
+};
+
+struct RingWriterStats {
+    uint64_t framesWritten;
+    uint64_t bytesWritten;
+    uint64_t framesDropped;     // Отброшено из-за переполнения очередей
+    uint64_t filesCreated;
+    bool writeFailed;
+    std::string currentFile;
+};
+
+// Запись сырых кадров в кольцо файлов pcap в отдельном потоке ввода-вывода.
+// Каждый поток захвата получает свою очередь FrameQueue и только копирует
+// в неё кадры; на диске запись идёт крупными блоками, старые файлы удаляются.
+class PcapRingWriter {
+public:
+    explicit PcapRingWriter(const RingWriterOptions& options);
+    ~PcapRingWriter();
+
+    // Очередь для одного потока захвата; вызывается до start()
+    FrameQueue* addProducer();
+
+    // Открывает первый файл и запускает поток записи
+    bool start(std::string& error);
+
+    // Дописывает всё, что осталось в очередях, и закрывает файл
+    void stop();
+
+    RingWriterStats stats() const;
+
+private:
+    RingWriterOptions options;
+    std::vector<std::unique_ptr<FrameQueue>> queues;
+    std::thread thread;
+    std::atomic<bool> running;
+
+    PcapFileWriter writer;
+    std::deque<std::string> files;       // Файлы кольца, от старых к новым
+    uint64_t fileIndex;
+    uint64_t fileStartUs;
+
+    std::atomic<uint64_t> framesWritten;
+    std::atomic<uint64_t> bytesWritten;
+    std::atomic<uint64_t> filesCreated;
+    std::atomic<bool> writeFailed;
+    mutable std::mutex fileMutex;
+    std::string currentFile;
+
+    void run();
+    bool writeNext();
+    bool openNextFile(uint64_t timestampUs);
+    std::string makeFileName(uint64_t timestampUs) const;
+};
+
+#endif // PCAP_RING_WRITER_H
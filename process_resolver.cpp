@@ -0,0 +1,397 @@
+#include "process_resolver.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unordered_set>
+
+#ifdef __linux__
+#include <dirent.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// Таблица сокетов и её формат
+struct SocketTable {
+    const char* path;
+    uint8_t protocol;
+    bool ipv6;
+};
+
+const SocketTable TABLES[] = {
+    {"/proc/net/tcp", 6, false},
+    {"/proc/net/tcp6", 6, true},
+    {"/proc/net/udp", 17, false},
+    {"/proc/net/udp6", 17, true},
+};
+
+// Ядро печатает адрес как число в порядке байт узла (%08X от __be32),
+// поэтому байты этого числа в памяти - адрес в сетевом порядке
+uint32_t parseWord(const char* hex) {
+    char digits[9];
+    memcpy(digits, hex, 8);
+    digits[8] = '\0';
+    uint32_t raw = static_cast<uint32_t>(strtoul(digits, nullptr, 16));
+    uint8_t bytes[4];
+    memcpy(bytes, &raw, 4);
+    return (uint32_t(bytes[0]) << 24) | (uint32_t(bytes[1]) << 16) | (uint32_t(bytes[2]) << 8) | bytes[3];
+}
+
+bool isHex(const std::string& text, size_t from, size_t count) {
+    if (from + count > text.size()) return false;
+    for (size_t i = from; i < from + count; i++) {
+        if (!isxdigit(static_cast<unsigned char>(text[i]))) return false;
+    }
+    return true;
+}
+
+// "0100007F:0050" или 32 цифры IPv6 и порт; false - формат не распознан,
+// mapped = false - адрес IPv6 без IPv4 (такие сокеты пропускаются)
+bool parseAddress(const std::string& token, bool ipv6, uint32_t& ip, uint16_t& port, bool& mapped) {
+    size_t digits = ipv6 ? 32 : 8;
+    if (token.size() != digits + 5 || token[digits] != ':' || !isHex(token, 0, digits) ||
+        !isHex(token, digits + 1, 4)) {
+        return false;
+    }
+    port = static_cast<uint16_t>(strtoul(token.c_str() + digits + 1, nullptr, 16));
+
+    mapped = true;
+    if (!ipv6) {
+        ip = parseWord(token.c_str());
+        return true;
+    }
+
+    uint32_t words[4];
+    for (int i = 0; i < 4; i++) {
+        words[i] = parseWord(token.c_str() + i * 8);
+    }
+    if (words[0] == 0 && words[1] == 0 && words[2] == 0 && words[3] == 0) {
+        ip = 0;                                 // :: - любой адрес, в том числе IPv4
+    } else if (words[0] == 0 && words[1] == 0 && words[2] == 0x0000ffff) {
+        ip = words[3];                          // ::ffff:a.b.c.d
+    } else {
+        mapped = false;
+    }
+    return true;
+}
+
+} // namespace
+
+size_t ProcessSnapshot::KeyHash::operator()(const Key& key) const {
+    uint64_t a = (uint64_t(key.localIP) << 32) | key.remoteIP;
+    uint64_t b = (uint64_t(key.localPort) << 24) | (uint64_t(key.remotePort) << 8) | key.protocol;
+    uint64_t hash = (a * 0x9e3779b97f4a7c15ULL) ^ (b * 0xc2b2ae3d27d4eb4fULL);
+    return static_cast<size_t>(hash ^ (hash >> 32));
+}
+
+uint32_t ProcessSnapshot::findConnected(uint8_t protocol, uint32_t localIP, uint16_t localPort,
+                                        uint32_t remoteIP, uint16_t remotePort) const {
+    auto it = connected.find(Key{localIP, remoteIP, localPort, remotePort, protocol});
+    return it != connected.end() ? it->second : NOT_FOUND;
+}
+
+uint32_t ProcessSnapshot::findBound(uint8_t protocol, uint32_t localIP, uint16_t localPort) const {
+    auto it = bound.find(Key{localIP, 0, localPort, 0, protocol});
+    if (it == bound.end()) {
+        it = bound.find(Key{0, 0, localPort, 0, protocol});     // Сокет на 0.0.0.0
+    }
+    return it != bound.end() ? it->second : NOT_FOUND;
+}
+
+uint32_t ProcessSnapshot::find(uint8_t protocol, uint32_t srcIP, uint16_t srcPort,
+                               uint32_t dstIP, uint16_t dstPort) const {
+    if (connected.empty() && bound.empty()) return NOT_FOUND;
+
+    // Соединённый сокет точнее слушающего: принятые соединения сервера
+    // имеют свой сокет с полным кортежем
+    uint32_t index = findConnected(protocol, srcIP, srcPort, dstIP, dstPort);
+    if (index == NOT_FOUND) index = findConnected(protocol, dstIP, dstPort, srcIP, srcPort);
+    if (index == NOT_FOUND) index = findBound(protocol, srcIP, srcPort);
+    if (index == NOT_FOUND) index = findBound(protocol, dstIP, dstPort);
+    return index;
+}
+
+bool ProcessResolver::isSupported() {
+#ifdef __linux__
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool ProcessResolver::parseSocketTable(const std::string& text, uint8_t protocol, bool ipv6,
+                                       std::vector<SocketEntry>& entries) {
+    // Строка заголовка, затем "  sl local rem st tx:rx tr:when retrnsmt uid timeout inode ..."
+    size_t pos = text.find('\n');
+    if (pos == std::string::npos) return false;
+    pos++;
+
+    std::string tokens[10];
+    while (pos < text.size()) {
+        size_t end = text.find('\n', pos);
+        if (end == std::string::npos) end = text.size();
+
+        size_t count = 0;
+        size_t cursor = pos;
+        while (count < 10) {
+            cursor = text.find_first_not_of(' ', cursor);
+            if (cursor == std::string::npos || cursor >= end) break;
+            size_t tokenEnd = std::min(text.find(' ', cursor), end);
+            tokens[count++].assign(text, cursor, tokenEnd - cursor);
+            cursor = tokenEnd;
+        }
+        pos = end + 1;
+        if (count == 0) continue;
+        if (count < 10) return false;
+
+        SocketEntry entry;
+        bool localMapped = false;
+        bool remoteMapped = false;
+        if (!parseAddress(tokens[1], ipv6, entry.localIP, entry.localPort, localMapped) ||
+            !parseAddress(tokens[2], ipv6, entry.remoteIP, entry.remotePort, remoteMapped)) {
+            return false;
+        }
+        char* rest = nullptr;
+        entry.inode = strtoull(tokens[9].c_str(), &rest, 10);
+        if (*rest != '\0') return false;
+
+        // Inode 0 - сокет уже без владельца (TIME_WAIT)
+        if (!localMapped || !remoteMapped || entry.inode == 0) continue;
+        entry.protocol = protocol;
+        entries.push_back(entry);
+    }
+    return true;
+}
+
+ProcessResolver::ProcessResolver(uint64_t refreshUs, uint64_t ttlUs)
+    : refreshUs(refreshUs), ttlUs(ttlUs), stopping(false), snapshotGeneration(0), scanCount(0) {
+}
+
+ProcessResolver::~ProcessResolver() {
+    stop();
+}
+
+void ProcessResolver::start() {
+    if (thread.joinable() || !isSupported()) return;
+    stopping = false;
+    thread = std::thread(&ProcessResolver::run, this);
+}
+
+void ProcessResolver::stop() {
+    if (!thread.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(waitMutex);
+        stopping = true;
+    }
+    wakeUp.notify_all();
+    thread.join();
+}
+
+std::shared_ptr<const ProcessSnapshot> ProcessResolver::snapshot() const {
+    std::lock_guard<std::mutex> lock(snapshotMutex);
+    return current;
+}
+
+void ProcessResolver::run() {
+    std::unique_lock<std::mutex> lock(waitMutex);
+    while (!stopping) {
+        lock.unlock();
+        uint64_t nowUs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+        refresh(nowUs);
+        lock.lock();
+        wakeUp.wait_for(lock, std::chrono::microseconds(refreshUs), [this] { return stopping; });
+    }
+}
+
+bool ProcessResolver::readFile(const char* path) {
+    text.clear();
+    FILE* file = fopen(path, "r");
+    if (!file) return false;
+    char chunk[16384];
+    size_t read;
+    while ((read = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+        text.append(chunk, read);
+    }
+    fclose(file);
+    return true;
+}
+
+bool ProcessResolver::readTables(uint64_t nowUs) {
+    bool changed = false;
+    for (const SocketTable& table : TABLES) {
+        entries.clear();
+        // Нет IPv6 в ядре - нет и файлов tcp6/udp6
+        if (!readFile(table.path) || !parseSocketTable(text, table.protocol, table.ipv6, entries)) {
+            continue;
+        }
+        for (const SocketEntry& entry : entries) {
+            ProcessSnapshot::Key key{entry.localIP, entry.remoteIP, entry.localPort, entry.remotePort,
+                                     entry.protocol};
+            auto inserted = sockets.emplace(key, SocketState{entry, nowUs});
+            SocketState& state = inserted.first->second;
+            if (!inserted.second) {
+                changed |= state.entry.inode != entry.inode;
+                state.entry = entry;
+                state.lastSeenUs = nowUs;
+            }
+            changed |= inserted.second;
+        }
+    }
+
+    // Закрытые сокеты удаляются не сразу: пакеты закрытия ещё в пути
+    for (auto it = sockets.begin(); it != sockets.end();) {
+        if (it->second.lastSeenUs + ttlUs < nowUs) {
+            it = sockets.erase(it);
+            changed = true;
+        } else {
+            ++it;
+        }
+    }
+    return changed;
+}
+
+const ProcessInfo* ProcessResolver::processInfo(int pid) {
+#ifdef __linux__
+    // Имя перечитывается при каждом обнаружении: номер мог достаться новому процессу
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/comm", pid);
+    if (!readFile(path)) return nullptr;
+    while (!text.empty() && (text.back() == '\n' || text.back() == '\r')) {
+        text.pop_back();
+    }
+
+    ProcessInfo& info = processes[pid];
+    info.pid = pid;
+    info.command = text;
+    info.label = text + " (" + std::to_string(pid) + ")";
+    return &info;
+#else
+    (void)pid;
+    return nullptr;
+#endif
+}
+
+void ProcessResolver::scanProcesses(std::vector<uint64_t>& unknown, uint64_t nowUs) {
+#ifdef __linux__
+    scanCount.fetch_add(1, std::memory_order_relaxed);
+    std::unordered_set<uint64_t> remaining(unknown.begin(), unknown.end());
+
+    // Сначала процессы, у которых уже есть сокеты: новые соединения чаще
+    // всего открывают они же, и весь /proc обходить не придётся
+    std::vector<int> order;
+    order.reserve(processes.size());
+    for (const auto& process : processes) {
+        order.push_back(process.first);
+    }
+
+    DIR* proc = opendir("/proc");
+    if (proc) {
+        while (dirent* entry = readdir(proc)) {
+            char* rest = nullptr;
+            long pid = strtol(entry->d_name, &rest, 10);
+            if (*rest == '\0' && pid > 0 && !processes.count(static_cast<int>(pid))) {
+                order.push_back(static_cast<int>(pid));
+            }
+        }
+        closedir(proc);
+    }
+
+    char path[300];     // Имя записи в fd - до 255 символов
+    char link[64];
+    for (size_t i = 0; i < order.size() && !remaining.empty(); i++) {
+        int pid = order[i];
+        snprintf(path, sizeof(path), "/proc/%d/fd", pid);
+        DIR* fds = opendir(path);
+        if (!fds) continue;   // Процесс завершился или нет прав
+
+        bool found = false;
+        while (dirent* entry = readdir(fds)) {
+            if (entry->d_name[0] == '.') continue;
+            snprintf(path, sizeof(path), "/proc/%d/fd/%s", pid, entry->d_name);
+            ssize_t length = readlink(path, link, sizeof(link) - 1);
+            if (length <= 8 || memcmp(link, "socket:[", 8) != 0) continue;
+            link[length] = '\0';
+
+            uint64_t inode = strtoull(link + 8, nullptr, 10);
+            if (remaining.erase(inode)) {
+                owners[inode] = Owner{pid, nowUs};
+                found = true;
+            }
+        }
+        closedir(fds);
+
+        if (found) {
+            processInfo(pid);
+        }
+    }
+#else
+    (void)nowUs;
+#endif
+
+    // Не найденные ищутся снова только после ttlUs
+    for (uint64_t inode : remaining) {
+        owners[inode] = Owner{0, nowUs};
+    }
+    unknown.clear();
+}
+
+void ProcessResolver::refresh(uint64_t nowUs) {
+    bool changed = readTables(nowUs) || !current;
+
+    std::vector<uint64_t> unknown;
+    for (const auto& socket : sockets) {
+        if (socket.second.lastSeenUs != nowUs) continue;
+        auto owner = owners.find(socket.second.entry.inode);
+        if (owner == owners.end() || (owner->second.pid == 0 && owner->second.checkedUs + ttlUs < nowUs)) {
+            unknown.push_back(socket.second.entry.inode);
+        }
+    }
+    if (!unknown.empty()) {
+        scanProcesses(unknown, nowUs);
+        changed = true;
+    }
+
+    if (changed) {
+        publish();
+    }
+}
+
+void ProcessResolver::publish() {
+    std::shared_ptr<ProcessSnapshot> snapshot = std::make_shared<ProcessSnapshot>();
+    std::unordered_set<uint64_t> liveInodes;
+    std::unordered_map<int, uint32_t> indexes;
+
+    for (const auto& socket : sockets) {
+        const SocketEntry& entry = socket.second.entry;
+        liveInodes.insert(entry.inode);
+        auto owner = owners.find(entry.inode);
+        if (owner == owners.end() || owner->second.pid == 0) continue;
+        auto process = processes.find(owner->second.pid);
+        if (process == processes.end()) continue;
+
+        auto index = indexes.emplace(process->first, static_cast<uint32_t>(snapshot->processes.size()));
+        if (index.second) {
+            snapshot->processes.push_back(process->second);
+        }
+        if (entry.remoteIP == 0 && entry.remotePort == 0) {
+            snapshot->bound[socket.first] = index.first->second;
+        } else {
+            snapshot->connected[socket.first] = index.first->second;
+        }
+    }
+
+    // Владельцы исчезнувших сокетов и процессы без сокетов больше не нужны
+    for (auto it = owners.begin(); it != owners.end();) {
+        it = liveInodes.count(it->first) ? std::next(it) : owners.erase(it);
+    }
+    for (auto it = processes.begin(); it != processes.end();) {
+        it = indexes.count(it->first) ? std::next(it) : processes.erase(it);
+    }
+
+    std::lock_guard<std::mutex> lock(snapshotMutex);
+    current = snapshot;
+    snapshotGeneration.fetch_add(1, std::memory_order_release);
+}
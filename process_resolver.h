@@ -0,0 +1,150 @@
+#ifndef PROCESS_RESOLVER_H
+#define PROCESS_RESOLVER_H
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Локальный процесс - владелец сокета
+struct ProcessInfo {
+    int pid = 0;
+    std::string command;    // /proc/<pid>/comm
+    std::string label;      // "nginx (1234)" - для столбца таблицы
+};
+
+// Строка таблицы сокетов /proc/net/{tcp,udp}[6]; адреса в порядке узла,
+// как в DecodedPacket. Из таблиц IPv6 берутся только сокеты, видящие IPv4
+// (адреса ::ffff:a.b.c.d и :: при двойном стеке)
+struct SocketEntry {
+    uint8_t protocol;       // 6 - TCP, 17 - UDP
+    uint32_t localIP;
+    uint16_t localPort;
+    uint32_t remoteIP;      // 0 - сокет не соединён (слушающий, UDP без connect)
+    uint16_t remotePort;
+    uint64_t inode;
+};
+
+// Снимок соответствия сокетов процессам. Неизменяем: поток захвата держит
+// его у себя и ищет без блокировок, пока не появится следующий
+class ProcessSnapshot {
+public:
+    static constexpr uint32_t NOT_FOUND = UINT32_MAX;
+
+    // Номер процесса любого из концов потока (локальным может быть
+    // отправитель или получатель); NOT_FOUND - не найден
+    uint32_t find(uint8_t protocol, uint32_t srcIP, uint16_t srcPort,
+                  uint32_t dstIP, uint16_t dstPort) const;
+
+    // Номера процессов - от 0 до processCount() - 1
+    size_t processCount() const { return processes.size(); }
+    const ProcessInfo& process(uint32_t index) const { return processes[index]; }
+
+    size_t size() const { return connected.size() + bound.size(); }
+
+private:
+    friend class ProcessResolver;
+
+    struct Key {
+        uint32_t localIP;
+        uint32_t remoteIP;
+        uint16_t localPort;
+        uint16_t remotePort;
+        uint8_t protocol;
+
+        bool operator==(const Key& other) const {
+            return localIP == other.localIP && remoteIP == other.remoteIP && localPort == other.localPort &&
+                   remotePort == other.remotePort && protocol == other.protocol;
+        }
+    };
+    struct KeyHash {
+        size_t operator()(const Key& key) const;
+    };
+
+    std::vector<ProcessInfo> processes;
+    std::unordered_map<Key, uint32_t, KeyHash> connected;   // Полный кортеж -> номер в processes
+    std::unordered_map<Key, uint32_t, KeyHash> bound;       // Только локальный конец (удалённый 0)
+
+    uint32_t findConnected(uint8_t protocol, uint32_t localIP, uint16_t localPort,
+                           uint32_t remoteIP, uint16_t remotePort) const;
+    uint32_t findBound(uint8_t protocol, uint32_t localIP, uint16_t localPort) const;
+};
+
+// Определение процессов для потоков (аналог ss -p). Фоновый поток раз в
+// refreshUs читает таблицы сокетов /proc/net и по номерам inode находит
+// владельцев в /proc/*/fd. Обход /proc/*/fd дорогой, поэтому он идёт
+// только при появлении неизвестных inode и заканчивается, как только все
+// они найдены; ненайденные (чужое пространство имён, нет прав) повторно
+// ищутся не раньше чем через ttlUs. Закрытые сокеты остаются в снимке ещё
+// ttlUs - последние пакеты соединения тоже получают процесс.
+// Поток захвата только сверяет generation() и берёт новый snapshot();
+// к /proc он не обращается.
+class ProcessResolver {
+public:
+    static bool isSupported();
+
+    // Разбор текста /proc/net/tcp, udp, tcp6 или udp6; false - формат не распознан
+    static bool parseSocketTable(const std::string& text, uint8_t protocol, bool ipv6,
+                                 std::vector<SocketEntry>& entries);
+
+    explicit ProcessResolver(uint64_t refreshUs = 500000, uint64_t ttlUs = 10ULL * 1000000);
+    ~ProcessResolver();
+
+    void start();
+    void stop();
+    bool isRunning() const { return thread.joinable(); }
+
+    // Меняется с каждым новым снимком; проверка дешёвая, на каждый пакет
+    uint64_t generation() const { return snapshotGeneration.load(std::memory_order_acquire); }
+    std::shared_ptr<const ProcessSnapshot> snapshot() const;
+
+    // Один проход обновления (вызывается фоновым потоком)
+    void refresh(uint64_t nowUs);
+
+    uint64_t fdScans() const { return scanCount.load(std::memory_order_relaxed); }
+
+private:
+    struct SocketState {
+        SocketEntry entry;
+        uint64_t lastSeenUs;
+    };
+    struct Owner {
+        int pid;                // 0 - владелец не найден (повторить после ttlUs)
+        uint64_t checkedUs;
+    };
+
+    uint64_t refreshUs;
+    uint64_t ttlUs;
+
+    // Состояние фонового потока
+    std::unordered_map<ProcessSnapshot::Key, SocketState, ProcessSnapshot::KeyHash> sockets;
+    std::unordered_map<uint64_t, Owner> owners;             // inode -> процесс
+    std::unordered_map<int, ProcessInfo> processes;         // pid -> имя
+    std::vector<SocketEntry> entries;                       // Буфер разбора таблиц
+    std::string text;                                       // Буфер чтения файла
+
+    std::thread thread;
+    bool stopping;
+    std::mutex waitMutex;
+    std::condition_variable wakeUp;
+
+    mutable std::mutex snapshotMutex;
+    std::shared_ptr<const ProcessSnapshot> current;
+    std::atomic<uint64_t> snapshotGeneration;
+    std::atomic<uint64_t> scanCount;
+
+    void run();
+    bool readFile(const char* path);
+    bool readTables(uint64_t nowUs);
+    void scanProcesses(std::vector<uint64_t>& unknown, uint64_t nowUs);
+    const ProcessInfo* processInfo(int pid);
+    void publish();
+};
+
+#endif // PROCESS_RESOLVER_H
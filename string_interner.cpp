@@ -0,0 +1,76 @@
+#include "string_interner.h"
+
+StringInterner::StringInterner() : count(0), valueBytes(0) {
+    for (uint32_t i = 0; i < MAX_BLOCKS; i++) {
+        blocks[i] = nullptr;
+    }
+    intern(std::string_view());
+}
+
+StringInterner::~StringInterner() {
+    for (uint32_t i = 0; i < MAX_BLOCKS; i++) {
+        delete[] blocks[i];
+    }
+}
+
+uint32_t StringInterner::intern(std::string_view text) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    // Уже известное значение находится без выделения памяти
+    auto found = index.find(text);
+    if (found != index.end()) {
+        return found->second;
+    }
+
+    uint32_t id = count.load(std::memory_order_relaxed);
+    uint32_t block = id >> BLOCK_BITS;
+    if (block >= MAX_BLOCKS) {
+        return EMPTY_ID;
+    }
+    if (!blocks[block]) {
+        blocks[block] = new std::string[BLOCK_SIZE];
+    }
+
+    std::string& stored = blocks[block][id & (BLOCK_SIZE - 1)];
+    stored.assign(text.data(), text.size());
+    valueBytes += stored.capacity();
+    index.emplace(std::string_view(stored), id);
+
+    // Публикуем значение для читателей
+    count.store(id + 1, std::memory_order_release);
+    return id;
+}
+
+const std::string& StringInterner::value(uint32_t id) const {
+    // Идентификатор мог остаться от таблицы до clear()
+    if (id >= count.load(std::memory_order_acquire)) {
+        return blocks[0][EMPTY_ID];
+    }
+    return blocks[id >> BLOCK_BITS][id & (BLOCK_SIZE - 1)];
+}
+
+size_t StringInterner::memoryUsage() const {
+    uint32_t values = count.load(std::memory_order_acquire);
+    size_t allocatedBlocks = (values + BLOCK_SIZE - 1) / BLOCK_SIZE;
+
+    // Узел хеш-таблицы: ключ, значение, указатель и хеш
+    return sizeof(*this) + allocatedBlocks * BLOCK_SIZE * sizeof(std::string) +
+           values * (sizeof(std::string_view) + 2 * sizeof(void*) + sizeof(size_t) + sizeof(uint32_t)) +
+           valueBytes;
+}
+
+void StringInterner::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    index.clear();
+    for (uint32_t i = 1; i < MAX_BLOCKS; i++) {
+        delete[] blocks[i];
+        blocks[i] = nullptr;
+    }
+    for (uint32_t i = 1; i < BLOCK_SIZE; i++) {
+        std::string().swap(blocks[0][i]);
+    }
+    valueBytes = 0;
+
+    index.emplace(std::string_view(blocks[0][EMPTY_ID]), EMPTY_ID);
+    count.store(1, std::memory_order_release);
+}
@@ -0,0 +1,54 @@
+#ifndef STRING_INTERNER_H
+#define STRING_INTERNER_H
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// Таблица интернирования строк: каждое различное значение хранится один
+// раз, а строки таблицы ссылаются на него 32-битным идентификатором.
+// intern() вызывают потоки захвата (под мьютексом; память выделяется
+// только для нового значения), value() - GUI без блокировок: значения
+// лежат в блоках, которые после создания не перемещаются.
+class StringInterner {
+public:
+    // Идентификатор пустой строки (и отсутствующего значения)
+    static constexpr uint32_t EMPTY_ID = 0;
+
+    StringInterner();
+    ~StringInterner();
+
+    StringInterner(const StringInterner&) = delete;
+    StringInterner& operator=(const StringInterner&) = delete;
+
+    // Возвращает идентификатор значения; EMPTY_ID, если таблица заполнена
+    uint32_t intern(std::string_view text);
+
+    // Значение по идентификатору, полученному от intern()
+    const std::string& value(uint32_t id) const;
+
+    size_t size() const { return count.load(std::memory_order_acquire); }
+
+    // Приблизительный объём памяти таблицы, байт
+    size_t memoryUsage() const;
+
+    // Удаляет все значения. Нельзя вызывать, пока работают потоки захвата
+    void clear();
+
+private:
+    static const uint32_t BLOCK_BITS = 12;
+    static const uint32_t BLOCK_SIZE = 1u << BLOCK_BITS;
+    static const uint32_t MAX_BLOCKS = 16384;   // До 67 млн значений
+
+    std::mutex mutex;
+    std::unordered_map<std::string_view, uint32_t> index;   // Ключи ссылаются на значения в blocks
+    std::string* blocks[MAX_BLOCKS];
+    std::atomic<uint32_t> count;
+    size_t valueBytes;
+};
+
+#endif // STRING_INTERNER_H
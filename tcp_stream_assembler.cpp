@@ -1,119 +1,492 @@
 #include "tcp_stream_assembler.h"
+#include "packet_decoder.h"
+#include "http_body_decoder.h"
+#include "trace.h"
+#include <cctype>
 #include <cstring>
 #include <algorithm>
 
 TCPStreamAssembler::TCPStreamAssembler(CompleteMessageCallback callback)
-    : messageCallback(callback) {
+    : messageCallback(callback), bypassedPacketCount(0), bypassedByteCount(0), webSocketFrameCount(0),
+      tlsHelloCount(0), http2MessageCount(0), messageStream(0), packetTime(0) {
+}
+
+void TCPStreamAssembler::setConfig(const AssemblerConfig& newConfig) {
+    config = newConfig;
+
+    // Поток, исключённый раньше, собрать уже нельзя: снятие порта
+    // с обхода действует только на новые соединения
+    for (auto& entry : streams) {
+        const StreamKey& key = entry.first;
+        if (entry.second.mode != STREAM_BYPASS &&
+            (config.isBypassPort(key.srcPort) || config.isBypassPort(key.dstPort))) {
+            markBypass(entry.second);
+        }
+    }
+}
+
+void TCPStreamAssembler::setWebSocketCallback(WebSocketFrameCallback callback) {
+    webSocketCallback = callback;
+}
+
+void TCPStreamAssembler::setTlsCallback(TlsHelloCallback callback) {
+    tlsCallback = callback;
 }
 
 void TCPStreamAssembler::processPacket(uint32_t srcIP, uint32_t dstIP, uint16_t srcPort, uint16_t dstPort,
-                                       uint32_t seqNum, const uint8_t* data, size_t length) {
-    if (length == 0) return;
+                                       uint32_t seqNum, const uint8_t* data, size_t length, uint8_t tcpFlags) {
+    bool syn = (tcpFlags & TCP_FLAG_SYN) != 0;
+    bool closing = (tcpFlags & (TCP_FLAG_FIN | TCP_FLAG_RST)) != 0;
+    if (length == 0 && !syn && !closing) return;
+
+    TRACE_SCOPE("assembler.processPacket");
 
     // Создаем ключ для потока
     StreamKey key{srcIP, dstIP, srcPort, dstPort};
 
+    // Получаем или создаем поток
+    auto found = streams.find(key);
+    if (found == streams.end()) {
+        // Закрытие неизвестного потока не требует состояния
+        if (length == 0 && !syn) return;
+
+        found = streams.emplace(key, StreamData()).first;
+        if (config.isBypassPort(srcPort) || config.isBypassPort(dstPort)) {
+            found->second.mode = STREAM_BYPASS;
+        }
+    }
+    StreamData& stream = found->second;
+
     // Обновляем время последней активности
-    lastActivity[key] = time(nullptr);
+    stream.lastActivity = currentTime();
 
-    // Получаем или создаем поток
-    StreamData& stream = streams[key];
+    // Поток уже классифицирован как неинтересный: только считаем
+    if (stream.mode == STREAM_BYPASS) {
+        bypassedPacketCount++;
+        bypassedByteCount += length;
+        if (closing) {
+            streams.erase(found);
+        }
+        return;
+    }
+
+    // Начальный номер задаётся один раз: по SYN (данные начинаются с ISN + 1)
+    // или, если начало соединения не захвачено, по первому сегменту
+    uint32_t dataSeq = syn ? seqNum + 1 : seqNum;
+    if (!stream.initialized) {
+        stream.expectedSeq = dataSeq;
+        stream.initialized = true;
+    }
+
+    // Смещение от ожидаемого номера - по модулю 2^32 (RFC 1982): сегмент
+    // после перехода через ноль идёт дальше, а не в прошлое. Повтор уже
+    // собранных данных отбрасывается, объединённый повтор с новыми байтами
+    // (начало раньше expectedSeq, конец позже) обрезается до expectedSeq
+    int32_t offset = static_cast<int32_t>(dataSeq - stream.expectedSeq);
+    if (offset < 0) {
+        size_t stale = static_cast<size_t>(-static_cast<int64_t>(offset));
+        size_t skipped = std::min(stale, length);
+        data += skipped;
+        length -= skipped;
+        offset = 0;
+    }
+
+    if (length > 0) {
+        // Добавляем данные в буфер
+        std::vector<uint8_t>& segment = stream.buffer[stream.expectedOffset + static_cast<uint32_t>(offset)];
+        stream.bufferedBytes -= segment.size();
+        if (segment.size() < length) {
+            segment.assign(data, data + length);
+        }
+        stream.bufferedBytes += segment.size();
+
+        // Пытаемся собрать последовательные пакеты
+        checkForCompletedMessages(key, stream);
+
+        // Защита от неограниченного роста: поток без границ сообщений
+        // или с длинной дырой в последовательности перестаём собирать
+        if (stream.mode != STREAM_BYPASS &&
+            stream.assembledData.size() + stream.bufferedBytes > config.maxStreamBuffer) {
+            markBypass(stream);
+        }
+    }
+
+    // RST закрывает поток сразу, FIN - когда не осталось сегментов вне очереди
+    // (FIN мог прийти раньше заполнения дыры); сообщение до закрытия отдаётся
+    if (tcpFlags & TCP_FLAG_FIN) {
+        stream.finReceived = true;
+    }
+    if (tcpFlags & TCP_FLAG_RST) {
+        streams.erase(key);
+    } else if (stream.finReceived && stream.buffer.empty()) {
+        flushOnClose(key, stream);
+        streams.erase(key);
+    }
+}
 
-    // Если это первый пакет в потоке, устанавливаем начальный seq
-    if (stream.buffer.empty() && stream.assembledData.empty()) {
-        stream.expectedSeq = seqNum;
+void TCPStreamAssembler::flushOnClose(const StreamKey& key, StreamData& stream) {
+    if (stream.mode != STREAM_HTTP || !stream.bodyUntilClose || stream.assembledData.empty()) {
+        return;
     }
+    std::vector<uint8_t> message;
+    message.swap(stream.assembledData);
+    messageCallback(key, message);
+    onMessageComplete(key, stream);
+}
+
+void TCPStreamAssembler::bypassStream(uint32_t srcIP, uint32_t dstIP, uint16_t srcPort, uint16_t dstPort) {
+    markBypass(streams[StreamKey{srcIP, dstIP, srcPort, dstPort}]);
+}
 
-    // Добавляем данные в буфер
-    std::vector<uint8_t> packetData(data, data + length);
-    stream.buffer[seqNum] = packetData;
+void TCPStreamAssembler::markBypass(StreamData& stream) {
+    stream.mode = STREAM_BYPASS;
+    stream.lastActivity = currentTime();
+    stream.awaitingUpgrade = false;
+    stream.webSocket.reset();
+    stream.http2.reset();
 
-    // Пытаемся собрать последовательные пакеты
-    checkForCompletedMessages(key, stream);
+    // Освобождаем память, а не только очищаем контейнеры
+    std::map<uint64_t, std::vector<uint8_t>>().swap(stream.buffer);
+    std::vector<uint8_t>().swap(stream.assembledData);
+    stream.bufferedBytes = 0;
 }
 
 void TCPStreamAssembler::checkForCompletedMessages(const StreamKey& key, StreamData& stream) {
     bool dataAdded = false;
 
-    // Проверяем, есть ли пакеты, которые можно добавить к собранным данным
-    auto it = stream.buffer.begin();
-    while (it != stream.buffer.end()) {
-        if (it->first == stream.expectedSeq) {
-            // Добавляем данные
-            stream.assembledData.insert(stream.assembledData.end(), it->second.begin(), it->second.end());
-            stream.expectedSeq += it->second.size();
-            it = stream.buffer.erase(it);
-            dataAdded = true;
-        } else if (it->first < stream.expectedSeq) {
-            // Устаревшие или дублирующиеся данные, удаляем
-            it = stream.buffer.erase(it);
-        } else {
-            // Еще не время для этого пакета
-            ++it;
+    // Сегменты упорядочены по позиции в потоке: берём с начала, пока они
+    // продолжают собранные данные. Сегмент, частично перекрытый уже
+    // собранным (пересылка другими границами), добавляется с середины
+    while (!stream.buffer.empty() && stream.buffer.begin()->first <= stream.expectedOffset) {
+        auto it = stream.buffer.begin();
+        size_t skip = static_cast<size_t>(stream.expectedOffset - it->first);
+        std::vector<uint8_t> segment;
+        segment.swap(it->second);
+        stream.buffer.erase(it);
+        stream.bufferedBytes -= segment.size();
+
+        if (skip >= segment.size()) {
+            continue;   // Целиком уже собран
+        }
+        size_t length = segment.size() - skip;
+        stream.expectedSeq += static_cast<uint32_t>(length);
+        stream.expectedOffset += length;
+
+        if (stream.mode == STREAM_WEBSOCKET || stream.mode == STREAM_HTTP2) {
+            // Кадры разбираются сразу, данные соединения не накапливаются
+            bool ok = stream.mode == STREAM_WEBSOCKET ? feedWebSocket(key, stream, segment.data() + skip, length)
+                                                      : feedHttp2(key, stream, segment.data() + skip, length);
+            if (!ok) {
+                markBypass(stream);
+                return;
+            }
+            continue;
         }
+
+        // Добавляем данные
+        stream.assembledData.insert(stream.assembledData.end(), segment.begin() + skip, segment.end());
+        dataAdded = true;
     }
 
     // Если добавили данные, проверяем, есть ли полные HTTP-сообщения
     if (dataAdded) {
-        while (isHTTPMessage(stream.assembledData)) {
-            size_t messageLength = getHTTPMessageLength(stream.assembledData);
-            if (messageLength == 0 || messageLength > stream.assembledData.size()) {
-                break;
-            }
+        parseMessages(key, stream);
+    }
+}
 
-            // Извлекаем полное HTTP-сообщение
-            std::vector<uint8_t> message(stream.assembledData.begin(), stream.assembledData.begin() + messageLength);
+void TCPStreamAssembler::parseMessages(const StreamKey& key, StreamData& stream) {
+    // После запроса на смену протокола данные ждут ответа сервера
+    while (!stream.assembledData.empty() && !stream.awaitingUpgrade) {
+        // Каждое сообщение должно начинаться как HTTP; иначе поток
+        // (TLS, бинарный протокол, потерянная синхронизация) обходится
+        StreamMode mode = classify(stream.assembledData);
+        if (mode == STREAM_BYPASS) {
+            markBypass(stream);
+            return;
+        }
+        if (mode == STREAM_UNKNOWN) {
+            break;
+        }
+        if (mode == STREAM_TLS) {
+            sniffTls(key, stream);
+            return;
+        }
+        if (mode == STREAM_HTTP2) {
+            switchToHttp2(key, stream, Http2Decoder::matchesPreface(stream.assembledData.data(),
+                                                                    stream.assembledData.size()));
+            return;
+        }
+        stream.mode = STREAM_HTTP;
+
+        size_t messageLength = getHTTPMessageLength(stream);
+        if (messageLength == 0 || messageLength > stream.assembledData.size()) {
+            break;
+        }
 
-            // Вызываем обратный вызов с полным сообщением
-            messageCallback(key, message);
+        // Извлекаем полное HTTP-сообщение
+        std::vector<uint8_t> message(stream.assembledData.begin(), stream.assembledData.begin() + messageLength);
 
-            // Удаляем обработанное сообщение из буфера
-            stream.assembledData.erase(stream.assembledData.begin(), stream.assembledData.begin() + messageLength);
+        // Вызываем обратный вызов с полным сообщением
+        messageCallback(key, message);
+
+        // Удаляем обработанное сообщение из буфера
+        stream.assembledData.erase(stream.assembledData.begin(), stream.assembledData.begin() + messageLength);
+
+        onMessageComplete(key, stream);
+        if (stream.mode != STREAM_HTTP) {
+            return;
         }
     }
 }
 
-bool TCPStreamAssembler::isHTTPMessage(const std::vector<uint8_t>& data) {
-    if (data.size() < 10) return false;
+void TCPStreamAssembler::onMessageComplete(const StreamKey& key, StreamData& stream) {
+    int status = stream.messageStatus;
+    bool upgrade = stream.messageUpgrade;
+    bool upgradeH2c = stream.messageUpgradeH2c;
+    bool connect = stream.messageConnect;
+    stream.messageLength = 0;
+    stream.chunkedBodyStart = 0;
+    stream.messageStatus = 0;
+    stream.messageUpgrade = false;
+    stream.messageUpgradeH2c = false;
+    stream.messageConnect = false;
+    stream.bodyUntilClose = false;
 
-    // Проверка на HTTP-запрос
-    static const char* methods[] = {"GET ", "POST ", "PUT ", "HEAD ", "DELETE ", "OPTIONS "};
-    for (const char* method : methods) {
-        if (memcmp(data.data(), method, strlen(method)) == 0) {
-            return true;
+    if (status == 0) {
+        // Запрос: дальнейшие байты клиента могут оказаться уже не HTTP
+        if (upgrade || upgradeH2c || connect) {
+            stream.awaitingUpgrade = true;
+            stream.connectRequested = connect;
         }
+        return;
     }
+    if (status < 200 && status != 101) {
+        return;   // 100 Continue и подобные не завершают обмен
+    }
+
+    // Ответ решает судьбу встречного направления (клиента)
+    StreamKey clientKey{key.dstIP, key.srcIP, key.dstPort, key.srcPort};
+    auto found = streams.find(clientKey);
+    bool clientWaiting = found != streams.end() && found->second.awaitingUpgrade;
+    bool tunnel = clientWaiting && found->second.connectRequested && status >= 200 && status < 300;
 
-    // Проверка на HTTP-ответ
-    if (memcmp(data.data(), "HTTP/", 5) == 0) {
-        return true;
+    if (status == 101 && upgrade) {
+        switchToWebSocket(key, stream);
+        StreamData& client = streams[clientKey];
+        if (client.mode != STREAM_BYPASS) {
+            switchToWebSocket(clientKey, client);
+        }
+    } else if (status == 101 && upgradeH2c) {
+        // Сервер сразу продолжает кадрами (SETTINGS и ответ на поток 1),
+        // клиент начинает с преамбулы
+        switchToHttp2(key, stream, false);
+        StreamData& client = streams[clientKey];
+        if (client.mode != STREAM_BYPASS) {
+            switchToHttp2(clientKey, client, true);
+        }
+    } else if (status == 101) {
+        // Другой протокол: содержимое не разбирается,
+        // соединение только учитывается в счётчиках
+        markBypass(stream);
+        markBypass(streams[clientKey]);
+    } else if (tunnel) {
+        // Туннель CONNECT: дальше обычно TLS - из него берутся SNI и ALPN,
+        // остальное содержимое обходится как у любого не-HTTP потока
+        StreamData& client = found->second;
+        client.awaitingUpgrade = false;
+        client.connectRequested = false;
+        parseMessages(clientKey, client);
+    } else if (clientWaiting) {
+        // Смена протокола отклонена: клиент продолжает говорить по HTTP
+        StreamData& client = found->second;
+        client.awaitingUpgrade = false;
+        client.connectRequested = false;
+        parseMessages(clientKey, client);
     }
+}
 
-    return false;
+void TCPStreamAssembler::switchToWebSocket(const StreamKey& key, StreamData& stream) {
+    stream.mode = STREAM_WEBSOCKET;
+    stream.awaitingUpgrade = false;
+    stream.connectRequested = false;
+    stream.webSocket.reset(new WebSocketFrameParser());
+
+    // Байты после ответа 101 (или отложенные после запроса) - уже кадры
+    std::vector<uint8_t> pending;
+    pending.swap(stream.assembledData);
+    if (!pending.empty() && !feedWebSocket(key, stream, pending.data(), pending.size())) {
+        markBypass(stream);
+    }
 }
 
-size_t TCPStreamAssembler::getHTTPMessageLength(const std::vector<uint8_t>& data) {
+bool TCPStreamAssembler::feedWebSocket(const StreamKey& key, StreamData& stream, const uint8_t* data, size_t length) {
+    TRACE_SCOPE("assembler.webSocket");
+    return stream.webSocket->feed(data, length, [this, &key](const WebSocketFrame& frame) {
+        webSocketFrameCount++;
+        if (webSocketCallback) {
+            webSocketCallback(key, frame);
+        }
+    });
+}
+
+void TCPStreamAssembler::switchToHttp2(const StreamKey& key, StreamData& stream, bool expectPreface) {
+    stream.mode = STREAM_HTTP2;
+    stream.awaitingUpgrade = false;
+    stream.connectRequested = false;
+    stream.http2.reset(new Http2Decoder(expectPreface));
+
+    std::vector<uint8_t> pending;
+    pending.swap(stream.assembledData);
+    if (!pending.empty() && !feedHttp2(key, stream, pending.data(), pending.size())) {
+        markBypass(stream);
+    }
+}
+
+bool TCPStreamAssembler::feedHttp2(const StreamKey& key, StreamData& stream, const uint8_t* data, size_t length) {
+    TRACE_SCOPE("assembler.http2");
+    // Потоки HTTP/2 выходят в виде сообщений HTTP/1 - тем же обратным вызовом
+    return stream.http2->feed(data, length, [this, &key](uint32_t streamId, const std::vector<uint8_t>& message) {
+        http2MessageCount++;
+        messageStream = streamId;
+        messageCallback(key, message);
+        messageStream = 0;
+    });
+}
+
+void TCPStreamAssembler::sniffTls(const StreamKey& key, StreamData& stream) {
+    TRACE_SCOPE("assembler.sniffTls");
+    stream.mode = STREAM_TLS;
+
+    TlsHello hello;
+    TlsSniffResult result = TlsSniffer::parseHello(stream.assembledData.data(), stream.assembledData.size(), hello);
+    if (result == TLS_NEED_MORE && stream.assembledData.size() < TlsSniffer::MAX_HELLO_BYTES) {
+        return;
+    }
+
+    if (result == TLS_HELLO) {
+        tlsHelloCount++;
+        StreamKey reverseKey{key.dstIP, key.srcIP, key.dstPort, key.srcPort};
+        if (hello.client) {
+            stream.tlsServerName = hello.serverName;
+        } else {
+            auto client = streams.find(reverseKey);
+            if (client != streams.end()) {
+                hello.serverName = client->second.tlsServerName;
+            }
+        }
+        if (tlsCallback) {
+            tlsCallback(key, hello);
+        }
+    }
+
+    // Дальше только шифрованные данные: не собираем
+    markBypass(stream);
+}
+
+StreamMode TCPStreamAssembler::classify(const std::vector<uint8_t>& data) {
+    // Начало HTTP-запроса или ответа; для короткого префикса решение откладывается
+    static const char* prefixes[] = {"GET ", "POST ", "PUT ", "HEAD ", "DELETE ", "OPTIONS ", "CONNECT ", "HTTP/"};
+
+    if (TlsSniffer::looksLikeTls(data.data(), data.size())) {
+        return data.size() >= 3 ? STREAM_TLS : STREAM_UNKNOWN;
+    }
+
+    // HTTP/2 с prior knowledge: преамбула клиента или SETTINGS сервера
+    if (Http2Decoder::matchesPreface(data.data(), data.size())) {
+        return data.size() >= Http2Decoder::PREFACE_LENGTH ? STREAM_HTTP2 : STREAM_UNKNOWN;
+    }
+    if (Http2Decoder::looksLikeServerStart(data.data(), data.size())) {
+        return data.size() >= 9 ? STREAM_HTTP2 : STREAM_UNKNOWN;
+    }
+
+    bool partial = false;
+    for (const char* prefix : prefixes) {
+        size_t prefixLength = strlen(prefix);
+        size_t compared = std::min(prefixLength, data.size());
+        if (memcmp(data.data(), prefix, compared) == 0) {
+            if (compared == prefixLength) {
+                return STREAM_HTTP;
+            }
+            partial = true;
+        }
+    }
+
+    return partial ? STREAM_UNKNOWN : STREAM_BYPASS;
+}
+
+size_t TCPStreamAssembler::getHTTPMessageLength(StreamData& stream) {
+    const std::vector<uint8_t>& data = stream.assembledData;
+
+    // Заголовки уже разобраны: ждём тело (или закрытия соединения)
+    if (stream.messageLength > 0) {
+        return stream.messageLength;
+    }
+    if (stream.bodyUntilClose) {
+        return 0;
+    }
+    if (stream.chunkedBodyStart > 0) {
+        size_t bodyLength = HttpBodyDecoder::chunkedLength(data.data() + stream.chunkedBodyStart,
+                                                           data.size() - stream.chunkedBodyStart);
+        return bodyLength > 0 ? stream.chunkedBodyStart + bodyLength : 0;
+    }
+
+    if (data.size() < 4) return 0;
+
     // Ищем конец заголовков
     for (size_t i = 0; i < data.size() - 3; i++) {
         if (data[i] == '\r' && data[i+1] == '\n' && data[i+2] == '\r' && data[i+3] == '\n') {
             size_t headersEnd = i + 4;
 
-            // Проверяем, есть ли заголовок Content-Length
-            std::string headers(reinterpret_cast<const char*>(data.data()), headersEnd);
-            size_t contentLengthPos = headers.find("Content-Length:");
-
-            if (contentLengthPos != std::string::npos) {
-                size_t valueStart = headers.find_first_not_of(" ", contentLengthPos + 15);
-                size_t valueEnd = headers.find("\r\n", valueStart);
-                if (valueStart != std::string::npos && valueEnd != std::string::npos) {
-                    std::string lengthStr = headers.substr(valueStart, valueEnd - valueStart);
-                    size_t contentLength = std::stoul(lengthStr);
-                    return headersEnd + contentLength;
+            std::string contentLengthValue;
+            std::string transferEncoding;
+            std::string upgrade;
+            scanFramingHeaders(data, headersEnd, contentLengthValue, transferEncoding, upgrade);
+
+            // Сведения для смены протокола после сообщения (см. onMessageComplete)
+            stream.messageUpgrade = containsToken(upgrade, "websocket");
+            stream.messageUpgradeH2c = containsToken(upgrade, "h2c");
+            stream.messageConnect = data.size() >= 8 && memcmp(data.data(), "CONNECT ", 8) == 0;
+            stream.messageStatus = 0;
+
+            // Ответы 1xx, 204 и 304 тела не имеют, какие бы заголовки ни пришли
+            if (data.size() >= 12 && memcmp(data.data(), "HTTP/", 5) == 0 &&
+                isdigit(data[9]) && isdigit(data[10]) && isdigit(data[11])) {
+                int status = (data[9] - '0') * 100 + (data[10] - '0') * 10 + (data[11] - '0');
+                stream.messageStatus = status;
+                if ((status >= 100 && status < 200) || status == 204 || status == 304) {
+                    return headersEnd;
                 }
             }
 
-            // Если нет Content-Length, возвращаем только длину заголовков
-            // (это работает для простых запросов, но не для чанковых ответов)
+            // Chunked важнее Content-Length (RFC 9112, 6.3)
+            if (!transferEncoding.empty() && HttpBodyDecoder::isChunked(transferEncoding)) {
+                stream.chunkedBodyStart = headersEnd;
+                size_t bodyLength = HttpBodyDecoder::chunkedLength(data.data() + headersEnd,
+                                                                   data.size() - headersEnd);
+                return bodyLength > 0 ? headersEnd + bodyLength : 0;
+            }
+
+            if (!contentLengthValue.empty()) {
+                // Разбираем вручную: некорректное значение не должно прерывать захват
+                size_t contentLength = 0;
+                size_t pos = 0;
+                for (; pos < contentLengthValue.size() && contentLengthValue[pos] >= '0' &&
+                       contentLengthValue[pos] <= '9'; pos++) {
+                    if (contentLength > config.maxStreamBuffer) break;
+                    contentLength = contentLength * 10 + (contentLengthValue[pos] - '0');
+                }
+                if (pos > 0) {
+                    stream.messageLength = headersEnd + contentLength;
+                    return stream.messageLength;
+                }
+            }
+
+            // Без Content-Length и chunked у запроса тела нет, а тело ответа
+            // идёт до закрытия соединения (RFC 9112, 6.3): ответ отдаётся по FIN
+            if (stream.messageStatus != 0) {
+                stream.bodyUntilClose = true;
+                return 0;
+            }
             return headersEnd;
         }
     }
@@ -121,14 +494,69 @@ size_t TCPStreamAssembler::getHTTPMessageLength(const std::vector<uint8_t>& data
     return 0; // Еще недостаточно данных
 }
 
+bool TCPStreamAssembler::headerNameIs(const uint8_t* line, size_t lineLength, const char* name, size_t nameLength) {
+    if (lineLength <= nameLength || line[nameLength] != ':') return false;
+    for (size_t k = 0; k < nameLength; k++) {
+        if (tolower(line[k]) != name[k]) return false;
+    }
+    return true;
+}
+
+bool TCPStreamAssembler::containsToken(const std::string& value, const char* token) {
+    size_t tokenLength = strlen(token);
+    for (size_t i = 0; i + tokenLength <= value.size(); i++) {
+        size_t k = 0;
+        while (k < tokenLength && tolower(static_cast<unsigned char>(value[i + k])) == token[k]) k++;
+        if (k == tokenLength) return true;
+    }
+    return false;
+}
+
+void TCPStreamAssembler::scanFramingHeaders(const std::vector<uint8_t>& data, size_t headersEnd,
+                                            std::string& contentLength, std::string& transferEncoding,
+                                            std::string& upgrade) {
+    static const char CONTENT_LENGTH[] = "content-length";
+    static const char TRANSFER_ENCODING[] = "transfer-encoding";
+    static const char UPGRADE[] = "upgrade";
+
+    // Первая строка - стартовая, заголовки начинаются со второй
+    const uint8_t* end = data.data() + headersEnd;
+    const uint8_t* line = static_cast<const uint8_t*>(memchr(data.data(), '\n', headersEnd));
+    while (line && ++line < end) {
+        const uint8_t* next = static_cast<const uint8_t*>(memchr(line, '\n', end - line));
+        size_t lineLength = (next ? next : end) - line;
+        if (lineLength > 0 && line[lineLength - 1] == '\r') lineLength--;
+
+        std::string* value = nullptr;
+        size_t nameLength = 0;
+        if (headerNameIs(line, lineLength, CONTENT_LENGTH, sizeof(CONTENT_LENGTH) - 1)) {
+            value = &contentLength;
+            nameLength = sizeof(CONTENT_LENGTH) - 1;
+        } else if (headerNameIs(line, lineLength, TRANSFER_ENCODING, sizeof(TRANSFER_ENCODING) - 1)) {
+            value = &transferEncoding;
+            nameLength = sizeof(TRANSFER_ENCODING) - 1;
+        } else if (headerNameIs(line, lineLength, UPGRADE, sizeof(UPGRADE) - 1)) {
+            value = &upgrade;
+            nameLength = sizeof(UPGRADE) - 1;
+        }
+        if (value) {
+            size_t valueStart = nameLength + 1;
+            while (valueStart < lineLength && (line[valueStart] == ' ' || line[valueStart] == '\t')) valueStart++;
+            value->assign(reinterpret_cast<const char*>(line) + valueStart, lineLength - valueStart);
+        }
+        line = next;
+    }
+}
+
 void TCPStreamAssembler::clearOldStreams(time_t olderThan) {
-    time_t now = time(nullptr);
+    TRACE_SCOPE("assembler.clearOldStreams");
+
+    time_t now = currentTime();
 
-    auto it = lastActivity.begin();
-    while (it != lastActivity.end()) {
-        if (now - it->second > olderThan) {
-            streams.erase(it->first);
-            it = lastActivity.erase(it);
+    auto it = streams.begin();
+    while (it != streams.end()) {
+        if (now - it->second.lastActivity > olderThan) {
+            it = streams.erase(it);
         } else {
             ++it;
         }
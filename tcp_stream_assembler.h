@@ -1,11 +1,18 @@
 #ifndef TCP_STREAM_ASSEMBLER_H
 #define TCP_STREAM_ASSEMBLER_H
 
+#include <cstdint>
 #include <map>
+#include <set>
 #include <vector>
 #include <string>
 #include <functional>
 #include <ctime>
+#include <memory>
+
+#include "websocket_parser.h"
+#include "tls_sniffer.h"
+#include "http2_decoder.h"
 
 struct StreamKey {
     uint32_t srcIP;
@@ -21,31 +28,137 @@ struct StreamKey {
     }
 };
 
+// Состояние потока после классификации первых байт
+enum StreamMode {
+    STREAM_UNKNOWN,   // Данных ещё недостаточно для классификации
+    STREAM_HTTP,      // Поток разбирается как HTTP
+    STREAM_WEBSOCKET, // После 101 Switching Protocols: кадры WebSocket без накопления
+    STREAM_TLS,       // Начало TLS: собирается только ClientHello/ServerHello
+    STREAM_HTTP2,     // HTTP/2 без шифрования (prior knowledge или Upgrade: h2c): кадры без накопления
+    STREAM_BYPASS     // Не HTTP, туннель CONNECT или исключён правилом: данные не собираются
+};
+
 struct StreamData {
-    uint32_t expectedSeq;
-    std::map<uint32_t, std::vector<uint8_t>> buffer;
+    StreamMode mode = STREAM_UNKNOWN;
+    bool initialized = false;      // expectedSeq задан (по SYN или первому сегменту)
+    uint32_t expectedSeq = 0;
+    uint64_t expectedOffset = 0;   // Позиция expectedSeq от начала потока (без переполнения)
+    // Сегменты вне очереди по позиции в потоке: номер последовательности
+    // после 2^32 начинается с нуля, позиция продолжает расти
+    std::map<uint64_t, std::vector<uint8_t>> buffer;
+    size_t bufferedBytes = 0;      // Объём сегментов, ожидающих в buffer
     std::vector<uint8_t> assembledData;
+    time_t lastActivity = 0;
+
+    // Разметка текущего сообщения, чтобы не разбирать заголовки на каждом сегменте
+    size_t messageLength = 0;      // Полная длина, если известна (Content-Length)
+    size_t chunkedBodyStart = 0;   // Начало chunked-тела, если оно ещё не получено
+    int messageStatus = 0;         // Код ответа текущего сообщения (0 - запрос)
+    bool messageUpgrade = false;   // Upgrade: websocket в текущем сообщении
+    bool messageUpgradeH2c = false; // Upgrade: h2c в текущем сообщении
+    bool messageConnect = false;   // Текущее сообщение - запрос CONNECT
+    bool bodyUntilClose = false;   // Ответ без Content-Length и chunked: тело до закрытия
+    bool finReceived = false;      // FIN получен, но перед ним ещё есть дыра
+
+    // Запрос на смену протокола отправлен: следующие байты - не HTTP,
+    // пока ответ не подтвердит или не отклонит смену
+    bool awaitingUpgrade = false;
+    bool connectRequested = false;
+
+    std::unique_ptr<WebSocketFrameParser> webSocket;
+    std::unique_ptr<Http2Decoder> http2;   // Своя таблица HPACK у каждого направления
+
+    std::string tlsServerName;     // SNI клиента - для строки ServerHello встречного потока
+};
+
+// Правила обхода: такие потоки только учитываются в счётчиках
+struct AssemblerConfig {
+    std::set<uint16_t> bypassPorts;             // Порты, которые не инспектируются
+    size_t maxStreamBuffer = 16 * 1024 * 1024;  // Предел несобранных данных на поток
+    time_t streamTimeout = 300;                 // Простой, после которого поток удаляется (секунды)
+
+    bool isBypassPort(uint16_t port) const { return bypassPorts.count(port) != 0; }
 };
 
 class TCPStreamAssembler {
 public:
     typedef std::function<void(const StreamKey&, const std::vector<uint8_t>&)> CompleteMessageCallback;
+    typedef std::function<void(const StreamKey&, const WebSocketFrame&)> WebSocketFrameCallback;
+    typedef std::function<void(const StreamKey&, const TlsHello&)> TlsHelloCallback;
 
     TCPStreamAssembler(CompleteMessageCallback callback);
 
+    // Можно менять во время захвата: потоки на новых портах обхода сразу
+    // переводятся в обход, остальные продолжают собираться
+    void setConfig(const AssemblerConfig& config);
+
+    // Кадры соединений, перешедших на WebSocket (без обработчика - только учитываются)
+    void setWebSocketCallback(WebSocketFrameCallback callback);
+
+    // ClientHello и ServerHello TLS-соединений; после Hello поток обходится
+    void setTlsCallback(TlsHelloCallback callback);
+
+    // tcpFlags - флаги TCP (SYN задаёт начальный номер, FIN/RST закрывают поток)
     void processPacket(uint32_t srcIP, uint32_t dstIP, uint16_t srcPort, uint16_t dstPort,
-                       uint32_t seqNum, const uint8_t* data, size_t length);
+                       uint32_t seqNum, const uint8_t* data, size_t length, uint8_t tcpFlags = 0);
+
+    // Исключает поток из сборки (например, если нагрузка обрезана snaplen)
+    void bypassStream(uint32_t srcIP, uint32_t dstIP, uint16_t srcPort, uint16_t dstPort);
 
     void clearOldStreams(time_t olderThan);
+    void clearOldStreams() { clearOldStreams(config.streamTimeout); }
+
+    // Часы простоя потоков: 0 - системное время, иначе метка текущего
+    // пакета в секундах (разбор файла не зависит от скорости чтения)
+    void setPacketTime(time_t now) { packetTime = now; }
+
+    size_t streamCount() const { return streams.size(); }
+    uint64_t bypassedPackets() const { return bypassedPacketCount; }
+    uint64_t bypassedBytes() const { return bypassedByteCount; }
+    uint64_t webSocketFrames() const { return webSocketFrameCount; }
+    uint64_t tlsHellos() const { return tlsHelloCount; }
+    uint64_t http2Messages() const { return http2MessageCount; }
+
+    // Номер потока HTTP/2 сообщения, переданного в текущем вызове
+    // CompleteMessageCallback (0 - сообщение HTTP/1)
+    uint32_t messageStreamId() const { return messageStream; }
 
 private:
     std::map<StreamKey, StreamData> streams;
-    std::map<StreamKey, time_t> lastActivity;
     CompleteMessageCallback messageCallback;
+    WebSocketFrameCallback webSocketCallback;
+    TlsHelloCallback tlsCallback;
+    AssemblerConfig config;
+    uint64_t bypassedPacketCount;
+    uint64_t bypassedByteCount;
+    uint64_t webSocketFrameCount;
+    uint64_t tlsHelloCount;
+    uint64_t http2MessageCount;
+    uint32_t messageStream;
+    time_t packetTime;
+
+    time_t currentTime() const { return packetTime != 0 ? packetTime : time(nullptr); }
 
     void checkForCompletedMessages(const StreamKey& key, StreamData& stream);
-    bool isHTTPMessage(const std::vector<uint8_t>& data);
-    size_t getHTTPMessageLength(const std::vector<uint8_t>& data);
+    void markBypass(StreamData& stream);
+    void onMessageComplete(const StreamKey& key, StreamData& stream);
+    // Закрытие соединения завершает сообщение, тело которого идёт до закрытия
+    void flushOnClose(const StreamKey& key, StreamData& stream);
+    void switchToWebSocket(const StreamKey& key, StreamData& stream);
+    bool feedWebSocket(const StreamKey& key, StreamData& stream, const uint8_t* data, size_t length);
+    void switchToHttp2(const StreamKey& key, StreamData& stream, bool expectPreface);
+    bool feedHttp2(const StreamKey& key, StreamData& stream, const uint8_t* data, size_t length);
+    void parseMessages(const StreamKey& key, StreamData& stream);
+    void sniffTls(const StreamKey& key, StreamData& stream);
+    StreamMode classify(const std::vector<uint8_t>& data);
+    size_t getHTTPMessageLength(StreamData& stream);
+
+    // Значения Content-Length, Transfer-Encoding и Upgrade (имена без учёта регистра)
+    static void scanFramingHeaders(const std::vector<uint8_t>& data, size_t headersEnd,
+                                   std::string& contentLength, std::string& transferEncoding,
+                                   std::string& upgrade);
+    static bool containsToken(const std::string& value, const char* token);
+    static bool headerNameIs(const uint8_t* line, size_t lineLength, const char* name, size_t nameLength);
 };
 
 #endif // TCP_STREAM_ASSEMBLER_H
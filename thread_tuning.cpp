@@ -0,0 +1,167 @@
+#include "thread_tuning.h"
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+bool ThreadTuning::parseCpuList(const std::string& text, std::vector<int>& cpus) {
+    cpus.clear();
+
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t end = text.find(',', pos);
+        if (end == std::string::npos) end = text.size();
+        std::string item = text.substr(pos, end - pos);
+        pos = end + 1;
+
+        // Пробелы вокруг элементов допускаются
+        size_t first = item.find_first_not_of(' ');
+        if (first == std::string::npos) continue;
+        item = item.substr(first, item.find_last_not_of(' ') - first + 1);
+
+        char* rest = nullptr;
+        long from = std::strtol(item.c_str(), &rest, 10);
+        long to = from;
+        if (rest == item.c_str()) return false;
+        if (*rest == '-') {
+            const char* start = rest + 1;
+            to = std::strtol(start, &rest, 10);
+            if (rest == start) return false;
+        }
+        if (*rest != '\0' || from < 0 || to < from || to > 4095) return false;
+
+        for (long cpu = from; cpu <= to; cpu++) {
+            cpus.push_back(static_cast<int>(cpu));
+        }
+    }
+    return true;
+}
+
+bool ThreadTuning::pinCurrentThread(int cpu) {
+    if (cpu < 0) return false;
+
+#ifdef _WIN32
+    if (cpu >= 64) return false;
+    return SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(1) << cpu) != 0;
+#elif defined(__linux__)
+    if (cpu >= CPU_SETSIZE) return false;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    return false;
+#endif
+}
+
+int ThreadTuning::cpuCount() {
+    unsigned count = std::thread::hardware_concurrency();
+    return count > 0 ? static_cast<int>(count) : 1;
+}
+
+bool ThreadTuning::parsePolicy(const std::string& text, SchedulingPolicy& policy) {
+    if (text == "normal") policy = SCHEDULING_NORMAL;
+    else if (text == "high") policy = SCHEDULING_HIGH;
+    else if (text == "realtime") policy = SCHEDULING_REALTIME;
+    else return false;
+    return true;
+}
+
+const char* ThreadTuning::policyName(SchedulingPolicy policy) {
+    switch (policy) {
+    case SCHEDULING_HIGH: return "high";
+    case SCHEDULING_REALTIME: return "realtime";
+    default: return "normal";
+    }
+}
+
+bool ThreadTuning::setCurrentThreadPolicy(SchedulingPolicy policy, std::string& error) {
+#ifdef _WIN32
+    int priority = THREAD_PRIORITY_NORMAL;
+    if (policy == SCHEDULING_HIGH) priority = THREAD_PRIORITY_HIGHEST;
+    if (policy == SCHEDULING_REALTIME) priority = THREAD_PRIORITY_TIME_CRITICAL;
+    if (!SetThreadPriority(GetCurrentThread(), priority)) {
+        error = "SetThreadPriority: ошибка " + std::to_string(GetLastError());
+        return false;
+    }
+    return true;
+#elif defined(__linux__)
+    if (policy == SCHEDULING_REALTIME) {
+        // Средний приоритет FIFO: выше обычных потоков, ниже потоков ядра
+        struct sched_param param;
+        param.sched_priority = 10;
+        int result = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+        if (result != 0) {
+            error = std::string("SCHED_FIFO: ") + strerror(result);
+            return false;
+        }
+        return true;
+    }
+
+    // В Linux nice задаётся для отдельного потока по его tid
+    int niceValue = policy == SCHEDULING_HIGH ? -10 : 0;
+    pid_t tid = static_cast<pid_t>(syscall(SYS_gettid));
+    if (setpriority(PRIO_PROCESS, static_cast<id_t>(tid), niceValue) == -1) {
+        error = std::string("setpriority: ") + strerror(errno);
+        return false;
+    }
+    return true;
+#else
+    (void)policy;
+    error = "изменение приоритета не поддерживается на этой платформе";
+    return false;
+#endif
+}
+
+int ThreadTuning::interfaceNumaNode(const std::string& interfaceName) {
+#ifdef __linux__
+    std::ifstream in("/sys/class/net/" + interfaceName + "/device/numa_node");
+    int node = -1;
+    if (in >> node) return node;
+#else
+    (void)interfaceName;
+#endif
+    return -1;
+}
+
+bool ThreadTuning::numaNodeCpus(int node, std::vector<int>& cpus) {
+    cpus.clear();
+#ifdef __linux__
+    if (node < 0) return false;
+    std::ifstream in("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+    std::string list;
+    if (!std::getline(in, list)) return false;
+    return parseCpuList(list, cpus) && !cpus.empty();
+#else
+    (void)node;
+    return false;
+#endif
+}
+
+uint64_t ThreadTuning::currentThreadCpuTimeUs() {
+#ifdef _WIN32
+    FILETIME creation, exitTime, kernel, user;
+    if (!GetThreadTimes(GetCurrentThread(), &creation, &exitTime, &kernel, &user)) return 0;
+    uint64_t total = (uint64_t(kernel.dwHighDateTime) << 32 | kernel.dwLowDateTime) +
+                     (uint64_t(user.dwHighDateTime) << 32 | user.dwLowDateTime);
+    return total / 10;   // Единицы по 100 нс
+#elif defined(__linux__)
+    struct timespec ts;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0) return 0;
+    return uint64_t(ts.tv_sec) * 1000000 + uint64_t(ts.tv_nsec) / 1000;
+#else
+    return 0;
+#endif
+}
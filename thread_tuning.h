@@ -0,0 +1,45 @@
+#ifndef THREAD_TUNING_H
+#define THREAD_TUNING_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Политика планирования потоков захвата
+enum SchedulingPolicy {
+    SCHEDULING_NORMAL,     // По умолчанию
+    SCHEDULING_HIGH,       // Повышенный приоритет (nice -10 / THREAD_PRIORITY_HIGHEST)
+    SCHEDULING_REALTIME    // Реальное время (SCHED_FIFO / THREAD_PRIORITY_TIME_CRITICAL)
+};
+
+// Размещение потоков: привязка к ядрам, приоритет, узлы NUMA, время CPU
+// (Linux и Windows; на остальных платформах вызовы возвращают false)
+class ThreadTuning {
+public:
+    // Разбирает список ядер вида "0-3,6"; false при синтаксической ошибке
+    static bool parseCpuList(const std::string& text, std::vector<int>& cpus);
+
+    // Привязывает текущий поток к одному ядру
+    static bool pinCurrentThread(int cpu);
+
+    // Число доступных логических процессоров
+    static int cpuCount();
+
+    // "normal", "high", "realtime"
+    static bool parsePolicy(const std::string& text, SchedulingPolicy& policy);
+    static const char* policyName(SchedulingPolicy policy);
+
+    // Меняет приоритет текущего потока; для HIGH и REALTIME обычно нужны права root
+    static bool setCurrentThreadPolicy(SchedulingPolicy policy, std::string& error);
+
+    // Узел NUMA, к которому подключена сетевая карта (-1, если неизвестен)
+    static int interfaceNumaNode(const std::string& interfaceName);
+
+    // Ядра узла NUMA
+    static bool numaNodeCpus(int node, std::vector<int>& cpus);
+
+    // Процессорное время текущего потока, микросекунды
+    static uint64_t currentThreadCpuTimeUs();
+};
+
+#endif // THREAD_TUNING_H
@@ -0,0 +1,225 @@
+#include "tls_sniffer.h"
+#include <cstdio>
+
+namespace {
+
+const uint8_t RECORD_HANDSHAKE = 0x16;
+const uint8_t HANDSHAKE_CLIENT_HELLO = 1;
+const uint8_t HANDSHAKE_SERVER_HELLO = 2;
+
+const uint16_t EXTENSION_SERVER_NAME = 0;
+const uint16_t EXTENSION_ALPN = 16;
+const uint16_t EXTENSION_SUPPORTED_VERSIONS = 43;
+
+// Значения GREASE (RFC 8701) вида 0x?a?a не означают реальных версий
+inline bool isGrease(uint16_t value) {
+    return (value & 0x0f0f) == 0x0a0a && (value >> 8) == (value & 0xff);
+}
+
+// Чтение с проверкой границ: при выходе за пределы ok становится false
+struct Reader {
+    const uint8_t* data;
+    size_t size;
+    size_t pos;
+    bool ok;
+
+    Reader(const uint8_t* data, size_t size) : data(data), size(size), pos(0), ok(true) {}
+
+    bool has(size_t count) const { return ok && size - pos >= count; }
+
+    uint32_t read(size_t bytes) {
+        if (!has(bytes)) {
+            ok = false;
+            return 0;
+        }
+        uint32_t value = 0;
+        for (size_t i = 0; i < bytes; i++) {
+            value = (value << 8) | data[pos++];
+        }
+        return value;
+    }
+
+    // Вложенный блок с длиной из lengthBytes байт
+    Reader sub(size_t lengthBytes) {
+        size_t length = read(lengthBytes);
+        if (!has(length)) {
+            ok = false;
+            return Reader(data, 0);
+        }
+        Reader result(data + pos, length);
+        pos += length;
+        return result;
+    }
+
+    void skip(size_t count) {
+        if (!has(count)) ok = false;
+        else pos += count;
+    }
+};
+
+void parseAlpn(Reader extension, TlsHello& hello) {
+    Reader list = extension.sub(2);
+    while (list.ok && list.pos < list.size) {
+        Reader name = list.sub(1);
+        if (!list.ok) break;
+        hello.alpn.emplace_back(reinterpret_cast<const char*>(name.data), name.size);
+    }
+}
+
+void parseServerName(Reader extension, TlsHello& hello) {
+    Reader list = extension.sub(2);
+    while (list.ok && list.pos < list.size) {
+        uint32_t type = list.read(1);
+        Reader name = list.sub(2);
+        if (list.ok && type == 0) {
+            hello.serverName.assign(reinterpret_cast<const char*>(name.data), name.size);
+            return;
+        }
+    }
+}
+
+bool parseExtensions(Reader& body, TlsHello& hello) {
+    // Расширений может не быть (старые клиенты)
+    if (body.pos == body.size) return true;
+
+    Reader extensions = body.sub(2);
+    while (extensions.ok && extensions.pos < extensions.size) {
+        uint16_t type = static_cast<uint16_t>(extensions.read(2));
+        Reader extension = extensions.sub(2);
+        if (!extensions.ok) return false;
+
+        if (type == EXTENSION_SERVER_NAME && hello.client) {
+            parseServerName(extension, hello);
+        } else if (type == EXTENSION_ALPN) {
+            parseAlpn(extension, hello);
+        } else if (type == EXTENSION_SUPPORTED_VERSIONS) {
+            if (hello.client) {
+                // Наибольшая из предложенных версий
+                Reader versions = extension.sub(1);
+                while (versions.has(2)) {
+                    uint16_t version = static_cast<uint16_t>(versions.read(2));
+                    if (!isGrease(version) && version > hello.version) hello.version = version;
+                }
+            } else {
+                uint16_t version = static_cast<uint16_t>(extension.read(2));
+                if (extension.ok) hello.version = version;
+            }
+        }
+    }
+    return extensions.ok;
+}
+
+bool parseHandshake(const uint8_t* data, size_t size, TlsHello& hello) {
+    Reader message(data, size);
+    uint8_t type = static_cast<uint8_t>(message.read(1));
+    Reader body = message.sub(3);
+    if (!message.ok) return false;
+
+    hello = TlsHello();
+    hello.client = type == HANDSHAKE_CLIENT_HELLO;
+    hello.version = static_cast<uint16_t>(body.read(2));
+    body.skip(32);          // random
+    body.sub(1);            // session_id
+
+    if (hello.client) {
+        Reader suites = body.sub(2);
+        hello.offeredCipherSuites = suites.size / 2;
+        body.sub(1);        // compression_methods
+    } else {
+        hello.cipherSuite = static_cast<uint16_t>(body.read(2));
+        body.skip(1);       // compression_method
+    }
+    if (!body.ok) return false;
+
+    return parseExtensions(body, hello);
+}
+
+} // namespace
+
+bool TlsSniffer::looksLikeTls(const uint8_t* data, size_t size) {
+    if (size >= 1 && data[0] != RECORD_HANDSHAKE) return false;
+    if (size >= 2 && data[1] != 0x03) return false;
+    if (size >= 3 && data[2] > 0x04) return false;
+    return true;
+}
+
+TlsSniffResult TlsSniffer::parseHello(const uint8_t* data, size_t size, TlsHello& hello) {
+    // Сообщение рукопожатия может быть разбито на несколько записей;
+    // в обычном случае оно целиком в первой и разбирается без копирования
+    std::vector<uint8_t> joined;
+    const uint8_t* handshake = nullptr;
+    size_t handshakeSize = 0;
+
+    size_t pos = 0;
+    while (true) {
+        if (size - pos < 5) return TLS_NEED_MORE;
+        if (!looksLikeTls(data + pos, 3)) return TLS_NOT_HANDSHAKE;
+
+        size_t recordLength = (size_t(data[pos + 3]) << 8) | data[pos + 4];
+        if (recordLength == 0 || recordLength > 16384 + 2048) return TLS_NOT_HANDSHAKE;
+        if (size - pos - 5 < recordLength) return TLS_NEED_MORE;
+
+        const uint8_t* fragment = data + pos + 5;
+        if (!handshake) {
+            handshake = fragment;
+            handshakeSize = recordLength;
+        } else {
+            if (joined.empty()) joined.assign(handshake, handshake + handshakeSize);
+            joined.insert(joined.end(), fragment, fragment + recordLength);
+            handshake = joined.data();
+            handshakeSize = joined.size();
+        }
+        pos += 5 + recordLength;
+
+        if (handshakeSize >= 4) {
+            if (handshake[0] != HANDSHAKE_CLIENT_HELLO && handshake[0] != HANDSHAKE_SERVER_HELLO) {
+                return TLS_NOT_HANDSHAKE;
+            }
+            size_t messageLength = (size_t(handshake[1]) << 16) | (size_t(handshake[2]) << 8) | handshake[3];
+            if (messageLength + 4 > MAX_HELLO_BYTES) return TLS_NOT_HANDSHAKE;
+            if (handshakeSize >= messageLength + 4) {
+                return parseHandshake(handshake, messageLength + 4, hello) ? TLS_HELLO : TLS_NOT_HANDSHAKE;
+            }
+        }
+    }
+}
+
+std::string TlsSniffer::versionName(uint16_t version) {
+    switch (version) {
+    case 0x0300: return "SSL 3.0";
+    case 0x0301: return "TLS 1.0";
+    case 0x0302: return "TLS 1.1";
+    case 0x0303: return "TLS 1.2";
+    case 0x0304: return "TLS 1.3";
+    default: {
+        char text[16];
+        snprintf(text, sizeof(text), "0x%04x", version);
+        return text;
+    }
+    }
+}
+
+std::string TlsSniffer::cipherSuiteName(uint16_t suite) {
+    switch (suite) {
+    case 0x1301: return "TLS_AES_128_GCM_SHA256";
+    case 0x1302: return "TLS_AES_256_GCM_SHA384";
+    case 0x1303: return "TLS_CHACHA20_POLY1305_SHA256";
+    case 0xc02b: return "TLS_ECDHE_ECDSA_WITH_AES_128_GCM_SHA256";
+    case 0xc02c: return "TLS_ECDHE_ECDSA_WITH_AES_256_GCM_SHA384";
+    case 0xc02f: return "TLS_ECDHE_RSA_WITH_AES_128_GCM_SHA256";
+    case 0xc030: return "TLS_ECDHE_RSA_WITH_AES_256_GCM_SHA384";
+    case 0xcca8: return "TLS_ECDHE_RSA_WITH_CHACHA20_POLY1305_SHA256";
+    case 0xcca9: return "TLS_ECDHE_ECDSA_WITH_CHACHA20_POLY1305_SHA256";
+    case 0xc013: return "TLS_ECDHE_RSA_WITH_AES_128_CBC_SHA";
+    case 0xc014: return "TLS_ECDHE_RSA_WITH_AES_256_CBC_SHA";
+    case 0x009c: return "TLS_RSA_WITH_AES_128_GCM_SHA256";
+    case 0x009d: return "TLS_RSA_WITH_AES_256_GCM_SHA384";
+    case 0x002f: return "TLS_RSA_WITH_AES_128_CBC_SHA";
+    case 0x0035: return "TLS_RSA_WITH_AES_256_CBC_SHA";
+    default: {
+        char text[16];
+        snprintf(text, sizeof(text), "0x%04x", suite);
+        return text;
+    }
+    }
+}
@@ -0,0 +1,42 @@
+#ifndef TLS_SNIFFER_H
+#define TLS_SNIFFER_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Результат разбора начала TLS-соединения
+enum TlsSniffResult {
+    TLS_NEED_MORE,        // Hello ещё не получено целиком
+    TLS_HELLO,            // ClientHello или ServerHello разобрано
+    TLS_NOT_HANDSHAKE     // Данные - не рукопожатие TLS
+};
+
+// Открытые сведения из ClientHello / ServerHello
+struct TlsHello {
+    bool client = true;
+    uint16_t version = 0;            // С учётом supported_versions (TLS 1.3)
+    std::string serverName;          // SNI (из ClientHello)
+    std::vector<std::string> alpn;   // Предложенные протоколы или выбранный сервером
+    uint16_t cipherSuite = 0;        // Выбранный сервером набор
+    size_t offeredCipherSuites = 0;  // Число наборов в ClientHello
+};
+
+// Разбор первых записей TLS без расшифровки: читается только первое
+// сообщение рукопожатия каждой стороны, после чего поток можно не собирать.
+class TlsSniffer {
+public:
+    // Предел данных, которые стоит ждать ради Hello (с запасом на большие key_share)
+    static const size_t MAX_HELLO_BYTES = 32 * 1024;
+
+    // Начало записи Handshake: 0x16 0x03 xx. Для 1-2 байт - совпадение префикса
+    static bool looksLikeTls(const uint8_t* data, size_t size);
+
+    static TlsSniffResult parseHello(const uint8_t* data, size_t size, TlsHello& hello);
+
+    static std::string versionName(uint16_t version);
+    static std::string cipherSuiteName(uint16_t suite);
+};
+
+#endif // TLS_SNIFFER_H
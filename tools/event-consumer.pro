@@ -0,0 +1,23 @@
+# event-consumer.pro - пример внешнего читателя потока событий (без Qt)
+#
+# Сборка:   qmake event-consumer.pro && make
+# Запуск:   ./event-consumer [--socket PATH] [--from-start] [--stats] [--delay-us N]
+#   (в сниффере: Настройки -> Публиковать события для внешних программ)
+
+QT -= core gui
+
+TARGET = event-consumer
+CONFIG += c++17 console warn_on release
+CONFIG -= app_bundle qt
+
+TEMPLATE = app
+
+INCLUDEPATH += ..
+
+SOURCES += event_stream_consumer.cpp \
+           ../event_stream.cpp \
+           ../trace.cpp
+
+QMAKE_CXXFLAGS += -Wall -O2
+LIBS += -pthread
+linux: LIBS += -lrt
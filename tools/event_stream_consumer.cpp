@@ -0,0 +1,182 @@
+// event-consumer: пример внешнего читателя потока событий сниффера.
+// Печатает по строке на событие прямо из общей памяти и сообщает о
+// потерях, если не успевает за захватом (сниффер при этом не ждёт).
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <string>
+#include <thread>
+
+#include "../event_stream.h"
+
+namespace {
+
+struct ConsumerOptions {
+    std::string socketPath = EventStreamPublisher::defaultSocketPath();
+    bool fromStart = false;
+    bool statsOnly = false;
+    unsigned delayUs = 0;   // Искусственная задержка на событие (проверка потерь)
+};
+
+void printUsage() {
+    fprintf(stderr,
+            "Использование: event-consumer [--socket PATH] [--from-start] [--stats] [--delay-us N]\n"
+            "  --socket PATH   управляющий сокет сниффера (по умолчанию %s)\n"
+            "  --from-start    начать с самого старого события в кольце\n"
+            "  --stats         напечатать счётчики писателя и выйти\n"
+            "  --delay-us N    задержка на событие - медленный читатель теряет только свои события\n",
+            EventStreamPublisher::defaultSocketPath().c_str());
+}
+
+bool parseOptions(int argc, char* argv[], ConsumerOptions& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (arg == "--socket" && hasValue) options.socketPath = argv[++i];
+        else if (arg == "--from-start") options.fromStart = true;
+        else if (arg == "--stats") options.statsOnly = true;
+        else if (arg == "--delay-us" && hasValue) options.delayUs = std::strtoul(argv[++i], nullptr, 10);
+        else {
+            printUsage();
+            return false;
+        }
+    }
+    return true;
+}
+
+const char* typeName(const StreamEventHeader& event) {
+    switch (event.type) {
+    case STREAM_EVENT_HTTP_REQUEST: return "HTTP-запрос";
+    case STREAM_EVENT_HTTP_RESPONSE: return "HTTP-ответ";
+    case STREAM_EVENT_TLS_HELLO: return event.flags & STREAM_EVENT_RESPONSE ? "ServerHello" : "ClientHello";
+    case STREAM_EVENT_DNS: return event.flags & STREAM_EVENT_RESPONSE ? "DNS-ответ" : "DNS-запрос";
+    default: return "?";
+    }
+}
+
+std::string address(uint32_t ip, uint16_t port) {
+    char text[32];
+    snprintf(text, sizeof(text), "%u.%u.%u.%u:%u", (ip >> 24) & 0xff, (ip >> 16) & 0xff, (ip >> 8) & 0xff,
+             ip & 0xff, port);
+    return text;
+}
+
+// Строка события собирается, пока ячейка не перезаписана; печатается после release()
+std::string formatEvent(const EventStreamReader& reader, const StreamEventHeader& event) {
+    time_t seconds = static_cast<time_t>(event.timestampUs / 1000000);
+    struct tm local;
+#ifdef _WIN32
+    localtime_s(&local, &seconds);
+#else
+    localtime_r(&seconds, &local);
+#endif
+    char prefix[160];
+    snprintf(prefix, sizeof(prefix), "%02d:%02d:%02d.%06u [%u] %-11s %s -> %s", local.tm_hour, local.tm_min,
+             local.tm_sec, unsigned(event.timestampUs % 1000000), event.interfaceIndex, typeName(event),
+             address(event.srcIP, event.srcPort).c_str(), address(event.dstIP, event.dstPort).c_str());
+    std::string line = prefix;
+
+    std::string_view method, uri, host, version, statusText, contentType, queryType;
+    reader.field(&event, STREAM_FIELD_METHOD, method);
+    reader.field(&event, STREAM_FIELD_URI, uri);
+    reader.field(&event, STREAM_FIELD_HOST, host);
+    reader.field(&event, STREAM_FIELD_VERSION, version);
+    reader.field(&event, STREAM_FIELD_STATUS_TEXT, statusText);
+    reader.field(&event, STREAM_FIELD_CONTENT_TYPE, contentType);
+    reader.field(&event, STREAM_FIELD_QUERY_TYPE, queryType);
+
+    switch (event.type) {
+    case STREAM_EVENT_HTTP_REQUEST:
+        line += " " + std::string(method) + " " + std::string(host) + std::string(uri);
+        break;
+    case STREAM_EVENT_HTTP_RESPONSE:
+        line += " " + std::to_string(event.code) + " " + std::string(statusText) + ", " +
+                std::to_string(event.length) + " байт" + (contentType.empty() ? "" : " " + std::string(contentType));
+        break;
+    case STREAM_EVENT_TLS_HELLO: {
+        char version[16];
+        snprintf(version, sizeof(version), "0x%04x", event.code);
+        line += " " + std::string(host.empty() ? "(без SNI)" : host) + " " + version;
+        break;
+    }
+    case STREAM_EVENT_DNS:
+        line += " " + std::string(queryType) + " " + std::string(host);
+        if (event.flags & STREAM_EVENT_RESPONSE) {
+            line += " rcode=" + std::to_string(event.code);
+        }
+        break;
+    }
+    if (event.flags & STREAM_EVENT_TRUNCATED) {
+        line += " (обрезано)";
+    }
+    return line;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    ConsumerOptions options;
+    if (!parseOptions(argc, argv, options)) {
+        return 2;
+    }
+    if (!EventStreamPublisher::isSupported()) {
+        fprintf(stderr, "Поток событий поддерживается только в POSIX-системах\n");
+        return 2;
+    }
+
+    EventStreamReader reader;
+    std::string error;
+    if (options.statsOnly) {
+        std::string reply;
+        if (!reader.attach(options.socketPath, false, error) || !reader.statistics(reply)) {
+            fprintf(stderr, "%s\n", error.empty() ? "Нет ответа от сниффера" : error.c_str());
+            return 1;
+        }
+        printf("%s\n", reply.c_str());
+        return 0;
+    }
+
+    // Сниффер может быть ещё не запущен или перезапустить захват - подключаемся заново
+    bool attached = false;
+    uint64_t reportedLost = 0;
+    for (;;) {
+        if (!attached) {
+            attached = reader.attach(options.socketPath, options.fromStart, error);
+            if (!attached) {
+                std::this_thread::sleep_for(std::chrono::seconds(1));
+                continue;
+            }
+            reportedLost = 0;
+            fprintf(stderr, "Подключено к %s\n", options.socketPath.c_str());
+        }
+
+        const StreamEventHeader* event = reader.next();
+        if (!event) {
+            if (reader.publisherGone()) {
+                fprintf(stderr, "Сниффер остановил поток событий\n");
+                reader.detach();
+                attached = false;
+                continue;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+
+        std::string line = formatEvent(reader, *event);
+        if (options.delayUs) {
+            std::this_thread::sleep_for(std::chrono::microseconds(options.delayUs));
+        }
+        if (reader.release()) {
+            printf("%s\n", line.c_str());
+        }
+
+        if (reader.lost() != reportedLost) {
+            fprintf(stderr, "Пропущено событий (читатель не успевает): %llu\n",
+                    static_cast<unsigned long long>(reader.lost() - reportedLost));
+            reportedLost = reader.lost();
+        }
+    }
+}
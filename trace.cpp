@@ -0,0 +1,183 @@
+#include "trace.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <mutex>
+
+namespace {
+
+// 65536 событий на поток (~1.5 МБ)
+const uint64_t RING_CAPACITY = 1 << 16;
+
+struct TraceEvent {
+    const char* name;
+    uint64_t startNs;
+    uint64_t endNs;
+};
+
+// Буфер одного потока: пишет только владелец, читают экспорт и сводка
+struct ThreadBuffer {
+    std::string name;
+    uint32_t id;
+    std::atomic<uint64_t> head;   // Число записанных событий
+    std::atomic<uint64_t> tail;   // Начало после последней очистки
+    std::vector<TraceEvent> events;
+
+    ThreadBuffer(uint32_t id)
+        : name("thread " + std::to_string(id)), id(id), head(0), tail(0), events(RING_CAPACITY) {}
+};
+
+std::mutex registryMutex;
+
+std::vector<ThreadBuffer*>& registry() {
+    // Буферы не освобождаются: данные завершившихся потоков остаются доступны
+    static std::vector<ThreadBuffer*> buffers;
+    return buffers;
+}
+
+thread_local ThreadBuffer* currentBuffer = nullptr;
+
+ThreadBuffer* threadBuffer() {
+    if (!currentBuffer) {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        currentBuffer = new ThreadBuffer(static_cast<uint32_t>(registry().size() + 1));
+        registry().push_back(currentBuffer);
+    }
+    return currentBuffer;
+}
+
+// Копирует события буфера, отбрасывая те, что могли быть перезаписаны во время чтения
+std::vector<TraceEvent> snapshot(const ThreadBuffer* buffer) {
+    uint64_t head = buffer->head.load(std::memory_order_acquire);
+    uint64_t start = buffer->tail.load(std::memory_order_relaxed);
+    if (head > RING_CAPACITY) start = std::max(start, head - RING_CAPACITY);
+
+    std::vector<TraceEvent> result;
+    if (start >= head) return result;
+    result.reserve(head - start);
+    for (uint64_t i = start; i < head; i++) {
+        result.push_back(buffer->events[i % RING_CAPACITY]);
+    }
+
+    uint64_t headAfter = buffer->head.load(std::memory_order_acquire);
+    if (headAfter > RING_CAPACITY && headAfter - RING_CAPACITY > start) {
+        size_t overwritten = std::min<uint64_t>(headAfter - RING_CAPACITY - start, result.size());
+        result.erase(result.begin(), result.begin() + overwritten);
+    }
+    return result;
+}
+
+} // namespace
+
+std::atomic<bool> Tracer::enabled(false);
+
+bool Tracer::isCompiledIn() {
+#ifdef SNIFFER_TRACING
+    return true;
+#else
+    return false;
+#endif
+}
+
+void Tracer::setEnabled(bool value) {
+    enabled.store(value && isCompiledIn(), std::memory_order_relaxed);
+}
+
+void Tracer::setThreadName(const char* name) {
+    ThreadBuffer* buffer = threadBuffer();
+    std::lock_guard<std::mutex> lock(registryMutex);
+    buffer->name = name;
+}
+
+uint64_t Tracer::nowNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void Tracer::record(const char* name, uint64_t startNs, uint64_t endNs) {
+    ThreadBuffer* buffer = threadBuffer();
+    uint64_t head = buffer->head.load(std::memory_order_relaxed);
+    buffer->events[head % RING_CAPACITY] = TraceEvent{name, startNs, endNs};
+    buffer->head.store(head + 1, std::memory_order_release);
+}
+
+bool Tracer::exportChromeTrace(const std::string& fileName) {
+    FILE* file = fopen(fileName.c_str(), "w");
+    if (!file) return false;
+
+    std::vector<ThreadBuffer*> buffers;
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        buffers = registry();
+    }
+
+    // Все временные метки отсчитываются от самого раннего события
+    std::vector<std::vector<TraceEvent>> events;
+    uint64_t base = UINT64_MAX;
+    for (const ThreadBuffer* buffer : buffers) {
+        events.push_back(snapshot(buffer));
+        for (const TraceEvent& event : events.back()) {
+            base = std::min(base, event.startNs);
+        }
+    }
+    if (base == UINT64_MAX) base = 0;
+
+    fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    bool first = true;
+    for (size_t i = 0; i < buffers.size(); i++) {
+        std::string threadName;
+        {
+            std::lock_guard<std::mutex> lock(registryMutex);
+            threadName = buffers[i]->name;
+        }
+        fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+                first ? "" : ",\n", buffers[i]->id, threadName.c_str());
+        first = false;
+
+        for (const TraceEvent& event : events[i]) {
+            fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                    event.name, buffers[i]->id,
+                    (event.startNs - base) / 1000.0, (event.endNs - event.startNs) / 1000.0);
+        }
+    }
+    fprintf(file, "\n]}\n");
+
+    return fclose(file) == 0;
+}
+
+std::vector<TraceStageSummary> Tracer::summary() {
+    std::vector<ThreadBuffer*> buffers;
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        buffers = registry();
+    }
+
+    std::map<std::string, TraceStageSummary> stages;
+    for (const ThreadBuffer* buffer : buffers) {
+        for (const TraceEvent& event : snapshot(buffer)) {
+            TraceStageSummary& stage = stages[event.name];
+            uint64_t duration = event.endNs - event.startNs;
+            stage.name = event.name;
+            stage.count++;
+            stage.totalNs += duration;
+            stage.maxNs = std::max(stage.maxNs, duration);
+        }
+    }
+
+    std::vector<TraceStageSummary> result;
+    for (const auto& stage : stages) {
+        result.push_back(stage.second);
+    }
+    std::sort(result.begin(), result.end(), [](const TraceStageSummary& a, const TraceStageSummary& b) {
+        return a.totalNs > b.totalNs;
+    });
+    return result;
+}
+
+void Tracer::clear() {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    for (ThreadBuffer* buffer : registry()) {
+        buffer->tail.store(buffer->head.load(std::memory_order_acquire), std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,82 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <atomic>
+
+// Трассировка горячего пути. Точки трассировки компилируются только при
+// CONFIG += tracing (DEFINES SNIFFER_TRACING), иначе макрос раскрывается в пустоту.
+// Каждый поток пишет в собственный кольцевой буфер без блокировок;
+// сбор и экспорт выполняются из любого другого потока.
+
+// Сводка по одной стадии
+struct TraceStageSummary {
+    std::string name;
+    uint64_t count;
+    uint64_t totalNs;
+    uint64_t maxNs;
+};
+
+class Tracer {
+public:
+    // Включена ли поддержка трассировки при сборке
+    static bool isCompiledIn();
+
+    // Включение/выключение записи во время работы
+    static void setEnabled(bool enabled);
+    static bool isEnabled() { return enabled.load(std::memory_order_relaxed); }
+
+    // Имя текущего потока в экспортированной трассе
+    static void setThreadName(const char* name);
+
+    // Записывает завершённый интервал в буфер текущего потока
+    static void record(const char* name, uint64_t startNs, uint64_t endNs);
+
+    static uint64_t nowNs();
+
+    // Экспорт в формате Chrome trace JSON (открывается в Perfetto / chrome://tracing)
+    static bool exportChromeTrace(const std::string& fileName);
+
+    // Суммарное время по стадиям, отсортированное по убыванию
+    static std::vector<TraceStageSummary> summary();
+
+    // Очищает все буферы
+    static void clear();
+
+private:
+    static std::atomic<bool> enabled;
+};
+
+// Замер времени жизни области видимости
+class ScopedTrace {
+public:
+    explicit ScopedTrace(const char* name)
+        : name(name), startNs(Tracer::isEnabled() ? Tracer::nowNs() : 0) {}
+
+    ~ScopedTrace() {
+        if (startNs) {
+            Tracer::record(name, startNs, Tracer::nowNs());
+        }
+    }
+
+private:
+    const char* name;
+    uint64_t startNs;
+
+    ScopedTrace(const ScopedTrace&) = delete;
+    ScopedTrace& operator=(const ScopedTrace&) = delete;
+};
+
+#define SNIFFER_TRACE_CONCAT_(a, b) a##b
+#define SNIFFER_TRACE_CONCAT(a, b) SNIFFER_TRACE_CONCAT_(a, b)
+
+#ifdef SNIFFER_TRACING
+// name должен быть строковым литералом (хранится указатель)
+#define TRACE_SCOPE(name) ScopedTrace SNIFFER_TRACE_CONCAT(traceScope_, __LINE__)(name)
+#else
+#define TRACE_SCOPE(name) do {} while (0)
+#endif
+
+#endif // TRACE_H
@@ -0,0 +1,370 @@
+#include "trigger_capture.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+namespace {
+
+typedef FrameQueue::RecordHeader RecordHeader;
+const uint32_t WRAP_MARKER = FrameQueue::WRAP_MARKER;
+
+inline size_t recordSize(uint32_t caplen) {
+    return FrameQueue::recordSize(caplen);
+}
+
+std::string trim(const std::string& text) {
+    size_t first = text.find_first_not_of(" \t");
+    if (first == std::string::npos) return std::string();
+    return text.substr(first, text.find_last_not_of(" \t") - first + 1);
+}
+
+} // namespace
+
+// ------------------ PreTriggerRing ------------------
+
+PreTriggerRing::PreTriggerRing(size_t capacityBytes)
+    : head(0), tail(0) {
+    size_t size = capacityBytes < 65536 ? 65536 : capacityBytes;
+    buffer.resize((size + 7) & ~size_t(7));
+}
+
+void PreTriggerRing::evictOldest() {
+    size_t offset = static_cast<size_t>(tail % buffer.size());
+    size_t untilEnd = buffer.size() - offset;
+
+    RecordHeader header;
+    header.caplen = WRAP_MARKER;
+    if (untilEnd >= sizeof(header)) {
+        memcpy(&header, &buffer[offset], sizeof(header));
+    }
+    tail += header.caplen == WRAP_MARKER ? untilEnd : recordSize(header.caplen);
+}
+
+void PreTriggerRing::push(uint64_t timestampUs, uint32_t caplen, uint32_t len, const uint8_t* data) {
+    size_t size = recordSize(caplen);
+    if (size > buffer.size() / 2) return;
+
+    size_t offset = static_cast<size_t>(head % buffer.size());
+    size_t untilEnd = buffer.size() - offset;
+    size_t needed = size <= untilEnd ? size : untilEnd + size;
+
+    // Освобождаем место, вытесняя самые старые кадры
+    while (head + needed - tail > buffer.size()) {
+        evictOldest();
+    }
+
+    if (size > untilEnd) {
+        RecordHeader marker{0, WRAP_MARKER, 0};
+        memcpy(&buffer[offset], &marker, untilEnd < sizeof(marker) ? untilEnd : sizeof(marker));
+        head += untilEnd;
+        offset = 0;
+    }
+
+    RecordHeader header{timestampUs, caplen, len};
+    memcpy(&buffer[offset], &header, sizeof(header));
+    memcpy(&buffer[offset + sizeof(header)], data, caplen);
+    head += size;
+}
+
+size_t PreTriggerRing::writeTo(PcapFileWriter& writer, uint64_t notBeforeUs) const {
+    size_t written = 0;
+    uint64_t position = tail;
+
+    while (position < head) {
+        size_t offset = static_cast<size_t>(position % buffer.size());
+        size_t untilEnd = buffer.size() - offset;
+
+        RecordHeader header;
+        header.caplen = WRAP_MARKER;
+        if (untilEnd >= sizeof(header)) {
+            memcpy(&header, &buffer[offset], sizeof(header));
+        }
+        if (header.caplen == WRAP_MARKER) {
+            position += untilEnd;
+            continue;
+        }
+
+        if (header.timestampUs >= notBeforeUs) {
+            writer.write(header.timestampUs, header.caplen, header.len, &buffer[offset + sizeof(header)]);
+            written++;
+        }
+        position += recordSize(header.caplen);
+    }
+    return written;
+}
+
+void PreTriggerRing::clear() {
+    head = 0;
+    tail = 0;
+}
+
+// ------------------ TriggerRecorder ------------------
+
+TriggerOptions::TriggerOptions()
+    : ringBytes(64 * 1024 * 1024), preSeconds(10), postSeconds(10), queueBytes(16 * 1024 * 1024),
+      linkType(PcapFileWriter::LINKTYPE_ETHERNET), snaplen(65535), threadIndex(0) {
+}
+
+TriggerRecorder::TriggerRecorder(const TriggerOptions& options)
+    : options(options), recordUntilUs(0), lastTimestampUs(0), recording(false), pushedFrames(0),
+      stampFiles(0), ring(options.ringBytes), ringBusy(false), queue(options.queueBytes), queuedFrames(0),
+      consumedFrames(0), stopping(false),
+      rateWindowStartUs(0), rateWindowPackets(0), sharedSignal(nullptr), seenGeneration(0) {
+    std::string error;
+    parseRules(options.rules, rules, error);
+    thread = std::thread(&TriggerRecorder::run, this);
+}
+
+TriggerRecorder::~TriggerRecorder() {
+    if (recording) {
+        post(WriterCommand{false, false, 0, pushedFrames, std::string(), std::string()});
+    }
+    {
+        std::lock_guard<std::mutex> lock(commandMutex);
+        stopping = true;
+    }
+    commandReady.notify_one();
+    thread.join();
+}
+
+bool TriggerRecorder::parseRules(const std::string& text, std::vector<TriggerRule>& rules, std::string& error) {
+    rules.clear();
+
+    size_t pos = 0;
+    while (pos <= text.size()) {
+        size_t end = text.find(';', pos);
+        if (end == std::string::npos) end = text.size();
+        std::string item = trim(text.substr(pos, end - pos));
+        pos = end + 1;
+        if (item.empty()) continue;
+
+        TriggerRule rule;
+        rule.statusMin = 0;
+        rule.statusMax = 0;
+        rule.countPerSecond = 1;
+        rule.packetsPerSecond = 0;
+        rule.source = item;
+
+        if (item.compare(0, 7, "status=") == 0) {
+            // status=500-599/10: диапазон кодов и число ответов за секунду
+            rule.kind = TRIGGER_HTTP_STATUS;
+            char* rest = nullptr;
+            rule.statusMin = static_cast<int>(std::strtol(item.c_str() + 7, &rest, 10));
+            rule.statusMax = rule.statusMin;
+            if (*rest == '-') rule.statusMax = static_cast<int>(std::strtol(rest + 1, &rest, 10));
+            if (*rest == '/') rule.countPerSecond = static_cast<uint32_t>(std::strtoul(rest + 1, &rest, 10));
+            if (*rest != '\0' || rule.statusMin < 100 || rule.statusMax < rule.statusMin ||
+                rule.statusMax > 999 || rule.countPerSecond == 0) {
+                error = "Некорректное правило: " + item;
+                return false;
+            }
+        } else if (item.compare(0, 4, "uri~") == 0 && item.size() > 4) {
+            rule.kind = TRIGGER_URI_CONTAINS;
+            rule.text = item.substr(4);
+        } else if (item.compare(0, 5, "host=") == 0 && item.size() > 5) {
+            rule.kind = TRIGGER_HOST;
+            rule.text = item.substr(5);
+        } else if (item.compare(0, 5, "rate>") == 0) {
+            rule.kind = TRIGGER_PACKET_RATE;
+            char* rest = nullptr;
+            rule.packetsPerSecond = std::strtoull(item.c_str() + 5, &rest, 10);
+            if (*rest != '\0' || rule.packetsPerSecond == 0) {
+                error = "Некорректное правило: " + item;
+                return false;
+            }
+        } else {
+            error = "Неизвестное правило: " + item;
+            return false;
+        }
+
+        rules.push_back(rule);
+    }
+    return true;
+}
+
+void TriggerRecorder::onPacket(uint64_t timestampUs, uint32_t caplen, uint32_t len, const uint8_t* data) {
+    lastTimestampUs = timestampUs;
+
+    // Событие в другом потоке захвата
+    if (sharedSignal) {
+        uint64_t generation = sharedSignal->generation.load(std::memory_order_relaxed);
+        if (generation != seenGeneration) {
+            seenGeneration = generation;
+            fire("событие в другом потоке захвата", timestampUs, false);
+        }
+    }
+
+    if (recording) {
+        if (queue.push(timestampUs, caplen, len, data)) {
+            queuedFrames.store(++pushedFrames, std::memory_order_release);
+        }
+        if (timestampUs >= recordUntilUs) {
+            recording = false;
+            post(WriterCommand{false, false, 0, pushedFrames, std::string(), std::string()});
+        }
+    } else if (!ringBusy.load(std::memory_order_acquire)) {
+        // Пока поток записи сбрасывает кольцо, кадры до события не копятся
+        ring.push(timestampUs, caplen, len, data);
+    }
+
+    // Скорость пакетов по окнам в одну секунду
+    rateWindowPackets++;
+    if (timestampUs - rateWindowStartUs >= 1000000) {
+        for (const TriggerRule& rule : rules) {
+            if (rule.kind == TRIGGER_PACKET_RATE && rateWindowPackets > rule.packetsPerSecond &&
+                rateWindowStartUs != 0) {
+                fire(rule.source, timestampUs, true);
+                break;
+            }
+        }
+        rateWindowStartUs = timestampUs;
+        rateWindowPackets = 0;
+    }
+}
+
+void TriggerRecorder::onHttpRequest(const std::string& host, const std::string& uri, uint64_t timestampUs) {
+    for (const TriggerRule& rule : rules) {
+        if ((rule.kind == TRIGGER_URI_CONTAINS && uri.find(rule.text) != std::string::npos) ||
+            (rule.kind == TRIGGER_HOST && host == rule.text)) {
+            fire(rule.source, timestampUs, true);
+            return;
+        }
+    }
+}
+
+void TriggerRecorder::onHttpResponse(int statusCode, uint64_t timestampUs) {
+    for (TriggerRule& rule : rules) {
+        if (rule.kind != TRIGGER_HTTP_STATUS || statusCode < rule.statusMin || statusCode > rule.statusMax) {
+            continue;
+        }
+
+        // Ответы за последнюю секунду
+        rule.hits.push_back(timestampUs);
+        while (!rule.hits.empty() && timestampUs - rule.hits.front() > 1000000) {
+            rule.hits.pop_front();
+        }
+        if (rule.hits.size() >= rule.countPerSecond) {
+            rule.hits.clear();
+            fire(rule.source, timestampUs, true);
+            return;
+        }
+    }
+}
+
+void TriggerRecorder::fire(const std::string& reason, uint64_t timestampUs, bool propagate) {
+    if (propagate && sharedSignal) {
+        seenGeneration = sharedSignal->generation.fetch_add(1, std::memory_order_relaxed) + 1;
+    }
+
+    // Повторное событие во время записи только продлевает её
+    recordUntilUs = timestampUs + uint64_t(options.postSeconds) * 1000000;
+    if (recording) return;
+    recording = true;
+
+    // Кольцо сбрасывается один раз за событие; дальше кадры идут через очередь.
+    // Если прошлый сброс ещё идёт, кольцо пусто - кадры в него не писались
+    bool dumpRing = !ringBusy.load(std::memory_order_acquire);
+    if (dumpRing) {
+        ringBusy.store(true, std::memory_order_relaxed);
+    }
+    uint64_t window = uint64_t(options.preSeconds) * 1000000;
+    post(WriterCommand{true, dumpRing, timestampUs > window ? timestampUs - window : 0, 0, reason,
+                       makeFileName(timestampUs)});
+}
+
+std::string TriggerRecorder::makeFileName(uint64_t timestampUs) {
+    time_t seconds = static_cast<time_t>(timestampUs / 1000000);
+    struct tm local;
+#ifdef _WIN32
+    localtime_s(&local, &seconds);
+#else
+    localtime_r(&seconds, &local);
+#endif
+    char stamp[32];
+    strftime(stamp, sizeof(stamp), "%Y%m%d%H%M%S", &local);
+
+    // Второй файл в ту же секунду получает номер, а не перезаписывает первый
+    stampFiles = lastStamp == stamp ? stampFiles + 1 : 1;
+    lastStamp = stamp;
+
+    std::string fileName = options.directory;
+    if (!fileName.empty() && fileName.back() != '/' && fileName.back() != '\\') fileName += '/';
+    fileName += std::string("trigger_") + stamp;
+    if (options.threadIndex > 0) fileName += "_t" + std::to_string(options.threadIndex);
+    if (stampFiles > 1) fileName += "_" + std::to_string(stampFiles);
+    fileName += ".pcap";
+    return fileName;
+}
+
+void TriggerRecorder::post(WriterCommand command) {
+    {
+        std::lock_guard<std::mutex> lock(commandMutex);
+        commands.push_back(std::move(command));
+    }
+    commandReady.notify_one();
+}
+
+void TriggerRecorder::run() {
+    bool active = false;   // Между командами открытия и закрытия файла
+
+    while (true) {
+        WriterCommand command;
+        bool haveCommand = false;
+        uint64_t available = 0;
+        {
+            std::unique_lock<std::mutex> lock(commandMutex);
+            if (commands.empty() && !stopping) {
+                // Во время записи очередь опрашивается, в остальное время поток спит
+                if (active) {
+                    commandReady.wait_for(lock, std::chrono::milliseconds(1));
+                } else {
+                    commandReady.wait(lock, [this] { return !commands.empty() || stopping; });
+                }
+            }
+            if (!commands.empty()) {
+                command = std::move(commands.front());
+                commands.pop_front();
+                haveCommand = true;
+            } else if (stopping) {
+                break;
+            }
+            // Прочитано под замком при пустых командах: все эти кадры - текущего файла
+            available = queuedFrames.load(std::memory_order_acquire);
+        }
+
+        if (!haveCommand) {
+            if (active) drainQueue(available);
+            continue;
+        }
+
+        if (!command.open) {
+            drainQueue(command.endFrame);
+            writer.close();
+            active = false;
+            continue;
+        }
+
+        active = true;
+        bool opened = writer.open(command.fileName, options.linkType, options.snaplen);
+        if (command.dumpRing) {
+            if (opened) ring.writeTo(writer, command.notBeforeUs);
+            ring.clear();
+            ringBusy.store(false, std::memory_order_release);
+        }
+        if (firedCallback) firedCallback(command.reason, opened ? command.fileName : std::string());
+    }
+}
+
+void TriggerRecorder::drainQueue(uint64_t endFrame) {
+    // Кадры освобождаются и без открытого файла, иначе очередь встанет
+    QueuedFrame frame;
+    while (consumedFrames < endFrame && queue.front(frame)) {
+        if (writer.isOpen()) {
+            writer.write(frame.timestampUs, frame.caplen, frame.len, frame.data);
+        }
+        queue.pop();
+        consumedFrames++;
+    }
+}
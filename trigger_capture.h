@@ -0,0 +1,164 @@
+#ifndef TRIGGER_CAPTURE_H
+#define TRIGGER_CAPTURE_H
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "frame_queue.h"
+#include "pcap_file_writer.h"
+
+// Кольцо последних кадров фиксированного размера: память выделяется один раз,
+// новые кадры вытесняют самые старые. Записи - в формате FrameQueue
+class PreTriggerRing {
+public:
+    explicit PreTriggerRing(size_t capacityBytes);
+
+    void push(uint64_t timestampUs, uint32_t caplen, uint32_t len, const uint8_t* data);
+
+    // Записывает кадры не старше notBeforeUs, от старых к новым; возвращает их число
+    size_t writeTo(PcapFileWriter& writer, uint64_t notBeforeUs) const;
+
+    void clear();
+    size_t usedBytes() const { return static_cast<size_t>(head - tail); }
+
+private:
+    std::vector<uint8_t> buffer;
+    uint64_t head;   // Счётчики байт, позиция в кольце - по модулю размера
+    uint64_t tail;
+
+    void evictOldest();
+};
+
+// Тип условия срабатывания
+enum TriggerKind {
+    TRIGGER_HTTP_STATUS,     // status=500-599 или status=503, с необязательным /N за секунду
+    TRIGGER_URI_CONTAINS,    // uri~подстрока
+    TRIGGER_HOST,            // host=имя
+    TRIGGER_PACKET_RATE      // rate>N пакетов в секунду
+};
+
+struct TriggerRule {
+    TriggerKind kind;
+    int statusMin;
+    int statusMax;
+    uint32_t countPerSecond;   // Для статуса: сколько ответов за секунду нужно (по умолчанию 1)
+    uint64_t packetsPerSecond;
+    std::string text;
+    std::string source;        // Исходная запись правила (для сообщений)
+
+    // Окно подсчёта для статуса
+    std::deque<uint64_t> hits;
+};
+
+// Общий сигнал для потоков захвата: событие в одном потоке
+// запускает запись и в остальных (каждый пишет свой файл)
+struct TriggerSignal {
+    std::atomic<uint64_t> generation{0};
+};
+
+struct TriggerOptions {
+    std::string rules;          // Правила через ";", например "status=500-599/10; uri~/login"
+    std::string directory;
+    size_t ringBytes;           // Размер кольца до события
+    uint32_t preSeconds;        // Сколько секунд до события сохранять
+    uint32_t postSeconds;       // Сколько секунд писать после события
+    size_t queueBytes;          // Очередь кадров после события к потоку записи
+    int linkType;               // Тип канала захвата (DLT_*) для заголовка файлов
+    uint32_t snaplen;
+    int threadIndex;            // Номер потока захвата для имени файла (0 - один поток)
+
+    TriggerOptions();
+};
+
+// Запись трафика вокруг события: кадры постоянно идут в кольцо в памяти,
+// при срабатывании правила кольцо сбрасывается в файл pcap и следующие
+// postSeconds секунд пишутся туда же. Объект принадлежит одному потоку захвата;
+// файл пишет собственный поток записи: поток захвата передаёт ему кольцо
+// и копирует кадры после события в очередь FrameQueue, не дожидаясь диска.
+// FiredCallback вызывается в потоке записи после открытия файла.
+class TriggerRecorder {
+public:
+    typedef std::function<void(const std::string& reason, const std::string& fileName)> FiredCallback;
+
+    explicit TriggerRecorder(const TriggerOptions& options);
+    // Дописывает начатый файл и останавливает поток записи
+    ~TriggerRecorder();
+
+    // Разбирает правила; false и текст ошибки при некорректной записи
+    static bool parseRules(const std::string& text, std::vector<TriggerRule>& rules, std::string& error);
+
+    void setSignal(TriggerSignal* signal) { sharedSignal = signal; }
+    void setFiredCallback(FiredCallback callback) { firedCallback = callback; }
+
+    // Каждый кадр до разбора
+    void onPacket(uint64_t timestampUs, uint32_t caplen, uint32_t len, const uint8_t* data);
+
+    // Разобранные HTTP-сообщения
+    void onHttpRequest(const std::string& host, const std::string& uri, uint64_t timestampUs);
+    void onHttpResponse(int statusCode, uint64_t timestampUs);
+
+    bool isRecording() const { return recording; }
+
+    // Кадры после события, не поместившиеся в очередь записи
+    uint64_t droppedFrames() const { return queue.dropped(); }
+
+private:
+    // Команда потоку записи: открыть файл (и сбросить в него кольцо)
+    // или закрыть его, дописав кадры очереди до номера endFrame
+    struct WriterCommand {
+        bool open;
+        bool dumpRing;
+        uint64_t notBeforeUs;
+        uint64_t endFrame;
+        std::string reason;
+        std::string fileName;
+    };
+
+    TriggerOptions options;
+    std::vector<TriggerRule> rules;
+    uint64_t recordUntilUs;
+    uint64_t lastTimestampUs;
+    bool recording;              // Кадры идут в очередь записи, а не в кольцо
+    uint64_t pushedFrames;       // Кадров, поставленных в очередь за всё время
+    std::string lastStamp;       // Секунда последнего файла и число файлов в ней
+    uint32_t stampFiles;
+
+    // Кольцо передаётся потоку записи на время сброса (ringBusy)
+    PreTriggerRing ring;
+    std::atomic<bool> ringBusy;
+    FrameQueue queue;
+    std::atomic<uint64_t> queuedFrames;
+
+    // Поток записи; writer и consumedFrames используются только в нём
+    PcapFileWriter writer;
+    uint64_t consumedFrames;
+    std::thread thread;
+    std::mutex commandMutex;
+    std::condition_variable commandReady;
+    std::deque<WriterCommand> commands;
+    bool stopping;
+
+    // Подсчёт скорости пакетов
+    uint64_t rateWindowStartUs;
+    uint64_t rateWindowPackets;
+
+    TriggerSignal* sharedSignal;
+    uint64_t seenGeneration;
+    FiredCallback firedCallback;
+
+    void fire(const std::string& reason, uint64_t timestampUs, bool propagate);
+    std::string makeFileName(uint64_t timestampUs);
+    void post(WriterCommand command);
+    void run();
+    void drainQueue(uint64_t endFrame);
+};
+
+#endif // TRIGGER_CAPTURE_H
@@ -0,0 +1,177 @@
+#include "trigram_index.h"
+#include "trace.h"
+#include <algorithm>
+
+namespace {
+
+inline uint8_t lowerByte(uint8_t c) {
+    return (c >= 'A' && c <= 'Z') ? uint8_t(c + ('a' - 'A')) : c;
+}
+
+inline uint32_t trigramAt(const char* text) {
+    return (uint32_t(lowerByte(uint8_t(text[0]))) << 16) | (uint32_t(lowerByte(uint8_t(text[1]))) << 8) |
+           lowerByte(uint8_t(text[2]));
+}
+
+// Узел unordered_map и указатель корзины - приблизительно
+const size_t POSTING_OVERHEAD = sizeof(uint32_t) + sizeof(void*) * 3 + 32;
+
+} // namespace
+
+TrigramIndex::TrigramIndex(size_t maxBytes)
+    : maxBytes(maxBytes), memoryBytes(0), currentRow(0), nextRow(0), firstUncovered(0),
+      rowOpen(false), full(false) {
+}
+
+bool TrigramIndex::beginRow(uint32_t row) {
+    rowOpen = false;
+    if (full || row < currentRow) {
+        return false;
+    }
+    if (memoryBytes >= maxBytes) {
+        full = true;
+        firstUncovered = row;
+        return false;
+    }
+    currentRow = row;
+    nextRow = row + 1;
+    rowOpen = true;
+    return true;
+}
+
+void TrigramIndex::addText(std::string_view text) {
+    if (!rowOpen || text.size() < MIN_QUERY) {
+        return;
+    }
+    TRACE_SCOPE("search.index");
+
+    for (size_t i = 0; i + MIN_QUERY <= text.size(); i++) {
+        auto inserted = postings.try_emplace(trigramAt(text.data() + i));
+        Posting& posting = inserted.first->second;
+        if (inserted.second) {
+            memoryBytes += POSTING_OVERHEAD;
+        } else if (posting.lastRow == currentRow) {
+            continue;   // Уже есть в этой строке (повтор или другое поле)
+        }
+
+        // Первая запись - сам номер строки, дальше разности
+        uint32_t delta = posting.count == 0 ? currentRow : currentRow - posting.lastRow;
+        size_t capacity = posting.deltas.capacity();
+        while (delta >= 0x80) {
+            posting.deltas.push_back(uint8_t(delta | 0x80));
+            delta >>= 7;
+        }
+        posting.deltas.push_back(uint8_t(delta));
+        memoryBytes += posting.deltas.capacity() - capacity;
+
+        posting.lastRow = currentRow;
+        posting.count++;
+    }
+}
+
+void TrigramIndex::decode(const Posting& posting, std::vector<uint32_t>& rows) {
+    rows.clear();
+    rows.reserve(posting.count);
+    uint32_t row = 0;
+    size_t i = 0;
+    while (i < posting.deltas.size()) {
+        uint32_t delta = 0;
+        for (int shift = 0; i < posting.deltas.size(); shift += 7) {
+            uint8_t byte = posting.deltas[i++];
+            delta |= uint32_t(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) break;
+        }
+        row += delta;
+        rows.push_back(row);
+    }
+}
+
+bool TrigramIndex::candidates(std::string_view query, std::vector<uint32_t>& rows) const {
+    rows.clear();
+    if (query.size() < MIN_QUERY) {
+        return false;
+    }
+    TRACE_SCOPE("search.candidates");
+
+    // Списки триграмм запроса, начиная с самого короткого
+    std::vector<const Posting*> lists;
+    for (size_t i = 0; i + MIN_QUERY <= query.size(); i++) {
+        auto it = postings.find(trigramAt(query.data() + i));
+        if (it == postings.end()) {
+            return true;   // Такой триграммы нет ни в одной строке
+        }
+        if (std::find(lists.begin(), lists.end(), &it->second) == lists.end()) {
+            lists.push_back(&it->second);
+        }
+    }
+    std::sort(lists.begin(), lists.end(),
+              [](const Posting* a, const Posting* b) { return a->count < b->count; });
+
+    decode(*lists[0], rows);
+
+    // Пересечение с остальными списками без их распаковки в память:
+    // кандидаты проверяются по ходу чтения разностей
+    for (size_t l = 1; l < lists.size() && !rows.empty(); l++) {
+        const std::vector<uint8_t>& deltas = lists[l]->deltas;
+        size_t kept = 0;
+        size_t next = 0;
+        uint32_t row = 0;
+        size_t i = 0;
+        while (i < deltas.size() && next < rows.size()) {
+            uint32_t delta = 0;
+            for (int shift = 0; i < deltas.size(); shift += 7) {
+                uint8_t byte = deltas[i++];
+                delta |= uint32_t(byte & 0x7f) << shift;
+                if (!(byte & 0x80)) break;
+            }
+            row += delta;
+            while (next < rows.size() && rows[next] < row) {
+                next++;
+            }
+            if (next < rows.size() && rows[next] == row) {
+                rows[kept++] = row;
+                next++;
+            }
+        }
+        rows.resize(kept);
+    }
+    return true;
+}
+
+void TrigramIndex::clear() {
+    postings.clear();
+    memoryBytes = 0;
+    currentRow = 0;
+    nextRow = 0;
+    firstUncovered = 0;
+    rowOpen = false;
+    full = false;
+}
+
+void TrigramIndex::toLower(std::string_view text, std::string& lower) {
+    lower.resize(text.size());
+    for (size_t i = 0; i < text.size(); i++) {
+        lower[i] = char(lowerByte(uint8_t(text[i])));
+    }
+}
+
+bool TrigramIndex::contains(std::string_view text, std::string_view query) {
+    if (query.empty()) {
+        return true;
+    }
+    if (text.size() < query.size()) {
+        return false;
+    }
+    uint8_t first = uint8_t(query[0]);
+    for (size_t i = 0; i + query.size() <= text.size(); i++) {
+        if (lowerByte(uint8_t(text[i])) != first) continue;
+        size_t j = 1;
+        while (j < query.size() && lowerByte(uint8_t(text[i + j])) == uint8_t(query[j])) {
+            j++;
+        }
+        if (j == query.size()) {
+            return true;
+        }
+    }
+    return false;
+}
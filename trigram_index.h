@@ -0,0 +1,73 @@
+#ifndef TRIGRAM_INDEX_H
+#define TRIGRAM_INDEX_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Инвертированный индекс по триграммам для поиска подстроки в тексте строк
+// таблицы (URI, Host, значения выбранных заголовков). Для каждой триграммы
+// хранится список номеров строк: разности соседних номеров в varint, так
+// что строка, в которой триграмма встречается подряд, занимает один байт.
+// Строки добавляются по возрастанию номера (как приходят в таблицу).
+// Регистр латиницы не учитывается; остальные байты (в т.ч. UTF-8)
+// сравниваются как есть.
+// Ответ candidates() - надмножество: триграммы запроса могут быть в
+// разных полях строки, поэтому кандидатов проверяют по самому тексту.
+// Память ограничена maxBytes: после предела строки не индексируются, и
+// строки от coveredRows() и дальше ищутся перебором.
+class TrigramIndex {
+public:
+    // Запрос короче ищется только перебором
+    static const size_t MIN_QUERY = 3;
+
+    explicit TrigramIndex(size_t maxBytes = 128 * 1024 * 1024);
+
+    // Начало строки row; номера - не меньше предыдущего. false - индекс
+    // заполнен, строка (и все следующие) не индексируется
+    bool beginRow(uint32_t row);
+
+    // Добавляет поле текущей строки
+    void addText(std::string_view text);
+
+    // Строки, содержащие все триграммы запроса, по возрастанию; только
+    // среди строк до coveredRows(). false - запрос короче MIN_QUERY
+    bool candidates(std::string_view query, std::vector<uint32_t>& rows) const;
+
+    // Строки с номером меньше этого проиндексированы
+    uint32_t coveredRows() const { return full ? firstUncovered : nextRow; }
+
+    bool isFull() const { return full; }
+    size_t memoryUsage() const { return memoryBytes; }
+    size_t trigramCount() const { return postings.size(); }
+
+    void setMaxBytes(size_t bytes) { maxBytes = bytes; }
+    void clear();
+
+    // Поиск подстроки без учёта регистра латиницы (проверка кандидатов и
+    // перебор); query - уже в нижнем регистре, см. toLower()
+    static bool contains(std::string_view text, std::string_view query);
+    static void toLower(std::string_view text, std::string& lower);
+
+private:
+    struct Posting {
+        std::vector<uint8_t> deltas;    // varint: row - предыдущая строка
+        uint32_t lastRow = 0;
+        uint32_t count = 0;
+    };
+
+    std::unordered_map<uint32_t, Posting> postings;   // Триграмма (3 байта) -> строки
+    size_t maxBytes;
+    size_t memoryBytes;
+    uint32_t currentRow;
+    uint32_t nextRow;
+    uint32_t firstUncovered;
+    bool rowOpen;
+    bool full;
+
+    static void decode(const Posting& posting, std::vector<uint32_t>& rows);
+};
+
+#endif // TRIGRAM_INDEX_H
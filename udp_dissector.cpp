@@ -0,0 +1,57 @@
+#include "udp_dissector.h"
+#include <algorithm>
+
+UdpDissectorRegistry::UdpDissectorRegistry() : portTable(65536, 0) {
+}
+
+void UdpDissectorRegistry::add(std::unique_ptr<UdpDissector> dissector,
+                               const std::vector<uint16_t>& ports, bool heuristic) {
+    // Номер хранится в байте: разборщиков заведомо меньше 255
+    if (dissectors.size() >= 255) {
+        return;
+    }
+
+    dissectors.push_back(std::move(dissector));
+    uint8_t index = static_cast<uint8_t>(dissectors.size());
+    for (uint16_t port : ports) {
+        portTable[port] = index;
+    }
+    if (heuristic) {
+        heuristics.push_back(dissectors.back().get());
+    }
+}
+
+bool UdpDissectorRegistry::tryDissector(UdpDissector* dissector, const UdpDatagram& datagram) {
+    return dissector->matchesSignature(datagram.payload, datagram.length) && dissector->dissect(datagram);
+}
+
+UdpDissector* UdpDissectorRegistry::dissect(const UdpDatagram& datagram) {
+    if (datagram.length == 0) {
+        return nullptr;
+    }
+
+    UdpDissector* byDstPort = nullptr;
+    if (uint8_t index = portTable[datagram.dstPort]) {
+        byDstPort = dissectors[index - 1].get();
+        if (tryDissector(byDstPort, datagram)) return byDstPort;
+    }
+
+    UdpDissector* bySrcPort = nullptr;
+    if (uint8_t index = portTable[datagram.srcPort]) {
+        bySrcPort = dissectors[index - 1].get();
+        if (bySrcPort != byDstPort && tryDissector(bySrcPort, datagram)) return bySrcPort;
+    }
+
+    for (UdpDissector* dissector : heuristics) {
+        if (dissector != byDstPort && dissector != bySrcPort && tryDissector(dissector, datagram)) {
+            return dissector;
+        }
+    }
+    return nullptr;
+}
+
+void UdpDissectorRegistry::clear() {
+    dissectors.clear();
+    heuristics.clear();
+    std::fill(portTable.begin(), portTable.end(), 0);
+}
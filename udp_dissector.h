@@ -0,0 +1,60 @@
+#ifndef UDP_DISSECTOR_H
+#define UDP_DISSECTOR_H
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// Датаграмма UDP; адреса и порты в порядке хоста, payload - внутри кадра pcap
+struct UdpDatagram {
+    uint32_t srcIP;
+    uint32_t dstIP;
+    uint16_t srcPort;
+    uint16_t dstPort;
+    const uint8_t* payload;
+    size_t length;
+    uint64_t timestampUs;
+};
+
+// Разборщик прикладного протокола поверх UDP
+class UdpDissector {
+public:
+    virtual ~UdpDissector() {}
+
+    virtual const char* name() const = 0;
+
+    // Быстрая проверка сигнатуры нагрузки (без разбора всего сообщения)
+    virtual bool matchesSignature(const uint8_t* data, size_t size) const = 0;
+
+    // Полный разбор; false - данные всё же не этого протокола
+    virtual bool dissect(const UdpDatagram& datagram) = 0;
+};
+
+// Выбор разборщика для датаграммы: сначала по порту назначения, затем по
+// порту источника (ответы), затем эвристические разборщики по сигнатуре.
+// Порт разборщика тоже подтверждается сигнатурой: на известных портах
+// встречается и посторонний трафик.
+class UdpDissectorRegistry {
+public:
+    UdpDissectorRegistry();
+
+    // Регистрирует разборщик для портов; heuristic - пробовать на любых портах
+    void add(std::unique_ptr<UdpDissector> dissector,
+             const std::vector<uint16_t>& ports, bool heuristic = false);
+
+    // Возвращает разборщик, принявший датаграмму, или nullptr
+    UdpDissector* dissect(const UdpDatagram& datagram);
+
+    bool empty() const { return dissectors.empty(); }
+    void clear();
+
+private:
+    std::vector<std::unique_ptr<UdpDissector>> dissectors;
+    std::vector<uint8_t> portTable;      // Номер разборщика + 1 для каждого порта, 0 - нет
+    std::vector<UdpDissector*> heuristics;
+
+    static bool tryDissector(UdpDissector* dissector, const UdpDatagram& datagram);
+};
+
+#endif // UDP_DISSECTOR_H
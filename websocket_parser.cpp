@@ -0,0 +1,115 @@
+#include "websocket_parser.h"
+#include <algorithm>
+
+WebSocketFrameParser::WebSocketFrameParser(size_t maxPreview)
+    : maxPreview(maxPreview), headerSize(0), inPayload(false), remaining(0), offset(0) {
+    std::fill(mask, mask + 4, 0);
+}
+
+const char* WebSocketFrameParser::opcodeName(uint8_t opcode) {
+    switch (opcode) {
+    case WS_CONTINUATION: return "Продолжение";
+    case WS_TEXT: return "Текст";
+    case WS_BINARY: return "Двоичный";
+    case WS_CLOSE: return "Закрытие";
+    case WS_PING: return "Ping";
+    case WS_PONG: return "Pong";
+    default: return "Неизвестный";
+    }
+}
+
+size_t WebSocketFrameParser::headerLength() const {
+    if (headerSize < 2) return 0;
+
+    size_t length = 2;
+    uint8_t shortLength = header[1] & 0x7f;
+    if (shortLength == 126) length += 2;
+    else if (shortLength == 127) length += 8;
+    if (header[1] & 0x80) length += 4;
+    return length;
+}
+
+bool WebSocketFrameParser::startFrame() {
+    frame = WebSocketFrame();
+    frame.fin = (header[0] & 0x80) != 0;
+    frame.compressed = (header[0] & 0x40) != 0;
+    frame.opcode = header[0] & 0x0f;
+    frame.masked = (header[1] & 0x80) != 0;
+
+    // Коды 3-7 и 0xb-0xf зарезервированы: такие данные - не WebSocket
+    if ((frame.opcode > WS_BINARY && frame.opcode < WS_CLOSE) || frame.opcode > WS_PONG) {
+        return false;
+    }
+
+    size_t pos = 2;
+    uint8_t shortLength = header[1] & 0x7f;
+    if (shortLength == 126) {
+        frame.length = (uint64_t(header[2]) << 8) | header[3];
+        pos = 4;
+    } else if (shortLength == 127) {
+        frame.length = 0;
+        for (int i = 0; i < 8; i++) {
+            frame.length = (frame.length << 8) | header[2 + i];
+        }
+        pos = 10;
+        if (frame.length >> 63) return false;
+    } else {
+        frame.length = shortLength;
+    }
+
+    // Управляющие кадры короткие и не фрагментируются
+    if (frame.opcode >= WS_CLOSE && (frame.length > 125 || !frame.fin)) {
+        return false;
+    }
+
+    if (frame.masked) {
+        std::copy(header + pos, header + pos + 4, mask);
+    }
+
+    remaining = frame.length;
+    offset = 0;
+    inPayload = true;
+    return true;
+}
+
+bool WebSocketFrameParser::feed(const uint8_t* data, size_t size, const FrameCallback& callback) {
+    while (size > 0) {
+        if (!inPayload) {
+            // Собираем заголовок: он может быть разрезан между сегментами
+            size_t needed = headerLength();
+            if (needed == 0) needed = 2;
+            while (headerSize < needed && size > 0) {
+                header[headerSize++] = *data++;
+                size--;
+                if (headerSize == 2) needed = headerLength();
+            }
+            if (headerSize < needed) return true;
+
+            headerSize = 0;
+            if (!startFrame()) return false;
+        }
+
+        // Данные кадра: сохраняем только начало
+        size_t take = static_cast<size_t>(std::min<uint64_t>(remaining, size));
+        if (frame.payload.size() < maxPreview) {
+            size_t keep = std::min(take, maxPreview - frame.payload.size());
+            size_t start = frame.payload.size();
+            frame.payload.append(reinterpret_cast<const char*>(data), keep);
+            if (frame.masked) {
+                for (size_t i = 0; i < keep; i++) {
+                    frame.payload[start + i] ^= mask[(offset + i) & 3];
+                }
+            }
+        }
+        offset += take;
+        remaining -= take;
+        data += take;
+        size -= take;
+
+        if (remaining == 0) {
+            inPayload = false;
+            callback(frame);
+        }
+    }
+    return true;
+}
@@ -0,0 +1,60 @@
+#ifndef WEBSOCKET_PARSER_H
+#define WEBSOCKET_PARSER_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <functional>
+
+// Коды операций кадра (RFC 6455, 5.2)
+enum WebSocketOpcode {
+    WS_CONTINUATION = 0x0,
+    WS_TEXT = 0x1,
+    WS_BINARY = 0x2,
+    WS_CLOSE = 0x8,
+    WS_PING = 0x9,
+    WS_PONG = 0xa
+};
+
+struct WebSocketFrame {
+    bool fin = false;
+    bool compressed = false;   // RSV1: permessage-deflate, payload сжат
+    uint8_t opcode = 0;
+    bool masked = false;
+    uint64_t length = 0;       // Полная длина данных кадра
+    std::string payload;       // Начало данных (без маски), не длиннее maxPreview
+};
+
+// Инкрементальный разбор кадров WebSocket. Данные кадра не накапливаются:
+// сохраняется только начало (maxPreview байт), поэтому память на
+// соединение постоянна при любой длине кадров и соединения.
+class WebSocketFrameParser {
+public:
+    typedef std::function<void(const WebSocketFrame&)> FrameCallback;
+
+    explicit WebSocketFrameParser(size_t maxPreview = 1024);
+
+    // Передаёт очередные байты потока; для каждого завершённого кадра
+    // вызывает callback. Возвращает false, если поток - не WebSocket
+    // (зарезервированный код операции или некорректная длина).
+    bool feed(const uint8_t* data, size_t size, const FrameCallback& callback);
+
+    static const char* opcodeName(uint8_t opcode);
+
+private:
+    size_t maxPreview;
+
+    uint8_t header[14];        // Заголовок кадра: 2 + 8 байт длины + 4 байта маски
+    size_t headerSize;
+    bool inPayload;
+    WebSocketFrame frame;
+    uint64_t remaining;        // Байт данных текущего кадра ещё не получено
+    uint64_t offset;           // Позиция в данных кадра (для маски)
+    uint8_t mask[4];
+
+    // Полная длина заголовка по первым байтам; 0 - байт пока недостаточно
+    size_t headerLength() const;
+    bool startFrame();
+};
+
+#endif // WEBSOCKET_PARSER_H